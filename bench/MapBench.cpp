@@ -0,0 +1,107 @@
+#include <benchmark/benchmark.h>
+#include <unordered_map>
+#include "object/Map.hpp"
+
+namespace li::bench
+{
+
+
+static const size_t KEYS = 200000;
+static const size_t PASSES = 5;
+
+//	The strings the maps are keyed by, made once for every benchmark
+static const vector<shared_ptr<String>>& keys()
+{
+	static vector<shared_ptr<String>> keys = []
+	{
+		vector<shared_ptr<String>> made;
+		for (size_t i = 0; i < KEYS; i++)
+		{
+			made.push_back(make_shared<String>("key" + to_string(i * 7919)));
+		}
+		return made;
+	}();
+	return keys;
+}
+
+static void mapInsert(benchmark::State& state)
+{
+	auto value = make_shared<Integer>(1);
+	for (auto _ : state)
+	{
+		Map map;
+		for (const auto& key : keys())
+		{
+			map.insert(key, Map::hash(*key)).value = value;
+		}
+		benchmark::DoNotOptimize(map.size());
+	}
+}
+
+static void mapLookup(benchmark::State& state)
+{
+	Map map;
+	auto value = make_shared<Integer>(1);
+	for (const auto& key : keys())
+	{
+		map.insert(key, Map::hash(*key)).value = value;
+	}
+
+	for (auto _ : state)
+	{
+		size_t found = 0;
+		for (size_t pass = 0; pass < PASSES; pass++)
+		{
+			for (const auto& key : keys())
+			{
+				found += map.find(*key) != nullptr;
+			}
+		}
+		benchmark::DoNotOptimize(found);
+	}
+}
+
+static void unorderedMapInsert(benchmark::State& state)
+{
+	auto value = make_shared<Integer>(1);
+	for (auto _ : state)
+	{
+		unordered_map<string, shared_ptr<Object>> map;
+		for (const auto& key : keys())
+		{
+			map[string(key->view())] = value;
+		}
+		benchmark::DoNotOptimize(map.size());
+	}
+}
+
+static void unorderedMapLookup(benchmark::State& state)
+{
+	unordered_map<string, shared_ptr<Object>> map;
+	auto value = make_shared<Integer>(1);
+	for (const auto& key : keys())
+	{
+		map[string(key->view())] = value;
+	}
+
+	for (auto _ : state)
+	{
+		size_t found = 0;
+		for (size_t pass = 0; pass < PASSES; pass++)
+		{
+			for (const auto& key : keys())
+			{
+				found += map.find(string(key->view())) != map.end();
+			}
+		}
+		benchmark::DoNotOptimize(found);
+	}
+}
+
+BENCHMARK(mapInsert)->Unit(benchmark::kMillisecond);
+BENCHMARK(mapLookup)->Unit(benchmark::kMillisecond);
+BENCHMARK(unorderedMapInsert)->Unit(benchmark::kMillisecond);
+BENCHMARK(unorderedMapLookup)->Unit(benchmark::kMillisecond);
+
+
+}
\ No newline at end of file
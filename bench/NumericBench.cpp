@@ -0,0 +1,72 @@
+#include <benchmark/benchmark.h>
+#include "evaluator/Evaluator.h"
+#include "parser/Parser.h"
+
+namespace li::bench
+{
+
+
+static const string SETUP = R"(
+let sum = fun(array) { _builtin_(2, array) };
+let min = fun(array) { _builtin_(3, array) };
+let dot = fun(a, b) { _builtin_(5, a, b) };
+let scale = fun(array, factor) { _builtin_(6, array, factor) };
+let add = fun(a, b) { _builtin_(7, a, b) };
+let fill = fun(count, value) { _builtin_(10, count, value) };
+let n = 100000;
+var a = fill(n, 3);
+var b = fill(n, 5);
+)";
+
+//	The program parsed, or null after the parser outputs were reported to state
+static shared_ptr<Program> parse(benchmark::State& state, const string& input)
+{
+	auto parser = make_shared<Parser>(make_shared<Lexer>(input));
+	auto program = parser->parseProgram();
+	if (!parser->outputs().empty())
+	{
+		state.SkipWithError(parser->outputs().front().c_str());
+		return nullptr;
+	}
+	return program;
+}
+
+//	Evaluates input in a scope of its own once per iteration, after SETUP, with the tree-walking
+//	evaluator and none of the optimizer passes
+static void evaluate(benchmark::State& state, const string& input)
+{
+	auto setup = parse(state, SETUP);
+	auto program = parse(state, input);
+	if (!setup || !program) return;
+
+	Evaluator evaluator;
+	auto env = make_shared<Environment>();
+	evaluator.evaluate(setup, env);
+	for (auto _ : state)
+	{
+		auto result = evaluator.evaluate(program, make_shared<Environment>(env));
+		if (result->type == Object::Type::Error)
+		{
+			state.SkipWithError(result->inspect().c_str());
+			break;
+		}
+		benchmark::DoNotOptimize(result);
+	}
+}
+
+// The builtins include the copy of the arrays a function is given
+BENCHMARK_CAPTURE(evaluate, sum, "sum(a)")->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(evaluate, sumLoop, "var s = 0; for (x in a) { s += x }; s")->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(evaluate, min, "min(a)")->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(evaluate, minLoop, "var m = a[0]; for (x in a) { if (x < m) { m = x } }; m")->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(evaluate, dot, "dot(a, b)")->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(evaluate, dotLoop, "var i = 0; var s = 0; while (i < n) { s += a[i] * b[i]; ++i }; s")->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(evaluate, scale, "scale(a, 3)")->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(evaluate, scaleLoop, "var r = fill(n, 0); for (i in 0..n) { r[i] = a[i] * 3 }; r")->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(evaluate, add, "add(a, b)")->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(evaluate, addLoop, "var r = fill(n, 0); for (i in 0..n) { r[i] = a[i] + b[i] }; r")->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(evaluate, fill, "fill(n, 7)")->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(evaluate, fillLoop, "var r = fill(n, 0); for (i in 0..n) { r[i] = 7 }; r")->Unit(benchmark::kMicrosecond);
+
+
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "ast/Program.hpp"
+#include "ast/FunctionExpr.hpp"
+#include "ast/IndexExpr.hpp"
+#include "ast/ForStat.hpp"
+#include <unordered_map>
+
+namespace li
+{
+
+
+// Finds the array reads whose element is only used on the spot: as an operand, a condition, an
+// argument, which is copied, or the target of an assignment, which is stored back into the array.
+// Those read a copy of the element of an unboxed Array. Anywhere else, such as a let, a return or an
+// array literal, a name may keep the element object and see it change with the array, so the array
+// is boxed by the read. A for loop over an array likewise only gets copies of its elements when its
+// body reads the name on the spot and neither assigns it nor hands it to a nested function.
+class ElementUses
+{
+public:
+	static void analyze(const shared_ptr<Program>& program);
+	static void analyze(const shared_ptr<FunctionExpr>& fun);
+
+private:
+	struct Loop
+	{
+		ForStat* node;
+		size_t depth;		// Of nested functions at the loop
+	};
+
+	struct Context
+	{
+		size_t depth = 0;
+		vector<Loop> loops;
+		unordered_map<IndexExpr*, bool> indexes;	// Whether any path keeps the element of a read
+		unordered_map<ForStat*, bool> fors;		// Whether any path keeps or assigns the name
+	};
+
+	// retained when the value of node may outlive the expression using it
+	static void visit(const shared_ptr<Node>& node, bool retained, Context& context);
+	static void block(const vector<shared_ptr<Stat>>& statements, bool retained, Context& context);
+	static void target(const shared_ptr<Expr>& id, Context& context);
+	static void reference(symbol_t symbol, bool retained, Context& context);
+	static void apply(Context& context);
+};
+
+
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "ast/Program.hpp"
+#include "ast/FunctionExpr.hpp"
+#include <unordered_map>
+#include <unordered_set>
+
+namespace li
+{
+
+
+// Computes the free variables of every function, so that creating a closure only captures
+// the variables its body references instead of keeping the whole defining scope chain alive
+class FreeVariables
+{
+public:
+	static void analyze(shared_ptr<Program> program);
+
+	// Analyze a function whose enclosing code is unknown, every free variable is assumed to
+	// possibly be declared after the function is created
+	static void analyze(shared_ptr<FunctionExpr> fun);
+
+private:
+	struct Context
+	{
+		bool isProgram = false;
+		int loopDepth = 0;
+		vector<symbol_t> references;
+		unordered_map<symbol_t, vector<shared_ptr<IdentifierExpr>>> ids;
+		unordered_set<symbol_t> declared;		// Declared in a local scope
+		vector<shared_ptr<FunctionExpr>> functions;
+	};
+
+	static void analyze_function(shared_ptr<FunctionExpr> fun, const unordered_set<symbol_t>* enclosing);
+	static void analyze_nested(Context& context, const unordered_set<symbol_t>* enclosing);
+	static void collect(const shared_ptr<Node>& node, Context& context);
+	static void reference(Context& context, symbol_t symbol);
+	static void declare(Context& context, symbol_t symbol);
+};
+
+
+}
\ No newline at end of file
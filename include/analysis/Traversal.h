@@ -0,0 +1,20 @@
+#pragma once
+
+#include "ast/basic/Node.hpp"
+#include "ast/basic/Expression.hpp"
+#include <functional>
+
+namespace li
+{
+
+
+// Visit every direct child of node that is evaluated as code. The names introduced by
+// let, var and function arguments are declarations rather than references, so they are skipped.
+void for_each_child(const shared_ptr<Node>& node, const function<void(const shared_ptr<Node>&)>& visit);
+
+// Visit every direct child slot of node that holds an expression, so that a pass can replace
+// the child in place. Statements and blocks are not expression slots, reach them by for_each_child.
+void for_each_expr_slot(const shared_ptr<Node>& node, const function<void(shared_ptr<Expr>&)>& visit);
+
+
+}
\ No newline at end of file
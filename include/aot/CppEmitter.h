@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ast/Program.hpp"
+#include "ast/FunctionExpr.hpp"
+#include "ast/WhileStat.hpp"
+#include "ast/ForStat.hpp"
+#include "ast/IndexExpr.hpp"
+#include <map>
+#include <ostream>
+#include <sstream>
+
+namespace li::aot
+{
+
+
+// Translates a program and the standard library it runs with to a C++ translation unit that links
+// against the interpreter library and runs on aot::Runtime. Every block becomes a C++ function of
+// the environment it runs in, which returns its value as the evaluator does, and every expression a
+// sequence of statements that returns from that function as soon as an operand is an error. The
+// conditions of if and while and the operands of an assignment, whose errors the evaluator does not
+// return right away, become functions of their own. Infix operators the IR proved to be numeric
+// are computed in place.
+class CppEmitter
+{
+public:
+	// Specializes the operators of both programs before translating them
+	static void emit(const shared_ptr<Program>& prelude, const shared_ptr<Program>& program, const string& sourceName, ostream& out);
+
+private:
+	// A C++ function being written, translated functions nest while the AST is walked
+	struct Function
+	{
+		stringstream body;
+		size_t values = 0;
+	};
+
+private:
+	string program(const shared_ptr<Program>& node);
+	string block(const vector<shared_ptr<Stat>>& statements);
+	string expression_function(const shared_ptr<Expr>& expr);
+	string element_function(const shared_ptr<IndexExpr>& node);
+	void statement(const shared_ptr<Stat>& stat);
+
+	// The name of a C++ variable holding the value of expr, an operand is checked for errors as well
+	string expression(const shared_ptr<Expr>& expr);
+	string operand(const shared_ptr<Expr>& expr);
+	string isolated(const shared_ptr<Expr>& expr);
+	string call(const vector<shared_ptr<Expr>>& args, const string& callee);
+
+	Function& begin();
+	string end(const string& prefix, const string& signature);
+	string value(const string& init);
+	void line(const string& text);
+	string symbol(const IdentifierExpr& id);
+
+	static string quote(const string& text);
+	static string annotation(Annotation annotation);
+
+private:
+	vector<Function> _stack;
+	vector<string> _declarations;
+	vector<string> _definitions;
+	vector<string> _statics;
+	map<symbol_t, string> _symbols;
+	size_t _functions = 0;
+};
+
+
+}
\ No newline at end of file
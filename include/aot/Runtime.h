@@ -0,0 +1,94 @@
+#pragma once
+
+#include "evaluator/Evaluator.h"
+#include "object/Float.hpp"
+#include "object/String.hpp"
+#include "object/ReturnValue.hpp"
+#include "object/Error.hpp"
+
+namespace li::aot
+{
+
+
+// What the C++ generated by CppEmitter runs on: the objects of the interpreter and the operations
+// the evaluator performs on them, so that a translated program behaves exactly as an evaluated one.
+// Control flow, calls of translated functions and proven numeric operations are native code.
+class Runtime
+{
+public:
+	using Value = shared_ptr<Object>;
+
+public:
+	static bool is_error(const Value& value)
+	{
+		return value->type == Object::Type::Error;
+	}
+
+	// Whether the value of a statement ends the block it is in
+	static bool ends_block(const Value& value)
+	{
+		return value && (value->type == Object::Type::ReturnValue || value->type == Object::Type::Error);
+	}
+
+	static Value integer(uint64_t value)
+	{
+		return make_shared<Integer>(value);
+	}
+
+	static Value number(double value)
+	{
+		return make_shared<Float>(value);
+	}
+
+	static Value string(const char* value)
+	{
+		return make_shared<String>(value);
+	}
+
+	static Value array(vector<Value> elements)
+	{
+		return make_shared<Array>(move(elements));
+	}
+
+	static Value return_value(const Value& value)
+	{
+		return make_shared<ReturnValue>(value);
+	}
+
+	// An infix operation the IR proved to combine numbers of these types
+	template <NumericOp op, bool leftFloat, bool rightFloat>
+	static Value numeric(const Value& left, const Value& right)
+	{
+		return Evaluator::numeric<op, leftFloat, rightFloat>(left, right);
+	}
+
+	// The arguments of a translated function, which has no expression of its own
+	static shared_ptr<ArgumentsStat> arguments(initializer_list<pair<const char*, Annotation>> args, Annotation result);
+
+	bool is_true(const Value& value);
+	Value identifier(const shared_ptr<Environment>& env, symbol_t symbol, const char* name);
+	Value declare(const shared_ptr<Environment>& env, symbol_t symbol, const char* name, Annotation annotation, const Value& value, bool isMutable);
+	Value prefix(const char* operatorName, const Value& right);
+	Value infix(const Value& left, const char* operatorName, const Value& right);
+	Value assign(const Value& id, const char* literal, const char* operatorName, const Value& value);
+	Value in_decrement(const Value& id, const char* operatorName);
+	Value index(const Value& left, const Value& index, bool consumed);
+	// Assigns to the element read from left at index, see Evaluator::assign_element
+	Value assign_element(const Value& left, const Value& index, const Value& element, const char* literal, const char* operatorName, const Value& value);
+	Value call(const Value& fun, const vector<Value>& args);
+	Value closure(const shared_ptr<Environment>& env, const shared_ptr<ArgumentsStat>& args, const char* text, Function::Native native);
+	Value iterate(const shared_ptr<Environment>& env, symbol_t symbol, const Value& iterable, const Value& end, bool copies, Function::Native body);
+
+	// Runs the standard library and then the program in a scope nested in it, printing the value of
+	// each as li does for a source file
+	int run(Function::Native prelude, Function::Native program);
+
+private:
+	static void report(const Value& value);
+
+private:
+	Evaluator _evaluator;
+};
+
+
+}
\ No newline at end of file
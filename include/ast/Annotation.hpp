@@ -0,0 +1,44 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+namespace li
+{
+
+using namespace std;
+
+
+// Type an argument, the result of a function or a declaration may be annotated with, as in
+// fun(a: int, b: float): float or let n: int = 0
+enum class Annotation
+{
+	None, Integer, Float, Bool, String, Array, Function
+};
+
+inline const map<string, Annotation>& annotations()
+{
+	static const map<string, Annotation> names = {
+		{ "int", Annotation::Integer }, { "float", Annotation::Float }, { "bool", Annotation::Bool },
+		{ "string", Annotation::String }, { "array", Annotation::Array }, { "fun", Annotation::Function }
+	};
+	return names;
+}
+
+inline string annotation_name(Annotation annotation)
+{
+	for (const auto& [name, value] : annotations())
+	{
+		if (value == annotation) return name;
+	}
+	return "";
+}
+
+// The annotation is written after the name it belongs to, an unannotated name is written alone
+inline string annotated_name(const string& name, Annotation annotation)
+{
+	return annotation == Annotation::None ? name : name + ": " + annotation_name(annotation);
+}
+
+
+}
\ No newline at end of file
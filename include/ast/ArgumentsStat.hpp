@@ -2,6 +2,7 @@
 
 #include "basic/Statement.hpp"
 #include "IdentifierExpr.hpp"
+#include "Annotation.hpp"
 #include <memory>
 #include <sstream>
 #include <vector>
@@ -20,20 +21,31 @@ public:
 	{
 		stringstream buffer;
 		buffer << "(";
-		for (const auto& arg : args)
+		for (size_t i = 0; i < args.size(); i++)
 		{
-			buffer << arg->toString();
-			if (arg != args.back())
+			buffer << annotated_name(args[i]->toString(), annotation(i));
+			if (i + 1 != args.size())
 			{
 				buffer << ", ";
 			}
 		}
 		buffer << ")";
+		if (result != Annotation::None)
+		{
+			buffer << ": " << annotation_name(result);
+		}
 		return buffer.str();
 	}
 
+	Annotation annotation(size_t index) const
+	{
+		return index < annotations.size() ? annotations[index] : Annotation::None;
+	}
+
 public:
 	vector<shared_ptr<IdentifierExpr>> args;
+	vector<Annotation> annotations;			// Of every argument in order, None where there is none
+	Annotation result = Annotation::None;	// Of the value the function returns
 };
 
 
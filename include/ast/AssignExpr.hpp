@@ -12,6 +12,25 @@ public:
     AssignExpr(shared_ptr<Token> token) :
         Expr(token, Type::Assign) {}
 
+	// Whether assigning a number by operatorName to a number keeps the type of the one assigned to,
+	// so that the result can be written into its object
+	static bool keeps_type(const string& operatorName, bool toFloat, bool fromFloat)
+	{
+		if (operatorName == "=")
+		{
+			return toFloat == fromFloat;
+		}
+		if (operatorName == "%=")
+		{
+			return !toFloat;
+		}
+		if (operatorName == "+=" || operatorName == "-=" || operatorName == "*=" || operatorName == "/=")
+		{
+			return toFloat || !fromFloat;
+		}
+		return false;
+	}
+
 	string toString() const override
 	{
 		stringstream buffer;
@@ -23,6 +42,7 @@ public:
 	shared_ptr<Expr> id;
 	string operatorName;
 	shared_ptr<Expr> value;
+	bool unboxed = false;		// Writes its number into the object of the name and nothing reads its value, see NumericSpecialization
 };
 
 
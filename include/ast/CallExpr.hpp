@@ -1,6 +1,7 @@
 #pragma once
 
 #include "basic/Expression.hpp"
+#include "basic/Feedback.hpp"
 #include "ExpressionsStat.hpp"
 #include <memory>
 
@@ -24,6 +25,7 @@ public:
 public:
 	shared_ptr<ExpressionsStat> exprs;
 	shared_ptr<Expr> fun;
+	Feedback feedback;		// Of the type of the callee
 };
 
 
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "basic/Statement.hpp"
+#include "basic/Expression.hpp"
+#include "IdentifierExpr.hpp"
+#include "BlockStat.hpp"
+
+namespace li
+{
+
+
+// for (name in iterable..end) body counts name from iterable up to but not including end,
+// for (name in iterable) body binds name to every element of an array
+class ForStat : public Stat
+{
+public:
+    ForStat(shared_ptr<Token> token) :
+        Stat(token, Type::For) {}
+
+    string toString() const override
+    {
+		stringstream buffer;
+		buffer << "for (" << name->toString() << " in " << iterable->toString();
+		if (end)
+		{
+			buffer << ".." << end->toString();
+		}
+		buffer << ")" << body->toString();
+		return buffer.str();
+    }
+
+public:
+	shared_ptr<IdentifierExpr> name;
+	shared_ptr<Expr> iterable;
+	shared_ptr<Expr> end;		// Null when iterating the elements of an array
+	shared_ptr<BlockStat> body;
+	bool copies = false;		// Set by ElementUses, the body only reads the values of the elements it is given
+};
+
+
+}
\ No newline at end of file
@@ -3,10 +3,16 @@
 #include "basic/Expression.hpp"
 #include "BlockStat.hpp"
 #include "ArgumentsStat.hpp"
+#include "basic/Profile.hpp"
 
 namespace li
 {
 
+namespace closure
+{
+struct Tree;
+}
+
 
 class FunctionExpr : public Expr
 {
@@ -24,6 +30,19 @@ public:
 public:
 	shared_ptr<BlockStat> body;
 	shared_ptr<ArgumentsStat> args;
+
+	// Filled in by FreeVariables, the names referenced in body but not bound by args in order of
+	// first use, and for each of them whether the enclosing code may declare it after this function
+	bool analyzed = false;
+	shared_ptr<const vector<symbol_t>> freeVars;
+	vector<bool> lateBound;
+
+	// Whether a function created by body may keep the whole chain, and with it the call frame, alive
+	bool frameEscapes = true;
+
+	// Shared by every function created by this expression
+	Profile profile;
+	shared_ptr<closure::Tree> tree;		// The body translated by closure::Compiler on the first call
 };
 
 
@@ -5,6 +5,7 @@
 namespace li
 {
 
+class Object;
 
 class IdentifierExpr : public Expr
 {
@@ -19,7 +20,16 @@ public:
 
 public:
     string value;
+    symbol_t symbol = SymbolTable::None;
+
+    // Inline cache of a global or builtin resolution, valid while cacheVersion equals Environment::version()
+    shared_ptr<Object> cache;
+    uint64_t cacheVersion = 0;
+
+    // Index into the captures of the enclosing closure, -1 if the name is not a free variable
+    // that can only come from the captures
+    int captureIndex = -1;
 };
 
 
-}
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "basic/Expression.hpp"
+#include "basic/Feedback.hpp"
 
 namespace li
 {
@@ -22,6 +23,9 @@ public:
 public:
 	shared_ptr<Expr> index;
 	shared_ptr<Expr> left;
+	Feedback feedback;
+	bool inBounds = false;		// Proven by RangeAnalysis, an integer index of an array is never out of range
+	bool consumed = false;		// Set by ElementUses, the element is used where it is read or stored back, so a copy may be read
 };
 
 
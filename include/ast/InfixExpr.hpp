@@ -1,18 +1,56 @@
 #pragma once
 
 #include "basic/Expression.hpp"
+#include "basic/Feedback.hpp"
 #include <string>
 
 namespace li
 {
 
 
+// Numeric operator an infix expression was specialized to once the types of both operands were
+// proven, so that evaluating it neither dispatches on the types nor compares the operator name
+enum class NumericOp
+{
+    None,
+    Add, Subtract, Multiply, Divide, Remainder,
+    Equal, NotEqual, Less, Greater, LessEqual, GreaterEqual
+};
+
 class InfixExpr : public Expr
 {
 public:
     InfixExpr(shared_ptr<Token> token) :
         Expr(token, Type::Infix) {}
 
+    // The operator for numeric operands of the given types, None if it is not a numeric one
+    static NumericOp numeric_op(const string& operatorName, bool leftFloat, bool rightFloat)
+    {
+        static const map<string, NumericOp> ops = {
+            { "+", NumericOp::Add }, { "-", NumericOp::Subtract }, { "*", NumericOp::Multiply }, { "/", NumericOp::Divide },
+            { "%", NumericOp::Remainder }, { "==", NumericOp::Equal }, { "!=", NumericOp::NotEqual }, { "<", NumericOp::Less },
+            { ">", NumericOp::Greater }, { "<=", NumericOp::LessEqual }, { ">=", NumericOp::GreaterEqual }
+        };
+
+        auto it = ops.find(operatorName);
+        if (it == ops.end())
+        {
+            return NumericOp::None;
+        }
+        // The remainder is only taken when an operand is an integer
+        if (it->second == NumericOp::Remainder && leftFloat && rightFloat)
+        {
+            return NumericOp::None;
+        }
+        return it->second;
+    }
+
+    // Whether the numeric operator gives a number rather than a bool
+    static bool is_arithmetic(NumericOp op)
+    {
+        return op == NumericOp::Add || op == NumericOp::Subtract || op == NumericOp::Multiply || op == NumericOp::Divide || op == NumericOp::Remainder;
+    }
+
     string toString() const override
     {
         stringstream stream;
@@ -24,6 +62,12 @@ public:
     shared_ptr<Expr> left;
     shared_ptr<Expr> right;
     string operatorName;
+
+    NumericOp numericOp = NumericOp::None;
+    bool leftFloat = false;     // Operand types of the specialization, integer unless set
+    bool rightFloat = false;
+    bool unboxed = false;       // Proven and only read by the proven operator it is an operand of, see NumericSpecialization
+    Feedback feedback;
 };
 
 
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "basic/Expression.hpp"
+#include "WhileStat.hpp"
+
+namespace li
+{
+
+
+// An expression found to be invariant in loop. Its value is computed the first time it is reached
+// in an execution of the loop and reused until the evaluator sees a mutation it may depend on.
+class InvariantExpr : public Expr
+{
+public:
+	InvariantExpr(shared_ptr<Expr> expr, const WhileStat* loop, size_t slot, bool shapeOnly) :
+		Expr(expr->token, Type::Invariant), expr(expr), loop(loop), slot(slot), shapeOnly(shapeOnly) {}
+
+	string toString() const override
+	{
+		return expr->toString();
+	}
+
+public:
+	shared_ptr<Expr> expr;
+	const WhileStat* loop;		// Not owning, the loop contains this node
+	size_t slot;
+	bool shapeOnly;		// Whether only the lengths of objects are read rather than their contents
+};
+
+
+}
\ No newline at end of file
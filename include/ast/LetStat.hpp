@@ -3,6 +3,7 @@
 #include "basic/Statement.hpp"
 #include "basic/Expression.hpp"
 #include "IdentifierExpr.hpp"
+#include "Annotation.hpp"
 #include <memory>
 #include <sstream>
 
@@ -19,13 +20,14 @@ public:
     string toString() const override
     {
         stringstream stream;
-        stream << token->literal << " " << name->toString() << " = " << value->toString();
+        stream << token->literal << " " << annotated_name(name->toString(), annotation) << " = " << value->toString();
         return stream.str();
     }
 
 public:
     shared_ptr<IdentifierExpr> name;
     shared_ptr<Expr> value;
+    Annotation annotation = Annotation::None;
 };
 
 
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "basic/Expression.hpp"
+#include "ExpressionsStat.hpp"
+
+namespace li
+{
+
+
+// {key: value, ...} makes a map, the keys and values are evaluated in the order they are written
+class MapExpr : public Expr
+{
+public:
+    MapExpr(shared_ptr<Token> token) :
+        Expr(token, Type::Map) {}
+
+    string toString() const override
+    {
+		stringstream buffer;
+		buffer << "{";
+		const auto& expressions = entries->expressions;
+		for (size_t i = 0; i + 1 < expressions.size(); i += 2)
+		{
+			buffer << (i == 0 ? "" : ", ") << expressions[i]->toString() << ": " << expressions[i + 1]->toString();
+		}
+		buffer << "}";
+		return buffer.str();
+    }
+
+public:
+	shared_ptr<ExpressionsStat> entries;		// Every key followed by its value
+};
+
+
+}
\ No newline at end of file
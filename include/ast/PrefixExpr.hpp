@@ -1,6 +1,7 @@
 #pragma once
 
 #include "basic/Expression.hpp"
+#include "basic/Feedback.hpp"
 #include <sstream>
 
 namespace li
@@ -23,6 +24,7 @@ public:
 public:
     shared_ptr<Expr> right;
     string operatorName;
+    Feedback feedback;
 };
 
 
@@ -5,6 +5,11 @@
 namespace li
 {
 
+namespace closure
+{
+struct Tree;
+}
+
 
 class Program : public Node
 {
@@ -34,7 +39,9 @@ public:
 
 public:
     vector<shared_ptr<Stat>> statements;
+    bool analyzed = false;
+    shared_ptr<closure::Tree> tree;     // The statements translated by closure::Compiler
 };
 
 
-}
+}
\ No newline at end of file
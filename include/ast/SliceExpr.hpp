@@ -0,0 +1,30 @@
+#pragma once
+
+#include "basic/Expression.hpp"
+
+namespace li
+{
+
+
+// left[from:to] is a view of an array or a slice of a string, either bound may be left out
+class SliceExpr : public Expr
+{
+public:
+    SliceExpr(shared_ptr<Token> token) :
+        Expr(token, Type::Slice) {}
+
+    string toString() const override
+    {
+		stringstream buffer;
+		buffer << left->toString() << "[" << (from ? from->toString() : "") << ":" << (to ? to->toString() : "") << "]";
+		return buffer.str();
+    }
+
+public:
+	shared_ptr<Expr> left;
+	shared_ptr<Expr> from;		// Null for the start
+	shared_ptr<Expr> to;		// Null for the end
+};
+
+
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "basic/Expression.hpp"
+
+namespace li
+{
+
+
+// An expression whose value global value numbering found to be computed before by an equal one
+// dominating it. The first stores its object in a slot of the running frame, the others read the
+// object back from there.
+class TempExpr : public Expr
+{
+public:
+	TempExpr(shared_ptr<Expr> expr, size_t slot, bool reuse) :
+		Expr(expr->token, Type::Temp), expr(expr), slot(slot), reuse(reuse) {}
+
+	string toString() const override
+	{
+		return expr->toString();
+	}
+
+public:
+	shared_ptr<Expr> expr;
+	size_t slot;
+	bool reuse;		// Whether this reads the slot rather than stores into it
+};
+
+
+}
\ No newline at end of file
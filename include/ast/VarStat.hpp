@@ -3,6 +3,7 @@
 #include "basic/Statement.hpp"
 #include "basic/Expression.hpp"
 #include "IdentifierExpr.hpp"
+#include "Annotation.hpp"
 
 namespace li
 {
@@ -17,13 +18,14 @@ public:
     string toString() const override
     {
         stringstream stream;
-        stream << "var " << name->toString() << " = " << value->toString();
+        stream << "var " << annotated_name(name->toString(), annotation) << " = " << value->toString();
         return stream.str();
     }
 
 public:
     shared_ptr<IdentifierExpr> name;
     shared_ptr<Expr> value;
+    Annotation annotation = Annotation::None;
 };
 
 
@@ -3,6 +3,7 @@
 #include "basic/Statement.hpp"
 #include "basic/Expression.hpp"
 #include "BlockStat.hpp"
+#include "basic/Profile.hpp"
 
 namespace li
 {
@@ -24,6 +25,8 @@ public:
 public:
 	shared_ptr<Expr> condition;
 	shared_ptr<BlockStat> body;
+	size_t invariants = 0;		// Number of InvariantExpr slots attached to this loop by LoopInvariants
+	Profile profile;
 };
 
 
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+namespace li
+{
+
+
+// Runtime type feedback of a node that specializes itself to the types of the objects it first
+// evaluates. A specialized node checks them with a guard on every evaluation, and goes back to the
+// generic path for good the first time the guard fails.
+struct Feedback
+{
+	enum class State : uint8_t
+	{
+		Uninitialized,
+		Specialized,
+		Proven,			// Specialized ahead of evaluation to types the analysis proved, there is no guard
+		Generic
+	};
+
+	State state = State::Uninitialized;
+	uint8_t left = 0;		// Object type of the first operand the node specialized to
+	uint8_t right = 0;		// Object type of the second operand, if the node has one
+};
+
+
+}
\ No newline at end of file
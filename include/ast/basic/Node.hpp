@@ -18,7 +18,7 @@ public:
         Let, Var, Return, Arguments, Exprs, Block,
         Call, Function, ExprStat, Identifier,
         Integer, Float, Bool, Infix, Prefix, If, String, Assign, InDecrement,
-        Array, Index, While
+        Array, Index, While, Invariant, Temp, For, Map, Slice
     };
 
 public:
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+namespace li
+{
+
+using namespace std;
+
+namespace jit
+{
+class Code;
+}
+
+
+// How often a function was called or a loop iterated, and the machine code jit::Jit compiled for
+// it once that made it hot
+struct Profile
+{
+	uint32_t hotness = 0;
+	bool rejected = false;		// Whether the body uses something the compiler can not translate
+	shared_ptr<jit::Code> code;
+};
+
+
+}
\ No newline at end of file
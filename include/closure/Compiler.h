@@ -0,0 +1,71 @@
+#pragma once
+
+#include "evaluator/Evaluator.h"
+#include "ast/PrefixExpr.hpp"
+#include "ast/CallExpr.hpp"
+#include "ast/AssignExpr.hpp"
+#include "ast/InDecrementExpr.hpp"
+#include <functional>
+
+namespace li::closure
+{
+
+
+using Value = shared_ptr<Object>;
+
+// A node translated to C++ code bound to its operands, called with the evaluator whose state it
+// updates and the environment it runs in
+using Code = function<Value(Evaluator& evaluator, const shared_ptr<Environment>& env)>;
+
+// The element an assigned IndexExpr reads, with the array and the index it was read with for storing it back
+using Element = function<Value(Evaluator& evaluator, const shared_ptr<Environment>& env, Value& left, Value& index)>;
+
+// The translation of a program or of the body of a function, kept on its node
+struct Tree
+{
+	Code code;
+};
+
+// Translates the AST once into a tree of closures, one per node, chosen by the kind of the node and
+// by its operator while it is translated. Running the tree does what Evaluator::evaluate does for the
+// same nodes, feedback, statistics and entries into jitted code included, without dispatching on the
+// type of each node or casting it on every step.
+class Compiler
+{
+public:
+	// Translates the node the first time it runs
+	static Value run(Evaluator& evaluator, Program& program, const shared_ptr<Environment>& env);
+	static Value call(Evaluator& evaluator, FunctionExpr& fun, const shared_ptr<Environment>& env);
+
+private:
+	static Code node(const shared_ptr<Node>& node);
+	static Code statements(const vector<shared_ptr<Stat>>& statements);
+	static vector<Code> nodes(const vector<shared_ptr<Expr>>& exprs);
+
+	static Code prefix(const shared_ptr<PrefixExpr>& node);
+	static Code infix(const shared_ptr<InfixExpr>& node);
+	static Code declaration(const shared_ptr<IdentifierExpr>& name, Annotation annotation, const shared_ptr<Expr>& value, bool isMutable);
+	static Code if_(const shared_ptr<IfExpr>& node);
+	static Code call(const shared_ptr<CallExpr>& node);
+	static Code assign(const shared_ptr<AssignExpr>& node);
+	static Code index(const shared_ptr<IndexExpr>& node);
+	static Element element(const shared_ptr<IndexExpr>& node);
+	static Code while_(const shared_ptr<WhileStat>& node);
+	static Code for_(const shared_ptr<ForStat>& node);
+	static Code invariant(const shared_ptr<InvariantExpr>& node);
+	static Code temp(const shared_ptr<TempExpr>& node);
+	static Code in_decrement(const shared_ptr<InDecrementExpr>& node);
+
+	// An infix operation the IR proved numeric, one instantiation per operator and operand types
+	static Code numeric(NumericOp op, bool leftFloat, bool rightFloat, Code left, Code right);
+	template <NumericOp op>
+	static Code numeric(bool leftFloat, bool rightFloat, Code left, Code right);
+	template <NumericOp op, bool leftFloat, bool rightFloat>
+	static Code numeric(Code left, Code right);
+
+	// Evaluates exprs into values, returns the first error instead
+	static Value values(const vector<Code>& exprs, Evaluator& evaluator, const shared_ptr<Environment>& env, vector<Value>& values);
+};
+
+
+}
\ No newline at end of file
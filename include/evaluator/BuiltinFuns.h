@@ -1,6 +1,8 @@
 #pragma once
 
-#include "object/basic/Object.h"
+#include "object/Array.hpp"
+#include "evaluator/Kernels.h"
+#include "evaluator/Evaluator.h"
 
 namespace li
 {
@@ -11,15 +13,126 @@ class BuiltinFuns
 public:
 	enum BuiltInType
 	{
-		Print, Len
+		Print, Len, Sum, Min, Max, Dot, Scale, Add, Sub, Mul, Fill
 	};
 
 public:
-	static shared_ptr<Object> _builtin_(const vector<shared_ptr<Object>>& objs);
+	static shared_ptr<Object> _builtin_(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs);
+
+	// sort(array) orders numbers or strings ascending, sort(array, cmp) orders anything by whether
+	// cmp(a, b) is true when a goes before b. Both return a sorted copy.
+	static shared_ptr<Object> sort(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs);
+
+	// join(array, sep) returns the strings of the array with sep between every two of them, sized
+	// before anything is copied into it
+	static shared_ptr<Object> join(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs);
+
+	// slice(s, from, to) returns the characters of s from from up to but not including to,
+	// substr(s, from, count) count characters from from, both cut to the string. Long results share
+	// the characters of s rather than copying them, see String::slice.
+	static shared_ptr<Object> slice(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs);
+	static shared_ptr<Object> substr(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs);
+
+	// map(array, f) and filter(array, f) return a new array of f(x) and of the elements x for which
+	// f(x) is true, reduce(array, f, init) folds the elements into f(f(init, x0), x1)..., each(array, f)
+	// calls f(x) for every element. The elements f is called with are copies, see Evaluator::Callback.
+	static shared_ptr<Object> map(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs);
+	static shared_ptr<Object> filter(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs);
+	static shared_ptr<Object> reduce(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs);
+	static shared_ptr<Object> each(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs);
+
+	// pmap(array, f) returns what map does, evaluating runs of the elements on the threads of
+	// ThreadPool::shared. preduce(array, f, init) folds the first run from init and every other one
+	// from its first element on those threads, then the results of the runs in order, so it returns
+	// what reduce does as long as f is associative. Both run on the calling thread like map and
+	// reduce when Sharing does not allow f on several threads.
+	static shared_ptr<Object> pmap(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs);
+	static shared_ptr<Object> preduce(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs);
+
+	// keys(map) and values(map) return new arrays of copies of the keys and values in the order the
+	// keys were inserted, or sorted by key for an OrderedMap, has(map, key) whether the map has key,
+	// remove(map, key) removes key from the mutable map and returns the value it had, or null when
+	// it had none.
+	static shared_ptr<Object> keys(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs);
+	static shared_ptr<Object> values(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs);
+	static shared_ptr<Object> has(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs);
+	static shared_ptr<Object> remove(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs);
+
+	// ordered() returns a new empty OrderedMap, ordered(map) one of copies of the entries of a Map,
+	// ordered(array) one of the elements of an array as keys, each mapped to true. insert(map, key)
+	// and insert(map, key, value) set key to value, or to true, in the mutable ordered map and return
+	// whether it did not have key. lower_bound(map, key) returns the first key not before key,
+	// range(map, from, to) an array of the keys from from up to but not including to, first(map) and
+	// last(map) the smallest and the largest key, all of them copies and null when there is none.
+	static shared_ptr<Object> ordered(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs);
+	static shared_ptr<Object> insert(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs);
+	static shared_ptr<Object> lower_bound(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs);
+	static shared_ptr<Object> range(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs);
+	static shared_ptr<Object> first(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs);
+	static shared_ptr<Object> last(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs);
+
+	// Whether the builtin called name changes an argument in place rather than reading it. Builtins
+	// are given the objects of the caller, which the arguments of a function are copies of.
+	static bool changes_arguments(const string& name);
+
+private:
+	// The elements of a numeric array as integers, or as floats once any of them is a float. They
+	// point into the array while it is unboxed and into the vectors here otherwise.
+	struct Numbers
+	{
+		bool isFloat = false;
+		size_t size = 0;
+		const int64_t* integers = nullptr;
+		const double* floats = nullptr;
+		vector<int64_t> integerValues;
+		vector<double> floatValues;
+
+		void to_floats();
+	};
+
+	// Evaluates the elements from first up to last in the evaluator of a thread, returns an error or null
+	using Run = function<shared_ptr<Object>(Evaluator& worker, size_t run, size_t first, size_t last)>;
 
 private:
 	static shared_ptr<Object> print(const vector<shared_ptr<Object>>& objs);
 	static shared_ptr<Object> len(const vector<shared_ptr<Object>>& objs);
+	static shared_ptr<Object> fold(int64_t opcode, const vector<shared_ptr<Object>>& objs);
+	static shared_ptr<Object> dot(const vector<shared_ptr<Object>>& objs);
+	static shared_ptr<Object> scale(const vector<shared_ptr<Object>>& objs);
+	static shared_ptr<Object> combine(Kernels::Op op, const vector<shared_ptr<Object>>& objs);
+	static shared_ptr<Object> fill(const vector<shared_ptr<Object>>& objs);
+	static shared_ptr<Object> sort_by(Evaluator& evaluator, const shared_ptr<Array>& array, const shared_ptr<Object>& cmp);
+
+	// Checks that objs are an array and a function followed by extra more, see Evaluator::Callback::check
+	static shared_ptr<Object> higher_order(const vector<shared_ptr<Object>>& objs, size_t extra);
+	// The element i as an object of its own, written into box instead when only the caller holds it
+	static void argument(const Array& array, size_t i, shared_ptr<Object>& box);
+	// Folds the elements from first up to last into accumulated
+	static shared_ptr<Object> accumulate(Evaluator::Callback& callback, const Array& array, size_t first, size_t last, shared_ptr<Object> accumulated);
+
+	// The number of runs count elements are split into: the first element alone, then a few runs for
+	// every thread of the pool so that the threads finishing early have some to steal
+	static size_t runs(size_t count);
+	// Runs run over every run of count elements, the first one on the calling thread, which leaves
+	// the feedback the workers only read in the tree, and the others on the pool, each thread in a
+	// worker Evaluator of its own. Sets error to the error of the first run that failed. Returns false
+	// without running anything when the evaluator does not use threads or Sharing does not allow objs
+	// on several threads, and when a worker met an object it would have had to change, after which the
+	// caller runs everything again on its own thread.
+	static bool in_parallel(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs, size_t count, const Run& run, shared_ptr<Object>& error);
+
+	// Returns an error unless objs are a string and two integers, which are cut to the string as
+	// from and to of slice
+	static shared_ptr<Object> string_arguments(const vector<shared_ptr<Object>>& objs, bool count, size_t& from, size_t& to);
+	// Returns an error unless objs are a map, or an ordered map when ordered, followed by extra more
+	// arguments, the first keys of them keys the map may have
+	static shared_ptr<Object> map_arguments(const vector<shared_ptr<Object>>& objs, size_t extra, size_t keys, bool ordered = false);
+	// The error of a key the ordered map does not accept, what names where it came from
+	static shared_ptr<Object> key_error(const OrderedMap& map, const Object& key, const string& what);
+
+	// Returns an error when obj is not an array of numbers
+	static shared_ptr<Object> numbers(const shared_ptr<Object>& obj, const string& position, Numbers& result);
+	static shared_ptr<Object> pair(const vector<shared_ptr<Object>>& objs, Numbers& a, Numbers& b);
 };
 
 
@@ -3,11 +3,17 @@
 #include "ast/BoolExpr.hpp"
 #include "ast/IfExpr.hpp"
 #include "ast/IdentifierExpr.hpp"
+#include "ast/InfixExpr.hpp"
 #include "ast/ExpressionsStat.hpp"
 #include "ast/Program.hpp"
 #include "ast/BlockStat.hpp"
 #include "ast/IndexExpr.hpp"
 #include "ast/AssignExpr.hpp"
+#include "ast/FunctionExpr.hpp"
+#include "ast/WhileStat.hpp"
+#include "ast/ForStat.hpp"
+#include "ast/InvariantExpr.hpp"
+#include "ast/TempExpr.hpp"
 #include "object/basic/Object.h"
 #include "object/Bool.hpp"
 #include "object/Null.hpp"
@@ -15,17 +21,89 @@
 #include "object/Environment.hpp"
 #include "object/BuiltinFun.hpp"
 #include "object/Array.hpp"
+#include "object/Map.hpp"
+#include "object/OrderedMap.hpp"
 #include "object/Integer.hpp"
+#include "object/Float.hpp"
+#include "jit/Jit.h"
+#include <thread>
 
 namespace li
 {
 
+namespace aot
+{
+class Runtime;
+}
+
+namespace closure
+{
+class Compiler;
+}
+
 
 class Evaluator
 {
+	// The runtime of translated programs performs the same operations on objects
+	friend class aot::Runtime;
+	friend class closure::Compiler;
+	// Builtins taking functions call them as calls from the program do
+	friend class BuiltinFuns;
+
+public:
+	struct Stats
+	{
+		uint64_t calls = 0;
+		uint64_t pooledFrames = 0;		// Calls whose frame came from the frame pool instead of the heap
+		uint64_t invariantHits = 0;		// Loop invariant values reused instead of evaluated again
+		uint64_t reusedValues = 0;		// Values of redundant expressions read from a frame slot
+		uint64_t numericOperations = 0;	// Infix operations evaluated by a numeric specialization proven by the IR
+		uint64_t unboxedValues = 0;		// Numbers of unboxed operations handed to the next one without an object
+		uint64_t nativeStores = 0;		// Numbers of unboxed assignments written into the object of the name
+		uint64_t reusedNumbers = 0;		// Annotated number arguments bound to an object a previous call left
+		uint64_t specializationHits = 0;	// Evaluations of self-specialized nodes and cached identifiers whose guard held
+		uint64_t specializationMisses = 0;	// Guards that failed, a node goes back to the generic path on its first
+		uint64_t uncheckedIndexes = 0;		// Elements read without comparing the index to the length, see RangeAnalysis
+		uint64_t reusedScopes = 0;		// Iterations of for loops run in the scope of the previous iteration
+		uint64_t reusedFrames = 0;		// Calls made by a builtin in the frame of its previous call, see Callback
+		uint64_t parallelRuns = 0;		// Runs of elements pmap and preduce handed to the thread pool
+		uint64_t serialCallbacks = 0;	// Calls of pmap and preduce that ran on the calling thread, see Sharing
+
+		Stats& operator+=(const Stats& other);
+	};
+
 public:
 	shared_ptr<Object> evaluate(shared_ptr<Node> node, shared_ptr<Environment> env);
 
+	const Stats& stats() const
+	{
+		return _stats;
+	}
+
+	// Compile functions and loops to machine code once they ran threshold times, returns false and
+	// keeps interpreting everything where that is not supported
+	bool enable_jit(uint32_t threshold = jit::Jit::DEFAULT_THRESHOLD);
+
+	// Run programs and the bodies of functions translated by closure::Compiler instead of evaluating
+	// them node by node
+	void enable_closures()
+	{
+		_closures = true;
+	}
+
+	// Let pmap and preduce run on ThreadPool::shared even on a machine of a single hardware thread.
+	// They only do elsewhere, the threads turn on atomic reference counting for the whole process.
+	void enable_threads()
+	{
+		_threads = true;
+	}
+
+	// Null unless enable_jit succeeded
+	const jit::Jit* jit() const
+	{
+		return _jit.get();
+	}
+
 public:
 	bool is_true(shared_ptr<Object> obj);
 
@@ -37,13 +115,63 @@ public:
 	static shared_ptr<Object> not_function(const string& type);
 	static shared_ptr<Object> invalid_arguments(const string& msg);
 	static shared_ptr<Object> index_operand_type(const string& left, const string& index);
+	static shared_ptr<Object> nan_key(const string& left);
+	static shared_ptr<Object> range_operand_type(const string& start, const string& end);
+	static shared_ptr<Object> not_iterable(const string& type);
 	static shared_ptr<Bool> bool_to_object(bool value);
+	// Whether obj is one of bool_true, bool_false and null, which stay immutable
+	static bool is_constant(const shared_ptr<Object>& obj);
+	// The object a let or a var binds to value, a var gets a copy of a constant
+	static shared_ptr<Object> declared(shared_ptr<Object> value, bool isMutable);
 	static shared_ptr<Object> repeat_declaration(const string& name);
 	static shared_ptr<Object> access_immutable_var(const string& name);
+	static shared_ptr<Object> annotation_mismatch(const string& name, Annotation annotation, const string& type);
+	static bool is_annotated(Annotation annotation, const shared_ptr<Object>& obj);
+	// A map of the keys and values that alternate in entries, an error when a key is not hashable
+	static shared_ptr<Object> new_map(vector<shared_ptr<Object>> entries);
+	// left[from:to], a view of an array or a slice of a string, a bound that is null is left out
+	static shared_ptr<Object> evaluate_slice(const shared_ptr<Object>& left, const shared_ptr<Object>& from, const shared_ptr<Object>& to);
+
+	// An infix operation on numbers of these types, computed exactly as evaluate_infix_number computes
+	// it without looking at the types or the operator at run time
+	template <NumericOp op, bool leftFloat, bool rightFloat>
+	static shared_ptr<Object> numeric(const shared_ptr<Object>& left, const shared_ptr<Object>& right)
+	{
+		double leftValue = leftFloat ? static_cast<Float&>(*left).value : static_cast<Integer&>(*left).value;
+		double rightValue = rightFloat ? static_cast<Float&>(*right).value : static_cast<Integer&>(*right).value;
+		auto number = [](double value) -> shared_ptr<Object>
+		{
+			if constexpr (leftFloat || rightFloat)
+			{
+				return make_shared<Float>(value);
+			}
+			return make_shared<Integer>(value);
+		};
+
+		if constexpr (op == NumericOp::Add) return number(leftValue + rightValue);
+		else if constexpr (op == NumericOp::Subtract) return number(leftValue - rightValue);
+		else if constexpr (op == NumericOp::Multiply) return number(leftValue * rightValue);
+		else if constexpr (op == NumericOp::Divide) return number(leftValue / rightValue);
+		else if constexpr (op == NumericOp::Remainder) return make_shared<Integer>(static_cast<int64_t>(leftValue) % static_cast<int64_t>(rightValue));
+		else if constexpr (op == NumericOp::Equal) return bool_to_object(leftValue == rightValue);
+		else if constexpr (op == NumericOp::NotEqual) return bool_to_object(leftValue != rightValue);
+		else if constexpr (op == NumericOp::Less) return bool_to_object(leftValue < rightValue);
+		else if constexpr (op == NumericOp::Greater) return bool_to_object(leftValue > rightValue);
+		else if constexpr (op == NumericOp::LessEqual) return bool_to_object(leftValue <= rightValue);
+		else return bool_to_object(leftValue >= rightValue);
+	}
 
 private:
 	shared_ptr<Bool> evaluate_bool(shared_ptr<BoolExpr> node);
-	tuple<shared_ptr<Object>, shared_ptr<Environment>> bind_fun_args_to_objects(shared_ptr<Function> fun, const vector<shared_ptr<Object>>& objects);
+	shared_ptr<Object> bind_fun_args_to_objects(shared_ptr<Function> fun, const vector<shared_ptr<Object>>& objects, shared_ptr<Environment> env);
+	Environment* acquire_frame();
+	void release_frame(Environment* frame);
+	// A copy of the number an argument annotated int or float is bound to, made in one of the spare
+	// numbers when there is one of its type
+	shared_ptr<Object> copy_number(const shared_ptr<Object>& number);
+	// Keeps the numbers the annotated arguments of fun were bound to in a pooled frame as spare
+	// numbers when nothing else holds them any more
+	void keep_numbers(const Function& fun, Environment& frame);
 
 	shared_ptr<Object> evaluate_prefix(const string& operatorName, shared_ptr<Object> right);
 	shared_ptr<Object> evaluate_prefix_bang(shared_ptr<Object> value);
@@ -53,20 +181,208 @@ private:
 	shared_ptr<Object> evaluate_if(shared_ptr<IfExpr> node, shared_ptr<Environment> env);
 	shared_ptr<Object> evaluate_program(shared_ptr<Program> node, shared_ptr<Environment> env);
 	shared_ptr<Object> evaluate_id(shared_ptr<IdentifierExpr> id, shared_ptr<Environment> env);
+	shared_ptr<Object> evaluate_closure(shared_ptr<FunctionExpr> node, shared_ptr<Environment> env);
+	shared_ptr<Object> evaluate_while(shared_ptr<WhileStat> node, shared_ptr<Environment> env);
+	shared_ptr<Object> evaluate_for(shared_ptr<ForStat> node, shared_ptr<Environment> env);
+	shared_ptr<Object> evaluate_invariant(shared_ptr<InvariantExpr> node, shared_ptr<Environment> env);
+	shared_ptr<Object> evaluate_temp(shared_ptr<TempExpr> node, shared_ptr<Environment> env);
 	shared_ptr<Object> evaluate_fun(shared_ptr<Object> fun, const vector<shared_ptr<Object>>& args);
+	shared_ptr<Object> call_function(const shared_ptr<Function>& fun, const vector<shared_ptr<Object>>& args);
+	// Runs the body of fun in the frame its arguments are bound in and checks the result
+	shared_ptr<Object> run_function(Function& fun, const shared_ptr<Environment>& frame);
 	shared_ptr<Object> evaluate_infix_string(shared_ptr<Object> left, const string& operatorName, shared_ptr<Object> right);
 	shared_ptr<Object> evaluate_infix_number(shared_ptr<Object> left, const string& operatorName, shared_ptr<Object> right);
+	shared_ptr<Object> evaluate_infix_numeric(const InfixExpr& node, const shared_ptr<Object>& left, const shared_ptr<Object>& right);
+	shared_ptr<Object> evaluate_infix_numeric(const InfixExpr& node, double left, double right);
+	// Reads the number of an operand of a proven operator into value, computing it without an object
+	// when the operand is unboxed. Returns the error the operand evaluated to, null otherwise.
+	shared_ptr<Object> evaluate_number(const shared_ptr<Expr>& node, bool isFloat, const shared_ptr<Environment>& env, double& value);
+	// Computes a proven arithmetic operator into value without creating its object, before an integer
+	// result is truncated. Returns the error an operand evaluated to, null otherwise.
+	shared_ptr<Object> evaluate_unboxed(const InfixExpr& node, const shared_ptr<Environment>& env, double& value);
+	// Evaluates an unboxed assignment, which writes its number into the object of the name and
+	// evaluates to that object, or assigns as evaluate_assign does when the types turn out to differ
+	shared_ptr<Object> assign_number(const AssignExpr& node, const shared_ptr<Environment>& env);
+
+	// Self-specializing nodes, see Feedback
+	bool guard(Feedback& feedback, Object::Type left, Object::Type right, bool specializable);
+	bool specialize_infix(InfixExpr& node, const Object& left, const Object& right);
 	vector<shared_ptr<Object>> evaluate_exprs(shared_ptr<ExpressionsStat> exprs, shared_ptr<Environment> env);
-	shared_ptr<Object> evaluate_index(shared_ptr<Object> left, shared_ptr<Object> index);
-	shared_ptr<Object> evaluate_index_array(shared_ptr<Array> array, shared_ptr<Integer> index);
+	shared_ptr<Object> evaluate_index(shared_ptr<Object> left, shared_ptr<Object> index, bool consumed);
+	shared_ptr<Object> evaluate_index_array(Array& array, int64_t index, bool consumed);
+	// The value itself, as a boxed array gives its elements, a key the map does not have reads null
+	template <typename Table>
+	shared_ptr<Object> evaluate_index_map(Table& map, const shared_ptr<Object>& key);
+	void box(Array& array);
+	shared_ptr<Object> read(Array& array, size_t i);
 	shared_ptr<Object> evaluate_in_decrement(shared_ptr<Object> id, const string& operatorName, shared_ptr<Environment> env);
 	shared_ptr<Object> evaluate_assign(shared_ptr<Object> id, const string& operatorName, shared_ptr<Object> value, shared_ptr<Environment> env);
 
+	// Reads the element of node, keeping the array and the index it was read with in left and index
+	shared_ptr<Object> evaluate_element(IndexExpr& node, shared_ptr<Environment> env, shared_ptr<Object>& left, shared_ptr<Object>& index);
+	shared_ptr<Object> read_index(IndexExpr& node, const shared_ptr<Object>& left, const shared_ptr<Object>& index);
+	// Assigns to an element read from left at index, a value read from an unboxed array is stored back
+	shared_ptr<Object> assign_element(const shared_ptr<Object>& left, const shared_ptr<Object>& index, const shared_ptr<Object>& element, const string& literal, const string& operatorName, const shared_ptr<Object>& value, shared_ptr<Environment> env);
+	// Assigns to the value of key in a Map or an OrderedMap, which gets the key when it did not have it
+	template <typename Table>
+	shared_ptr<Object> assign_entry(Table& map, const shared_ptr<Object>& key, const shared_ptr<Object>& element, const string& literal, const string& operatorName, const shared_ptr<Object>& value, shared_ptr<Environment> env);
+
+	// Runs body once for every number from iterable up to end, or for every element of the array
+	// iterable when there is no end, with symbol bound to it in a scope nested in env. The count is a
+	// native integer. The scope and the Integer bound to the number are only allocated again when
+	// the previous iteration left them to a closure, a name or an array. Elements are bound as they
+	// are unless copies, see ForStat::copies. Returns the first return value or error of the body.
+	template <typename Body>
+	shared_ptr<Object> iterate(symbol_t symbol, const shared_ptr<Object>& iterable, const shared_ptr<Object>& end, bool copies, const shared_ptr<Environment>& env, Body&& body)
+	{
+		int64_t first = 0;
+		int64_t last = 0;
+		Array* array = nullptr;
+		if (end)
+		{
+			if (iterable->type != Object::Type::Integer || end->type != Object::Type::Integer)
+			{
+				return range_operand_type(iterable->typeName(), end->typeName());
+			}
+			first = static_cast<Integer&>(*iterable).value;
+			last = static_cast<Integer&>(*end).value;
+		}
+		else
+		{
+			if (iterable->type != Object::Type::Array)
+			{
+				return not_iterable(iterable->typeName());
+			}
+			// Elements the body appends are not visited
+			array = static_cast<Array*>(iterable.get());
+			if (!copies)
+			{
+				box(*array);
+			}
+			last = static_cast<int64_t>(array->size());
+		}
+
+		shared_ptr<Environment> scope;
+		shared_ptr<Integer> number;
+		for (int64_t i = first; i < last; i++)
+		{
+			if (!scope || scope.use_count() != 1)
+			{
+				scope = make_shared<Environment>(env, Environment::Kind::Scope);
+				number.reset();
+			}
+			else
+			{
+				_stats.reusedScopes++;
+				if (scope->size() != 1)
+				{
+					scope->unbind();
+				}
+			}
+
+			auto* slot = scope->find(symbol);
+			if (slot != nullptr)
+			{
+				slot->reset();
+			}
+
+			// The body may have boxed the array or given a view elements of its own
+			size_t from = 0;
+			const Array* source = array ? &array->storage(from) : nullptr;
+			shared_ptr<Object> value;
+			if (source && source->kind != Array::Kind::Integer)
+			{
+				value = array->get(i);
+			}
+			else
+			{
+				if (!number || number.use_count() != 1)
+				{
+					number = make_shared<Integer>(i);
+				}
+				number->value = source ? source->integers[from + i] : i;
+				number->isMutable = false;
+				value = number;
+			}
+
+			if (slot != nullptr)
+			{
+				*slot = move(value);
+			}
+			else
+			{
+				scope->add(symbol, move(value));
+			}
+
+			auto result = body(scope);
+			if (result && (result->type == Object::Type::ReturnValue || result->type == Object::Type::Error))
+			{
+				return result;
+			}
+		}
+		return null;
+	}
+
+	// A function a builtin calls once for every element. A frame from the pool is set up for it once
+	// and only the arguments are bound again for every call. They are bound as they are, so the
+	// caller passes objects nothing else holds, which it may reuse once they are held by it alone.
+	class Callback
+	{
+	public:
+		Callback(Evaluator& evaluator, const shared_ptr<Object>& fun);
+		~Callback();
+
+		// An error unless fun, the second argument of the builtin, is a function taking arity arguments
+		shared_ptr<Object> check(size_t arity) const;
+
+		shared_ptr<Object> call(const vector<shared_ptr<Object>>& args);
+
+	private:
+		Evaluator& _evaluator;
+		shared_ptr<Object> _fun;
+		Function* _function = nullptr;		// Null for a builtin
+		Environment* _frame = nullptr;		// Null when closures may keep the frame of a call
+		shared_ptr<Environment> _env;
+		bool _used = false;
+	};
+
 public:
 	static const shared_ptr<Bool> bool_true;
 	static const shared_ptr<Bool> bool_false;
 	static const shared_ptr<Null> null;
 	static const map<string, shared_ptr<BuiltinFun>> builtinFuns;
+
+private:
+	struct CachedValue
+	{
+		shared_ptr<Object> value;
+		uint64_t version = 0;
+	};
+
+	// The invariant values of one execution of a loop
+	struct LoopActivation
+	{
+		const WhileStat* loop;
+		vector<CachedValue> values;
+	};
+
+private:
+	Stats _stats;
+	vector<unique_ptr<Environment>> _framePool;
+	static const size_t MAX_SPARE_NUMBERS = 64;
+	vector<shared_ptr<Object>> _spareNumbers;	// Integers and floats no binding holds, see keep_numbers
+	vector<LoopActivation> _loops;
+	uint64_t _mutations = 1;		// Bumped by every assignment, increment and decrement
+	uint64_t _reshapes = 1;		// Bumped by assignments that may change the length or the function of an object
+	unique_ptr<jit::Jit> _jit;
+	FunctionExpr* _running = nullptr;	// The expression of the function being called, null at the top level
+	bool _closures = false;
+	bool _threads = thread::hardware_concurrency() > 1;
+
+	// A worker evaluates functions on a thread of the pool alongside others, see BuiltinFuns::pmap.
+	// It leaves the feedback and caches of the tree as they are and only reads immutable arrays.
+	bool _shared = false;
+	bool _conflict = false;		// Whether a worker copied an object instead of making it mutable
 };
 
 
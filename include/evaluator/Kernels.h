@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace li
+{
+
+
+// Loops over the unboxed elements of numeric arrays for the builtins. On x86-64 they run on AVX2
+// when the processor has it and on SSE2 otherwise, elsewhere they are plain loops. Integers wrap
+// around on overflow, and floats may be summed in another order than one by one.
+class Kernels
+{
+public:
+	enum class Op
+	{
+		Add, Sub, Mul
+	};
+
+public:
+	static int64_t sum(const int64_t* a, size_t n);
+	static double sum(const double* a, size_t n);
+
+	// n must not be 0
+	static int64_t min(const int64_t* a, size_t n);
+	static double min(const double* a, size_t n);
+	static int64_t max(const int64_t* a, size_t n);
+	static double max(const double* a, size_t n);
+
+	static int64_t dot(const int64_t* a, const int64_t* b, size_t n);
+	static double dot(const double* a, const double* b, size_t n);
+
+	// out[i] = a[i] op b[i]
+	static void combine(Op op, const int64_t* a, const int64_t* b, int64_t* out, size_t n);
+	static void combine(Op op, const double* a, const double* b, double* out, size_t n);
+
+	// out[i] = a[i] * k
+	static void scale(const int64_t* a, int64_t k, int64_t* out, size_t n);
+	static void scale(const double* a, double k, double* out, size_t n);
+
+	// The instruction set the kernels run on: "avx2", "sse2" or "scalar"
+	static const char* isa();
+
+	// Sorts by less with std::sort. From parallelSize elements on, runs of the array are sorted on
+	// threads of their own and merged pairwise, so less must be safe to call from several threads.
+	template <typename T, typename Less>
+	static void sort(T* a, size_t n, Less less);
+
+	static constexpr size_t parallelSize = 1 << 17;
+};
+
+template <typename T, typename Less>
+void Kernels::sort(T* a, size_t n, Less less)
+{
+	// Every thread gets at least half of parallelSize elements
+	size_t threads = n < parallelSize ? 1 : std::min<size_t>(std::thread::hardware_concurrency(), n / (parallelSize / 2));
+	if (threads < 2)
+	{
+		std::sort(a, a + n, less);
+		return;
+	}
+
+	std::vector<size_t> bounds;
+	for (size_t i = 0; i < threads; i++)
+	{
+		bounds.push_back(n * i / threads);
+	}
+	bounds.push_back(n);
+
+	std::vector<std::thread> workers;
+	for (size_t i = 0; i + 1 < bounds.size(); i++)
+	{
+		size_t first = bounds[i], last = bounds[i + 1];
+		workers.emplace_back([=] { std::sort(a + first, a + last, less); });
+	}
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+
+	// Halves the number of runs every round, a run left without a neighbour waits for the next one
+	while (bounds.size() > 2)
+	{
+		std::vector<size_t> merged;
+		workers.clear();
+		for (size_t i = 0; i + 2 < bounds.size(); i += 2)
+		{
+			size_t first = bounds[i], middle = bounds[i + 1], last = bounds[i + 2];
+			workers.emplace_back([=] { std::inplace_merge(a + first, a + middle, a + last, less); });
+			merged.push_back(first);
+		}
+		if (bounds.size() % 2 == 0)
+		{
+			merged.push_back(bounds[bounds.size() - 2]);
+		}
+		merged.push_back(bounds.back());
+
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+		bounds = std::move(merged);
+	}
+}
+
+
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "object/Function.hpp"
+#include <unordered_set>
+
+namespace li
+{
+
+
+// Decides whether functions may be called on several threads at once, each thread evaluating in
+// an Evaluator of its own. They may when no code they can reach assigns, increments or decrements
+// a name it did not declare, or prints, and every object of the program that code reads through a
+// name is immutable, so the threads only share what none of them changes. Functions translated
+// ahead of time can not be looked into and never may.
+class Sharing
+{
+public:
+	// Whether the functions in obj, which the threads get copies of, may be called on them. Once
+	// they may, every name their code declares is marked local as their first calls would mark it.
+	static bool check(const shared_ptr<Object>& obj);
+
+private:
+	struct Context
+	{
+		unordered_set<const FunctionExpr*> visited;
+		vector<symbol_t> locals;		// Declared by the code reached
+	};
+
+	// read when the threads read obj itself rather than copies of it
+	static bool value(const shared_ptr<Object>& obj, bool read, Context& context);
+	static bool function(const Function& fun, Context& context);
+	static bool code(const shared_ptr<Node>& node, const Function& fun, const unordered_set<symbol_t>& declared, Context& context);
+	static bool name(symbol_t symbol, const string& text, const Function& fun, Context& context);
+	static void declarations(const shared_ptr<Node>& node, unordered_set<symbol_t>& declared);
+	// The name an assignment to target changes, None when it is no name or an element of one
+	static symbol_t root(const shared_ptr<Expr>& target);
+};
+
+
+}
\ No newline at end of file
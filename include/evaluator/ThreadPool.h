@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace li
+{
+
+
+// Threads running the tasks of parallel loops. A run deals its tasks out to the queues of the
+// threads in contiguous blocks. Every thread takes the tasks of its own queue from the front and,
+// once that is empty, steals from the back of the others, so a thread that finishes its block
+// early takes over the rest of a slower one.
+class ThreadPool
+{
+public:
+	// Called with the index of a task and the thread running it, which is below size()
+	using Task = std::function<void(size_t index, size_t worker)>;
+
+public:
+	explicit ThreadPool(size_t threads);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// A pool of a thread per hardware thread, started on first use
+	static ThreadPool& shared();
+
+	// Whether the calling thread is a thread of any pool
+	static bool inside();
+
+	// Runs task for every index below count and returns once all of them finished. One run is
+	// in progress at a time. A run started by a thread of the pool runs on that thread alone.
+	void run(size_t count, const Task& task);
+
+	size_t size() const
+	{
+		return _threads.size();
+	}
+
+	// Tasks a thread took from the queue of another one
+	uint64_t steals() const
+	{
+		return _steals;
+	}
+
+private:
+	struct Queue
+	{
+		std::mutex lock;
+		std::deque<size_t> tasks;
+	};
+
+	void work(size_t worker);
+	bool take(size_t worker, size_t& index);
+
+private:
+	std::vector<std::thread> _threads;
+	std::vector<std::unique_ptr<Queue>> _queues;
+	std::mutex _running;				// Held for the whole of a run
+	std::mutex _lock;					// Guards _pending and _stop and orders the waits
+	std::condition_variable _wake;		// Tasks were queued or the pool stops
+	std::condition_variable _done;		// The last task of the run finished
+	const Task* _task = nullptr;
+	std::atomic<size_t> _queued{ 0 };	// Tasks in the queues
+	size_t _pending = 0;				// Tasks of the run that did not finish
+	bool _stop = false;
+	std::atomic<uint64_t> _steals{ 0 };
+};
+
+
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "ir/IR.h"
+#include "ast/IfExpr.hpp"
+#include "ast/WhileStat.hpp"
+
+namespace li::ir
+{
+
+
+// Builds the SSA form of the top-level code of a program and of every function it contains. Each
+// let, var and argument defines a value, phis merge the values a name may be bound to where control
+// flow joins. A while body is a new scope on every iteration, an if shares the enclosing scope.
+class Builder
+{
+public:
+	static unique_ptr<Module> build(shared_ptr<Program> program);
+
+private:
+	struct Scope
+	{
+		size_t id;
+		BasicBlock* entry;		// Names of the scope are unbound on entry
+	};
+
+	struct PendingPhi
+	{
+		Instruction* phi;
+		symbol_t symbol;
+		size_t level;
+	};
+
+	Builder(Module& module, Function& function) : _module(module), _function(function) {}
+
+	void build_function(const vector<shared_ptr<Stat>>& statements);
+	Instruction* build_statements(const vector<shared_ptr<Stat>>& statements);
+	Instruction* build_statement(const shared_ptr<Stat>& stat, bool last);
+	Instruction* build_expr(const shared_ptr<Expr>& expr, bool statement = false);
+	Instruction* build_condition(const shared_ptr<Expr>& condition);
+	Instruction* build_if(const shared_ptr<IfExpr>& node, bool statement);
+	void build_while(const shared_ptr<WhileStat>& node);
+	Instruction* build_closure(const shared_ptr<FunctionExpr>& node);
+
+	Instruction* emit(Opcode opcode, shared_ptr<Node> origin, vector<Instruction*> operands = {});
+	Instruction* null_constant();
+	void branch(Instruction* condition, BasicBlock* consequence, BasicBlock* alternative);
+	void jump(BasicBlock* target);
+	BasicBlock* sealed_block();
+
+	// SSA construction after Braun et al., "Simple and Efficient Construction of Static Single Assignment
+	// Form", where a variable is a name in one scope. A name unbound in a scope resolves in the scope
+	// around it, or outside of the function for the outermost scope.
+	static uint64_t key(size_t scope, symbol_t symbol)
+	{
+		return (static_cast<uint64_t>(scope) << 32) | symbol;
+	}
+
+	void write(symbol_t symbol, size_t level, BasicBlock* block, Instruction* value);
+	Instruction* read(symbol_t symbol, size_t level, BasicBlock* block);
+	Instruction* read_recursive(symbol_t symbol, size_t level, BasicBlock* block);
+	Instruction* read_outside(symbol_t symbol, size_t level, BasicBlock* block);
+	Instruction* create_phi(BasicBlock* block);
+	void add_phi_operands(Instruction* phi, symbol_t symbol, size_t level);
+	void seal(BasicBlock* block);
+
+private:
+	Module& _module;
+	Function& _function;
+	BasicBlock* _current = nullptr;
+
+	vector<Scope> _scopes;
+	size_t _scopeCount = 0;
+	vector<BasicBlock*> _loops;		// Headers of the enclosing loops, where a return in their body continues
+
+	unordered_map<uint64_t, unordered_map<BasicBlock*, Instruction*>> _defs;
+	unordered_set<BasicBlock*> _sealed;
+	unordered_map<BasicBlock*, vector<PendingPhi>> _pending;
+	unordered_map<symbol_t, Instruction*> _outer;
+	unordered_map<uint64_t, vector<const Stat*>> _declarations;
+
+	const Stat* _statement = nullptr;
+	shared_ptr<Expr> _condition;	// Outermost if or while condition being built
+	size_t _ifValues = 0;			// Depth of ifs whose value an expression consumes
+	string _bindingName;			// Name of the let or var whose value is being built
+
+	vector<pair<Function*, shared_ptr<FunctionExpr>>> _nested;
+};
+
+
+}
\ No newline at end of file
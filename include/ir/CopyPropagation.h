@@ -0,0 +1,24 @@
+#pragma once
+
+#include "ir/PassManager.h"
+
+namespace li::ir
+{
+
+
+// Replaces phis whose operands are all the same value, or the phi itself, by that value, and removes
+// phis and synthesized constants nothing uses. The builder binds a let or var to the value it is
+// initialized with, so these phis are the only copies left in the SSA form.
+class CopyPropagation : public Pass
+{
+public:
+	string name() const override
+	{
+		return "copy propagation";
+	}
+
+	size_t run(Function& function) override;
+};
+
+
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "ir/PassManager.h"
+
+namespace li::ir
+{
+
+
+// Drops statements whose only effect is a store nothing observes: declarations in a function body
+// whose binding is never read, and assignments of a scalar that the next instruction of the block
+// overwrites with nothing read in between. The dropped statement must not be able to fail, an
+// error would have ended the block at that point.
+class DeadStoreElimination : public Pass
+{
+public:
+	string name() const override
+	{
+		return "dead store elimination";
+	}
+
+	size_t run(Function& function) override;
+
+private:
+	size_t dead_declarations(Function& function);
+	size_t dead_assignments(Function& function);
+	void drop(Function& function, const Stat* statement);
+
+	// Whether nothing outside of statement uses the values it computes
+	static bool self_contained(const Function& function, const Stat* statement, const unordered_map<Instruction*, vector<Instruction*>>& users);
+};
+
+
+}
\ No newline at end of file
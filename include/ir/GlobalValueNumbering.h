@@ -0,0 +1,30 @@
+#pragma once
+
+#include "ir/PassManager.h"
+
+namespace li::ir
+{
+
+
+// Dominator based value numbering of operators and index reads. Every effect starts a new memory
+// version, and so do blocks where versions from different paths or a loop back edge meet, so two
+// instructions are equal only if they read the same objects in the same state. A redundant
+// instruction reuses the object of the one dominating it, which is only done when every use
+// consumes the object on the spot, since an object that is bound to a name may be changed later.
+class GlobalValueNumbering : public Pass
+{
+public:
+	string name() const override
+	{
+		return "global value numbering";
+	}
+
+	size_t run(Function& function) override;
+
+private:
+	static string operand_key(const Instruction* operand);
+	static bool consumed(Instruction* inst, const unordered_map<Instruction*, vector<Instruction*>>& users);
+};
+
+
+}
\ No newline at end of file
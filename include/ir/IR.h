@@ -0,0 +1,179 @@
+#pragma once
+
+#include "ast/Program.hpp"
+#include "ast/FunctionExpr.hpp"
+#include "ast/InfixExpr.hpp"
+#include "lexer/SymbolTable.h"
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace li::ir
+{
+
+using namespace std;
+
+
+// Static type of the object a value refers to. Assignments change objects in place but never
+// their type, so the type of a value holds for as long as the object lives.
+enum class Type
+{
+	Unknown,		// Nothing is known yet, the bottom of the lattice
+	Null, Integer, Float, Bool, String, Array, Function,
+	Any				// May be of several types, the top of the lattice
+};
+
+string type_name(Type type);
+Type annotated_type(Annotation annotation);
+Type join(Type left, Type right);
+bool is_number(Type type);
+
+enum class Opcode
+{
+	Const,			// Literal, every execution creates a new object
+	Param,			// Copy of an argument made by the call
+	Outer,			// Binding of a name outside the function, resolved by name and possibly missing
+	Phi,
+	Prefix,
+	Infix,
+	Index,
+	Array,
+	Closure,
+	Call,
+	Check,			// The operand, if it refers to an object of the annotated type, fails otherwise
+	Declare,		// Binds a name in the innermost scope, no value
+	Assign,
+	InDecrement,
+	Jump,
+	Branch,			// Jumps to the first target if the condition is true, otherwise to the second
+	Return
+};
+
+string opcode_name(Opcode opcode);
+
+class BasicBlock;
+class Function;
+
+// Values are objects rather than bindings: a name is bound once per scope, so a binding is an SSA
+// value, while assignments are effects on the object a value refers to
+class Instruction
+{
+public:
+	Instruction(Opcode opcode, size_t id) : opcode(opcode), id(id) {}
+
+	bool has_value() const;
+	bool is_terminator() const;
+
+	// Whether the instruction may change an object, a binding or the control flow
+	bool has_effect() const;
+
+	// Whether the instruction reads the contents of objects that an effect may change
+	bool reads_memory() const;
+
+public:
+	Opcode opcode;
+	size_t id;
+	vector<Instruction*> operands;
+	vector<BasicBlock*> targets;		// Jump and Branch, or the incoming blocks of a Phi in the order of operands
+	string op;							// Operator of Prefix, Infix, Assign and InDecrement
+	symbol_t symbol = SymbolTable::None;	// Name of Param, Outer and Declare
+	bool isMutable = false;				// Declare by var rather than let
+	size_t index = 0;					// Argument index of Param
+	Function* callee = nullptr;			// Function created by Closure
+	Annotation annotation = Annotation::None;	// Type of an annotated Param, or the one a Check requires
+	Type type = Type::Unknown;
+	BasicBlock* block = nullptr;
+	bool removed = false;
+
+	shared_ptr<Node> origin;			// The AST node the instruction was built from, null if synthesized
+	const Stat* statement = nullptr;	// Innermost statement the instruction was built for
+	bool droppable = false;				// Root of a statement whose removal does not change the value of its block
+	shared_ptr<Expr> condition;			// Root of the if or while condition the instruction is part of
+	NumericOp numericOp = NumericOp::None;	// Specialization of an Infix whose operands are numbers
+	bool unboxed = false;				// A specialized arithmetic Infix only a specialized Infix uses, or an
+										// Assign of a number to a name whose value nothing uses
+};
+
+class BasicBlock
+{
+public:
+	BasicBlock(size_t id) : id(id) {}
+
+	Instruction* terminator() const
+	{
+		return !instructions.empty() && instructions.back()->is_terminator() ? instructions.back() : nullptr;
+	}
+
+public:
+	size_t id;
+	vector<Instruction*> instructions;
+	vector<BasicBlock*> preds;
+	vector<BasicBlock*> succs;
+};
+
+class Function
+{
+public:
+	Function(size_t id, string name) : id(id), name(move(name)) {}
+
+	Instruction* create(Opcode opcode, BasicBlock* block);
+	BasicBlock* create_block();
+	void add_edge(BasicBlock* from, BasicBlock* to);
+
+	// Unlink inst from its block, the object is kept so that AST mappings stay valid
+	void remove(Instruction* inst);
+	void replace_uses(Instruction* from, Instruction* to);
+	unordered_map<Instruction*, vector<Instruction*>> users() const;
+
+	// Blocks reachable from the entry in reverse post order
+	vector<BasicBlock*> reverse_post_order() const;
+	// Immediate dominator of every reachable block, the entry is its own
+	unordered_map<BasicBlock*, BasicBlock*> dominators() const;
+	void remove_unreachable();
+
+	// Value of an expression of the AST, if the expression was built
+	Instruction* value(const Node* expr) const;
+
+	// Whether evaluating expr can not produce an error, judged by the values and types found for it
+	bool cannot_fail(const shared_ptr<Expr>& expr) const;
+
+	// Whether the instruction is reached whenever the condition it is part of is evaluated. A failed
+	// operand ends the evaluation of a condition, which still counts as true since it is an error.
+	bool always_reached(const Instruction* inst) const;
+
+	void print(ostream& out) const;
+
+public:
+	size_t id;
+	string name;
+	shared_ptr<FunctionExpr> node;		// Null for the top-level code of a program
+	BasicBlock* entry = nullptr;
+	vector<unique_ptr<BasicBlock>> blocks;
+	vector<unique_ptr<Instruction>> instructions;
+
+	// Whether the body only uses constructs the builder models, passes skip other functions
+	bool supported = true;
+
+	unordered_map<const Node*, Instruction*> values;		// Value of every built expression
+	unordered_set<symbol_t> nestedReferences;			// Names referenced by functions nested in this one
+	unordered_set<const Stat*> repeated;				// Declarations whose name the same scope declares again
+
+	// Filled in by the passes for lowering
+	unordered_set<const Stat*> droppedStatements;
+	vector<pair<Instruction*, Instruction*>> reuses;	// Redundant instruction and the dominating one it reuses
+};
+
+class Module
+{
+public:
+	Function* create_function(const string& name);
+	void print(ostream& out) const;
+
+public:
+	shared_ptr<Program> program;
+	vector<unique_ptr<Function>> functions;		// The top-level code first
+};
+
+
+}
\ No newline at end of file
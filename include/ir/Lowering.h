@@ -0,0 +1,20 @@
+#pragma once
+
+#include "ir/IR.h"
+
+namespace li::ir
+{
+
+
+// Writes what the passes found back into the AST the evaluator runs: dropped statements are
+// removed from their blocks, specialized operators are marked on their infix expressions, and an
+// expression whose value numbering found an equal one dominating it reads the object that one
+// stored in a TempExpr slot of the running frame.
+class Lowering
+{
+public:
+	static void run(Module& module);
+};
+
+
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "ir/PassManager.h"
+
+namespace li::ir
+{
+
+
+// Specializes the infix operators whose operands type propagation proved to be integers or floats.
+// A value of a known type refers to an object of that type whenever it did not fail, so the
+// evaluator only has to check the operands for errors before reading their numbers. An arithmetic
+// operator whose only user is another specialized operator is marked unboxed: the evaluator hands
+// its number straight to that user, so a chain of them only creates the object it ends with. An
+// assignment to a name proven to be a number whose value nothing uses is marked unboxed too when
+// it keeps the type of the name: the evaluator writes its number into the object of the name,
+// which serves as a native slot, rather than creating another object and copying it in.
+class NumericSpecialization : public Pass
+{
+public:
+	string name() const override
+	{
+		return "numeric specialization";
+	}
+
+	// Returns the number of operators specialized
+	size_t run(Function& function) override;
+
+	// Lists the functions every operator of which was specialized, and how far the others got and
+	// how many of their operators are unboxed
+	static void report(const Module& module, ostream& out);
+
+private:
+	static NumericOp numeric_op(const string& op, Type left, Type right);
+};
+
+
+}
\ No newline at end of file
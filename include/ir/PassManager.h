@@ -0,0 +1,54 @@
+#pragma once
+
+#include "ir/IR.h"
+#include <map>
+
+namespace li::ir
+{
+
+
+class Pass
+{
+public:
+	virtual ~Pass() = default;
+
+	virtual string name() const = 0;
+
+	// Returns the number of changes made to function
+	virtual size_t run(Function& function) = 0;
+};
+
+// Runs passes in the order they were added over every function of a module the builder could model
+class PassManager
+{
+public:
+	// Copy propagation, type propagation, global value numbering, dead store elimination, numeric
+	// specialization and a last copy propagation to clean up after them
+	static unique_ptr<PassManager> standard();
+
+	// Copy propagation, type propagation and numeric specialization, which only find the types of
+	// operands and leave every statement and expression in place
+	static unique_ptr<PassManager> specialization();
+
+	void add(unique_ptr<Pass> pass);
+	void run(Module& module);
+
+	// Changes made by every pass so far, by name
+	const map<string, size_t>& changes() const
+	{
+		return _changes;
+	}
+
+	size_t changes(const string& name) const
+	{
+		auto it = _changes.find(name);
+		return it == _changes.end() ? 0 : it->second;
+	}
+
+private:
+	vector<unique_ptr<Pass>> _passes;
+	map<string, size_t> _changes;
+};
+
+
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "ir/PassManager.h"
+
+namespace li::ir
+{
+
+
+// Forward propagation of the types of values from literals through operators and phis until a fixed
+// point is reached. A type is what a value refers to whenever the instruction did not fail.
+class TypePropagation : public Pass
+{
+public:
+	string name() const override
+	{
+		return "type propagation";
+	}
+
+	// Returns the number of values whose type is known
+	size_t run(Function& function) override;
+
+	static Type infer(const Instruction* inst);
+
+private:
+	static Type infer_infix(const string& op, Type left, Type right);
+};
+
+
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace li::jit
+{
+
+using namespace std;
+
+
+enum class Reg : uint8_t
+{
+	Rax, Rcx, Rdx, Rbx, Rsp, Rbp, Rsi, Rdi,
+	R8, R9, R10, R11, R12, R13, R14, R15
+};
+
+enum class Xmm : uint8_t
+{
+	Xmm0, Xmm1
+};
+
+// Condition codes of jcc and setcc, the unsigned ones are those ucomisd sets
+enum class Condition : uint8_t
+{
+	Below = 0x2, AboveEqual = 0x3, Equal = 0x4, NotEqual = 0x5,
+	BelowEqual = 0x6, Above = 0x7, Parity = 0xA, NotParity = 0xB
+};
+
+// Encodes the few x86-64 instructions the templates of the compiler are made of. Memory operands
+// are always a base register plus a 32-bit displacement.
+class Assembler
+{
+public:
+	// A jump target, jumps emitted before it is bound are patched by bind
+	struct Label
+	{
+		size_t position = SIZE_MAX;
+		vector<size_t> patches;
+	};
+
+public:
+	const vector<uint8_t>& code() const
+	{
+		return _code;
+	}
+
+	size_t position() const
+	{
+		return _code.size();
+	}
+
+	void bind(Label& label);
+	void jmp(Label& label);
+	void jcc(Condition condition, Label& label);
+	void call(Label& label);
+	void ret();
+
+	void push(Reg reg);
+	void pop(Reg reg);
+	void mov(Reg dst, Reg src);
+	void mov(Reg dst, int64_t imm);
+	void mov(Reg dst, Reg base, int32_t disp);
+	void mov(Reg base, int32_t disp, Reg src);
+	void movsd(Xmm dst, Reg base, int32_t disp);
+	void movsd(Reg base, int32_t disp, Xmm src);
+	void movq(Xmm dst, Reg src);
+	void movq(Reg dst, Xmm src);
+	void lea(Reg dst, Reg base, int32_t disp);
+
+	// Returns the position of the immediate, so that a frame size can be patched in later
+	size_t sub(Reg dst, int32_t imm);
+	void add(Reg dst, int32_t imm);
+	void neg(Reg reg);
+	void btc(Reg reg, uint8_t bit);
+	void xor_(Reg reg, int8_t imm);
+	void inc(Reg base, int32_t disp);
+	void dec(Reg base, int32_t disp);
+	void test(Reg left, Reg right);
+	void cqo();
+	void idiv(Reg divisor);
+	void setcc(Condition condition, Reg dst);
+	void and8(Reg dst, Reg src);
+	void or8(Reg dst, Reg src);
+	void movzx8(Reg dst, Reg src);
+
+	void cvtsi2sd(Xmm dst, Reg src);
+	void cvttsd2si(Reg dst, Xmm src);
+	void addsd(Xmm dst, Xmm src);
+	void subsd(Xmm dst, Xmm src);
+	void mulsd(Xmm dst, Xmm src);
+	void divsd(Xmm dst, Xmm src);
+	void ucomisd(Xmm left, Xmm right);
+
+	void patch32(size_t position, int32_t value);
+
+private:
+	void byte(uint8_t value);
+	void imm32(int32_t value);
+	void rex(bool wide, uint8_t reg, uint8_t base);
+	void modrm(uint8_t reg, uint8_t rm);
+	void memory(uint8_t reg, Reg base, int32_t disp);
+	void sse(uint8_t prefix, uint8_t opcode, uint8_t reg, uint8_t rm, bool wide = false);
+	void link(Label& label);
+
+private:
+	vector<uint8_t> _code;
+};
+
+
+}
\ No newline at end of file
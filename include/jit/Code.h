@@ -0,0 +1,71 @@
+#pragma once
+
+#include "object/basic/Object.h"
+#include "lexer/SymbolTable.h"
+#include <cstdint>
+
+// Machine code is only generated for x86-64 Linux, elsewhere --jit leaves everything to the interpreter
+#if defined(__x86_64__) && defined(__linux__)
+#define LI_JIT_SUPPORTED 1
+#else
+#define LI_JIT_SUPPORTED 0
+#endif
+
+namespace li::jit
+{
+
+
+// Machine code of a function or a loop in executable memory. It is specialized to the types of the
+// arguments and of the objects bound to the names it reads from outside, which the caller guards.
+class Code
+{
+public:
+	// Raw bits of the value computed, and whether the object holding it was mutable
+	struct Result
+	{
+		uint64_t value;
+		uint64_t isMutable;
+	};
+
+	// Arguments are passed in reverse order, externals point at the values of the objects
+	using Entry = Result (*)(const uint64_t* args, void* const* externals);
+
+	// A name resolved outside of the compiled code
+	struct External
+	{
+		symbol_t symbol;
+		Object::Type type;
+		bool assigned;		// Whether the code assigns the object, which must then be mutable
+	};
+
+	// Arguments and externals are passed in arrays of at most this many
+	static constexpr size_t MAX_OPERANDS = 16;
+
+public:
+	Code() = default;
+	Code(const Code&) = delete;
+	Code& operator=(const Code&) = delete;
+	~Code();
+
+	// Copies bytes to executable memory, returns false if none can be mapped
+	bool load(const vector<uint8_t>& bytes);
+
+	Result run(const uint64_t* args, void* const* externals) const
+	{
+		return reinterpret_cast<Entry>(_memory)(args, externals);
+	}
+
+public:
+	vector<Object::Type> params;
+	Object::Type result = Object::Type::Null;
+	vector<External> externals;
+	symbol_t self = SymbolTable::None;	// Name a function calls itself by, checked to still be bound to it
+	bool mutates = false;				// Whether the code changes objects bound outside of it
+
+private:
+	void* _memory = nullptr;
+	size_t _size = 0;
+};
+
+
+}
\ No newline at end of file
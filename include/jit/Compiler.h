@@ -0,0 +1,114 @@
+#pragma once
+
+#include "jit/Assembler.h"
+#include "jit/Code.h"
+#include "object/Function.hpp"
+#include "ast/IfExpr.hpp"
+#include "ast/InfixExpr.hpp"
+#include "ast/PrefixExpr.hpp"
+#include "ast/AssignExpr.hpp"
+#include "ast/InDecrementExpr.hpp"
+#include "ast/CallExpr.hpp"
+#include "ast/WhileStat.hpp"
+#include <functional>
+#include <unordered_map>
+
+namespace li::jit
+{
+
+
+// Translates a function or a loop that only computes with integers and floats to x86-64 machine code,
+// one template per node. Every value a template computes is left in rax, or in xmm0 for a float, and
+// a bool is 0 or 1 in rax. Names declared by the code live in its stack frame, names bound outside
+// are read and written in place through pointers to the values of their objects. Numbers are combined
+// through doubles exactly as the evaluator does, so the results are the same bit for bit.
+class Compiler
+{
+public:
+	// Null if the body uses something the templates do not cover, which is left to the interpreter
+	static shared_ptr<Code> compile_function(const Function& fun, const vector<Object::Type>& params);
+	static shared_ptr<Code> compile_loop(const shared_ptr<WhileStat>& loop, const shared_ptr<Environment>& env);
+
+	// The object a name in the body of fun is bound to outside of it, as a call would resolve it
+	static shared_ptr<Object> resolve(const Function& fun, symbol_t symbol);
+
+private:
+	using Resolver = function<shared_ptr<Object>(symbol_t)>;
+
+	struct Variable
+	{
+		Object::Type type;
+		bool isMutable;
+		bool external;
+		size_t index;		// Slot in the frame, or index of the external
+		bool assigned = false;
+	};
+
+	Compiler(Code& code, Resolver resolve, const Function* self) : _code(code), _resolve(move(resolve)), _self(self) {}
+
+	void prologue();
+	void epilogue();
+	void statements(const vector<shared_ptr<Stat>>& statements, bool tail);
+	void statement(const shared_ptr<Stat>& stat, bool tail);
+	void declare(const shared_ptr<IdentifierExpr>& name, Annotation annotation, const shared_ptr<Expr>& value, bool isMutable);
+	void if_(const shared_ptr<IfExpr>& node, bool tail);
+	void while_(const shared_ptr<WhileStat>& node);
+	void condition(const shared_ptr<Expr>& expr, Assembler::Label& otherwise);
+
+	// The value of expr becomes the result of the function
+	void result(const shared_ptr<Expr>& expr);
+	void null_result();
+	int result_flag(const shared_ptr<Expr>& expr);
+
+	Object::Type value(const shared_ptr<Expr>& expr);
+	Object::Type prefix(const PrefixExpr& node);
+	Object::Type infix(const InfixExpr& node);
+	Object::Type assign(const AssignExpr& node);
+	Object::Type in_decrement(const InDecrementExpr& node);
+	Object::Type call(const CallExpr& node);
+
+	// Leaves both operands converted to doubles, the left one in xmm0 and the right one in xmm1
+	pair<Object::Type, Object::Type> operands(const shared_ptr<Expr>& left, const shared_ptr<Expr>& right);
+	Object::Type arithmetic(char operatorName, Object::Type left, Object::Type right);
+	Object::Type comparison(const string& operatorName);
+	void to_double(Object::Type type, Xmm dst);
+	Object::Type load_double(const shared_ptr<Expr>& expr, Xmm dst);
+
+	const Variable* variable(symbol_t symbol);
+	const Variable* lookup_local(symbol_t symbol) const;
+	pair<Reg, int32_t> address(const Variable& variable);
+	void load(const Variable& variable);
+	void store(const Variable& variable);
+	void mark_assigned(const Variable& variable);
+
+	shared_ptr<Expr> unwrap(shared_ptr<Expr> expr);
+	bool is_reference(const shared_ptr<Expr>& expr);
+	bool has_effects(const shared_ptr<Expr>& expr);
+	static bool is_number(Object::Type type);
+	static bool is_annotated(Annotation annotation, Object::Type type);
+
+	Object::Type unsupported();
+
+private:
+	Code& _code;
+	Resolver _resolve;
+	const Function* _self;		// The function compiled, null for a loop
+	Assembler _asm;
+
+	Assembler::Label _entry;
+	Assembler::Label _exit;
+	size_t _frameSize = 0;		// Position of the size of the frame in the prologue
+	size_t _slots = 0;
+	size_t _depth = 0;			// Values pushed by the templates, to align the stack for calls
+
+	vector<unordered_map<symbol_t, Variable>> _scopes;
+	unordered_map<symbol_t, Variable> _externals;
+	vector<Assembler::Label*> _loops;		// Conditions of the enclosing loops, where a return in their body continues
+	bool _outerCondition = false;	// Whether the condition of the loop compiled on its own is compiled
+	bool _declarations = true;		// Whether a declaration here binds a name in the innermost scope for sure
+	bool _supported = true;
+	bool _resultMatches = true;
+};
+
+
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "jit/Code.h"
+#include "object/Function.hpp"
+#include "ast/WhileStat.hpp"
+#include <functional>
+
+namespace li::jit
+{
+
+
+// Counts calls of functions and iterations of loops, compiles those that become hot and runs their
+// machine code. The code is specialized to the types seen when it was compiled, every entry guards
+// them and leaves the call or the loop to the interpreter where they do not hold.
+class Jit
+{
+public:
+	static constexpr uint32_t DEFAULT_THRESHOLD = 1000;
+
+	struct Stats
+	{
+		uint64_t compiledFunctions = 0;
+		uint64_t compiledLoops = 0;
+		uint64_t entries = 0;		// Runs of compiled code
+		uint64_t bailouts = 0;		// Entries whose guards failed, run by the interpreter instead
+	};
+
+public:
+	Jit(uint32_t threshold = DEFAULT_THRESHOLD) : _threshold(threshold) {}
+
+	// Whether machine code can be generated on this platform
+	static bool supported()
+	{
+		return LI_JIT_SUPPORTED;
+	}
+
+	const Stats& stats() const
+	{
+		return _stats;
+	}
+
+	// The result of calling fun with args, null if the call is left to the interpreter
+	shared_ptr<Object> call(const Function& fun, const vector<shared_ptr<Object>>& args);
+
+	// Runs the rest of loop in env, counting the iteration towards running, the function the loop is in.
+	// Returns false if the loop is left to the interpreter.
+	bool run_loop(const shared_ptr<WhileStat>& loop, const shared_ptr<Environment>& env, FunctionExpr* running);
+
+	// Whether the last code run assigned objects bound outside of it
+	bool mutated() const
+	{
+		return _mutated;
+	}
+
+private:
+	bool bind(const Code& code, const function<shared_ptr<Object>(symbol_t)>& resolve, void** externals);
+	static uint64_t bits(const Object& object);
+	static shared_ptr<Object> box(Object::Type type, const Code::Result& result);
+
+private:
+	uint32_t _threshold;
+	Stats _stats;
+	bool _mutated = false;
+};
+
+
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <deque>
+#include <unordered_map>
+#include <cstdint>
+
+namespace li
+{
+
+using namespace std;
+
+using symbol_t = uint32_t;
+
+
+// Interns identifier names into dense integer ids, so that every later lookup
+// compares integers instead of strings. Symbol 0 is reserved for "no symbol".
+class SymbolTable
+{
+public:
+	static constexpr symbol_t None = 0;
+
+public:
+	static symbol_t intern(const string& name);
+	static const string& name(symbol_t symbol);
+
+	static size_t size();
+
+private:
+	// Function-local statics, so interning is safe during static initialization
+	static unordered_map<string, symbol_t>& symbols();
+	static deque<string>& names();
+};
+
+
+}
\ No newline at end of file
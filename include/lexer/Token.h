@@ -1,5 +1,6 @@
 #pragma once
 
+#include "SymbolTable.h"
 #include <string>
 #include <map>
 
@@ -15,10 +16,10 @@ public:
 	enum Type
 	{
 		// special chars
-		Illegal, Eof, Identifier, Semicolon, Comma,
+		Illegal, Eof, Identifier, Semicolon, Comma, Colon,
 		LParen, RParen,
 		LBrace, RBrace, DoubleQuotes,
-		LBracket, RBracket,
+		LBracket, RBracket, Range,
 
 		// types
 		Integer, Float, String,
@@ -30,11 +31,11 @@ public:
 		Increment, Decrement,
 
 		// keywords
-		Let, Var, Fun, True, False, If, Else, Return, While
+		Let, Var, Fun, True, False, If, Else, Return, While, For, In
 	};
 
 public:
-	Token(const string& literal, Token::Type type) : literal(literal), type(type) {}
+	Token(const string& literal, Token::Type type, symbol_t symbol = SymbolTable::None) : literal(literal), type(type), symbol(symbol) {}
 
 public:
 	static string typeName(Type type)
@@ -56,6 +57,7 @@ public:
 public:
 	string literal;
 	Token::Type type;
+	symbol_t symbol;	// Interned name, only set for identifiers
 	static const map<Token::Type, string> typeNames;
 };
 
@@ -1,51 +1,147 @@
 #pragma once
 
 #include "basic/Object.h"
+#include "Integer.hpp"
+#include "Float.hpp"
+#include "Bool.hpp"
+#include "Null.hpp"
 
 namespace li
 {
 
 
+// The elements of an array are kept unboxed in contiguous memory while they are all integers, all
+// floats or all bools no other object refers to. Reading such an element makes a box holding its
+// value, so an array becomes boxed before anything may keep an element it reads, see ElementUses.
+//
+// A view, which a[from:to] makes, holds no elements but shares a range of those of its parent: it
+// reads them as they are in there, and its writes change them. Copying a view copies no elements
+// either, so that a function given a slice of a large array works on it in place. A view of an
+// immutable array copies its elements once it is made mutable and first written, or appended to,
+// and an immutable view of a mutable array copies them at once, as the array may still change.
 class Array : public Object
 {
 public:
-	Array(const vector<shared_ptr<Object>>& elements = {}) : Object(Type::Array), elements(elements) {}
+	enum class Kind
+	{
+		Boxed,
+		Integer,
+		Float,
+		Bool
+	};
+
+public:
+	Array(vector<shared_ptr<Object>> elements = {}) : Object(Type::Array)
+	{
+		kind = elements.empty() ? Kind::Boxed : kind_of(elements.front());
+		for (const auto& element : elements)
+		{
+			if (kind_of(element) != kind)
+			{
+				kind = Kind::Boxed;
+				break;
+			}
+		}
+		if (kind == Kind::Boxed)
+		{
+			this->elements = move(elements);
+			return;
+		}
+		for (const auto& element : elements)
+		{
+			store(element);
+		}
+	}
 
 	string inspect() const override
 	{
 		stringstream buffer;
 		buffer << "[";
-		int i = 0;
-		while (i < elements.size() - 1)
+		for (size_t i = 0; i < size(); i++)
 		{
-			buffer << elements.at(i)->inspect() << ", ";
-			i++;
+			buffer << (i == 0 ? "" : ", ") << get(i)->inspect();
 		}
-		buffer << elements.at(i)->inspect() << "]";
+		buffer << "]";
 		return buffer.str();
 	}
 
+	// A view is copied as another view of its parent
 	shared_ptr<Object> copy() override
 	{
-		auto copied = make_shared<Array>();
-		for (const auto& element : elements)
+		if (parent)
 		{
-			copied->elements.push_back(element->copy());
+			return view(parent, offset, length);
 		}
-		return copied;
+		return owned();
 	}
 
+	// An array with copies of the elements, also of those a view shares
+	shared_ptr<Array> owned() const
+	{
+		size_t from;
+		const auto& source = storage(from);
+		if (source.kind == Kind::Boxed)
+		{
+			vector<shared_ptr<Object>> copied;
+			copied.reserve(size());
+			for (size_t i = from; i < from + size(); i++)
+			{
+				copied.push_back(source.elements[i]->copy());
+			}
+			return make_shared<Array>(move(copied));
+		}
+		return shared_ptr<Array>(new Array(source, from, size()));
+	}
+
+	// Appends the elements of value, sharing them when it is boxed. A view gets elements of its own
+	// first, it can not grow into its parent.
 	void assign(shared_ptr<Object> value) override
 	{
-		for (const auto& element : dynamic_pointer_cast<Array>(value)->elements)
+		auto& other = *dynamic_pointer_cast<Array>(value);
+		size_t from;
+		const auto& source = other.storage(from);
+		size_t count = other.size();
+		if (&source == this || &other == this)
+		{
+			// An array appended to itself appends the elements it had before
+			assign(shared_ptr<Array>(new Array(source, from, count)));
+			return;
+		}
+
+		if (parent)
+		{
+			detach();
+		}
+		if (size() == 0 && kind == Kind::Boxed)
 		{
-			element->isMutable = isMutable;
+			kind = source.kind;
+		}
+		if (kind != Kind::Boxed && kind == source.kind)
+		{
+			switch (kind)
+			{
+			case Kind::Integer: integers.insert(integers.end(), source.integers.begin() + from, source.integers.begin() + from + count); break;
+			case Kind::Float: floats.insert(floats.end(), source.floats.begin() + from, source.floats.begin() + from + count); break;
+			default: bools.insert(bools.end(), source.bools.begin() + from, source.bools.begin() + from + count); break;
+			}
+			return;
+		}
+
+		box();
+		for (size_t i = 0; i < count; i++)
+		{
+			auto element = source.get(from + i);
+			element->setMutable(isMutable);
 			elements.push_back(element);
 		}
 	}
 
 	void setMutable(bool isMutable) override
 	{
+		if (parent && !isMutable && parent->isMutable)
+		{
+			detach();
+		}
 		Object::setMutable(isMutable);
 		for (auto& element : elements)
 		{
@@ -53,8 +149,265 @@ public:
 		}
 	}
 
+	// A view of the count elements of array from from, which must all be in it, as mutable as it
+	static shared_ptr<Array> view(const shared_ptr<Array>& array, size_t from, size_t count)
+	{
+		auto shared = make_shared<Array>();
+		shared->parent = array->parent ? array->parent : array;
+		shared->offset = array->parent ? array->offset + from : from;
+		shared->length = count;
+		shared->isMutable = array->isMutable;
+		return shared;
+	}
+
+	bool isView() const
+	{
+		return parent != nullptr;
+	}
+
+	// The array holding the elements, which is the parent of a view, and the index of the first
+	// of them in there. Only it has kind and the vectors of the elements.
+	const Array& storage(size_t& from) const
+	{
+		from = parent ? offset : 0;
+		return parent ? *parent : *this;
+	}
+
+	// The array to change the element i in, the parent of a view unless that is immutable, when the
+	// view gets elements of its own first. i becomes the index of the element in there.
+	Array& writable(size_t& i)
+	{
+		if (parent && isMutable && !parent->isMutable)
+		{
+			detach();
+		}
+		if (!parent)
+		{
+			return *this;
+		}
+		i += offset;
+		return *parent;
+	}
+
+	size_t size() const
+	{
+		if (parent)
+		{
+			return length;
+		}
+		switch (kind)
+		{
+		case Kind::Integer: return integers.size();
+		case Kind::Float: return floats.size();
+		case Kind::Bool: return bools.size();
+		default: return elements.size();
+		}
+	}
+
+	// The element i, which must be in range, or a new box of its value when it is unboxed
+	shared_ptr<Object> get(size_t i) const
+	{
+		if (parent)
+		{
+			return parent->get(offset + i);
+		}
+		shared_ptr<Object> boxed;
+		switch (kind)
+		{
+		case Kind::Integer: boxed = make_shared<li::Integer>(integers[i]); break;
+		case Kind::Float: boxed = make_shared<li::Float>(floats[i]); break;
+		case Kind::Bool: return li::Bool::constant(bools[i]);
+		default: return elements[i];
+		}
+		boxed->isMutable = isMutable;
+		return boxed;
+	}
+
+	// The element i as get returns it, except that the value of an unboxed number is written into
+	// the box the previous read made when nothing holds that box any more. A view has a box of its
+	// own, it never hands out the one of its parent.
+	shared_ptr<Object> read(size_t i)
+	{
+		size_t from;
+		const auto& source = storage(from);
+		if (source.kind != Kind::Integer && source.kind != Kind::Float)
+		{
+			return get(i);
+		}
+		if (!scratch || scratch.use_count() != 1 || (scratch->type == Type::Integer) != (source.kind == Kind::Integer))
+		{
+			scratch = get(i);
+			return scratch;
+		}
+		if (source.kind == Kind::Integer)
+		{
+			static_cast<li::Integer&>(*scratch).value = source.integers[from + i];
+		}
+		else
+		{
+			static_cast<li::Float&>(*scratch).value = source.floats[from + i];
+		}
+		scratch->isMutable = source.isMutable;
+		return scratch;
+	}
+
+	// Replaces the element i with value. An unboxed array keeps the value of a number or bool of its
+	// kind and becomes boxed for anything else, a boxed one keeps a copy of value.
+	void set(size_t i, const shared_ptr<Object>& value)
+	{
+		auto& target = writable(i);
+		if (&target != this)
+		{
+			target.set(i, value);
+			return;
+		}
+		switch (kind)
+		{
+		case Kind::Integer:
+			if (value->type == Type::Integer)
+			{
+				integers[i] = static_cast<li::Integer&>(*value).value;
+				return;
+			}
+			break;
+
+		case Kind::Float:
+			if (value->type == Type::Float)
+			{
+				floats[i] = static_cast<li::Float&>(*value).value;
+				return;
+			}
+			break;
+
+		case Kind::Bool:
+			if (value->type == Type::Bool)
+			{
+				bools[i] = static_cast<li::Bool&>(*value).value;
+				return;
+			}
+			break;
+
+		default:
+			break;
+		}
+
+		box();
+		if (value->type == Type::Bool)
+		{
+			elements[i] = li::Bool::constant(static_cast<li::Bool&>(*value).value);
+			return;
+		}
+		// A constant replaced is as mutable as the array
+		bool origin = is_constant(elements[i]) ? isMutable : elements[i]->isMutable;
+		elements[i] = value->copy();
+		elements[i]->isMutable = origin;
+	}
+
+	// Moves unboxed elements into objects of their own, which they keep from then on
+	void box()
+	{
+		if (parent && isMutable && !parent->isMutable)
+		{
+			detach();
+		}
+		if (parent)
+		{
+			parent->box();
+			return;
+		}
+		if (kind == Kind::Boxed) return;
+
+		vector<shared_ptr<Object>> boxed;
+		boxed.reserve(size());
+		for (size_t i = 0; i < size(); i++)
+		{
+			boxed.push_back(get(i));
+			boxed.back()->setMutable(isMutable);
+		}
+		elements = move(boxed);
+		integers = {};
+		floats = {};
+		bools = {};
+		scratch.reset();
+		kind = Kind::Boxed;
+	}
+
+private:
+	// The count elements of array from from, which is not a view, sharing the boxed ones
+	Array(const Array& array, size_t from, size_t count) : Object(Type::Array)
+	{
+		kind = array.kind;
+		switch (kind)
+		{
+		case Kind::Integer: integers.assign(array.integers.begin() + from, array.integers.begin() + from + count); break;
+		case Kind::Float: floats.assign(array.floats.begin() + from, array.floats.begin() + from + count); break;
+		case Kind::Bool: bools.assign(array.bools.begin() + from, array.bools.begin() + from + count); break;
+		default: elements.assign(array.elements.begin() + from, array.elements.begin() + from + count); break;
+		}
+	}
+
+	// Gives a view copies of the elements it shared, as mutable as it, and no parent
+	void detach()
+	{
+		auto own = owned();
+		parent.reset();
+		kind = own->kind;
+		elements = move(own->elements);
+		integers = move(own->integers);
+		floats = move(own->floats);
+		bools = move(own->bools);
+		for (auto& element : elements)
+		{
+			element->setMutable(isMutable);
+		}
+	}
+
+	// Whether element is one of the bool constants or the null constant, which are never assigned
+	static bool is_constant(const shared_ptr<Object>& element)
+	{
+		switch (element->type)
+		{
+		case Type::Bool: return element == li::Bool::constant(static_cast<li::Bool&>(*element).value);
+		case Type::Null: return element == li::Null::constant();
+		default: return false;
+		}
+	}
+
+	// Numbers are only unboxed when nothing else holds them, bools when they are the shared constants
+	static Kind kind_of(const shared_ptr<Object>& element)
+	{
+		switch (element->type)
+		{
+		case Type::Integer: return element.use_count() == 1 ? Kind::Integer : Kind::Boxed;
+		case Type::Float: return element.use_count() == 1 ? Kind::Float : Kind::Boxed;
+		case Type::Bool: return is_constant(element) ? Kind::Bool : Kind::Boxed;
+		default: return Kind::Boxed;
+		}
+	}
+
+	void store(const shared_ptr<Object>& element)
+	{
+		switch (kind)
+		{
+		case Kind::Integer: integers.push_back(static_cast<li::Integer&>(*element).value); break;
+		case Kind::Float: floats.push_back(static_cast<li::Float&>(*element).value); break;
+		case Kind::Bool: bools.push_back(static_cast<li::Bool&>(*element).value); break;
+		default: elements.push_back(element); break;
+		}
+	}
+
 public:
-	vector<shared_ptr<Object>> elements;
+	Kind kind = Kind::Boxed;					// Boxed for a view, see storage
+	vector<shared_ptr<Object>> elements;		// Only while boxed
+	vector<int64_t> integers;
+	vector<double> floats;
+	vector<bool> bools;
+
+private:
+	shared_ptr<Object> scratch;		// The box of the last number read
+	shared_ptr<Array> parent;		// Only of a view, which shares length elements of it from offset
+	size_t offset = 0;
+	size_t length = 0;
 };
 
 
@@ -11,6 +11,22 @@ class Bool : public Object
 public:
 	Bool(bool value = false) : Object(Type::Bool), value(value) {}
 
+	// The objects every bool expression and comparison evaluates to
+	static const shared_ptr<Bool>& constant(bool value)
+	{
+		static const shared_ptr<Bool> constants[] = { make_shared<Bool>(false), make_shared<Bool>(true) };
+		return constants[value];
+	}
+
+	// The constants stay immutable, a name that may be assigned holds a copy of them
+	void setMutable(bool isMutable) override
+	{
+		if (this != constant(value).get())
+		{
+			Object::setMutable(isMutable);
+		}
+	}
+
 	string inspect() const override
 	{
 		return value ? "true" : "false";
@@ -7,10 +7,13 @@ namespace li
 {
 
 
+class Evaluator;
+
 class BuiltinFun : public Object
 {
 public:
-	using built_in_fun = function<shared_ptr<Object>( const vector<shared_ptr<Object>>& )>;
+	// The evaluator calling it, through which it may call the functions it is given
+	using built_in_fun = function<shared_ptr<Object>( Evaluator& evaluator, const vector<shared_ptr<Object>>& )>;
 
 public:
 	BuiltinFun(const built_in_fun& fun = {}, const string& inspectText = "") : Object(Type::BuiltinFun), fun(fun), inspectText(inspectText) {}
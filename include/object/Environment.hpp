@@ -1,49 +1,267 @@
 #pragma once
 
 #include "basic/Object.h"
+#include "lexer/SymbolTable.h"
+#include <atomic>
 
 namespace li
 {
 
 
+// Flat record of the free variables a closure captured from enclosing local scopes when it
+// was created. A null value means the variable was not bound locally and resolves by name.
+struct Captures
+{
+	shared_ptr<const vector<symbol_t>> symbols;
+	vector<shared_ptr<Object>> values;
+
+	shared_ptr<Object>* find(symbol_t symbol)
+	{
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			if (symbols->at(i) == symbol && values[i])
+			{
+				return &values[i];
+			}
+		}
+		return nullptr;
+	}
+};
+
+// Bindings are kept in a flat open-addressing table keyed by interned symbols,
+// so a lookup is an integer hash plus a short linear probe
 class Environment
 {
 public:
-	Environment(shared_ptr<Environment> outer = nullptr) : outer(outer) {}
+	enum class Kind
+	{
+		Global, Frame, Scope
+	};
+
+public:
+	Environment(shared_ptr<Environment> outer = nullptr, Kind kind = Kind::Global) : outer(outer), kind(kind)
+	{
+		// A scope nested in a function frame sees the captures of that frame
+		if (kind == Kind::Scope && outer)
+		{
+			captures = outer->captures;
+		}
+	}
+
+	// Bumped whenever a lookup that skipped the local scopes could resolve differently,
+	// so a cached global resolution stays valid as long as this number is unchanged
+	static uint64_t version()
+	{
+		return version_counter();
+	}
+
+	// Whether symbol has ever been declared in a local scope, lookups of such symbols
+	// depend on the calling frame and can not be cached per site
+	static bool is_local_symbol(symbol_t symbol)
+	{
+		auto& locals = local_symbols();
+		return symbol < locals.size() && locals[symbol];
+	}
+
+	// Marks symbol as declared in a local scope before any scope declares it, after which declaring
+	// it changes nothing shared between environments
+	static void mark_local(symbol_t symbol)
+	{
+		auto& locals = local_symbols();
+		if (symbol >= locals.size())
+		{
+			locals.resize(symbol + 1);
+		}
+		if (!locals[symbol])
+		{
+			locals[symbol] = true;
+			version_counter()++;
+		}
+	}
 
 	// This function will set the value of name if name can be found, otherwise do nothing
-	void set(const string& name, shared_ptr<Object> value)
+	void set(symbol_t symbol, shared_ptr<Object> value)
 	{
-		auto* found = get(name);
+		auto* found = get(symbol);
 		if (found != nullptr)
 		{
 			*found = value;
+			version_counter()++;
+		}
+	}
+
+	// This function will do nothing if name has already been declared in this scope
+	void add(symbol_t symbol, shared_ptr<Object> value)
+	{
+		if ((_size + 1) * 2 > _slots.size())
+		{
+			rehash(_slots.empty() ? MIN_CAPACITY : _slots.size() * 2);
+		}
+
+		auto& slot = probe(symbol);
+		if (slot.symbol == symbol)
+		{
+			return;
+		}
+		slot.symbol = symbol;
+		slot.value = value;
+		_size++;
+		invalidate(symbol);
+	}
+
+	// Only search this scope
+	shared_ptr<Object>* find(symbol_t symbol)
+	{
+		if (_size == 0)
+		{
+			return nullptr;
 		}
+
+		auto& slot = probe(symbol);
+		return slot.symbol == symbol ? &slot.value : nullptr;
+	}
+
+	shared_ptr<Object>* get(symbol_t symbol)
+	{
+		return lookup(symbol, false);
+	}
+
+	// Like get, but stops at the first global scope
+	shared_ptr<Object>* get_local(symbol_t symbol)
+	{
+		return lookup(symbol, true);
+	}
+
+	size_t size() const
+	{
+		return _size;
+	}
+
+	// Drop every binding but keep the table, so the environment can be reused as another frame
+	void clear()
+	{
+		unbind();
+		outer.reset();
+		captures.reset();
+		temps.clear();
 	}
 
-	void add(const string& name, shared_ptr<Object> value)
+	// Drop every binding but stay in the chain, so a loop can run its next iteration in this scope
+	void unbind()
 	{
-		store.emplace(name, value);
+		if (_size != 0)
+		{
+			for (auto& slot : _slots)
+			{
+				slot.symbol = SymbolTable::None;
+				slot.value.reset();
+			}
+			_size = 0;
+		}
 	}
 
-	shared_ptr<Object>* get(const string& name)
+	// The innermost global scope of the chain starting at env
+	static shared_ptr<Environment> global(shared_ptr<Environment> env)
 	{
-		auto it = store.find(name);
+		while (env->kind != Kind::Global && env->outer)
+		{
+			env = env->outer;
+		}
+		return env;
+	}
 
-		if (it == store.end())
+private:
+	shared_ptr<Object>* lookup(symbol_t symbol, bool localOnly)
+	{
+		for (auto* env = this; env != nullptr; env = env->outer.get())
 		{
-			if (!outer)
+			if (localOnly && env->kind == Kind::Global)
 			{
 				return nullptr;
 			}
-			return outer->get(name);
+
+			auto* found = env->find(symbol);
+			if (found == nullptr && env->kind == Kind::Frame && env->captures)
+			{
+				found = env->captures->find(symbol);
+			}
+			if (found != nullptr)
+			{
+				return found;
+			}
+		}
+		return nullptr;
+	}
+
+	struct Slot
+	{
+		symbol_t symbol = SymbolTable::None;
+		shared_ptr<Object> value;
+	};
+
+	static constexpr size_t MIN_CAPACITY = 8;
+
+	// Atomic, as the evaluators of parallel builtins assign names on threads of their own
+	static atomic<uint64_t>& version_counter()
+	{
+		static atomic<uint64_t> version{ 1 };
+		return version;
+	}
+
+	static vector<bool>& local_symbols()
+	{
+		static vector<bool> locals;
+		return locals;
+	}
+
+	void invalidate(symbol_t symbol)
+	{
+		if (kind == Kind::Global)
+		{
+			version_counter()++;
+			return;
+		}
+		mark_local(symbol);
+	}
+
+	// Return the slot holding symbol, or the empty slot where it would be inserted
+	Slot& probe(symbol_t symbol)
+	{
+		// Fibonacci hashing: the high bits of the product, which every bit of the id reaches, index
+		// the slots, whose number is a power of 2 of at least MIN_CAPACITY
+		size_t mask = _slots.size() - 1;
+		size_t index = static_cast<size_t>((symbol * 11400714819323198485ull) >> (64 - __builtin_ctzll(_slots.size())));
+		while (_slots[index].symbol != symbol && _slots[index].symbol != SymbolTable::None)
+		{
+			index = (index + 1) & mask;
+		}
+		return _slots[index];
+	}
+
+	void rehash(size_t capacity)
+	{
+		vector<Slot> old(capacity);
+		old.swap(_slots);
+		for (auto& slot : old)
+		{
+			if (slot.symbol != SymbolTable::None)
+			{
+				auto& moved = probe(slot.symbol);
+				moved.symbol = slot.symbol;
+				moved.value = move(slot.value);
+			}
 		}
-		return &it->second;
 	}
 
 public:
-	map<string, shared_ptr<Object>> store;
 	shared_ptr<Environment> outer;
+	Kind kind;
+	shared_ptr<Captures> captures;
+	vector<shared_ptr<Object>> temps;		// Values stored by the TempExpr nodes run in a frame or global scope
+
+private:
+	vector<Slot> _slots;
+	size_t _size = 0;
 };
 
 
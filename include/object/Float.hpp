@@ -1,6 +1,7 @@
 #pragma once
 
 #include "basic/Object.h"
+#include <cmath>
 
 namespace li
 {
@@ -28,6 +29,12 @@ public:
 		*this = *dynamic_pointer_cast<Float>(value);
 	}
 
+	// Whether obj is a float that is NaN, which is equal to no float, not even to itself
+	static bool is_nan(const Object& obj)
+	{
+		return obj.type == Type::Float && std::isnan(static_cast<const Float&>(obj).value);
+	}
+
 public:
 	double value;
 };
@@ -4,22 +4,28 @@
 #include "Environment.hpp"
 #include "ast/ArgumentsStat.hpp"
 #include "ast/BlockStat.hpp"
+#include "ast/FunctionExpr.hpp"
 
 namespace li
 {
 
 class Function : public Object
 {
+public:
+	// The body of a function translated ahead of time, run in the frame the arguments are bound in
+	using Native = shared_ptr<Object> (*)(const shared_ptr<Environment>& env);
+
 public:
 	Function(shared_ptr<ArgumentsStat> args = nullptr,
 			 shared_ptr<BlockStat> body = nullptr,
-			 shared_ptr<Environment> env = nullptr) :
-	Object(Type::Function), args(args), body(body), env(env) {}
+			 shared_ptr<Environment> env = nullptr,
+			 shared_ptr<Captures> captures = nullptr) :
+	Object(Type::Function), args(args), body(body), env(env), captures(captures) {}
 
 	string inspect() const override
 	{
 		stringstream buffer;
-		buffer << "fun" << args->toString() << body->toString();
+		buffer << "fun" << args->toString() << (body ? body->toString() : text);
 		return buffer.str();
 	}
 
@@ -36,7 +42,12 @@ public:
 public:
 	shared_ptr<ArgumentsStat> args;
 	shared_ptr<BlockStat> body;
-	shared_ptr<Environment> env;
+	shared_ptr<Environment> env;			// The global scope, or the whole defining chain if a free variable could not be captured
+	shared_ptr<Captures> captures;
+	bool frameEscapes = true;		// Whether a closure created by body may keep the call frame alive
+	shared_ptr<FunctionExpr> node;	// The expression that created the function
+	Native native = nullptr;		// Runs instead of body, which a translated function does not have
+	string text;					// What body would print as
 };
 
 } // namespace li
\ No newline at end of file
@@ -0,0 +1,366 @@
+#pragma once
+
+#include "basic/Object.h"
+#include "Integer.hpp"
+#include "Float.hpp"
+#include "Bool.hpp"
+#include "String.hpp"
+#include <algorithm>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace li
+{
+
+
+// A hash map from integers, floats, bools and strings to objects, which keeps its keys in the order
+// they were first inserted. The entries are kept in a vector in that order and found through a
+// table of slots in the manner of a Swiss table: the slots come in groups of 16, each with a
+// control byte holding 7 bits of the hash of its key, or that it is empty or deleted, so that one
+// SSE2 comparison tells which slots of a group may hold a key. Every entry keeps the whole hash of
+// its key, the table grows without hashing or comparing any key, and strings cache their hashes.
+class Map : public Object
+{
+public:
+	struct Entry
+	{
+		shared_ptr<Object> key;		// Null once the entry was removed
+		shared_ptr<Object> value;
+		size_t hash;
+	};
+
+public:
+	Map() : Object(Type::Map) {}
+
+	string inspect() const override
+	{
+		stringstream buffer;
+		buffer << "{";
+		bool first = true;
+		for (const auto& entry : _entries)
+		{
+			if (!entry.key) continue;
+			buffer << (first ? "" : ", ") << entry.key->inspect() << ": " << entry.value->inspect();
+			first = false;
+		}
+		buffer << "}";
+		return buffer.str();
+	}
+
+	// Copies the table as it is, the keys are never changed and are shared with the copy
+	shared_ptr<Object> copy() override
+	{
+		auto copied = make_shared<Map>();
+		copied->_entries = _entries;
+		copied->_control = _control;
+		copied->_slots = _slots;
+		copied->_size = _size;
+		copied->_used = _used;
+		for (auto& entry : copied->_entries)
+		{
+			if (entry.key) entry.value = entry.value->copy();
+		}
+		return copied;
+	}
+
+	// Inserts the entries of value, replacing the values of the keys this map has already
+	void assign(shared_ptr<Object> value) override
+	{
+		auto& other = *dynamic_pointer_cast<Map>(value);
+		if (&other == this) return;
+
+		for (const auto& entry : other._entries)
+		{
+			if (!entry.key) continue;
+			set(entry.key, entry.value);
+		}
+	}
+
+	void setMutable(bool isMutable) override
+	{
+		Object::setMutable(isMutable);
+		for (auto& entry : _entries)
+		{
+			if (entry.key) entry.value->setMutable(isMutable);
+		}
+	}
+
+	// Whether obj may be a key, which NaN may not, no key would ever be found equal to it
+	static bool hashable(const Object& obj)
+	{
+		switch (obj.type)
+		{
+		case Type::Integer:
+		case Type::Bool:
+		case Type::String:
+			return true;
+		case Type::Float:
+			return !li::Float::is_nan(obj);
+		default:
+			return false;
+		}
+	}
+
+	// The hash of a hashable key, keys equal by keys_equal have equal hashes
+	static size_t hash(const Object& key)
+	{
+		uint64_t bits = 0;
+		switch (key.type)
+		{
+		case Type::Integer:
+			bits = static_cast<uint64_t>(static_cast<const li::Integer&>(key).value);
+			break;
+
+		case Type::Float:
+		{
+			// 0.0 and -0.0 are equal
+			double value = static_cast<const li::Float&>(key).value;
+			value = value == 0 ? 0 : value;
+			memcpy(&bits, &value, sizeof(bits));
+			break;
+		}
+
+		case Type::Bool:
+			bits = static_cast<const li::Bool&>(key).value;
+			break;
+
+		default:
+			bits = static_cast<const li::String&>(key).hash();
+			break;
+		}
+
+		// The control bytes take the low 7 bits and the groups the others, so every bit of the key
+		// has to reach both
+		bits = (bits ^ static_cast<uint64_t>(key.type)) * 0x9E3779B97F4A7C15ull;
+		return static_cast<size_t>(bits ^ (bits >> 29));
+	}
+
+	static bool keys_equal(const Object& a, const Object& b)
+	{
+		if (a.type != b.type) return false;
+		switch (a.type)
+		{
+		case Type::Integer: return static_cast<const li::Integer&>(a).value == static_cast<const li::Integer&>(b).value;
+		case Type::Float: return static_cast<const li::Float&>(a).value == static_cast<const li::Float&>(b).value;
+		case Type::Bool: return static_cast<const li::Bool&>(a).value == static_cast<const li::Bool&>(b).value;
+		default: return static_cast<const li::String&>(a).view() == static_cast<const li::String&>(b).view();
+		}
+	}
+
+	size_t size() const
+	{
+		return _size;
+	}
+
+	// In the order the keys were inserted, the entries that were removed have no key
+	const vector<Entry>& entries() const
+	{
+		return _entries;
+	}
+
+	// The value of the hashable key, null when the map does not have it
+	shared_ptr<Object>* find(const Object& key)
+	{
+		size_t slot = find_slot(key, hash(key));
+		return slot == npos ? nullptr : &_entries[_slots[slot]].value;
+	}
+
+	// The entry of key, a new one with a null value when the map did not have it. The key is copied
+	// unless nothing else holds it, so that no assignment reaches it.
+	Entry& insert(shared_ptr<Object> key, size_t hash)
+	{
+		size_t slot = find_slot(*key, hash);
+		if (slot != npos)
+		{
+			return _entries[_slots[slot]];
+		}
+
+		// At most 7 of every 8 slots are full or deleted, so a probe always ends at an empty one
+		if ((_used + 1) * 8 > _control.size() * 7)
+		{
+			rehash(_size + 1);
+		}
+		slot = free_slot(hash);
+		if (_control[slot] == Empty)
+		{
+			_used++;
+		}
+		_control[slot] = tag(hash);
+		_slots[slot] = static_cast<uint32_t>(_entries.size());
+
+		if (key.use_count() != 1 || key->isMutable)
+		{
+			key = key->copy();
+		}
+		key->isMutable = false;
+		_entries.push_back({ move(key), nullptr, hash });
+		_size++;
+		return _entries.back();
+	}
+
+	// Sets the value of key to a copy of value as mutable as the map, or to the constant of a bool
+	void set(const shared_ptr<Object>& key, const shared_ptr<Object>& value)
+	{
+		auto& entry = insert(key, hash(*key));
+		if (value->type == Type::Bool)
+		{
+			entry.value = li::Bool::constant(static_cast<li::Bool&>(*value).value);
+			return;
+		}
+		entry.value = value->copy();
+		entry.value->setMutable(isMutable);
+	}
+
+	// Returns the value key had, null when the map did not have it
+	shared_ptr<Object> remove(const Object& key)
+	{
+		size_t slot = find_slot(key, hash(key));
+		if (slot == npos)
+		{
+			return nullptr;
+		}
+
+		auto& entry = _entries[_slots[slot]];
+		auto value = move(entry.value);
+		entry.key.reset();
+		_control[slot] = Deleted;
+		_size--;
+
+		// The removed entries would make keys and values walk past them
+		if (_entries.size() > 16 && _size * 2 < _entries.size())
+		{
+			rehash(_size);
+		}
+		return value;
+	}
+
+private:
+	static constexpr size_t GroupSize = 16;
+	static constexpr int8_t Empty = -128;
+	static constexpr int8_t Deleted = -2;
+	static constexpr size_t npos = ~size_t(0);
+
+	// The control byte of a full slot, whose sign bit is clear
+	static int8_t tag(size_t hash)
+	{
+		return static_cast<int8_t>(hash & 0x7F);
+	}
+
+	// Bit i is set when control byte i of the group equals value
+	static uint32_t match(const int8_t* group, int8_t value)
+	{
+#if defined(__SSE2__)
+		auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+		return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(value))));
+#else
+		uint32_t bits = 0;
+		for (size_t i = 0; i < GroupSize; i++)
+		{
+			bits |= static_cast<uint32_t>(group[i] == value) << i;
+		}
+		return bits;
+#endif
+	}
+
+	// Bit i is set when slot i of the group is empty or deleted, whose control bytes are negative
+	static uint32_t match_free(const int8_t* group)
+	{
+#if defined(__SSE2__)
+		return static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group))));
+#else
+		uint32_t bits = 0;
+		for (size_t i = 0; i < GroupSize; i++)
+		{
+			bits |= static_cast<uint32_t>(group[i] < 0) << i;
+		}
+		return bits;
+#endif
+	}
+
+	// The groups are probed by triangular numbers, which visit all of them as their number is a
+	// power of 2
+	size_t find_slot(const Object& key, size_t hash) const
+	{
+		size_t groups = _control.size() / GroupSize;
+		if (groups == 0)
+		{
+			return npos;
+		}
+
+		size_t mask = groups - 1;
+		size_t group = (hash >> 7) & mask;
+		for (size_t step = 1; ; step++)
+		{
+			const int8_t* control = &_control[group * GroupSize];
+			for (uint32_t bits = match(control, tag(hash)); bits != 0; bits &= bits - 1)
+			{
+				size_t slot = group * GroupSize + __builtin_ctz(bits);
+				const auto& entry = _entries[_slots[slot]];
+				if (entry.hash == hash && keys_equal(*entry.key, key))
+				{
+					return slot;
+				}
+			}
+			if (match(control, Empty) != 0)
+			{
+				return npos;
+			}
+			group = (group + step) & mask;
+		}
+	}
+
+	size_t free_slot(size_t hash) const
+	{
+		size_t mask = _control.size() / GroupSize - 1;
+		size_t group = (hash >> 7) & mask;
+		for (size_t step = 1; ; step++)
+		{
+			uint32_t bits = match_free(&_control[group * GroupSize]);
+			if (bits != 0)
+			{
+				return group * GroupSize + __builtin_ctz(bits);
+			}
+			group = (group + step) & mask;
+		}
+	}
+
+	// Drops the removed entries and makes a table in which count entries fill at most 7 of 16 slots
+	void rehash(size_t count)
+	{
+		size_t capacity = GroupSize;
+		while (capacity * 7 < count * 16)
+		{
+			capacity *= 2;
+		}
+
+		vector<Entry> entries;
+		entries.reserve(max(count, _size));
+		for (auto& entry : _entries)
+		{
+			if (entry.key) entries.push_back(move(entry));
+		}
+		_entries = move(entries);
+		_control.assign(capacity, Empty);
+		_slots.assign(capacity, 0);
+		_used = _entries.size();
+
+		for (size_t i = 0; i < _entries.size(); i++)
+		{
+			size_t slot = free_slot(_entries[i].hash);
+			_control[slot] = tag(_entries[i].hash);
+			_slots[slot] = static_cast<uint32_t>(i);
+		}
+	}
+
+private:
+	vector<Entry> _entries;
+	vector<int8_t> _control;		// A control byte for every slot, in groups of GroupSize
+	vector<uint32_t> _slots;		// The index in _entries of the entry of every full slot
+	size_t _size = 0;				// Entries that were not removed
+	size_t _used = 0;				// Slots that are full or deleted
+};
+
+
+}
\ No newline at end of file
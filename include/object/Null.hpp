@@ -10,6 +10,22 @@ class Null : public Object
 public:
 	Null() : Object(Type::Null) {}
 
+	// The object everything without a value evaluates to
+	static const shared_ptr<Null>& constant()
+	{
+		static const shared_ptr<Null> instance = make_shared<Null>();
+		return instance;
+	}
+
+	// The constant stays immutable, a name that may be assigned holds a copy of it
+	void setMutable(bool isMutable) override
+	{
+		if (this != constant().get())
+		{
+			Object::setMutable(isMutable);
+		}
+	}
+
 	string inspect() const override
 	{
 		return "null";
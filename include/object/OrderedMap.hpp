@@ -0,0 +1,518 @@
+#pragma once
+
+#include "basic/Object.h"
+#include "Integer.hpp"
+#include "Float.hpp"
+#include "Bool.hpp"
+#include "String.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace li
+{
+
+
+// A map from numbers or from strings to objects that keeps its keys sorted, for iterating them in
+// order and for range queries. The entries are kept in a B+ tree of wide nodes: every node holds up
+// to Order keys next to each other, each with a 64 bit prefix that orders as the key does, so that
+// searching a node mostly compares the integers of a few cache lines and only reads the objects of
+// the keys whose prefixes are equal. Integers and floats are compared by value, 1 and 1.0 are the
+// same key, strings by their bytes.
+class OrderedMap : public Object
+{
+public:
+	struct Key
+	{
+		uint64_t prefix;
+		shared_ptr<Object> object;
+	};
+
+public:
+	OrderedMap() : Object(Type::OrderedMap), _root(make_unique<Node>()) {}
+
+	string inspect() const override
+	{
+		stringstream buffer;
+		buffer << "{";
+		bool first = true;
+		visit(nullptr, [&](const shared_ptr<Object>& key, const shared_ptr<Object>& value)
+		{
+			buffer << (first ? "" : ", ") << key->inspect() << ": " << value->inspect();
+			first = false;
+			return true;
+		});
+		buffer << "}";
+		return buffer.str();
+	}
+
+	// Copies the tree as it is, the keys are never changed and are shared with the copy
+	shared_ptr<Object> copy() override
+	{
+		auto copied = make_shared<OrderedMap>();
+		copied->_root = clone(*_root);
+		copied->_size = _size;
+		copied->_kind = _kind;
+		return copied;
+	}
+
+	// Inserts the entries of value, replacing the values of the keys this map has already. The
+	// keys of value that can not be compared with the keys here are left out.
+	void assign(shared_ptr<Object> value) override
+	{
+		auto& other = *dynamic_pointer_cast<OrderedMap>(value);
+		if (&other == this) return;
+
+		other.visit(nullptr, [&](const shared_ptr<Object>& key, const shared_ptr<Object>& value)
+		{
+			if (accepts(*key)) set(key, value);
+			return true;
+		});
+	}
+
+	void setMutable(bool isMutable) override
+	{
+		Object::setMutable(isMutable);
+		set_mutable(*_root, isMutable);
+	}
+
+	// Whether obj may be a key of some ordered map
+	static bool orderable(const Object& obj)
+	{
+		switch (obj.type)
+		{
+		case Type::Integer:
+		case Type::String:
+			return true;
+		case Type::Float:
+			return !li::Float::is_nan(obj);
+		default:
+			return false;
+		}
+	}
+
+	// Whether obj may be a key of this map, which takes numbers or strings once it has either
+	bool accepts(const Object& obj) const
+	{
+		return orderable(obj) && (_kind == Kind::None || kind(obj) == _kind);
+	}
+
+	// Negative, zero or positive as a goes before, is the same key as or goes after b, both of a kind
+	static int compare(const Object& a, const Object& b)
+	{
+		if (a.type == Type::String)
+		{
+			return static_cast<const li::String&>(a).view().compare(static_cast<const li::String&>(b).view());
+		}
+		if (a.type == Type::Integer && b.type == Type::Integer)
+		{
+			auto x = static_cast<const li::Integer&>(a).value, y = static_cast<const li::Integer&>(b).value;
+			return (x > y) - (x < y);
+		}
+		double x = number(a), y = number(b);
+		return (x > y) - (x < y);
+	}
+
+	size_t size() const
+	{
+		return _size;
+	}
+
+	// The value of the key, null when the map does not have it or does not accept it
+	shared_ptr<Object>* find(const Object& obj)
+	{
+		if (!accepts(obj)) return nullptr;
+
+		Key key = make_key(obj);
+		Node* node = _root.get();
+		while (!node->leaf())
+		{
+			node = node->children[upper_bound(*node, key)].get();
+		}
+		size_t i = lower_bound(*node, key);
+		return i < node->keys.size() && equal(node->keys[i], key) ? &node->values[i] : nullptr;
+	}
+
+	// Sets the value of the accepted key to value itself, returns whether the map did not have the
+	// key. Like Map::insert, the key is copied unless nothing else holds it.
+	bool insert(shared_ptr<Object> obj, shared_ptr<Object> value)
+	{
+		if (obj.use_count() != 1 || obj->isMutable)
+		{
+			obj = obj->copy();
+		}
+		obj->isMutable = false;
+		_kind = kind(*obj);
+
+		Key key{ prefix(*obj), move(obj) };
+		bool inserted = false;
+		Key separator;
+		if (auto right = insert(*_root, key, value, inserted, separator))
+		{
+			auto root = make_unique<Node>();
+			root->keys.push_back(move(separator));
+			root->children.push_back(move(_root));
+			root->children.push_back(move(right));
+			_root = move(root);
+		}
+		_size += inserted;
+		return inserted;
+	}
+
+	// Sets the value of the accepted key to a copy of value as mutable as the map, or to the
+	// constant of a bool, see Map::set
+	bool set(const shared_ptr<Object>& key, const shared_ptr<Object>& value)
+	{
+		if (value->type == Type::Bool)
+		{
+			return insert(key, li::Bool::constant(static_cast<li::Bool&>(*value).value));
+		}
+		auto copied = value->copy();
+		copied->setMutable(isMutable);
+		return insert(key, move(copied));
+	}
+
+	// Returns the value key had, null when the map did not have it
+	shared_ptr<Object> remove(const Object& obj)
+	{
+		if (!accepts(obj)) return nullptr;
+
+		auto removed = erase(*_root, make_key(obj));
+		if (!removed) return nullptr;
+
+		// A branch left with a single child gives the tree its place
+		if (!_root->leaf() && _root->keys.empty())
+		{
+			_root = move(_root->children.front());
+		}
+		if (--_size == 0)
+		{
+			_kind = Kind::None;
+		}
+		return removed;
+	}
+
+	// Calls visit(key, value) for the keys from the first one not before from, or from the first
+	// one when from is null, in order until visit returns false. from must be accepted.
+	template <typename Visit>
+	void visit(const Object* from, Visit visit) const
+	{
+		if (from)
+		{
+			Key key = make_key(*from);
+			walk(*_root, &key, visit);
+		}
+		else
+		{
+			walk(*_root, nullptr, visit);
+		}
+	}
+
+	// The first key not before the accepted key, null when there is none
+	shared_ptr<Object> lower_bound(const Object& obj) const
+	{
+		shared_ptr<Object> found;
+		visit(&obj, [&](const shared_ptr<Object>& key, const shared_ptr<Object>&)
+		{
+			found = key;
+			return false;
+		});
+		return found;
+	}
+
+	// The smallest and the largest keys, null when the map is empty
+	shared_ptr<Object> first() const
+	{
+		const Node* node = _root.get();
+		while (!node->leaf()) node = node->children.front().get();
+		return node->keys.empty() ? nullptr : node->keys.front().object;
+	}
+
+	shared_ptr<Object> last() const
+	{
+		const Node* node = _root.get();
+		while (!node->leaf()) node = node->children.back().get();
+		return node->keys.empty() ? nullptr : node->keys.back().object;
+	}
+
+private:
+	// Leaves split once they hold more keys than this, and so do branches
+	static constexpr size_t Order = 64;
+	// Every node but the root holds at least this many keys
+	static constexpr size_t MinKeys = Order / 2;
+
+	enum class Kind
+	{
+		None, Number, String
+	};
+
+	// A leaf holds the entries, a branch its children and the keys that separate them: every key of
+	// children[i] goes before keys[i] and none goes before keys[i - 1]
+	struct Node
+	{
+		vector<Key> keys;
+		vector<shared_ptr<Object>> values;		// Of a leaf
+		vector<unique_ptr<Node>> children;		// Of a branch, one more than keys
+
+		bool leaf() const
+		{
+			return children.empty();
+		}
+	};
+
+	static Kind kind(const Object& obj)
+	{
+		return obj.type == Type::String ? Kind::String : Kind::Number;
+	}
+
+	static double number(const Object& obj)
+	{
+		return obj.type == Type::Integer ? static_cast<double>(static_cast<const li::Integer&>(obj).value) : static_cast<const li::Float&>(obj).value;
+	}
+
+	// Never greater for a key that goes before another: numbers as doubles whose bits are flipped
+	// to order as unsigned integers, strings by their first 8 bytes
+	static uint64_t prefix(const Object& obj)
+	{
+		if (obj.type == Type::String)
+		{
+			auto value = static_cast<const li::String&>(obj).view();
+			uint64_t bits = 0;
+			for (size_t i = 0; i < 8; i++)
+			{
+				bits = bits << 8 | (i < value.size() ? static_cast<unsigned char>(value[i]) : 0);
+			}
+			return bits;
+		}
+
+		// 0.0 and -0.0 are the same key
+		double value = number(obj);
+		value = value == 0 ? 0 : value;
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits >> 63 ? ~bits : bits | (uint64_t(1) << 63);
+	}
+
+	static Key make_key(const Object& obj)
+	{
+		// The key only lives while it is looked for, nothing else is kept of it
+		return { prefix(obj), shared_ptr<Object>(shared_ptr<Object>(), const_cast<Object*>(&obj)) };
+	}
+
+	static bool less(const Key& a, const Key& b)
+	{
+		return a.prefix != b.prefix ? a.prefix < b.prefix : compare(*a.object, *b.object) < 0;
+	}
+
+	static bool equal(const Key& a, const Key& b)
+	{
+		return a.prefix == b.prefix && compare(*a.object, *b.object) == 0;
+	}
+
+	// The first key of node not before key
+	static size_t lower_bound(const Node& node, const Key& key)
+	{
+		return std::lower_bound(node.keys.begin(), node.keys.end(), key, less) - node.keys.begin();
+	}
+
+	// The child of the branch whose keys key is among
+	static size_t upper_bound(const Node& node, const Key& key)
+	{
+		return std::upper_bound(node.keys.begin(), node.keys.end(), key, less) - node.keys.begin();
+	}
+
+	// Inserts into the subtree of node, returns the new right half of node when it split, whose keys
+	// none goes before separator
+	static unique_ptr<Node> insert(Node& node, Key& key, shared_ptr<Object>& value, bool& inserted, Key& separator)
+	{
+		if (node.leaf())
+		{
+			size_t i = lower_bound(node, key);
+			if (i < node.keys.size() && equal(node.keys[i], key))
+			{
+				node.values[i] = move(value);
+				return nullptr;
+			}
+			node.keys.insert(node.keys.begin() + i, move(key));
+			node.values.insert(node.values.begin() + i, move(value));
+			inserted = true;
+			if (node.keys.size() <= Order) return nullptr;
+
+			auto right = make_unique<Node>();
+			size_t half = node.keys.size() / 2;
+			move(node.keys.begin() + half, node.keys.end(), back_inserter(right->keys));
+			move(node.values.begin() + half, node.values.end(), back_inserter(right->values));
+			node.keys.resize(half);
+			node.values.resize(half);
+			separator = right->keys.front();
+			return right;
+		}
+
+		size_t i = upper_bound(node, key);
+		Key childSeparator;
+		auto child = insert(*node.children[i], key, value, inserted, childSeparator);
+		if (!child) return nullptr;
+
+		node.keys.insert(node.keys.begin() + i, move(childSeparator));
+		node.children.insert(node.children.begin() + i + 1, move(child));
+		if (node.keys.size() <= Order) return nullptr;
+
+		// The middle key moves up, the children on either side of it stay apart
+		auto right = make_unique<Node>();
+		size_t half = node.keys.size() / 2;
+		separator = move(node.keys[half]);
+		move(node.keys.begin() + half + 1, node.keys.end(), back_inserter(right->keys));
+		move(node.children.begin() + half + 1, node.children.end(), back_inserter(right->children));
+		node.keys.resize(half);
+		node.children.resize(half + 1);
+		return right;
+	}
+
+	// Removes key from the subtree of node and returns its value, then fills up a child left with
+	// too few keys from a sibling or merges it into one. The keys of the branches may outlive the
+	// keys of the leaves, they still separate the children.
+	static shared_ptr<Object> erase(Node& node, const Key& key)
+	{
+		if (node.leaf())
+		{
+			size_t i = lower_bound(node, key);
+			if (i == node.keys.size() || !equal(node.keys[i], key))
+			{
+				return nullptr;
+			}
+			auto value = move(node.values[i]);
+			node.keys.erase(node.keys.begin() + i);
+			node.values.erase(node.values.begin() + i);
+			return value;
+		}
+
+		size_t i = upper_bound(node, key);
+		auto value = erase(*node.children[i], key);
+		if (value && node.children[i]->keys.size() < MinKeys)
+		{
+			rebalance(node, i);
+		}
+		return value;
+	}
+
+	static void rebalance(Node& parent, size_t i)
+	{
+		auto& child = *parent.children[i];
+		if (i > 0 && parent.children[i - 1]->keys.size() > MinKeys)
+		{
+			auto& left = *parent.children[i - 1];
+			if (child.leaf())
+			{
+				child.keys.insert(child.keys.begin(), move(left.keys.back()));
+				child.values.insert(child.values.begin(), move(left.values.back()));
+				left.values.pop_back();
+				parent.keys[i - 1] = child.keys.front();
+			}
+			else
+			{
+				child.keys.insert(child.keys.begin(), move(parent.keys[i - 1]));
+				child.children.insert(child.children.begin(), move(left.children.back()));
+				left.children.pop_back();
+				parent.keys[i - 1] = move(left.keys.back());
+			}
+			left.keys.pop_back();
+			return;
+		}
+
+		if (i + 1 < parent.children.size() && parent.children[i + 1]->keys.size() > MinKeys)
+		{
+			auto& right = *parent.children[i + 1];
+			if (child.leaf())
+			{
+				child.keys.push_back(move(right.keys.front()));
+				child.values.push_back(move(right.values.front()));
+				right.keys.erase(right.keys.begin());
+				right.values.erase(right.values.begin());
+				parent.keys[i] = right.keys.front();
+			}
+			else
+			{
+				child.keys.push_back(move(parent.keys[i]));
+				child.children.push_back(move(right.children.front()));
+				right.children.erase(right.children.begin());
+				parent.keys[i] = move(right.keys.front());
+				right.keys.erase(right.keys.begin());
+			}
+			return;
+		}
+
+		// Neither sibling can spare a key, so the child and one of them fit into a single node
+		size_t at = i > 0 ? i - 1 : i;
+		auto& left = *parent.children[at];
+		auto& right = *parent.children[at + 1];
+		if (left.leaf())
+		{
+			move(right.keys.begin(), right.keys.end(), back_inserter(left.keys));
+			move(right.values.begin(), right.values.end(), back_inserter(left.values));
+		}
+		else
+		{
+			left.keys.push_back(move(parent.keys[at]));
+			move(right.keys.begin(), right.keys.end(), back_inserter(left.keys));
+			move(right.children.begin(), right.children.end(), back_inserter(left.children));
+		}
+		parent.keys.erase(parent.keys.begin() + at);
+		parent.children.erase(parent.children.begin() + at + 1);
+	}
+
+	// Returns false once visit did
+	template <typename Visit>
+	static bool walk(const Node& node, const Key* from, Visit& visit)
+	{
+		if (node.leaf())
+		{
+			for (size_t i = from ? lower_bound(node, *from) : 0; i < node.keys.size(); i++)
+			{
+				if (!visit(node.keys[i].object, node.values[i])) return false;
+			}
+			return true;
+		}
+
+		for (size_t i = from ? upper_bound(node, *from) : 0; i < node.children.size(); i++)
+		{
+			if (!walk(*node.children[i], from, visit)) return false;
+			from = nullptr;
+		}
+		return true;
+	}
+
+	static unique_ptr<Node> clone(const Node& node)
+	{
+		auto copied = make_unique<Node>();
+		copied->keys = node.keys;
+		copied->values.reserve(node.values.size());
+		for (const auto& value : node.values)
+		{
+			copied->values.push_back(value->copy());
+		}
+		for (const auto& child : node.children)
+		{
+			copied->children.push_back(clone(*child));
+		}
+		return copied;
+	}
+
+	static void set_mutable(Node& node, bool isMutable)
+	{
+		for (auto& value : node.values)
+		{
+			value->setMutable(isMutable);
+		}
+		for (auto& child : node.children)
+		{
+			set_mutable(*child, isMutable);
+		}
+	}
+
+private:
+	unique_ptr<Node> _root;
+	size_t _size = 0;
+	Kind _kind = Kind::None;
+};
+
+
+}
\ No newline at end of file
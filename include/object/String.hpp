@@ -1,19 +1,39 @@
 #pragma once
 
 #include "basic/Object.h"
+#include <atomic>
+#include <functional>
+#include <string_view>
 
 namespace li
 {
 
 
+// The characters of a string live in a buffer that strings copied from it, strings made by
+// appending to it and slices of it share: every string sees size() characters of its buffer from
+// an offset, which are never changed once written, and a string ending where its buffer does
+// appends in place. Building a string piece by piece with + or += thus copies every piece once
+// instead of the whole string every time, and copying or slicing a string copies no characters.
 class String : public Object
 {
 public:
-	String(const string& value = "") : Object(Type::String), value(value) {}
+	String(string value = "") : Object(Type::String), _buffer(make_shared<string>(move(value))), _size(_buffer->size()) {}
+
+	String(const String& other) : Object(other), _buffer(other._buffer), _offset(other._offset), _size(other._size), _hash(other._hash.load(memory_order_relaxed)) {}
+
+	String& operator=(const String& other)
+	{
+		Object::operator=(other);
+		_buffer = other._buffer;
+		_offset = other._offset;
+		_size = other._size;
+		_hash.store(other._hash.load(memory_order_relaxed), memory_order_relaxed);
+		return *this;
+	}
 
 	string inspect() const override
 	{
-		return value;
+		return string(view());
 	}
 
 	shared_ptr<Object> copy() override
@@ -26,8 +46,79 @@ public:
 		*this = *dynamic_pointer_cast<String>(value);
 	}
 
-public:
-	string value;
+	// The characters, until anything is appended to a string sharing the buffer
+	string_view view() const
+	{
+		return string_view(_buffer->data() + _offset, _size);
+	}
+
+	size_t size() const
+	{
+		return _size;
+	}
+
+	// Appends piece. The buffer grows in place when this string ends where it does, unless other
+	// threads may read it while it does, as when shared. Otherwise the characters move to a buffer
+	// of their own with room to spare for the next pieces.
+	void append(string_view piece, bool shared = false)
+	{
+		if (shared || _offset + _size != _buffer->size())
+		{
+			auto buffer = make_shared<string>();
+			buffer->reserve(max(_size + piece.size(), _size * 2));
+			buffer->append(view()).append(piece);
+			_buffer = move(buffer);
+			_offset = 0;
+		}
+		else if (piece.data() >= _buffer->data() && piece.data() < _buffer->data() + _buffer->size())
+		{
+			// The piece would move away while it is appended
+			_buffer->append(string(piece));
+		}
+		else
+		{
+			_buffer->append(piece);
+		}
+		_size += piece.size();
+		_hash.store(0, memory_order_relaxed);
+	}
+
+	// The count characters from from, which must all be in the string. A slice shares the buffer
+	// unless it is short, when copying costs about as much, or much shorter than the buffer, which
+	// it would keep alive on its own once the string is gone.
+	shared_ptr<String> slice(size_t from, size_t count) const
+	{
+		if (count < MinShared || count * MaxPinned < _buffer->size())
+		{
+			return make_shared<String>(string(view().substr(from, count)));
+		}
+		return shared_ptr<String>(new String(_buffer, _offset + from, count));
+	}
+
+	// The hash of the characters, computed once for every lookup of a map with this string as the
+	// key. They are only changed by assign and append, which take the hash along or forget it.
+	size_t hash() const
+	{
+		size_t cached = _hash.load(memory_order_relaxed);
+		if (cached == 0)
+		{
+			cached = std::hash<string_view>()(view()) | 1;
+			_hash.store(cached, memory_order_relaxed);
+		}
+		return cached;
+	}
+
+private:
+	static constexpr size_t MinShared = 32;
+	static constexpr size_t MaxPinned = 4;		// Times the characters of a slice its buffer may hold
+
+	String(shared_ptr<string> buffer, size_t offset, size_t size) : Object(Type::String), _buffer(move(buffer)), _offset(offset), _size(size) {}
+
+private:
+	shared_ptr<string> _buffer;
+	size_t _offset = 0;
+	size_t _size;
+	mutable atomic<size_t> _hash{ 0 };		// 0 until computed, atomic as threads may share a string
 };
 
 
@@ -11,7 +11,7 @@ class Object
 public:
 	enum class Type
 	{
-		Null, Integer, Float, Bool, ReturnValue, Error, Function, String, BuiltinFun, Array
+		Null, Integer, Float, Bool, ReturnValue, Error, Function, String, BuiltinFun, Array, Map, OrderedMap
 	};
 
 public:
@@ -37,9 +37,13 @@ public:
 		return typeName(type);
 	}
 
+	// Only writes a flag it changes, so objects several threads read keep being only read
 	virtual void setMutable(bool isMutable)
 	{
-		this->isMutable = isMutable;
+		if (this->isMutable != isMutable)
+		{
+			this->isMutable = isMutable;
+		}
 	}
 
 public:
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "ast/Program.hpp"
+#include "ast/LetStat.hpp"
+#include "ast/CallExpr.hpp"
+#include <unordered_map>
+#include <unordered_set>
+
+namespace li
+{
+
+
+// Substitutes the bodies of small, non-recursive, let-bound functions at their call sites, so a call
+// through a thin wrapper such as println collapses into a direct builtin call. Candidates are kept
+// across programs, run the inliner over the preread sources before the programs that use them.
+class Inliner
+{
+public:
+	static constexpr size_t DEFAULT_THRESHOLD = 16;		// Maximum number of nodes of an inlined body
+
+public:
+	Inliner(size_t threshold = DEFAULT_THRESHOLD) : _threshold(threshold) {}
+
+	void run(shared_ptr<Program> program);
+
+	// Number of call sites replaced so far
+	size_t inlined() const
+	{
+		return _inlined;
+	}
+
+private:
+	struct Use
+	{
+		size_t arg;
+		bool afterEffect;		// Whether anything that may fail or have a side effect is evaluated before
+	};
+
+	struct Candidate
+	{
+		size_t program;						// The run that defined the candidate
+		vector<symbol_t> args;
+		shared_ptr<Expr> body;
+		vector<Use> uses;					// Uses of the arguments in evaluation order
+		unordered_set<symbol_t> names;		// Names the body resolves
+		unordered_set<symbol_t> expanded;	// Functions whose bodies were inlined into this one
+	};
+
+	struct Context
+	{
+		size_t program;
+		unordered_map<symbol_t, size_t> declarations;		// Every let, var and argument of the program
+		unordered_map<symbol_t, size_t> topLevel;			// Declarations living in the global scope
+		unordered_set<symbol_t> valueUses;					// Names used other than by calling them
+	};
+
+	void scan(const shared_ptr<Node>& node, Context& context);
+	void inline_calls(const shared_ptr<Node>& node, Context& context, unordered_set<symbol_t>& expanded);
+	shared_ptr<Expr> expand(const shared_ptr<CallExpr>& call, Context& context, unordered_set<symbol_t>& expanded);
+	void try_register(const shared_ptr<LetStat>& let, Context& context, const unordered_set<symbol_t>& expanded);
+	bool check_body(const shared_ptr<Expr>& node, const unordered_map<symbol_t, size_t>& args, Candidate& candidate, bool& effect, size_t& size);
+	bool resolves_same(symbol_t symbol, const Candidate& candidate, const Context& context) const;
+	bool usable(symbol_t symbol, const Candidate& candidate, const Context& context) const;
+
+	static shared_ptr<Expr> clone(const shared_ptr<Expr>& node, const unordered_map<symbol_t, shared_ptr<Expr>>& args);
+	static bool is_literal(const shared_ptr<Expr>& node);
+
+private:
+	size_t _threshold;
+	size_t _inlined = 0;
+	size_t _runs = 0;
+	unordered_map<symbol_t, Candidate> _candidates;
+	unordered_set<symbol_t> _poisoned;		// Functions used as values, which may be changed through an alias
+};
+
+
+}
\ No newline at end of file
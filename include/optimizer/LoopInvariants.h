@@ -0,0 +1,59 @@
+#pragma once
+
+#include "ast/Program.hpp"
+#include "ast/WhileStat.hpp"
+#include "ast/CallExpr.hpp"
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace li
+{
+
+
+// Loop invariant code motion for while loops. Pure subexpressions of a loop whose names are not
+// declared by the loop are wrapped in an InvariantExpr, which the evaluator computes once per
+// execution of the outermost such loop and reuses while nothing they depend on is mutated.
+class LoopInvariants
+{
+public:
+	enum class Purity
+	{
+		Io,			// Has effects outside of the program but does not change any object
+		Pure,		// Only reads the contents of its arguments
+		Shape		// Only reads the lengths of its arguments
+	};
+
+	// What the functions of the preread sources and the builtin opcodes do, anything else may do anything
+	static const map<string, Purity> stdlibPurity;
+	static const map<int64_t, Purity> builtinPurity;
+
+public:
+	// Returns the number of expressions made invariant
+	static size_t run(shared_ptr<Program> program);
+
+private:
+	struct Context
+	{
+		unordered_map<symbol_t, size_t> declarations;		// Every let, var and argument of the program
+		size_t hoisted = 0;
+	};
+
+	struct Loop
+	{
+		shared_ptr<WhileStat> stat;
+		unordered_set<symbol_t> declared;		// Declared in a scope of the loop, bound anew by every iteration
+		bool mutates = false;					// Whether the loop itself assigns, increments or decrements
+	};
+
+	static void scan(const shared_ptr<Node>& node, Context& context);
+	static void find_loops(const shared_ptr<Node>& node, Context& context);
+	static void summarize(const shared_ptr<Node>& node, Loop& loop);
+	static void hoist(const shared_ptr<Node>& node, Loop& loop, Context& context);
+	static void try_hoist(shared_ptr<Expr>& slot, Loop& loop, Context& context);
+	static bool invariant(const shared_ptr<Expr>& node, const Loop& loop, const Context& context, bool& shapeOnly, bool& worthwhile);
+	static const Purity* purity(const shared_ptr<CallExpr>& call, const Context& context);
+};
+
+
+}
\ No newline at end of file
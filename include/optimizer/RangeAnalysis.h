@@ -0,0 +1,74 @@
+#pragma once
+
+#include "ast/Program.hpp"
+#include "ast/FunctionExpr.hpp"
+#include "ast/CallExpr.hpp"
+#include "ast/IndexExpr.hpp"
+#include <unordered_map>
+#include <unordered_set>
+
+namespace li
+{
+
+
+// Integer range analysis of loops that proves array accesses to be in bounds. When the condition
+// of a while loop is i < len(a), or a for loop counts i up to len(a), every a[i] of the body is below
+// the length of a until something that may change i or the length of a runs. The index is never negative either when i
+// is a variable no other name, array or function can reach that starts and stays non-negative.
+// Proven IndexExpr nodes are marked inBounds and read their element without comparing the index.
+class RangeAnalysis
+{
+public:
+	// Returns the number of index expressions proven to be in bounds
+	static size_t run(shared_ptr<Program> program);
+
+private:
+	// The object bound to index is less than the length of the object bound to array
+	struct Fact
+	{
+		symbol_t index;
+		symbol_t array;
+	};
+
+	struct Variable
+	{
+		size_t declarations = 0;
+		shared_ptr<Expr> value;						// Of its declaration, null for an argument
+		const FunctionExpr* function = nullptr;		// Declaring it, null at the top level
+		unordered_set<const FunctionExpr*> users;	// Functions referring to it
+		vector<pair<string, shared_ptr<Expr>>> updates;		// Operators and values of its assignments, null for ++ and --
+		bool escapes = false;		// Whether an array, another name or a caller may hold its object
+		enum { Unknown, Visiting, Yes, No } nonNegative = Unknown;
+	};
+
+	struct Context
+	{
+		unordered_map<symbol_t, Variable> variables;
+		unordered_map<IndexExpr*, bool> indexes;		// Whether every path that reaches an index proves it
+	};
+
+	// The effects of a loop on the facts holding before it
+	struct Summary
+	{
+		bool all = false;
+		unordered_set<symbol_t> symbols;
+	};
+
+	static void scan(const shared_ptr<Node>& node, const FunctionExpr* function, Context& context, vector<shared_ptr<CallExpr>>& calls);
+	static void escape(const shared_ptr<Node>& node, Context& context);
+	static void walk(const shared_ptr<Node>& node, vector<Fact>& facts, Context& context);
+	static void summarize(const shared_ptr<Node>& node, Summary& summary, const Context& context);
+
+	// The fact a loop condition such as i < len(a) establishes in the body
+	static bool bound(const shared_ptr<Expr>& condition, Fact& fact, Context& context);
+	// The array whose length is not below the value of length
+	static const IdentifierExpr* limit(shared_ptr<Expr> length, Context& context);
+	static bool non_negative(symbol_t symbol, Context& context);
+	static bool non_negative(const shared_ptr<Expr>& expr, Context& context);
+	static bool is_pure(const shared_ptr<CallExpr>& call, const Context& context);
+	static const IdentifierExpr* length_of(const shared_ptr<Expr>& expr, const Context& context);
+	static void kill(vector<Fact>& facts, symbol_t symbol);
+};
+
+
+}
\ No newline at end of file
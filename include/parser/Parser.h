@@ -8,6 +8,7 @@
 #include "ast/ArgumentsStat.hpp"
 #include "ast/ExpressionsStat.hpp"
 #include "ast/WhileStat.hpp"
+#include "ast/ForStat.hpp"
 #include "ast/VarStat.hpp"
 #include <functional>
 
@@ -53,8 +54,10 @@ private:
 	shared_ptr<ReturnStat> parse_return_stat();
 	shared_ptr<BlockStat> parse_block_stat();
 	shared_ptr<WhileStat> parse_while_stat();
+	shared_ptr<ForStat> parse_for_stat();
 
 	shared_ptr<ArgumentsStat> parse_args();
+	bool parse_annotation(Annotation& annotation);
 	shared_ptr<ExpressionsStat> parse_exprs(Token::Type end);
 
 	shared_ptr<Expr> parse_expr(PrecedenceType precedence);
@@ -67,6 +70,7 @@ private:
 	shared_ptr<Expr> parse_function();
 	shared_ptr<Expr> parse_string();
 	shared_ptr<Expr> parse_array();
+	shared_ptr<Expr> parse_map();
 	shared_ptr<Expr> parse_in_decrement();
 
 	shared_ptr<Expr> parse_infix(shared_ptr<Expr> left);
@@ -93,6 +97,7 @@ private:
 		{ Token::String,			bind(&Parser::parse_string, this) },
 		{ Token::Fun,				bind(&Parser::parse_function, this) },
 		{ Token::LBracket,			bind(&Parser::parse_array, this) },
+		{ Token::LBrace,			bind(&Parser::parse_map, this) },
 		{ Token::Increment,			bind(&Parser::parse_in_decrement, this) }, 
 		{ Token::Decrement,			bind(&Parser::parse_in_decrement, this) } 
 	};
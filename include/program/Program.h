@@ -4,6 +4,11 @@
 #include <fstream>
 #include <filesystem>
 #include "object/Environment.hpp"
+#include "evaluator/Evaluator.h"
+#include "optimizer/Inliner.h"
+#include "optimizer/LoopInvariants.h"
+#include "optimizer/RangeAnalysis.h"
+#include "ir/PassManager.h"
 
 namespace li::program
 {
@@ -25,8 +30,13 @@ private:
 	string read_folder_sources(const filesystem::path& folder);
 	void change_write_file(const string& fileName);
 	string get_source_file_name();
+	void load_preread_sources();
+	shared_ptr<li::Program> parse(const string& input);
 	void parse_source(const string& input, shared_ptr<Environment> inner, shared_ptr<Environment> outer);
+	int emit_ir(const string& input);
+	int emit_cpp(const string& input, const string& fileName);
 	int repl();
+	void print_stats();
 
 private:
 	vector<string> _argv;
@@ -35,6 +45,11 @@ private:
 	ostream* _out;
 	ofstream _outFile;
 	shared_ptr<Environment> _prereadEnv;
+	shared_ptr<Evaluator> _evaluator;
+	shared_ptr<Inliner> _inliner;
+	shared_ptr<ir::PassManager> _passes;
+	bool _licm = false;
+	bool _ranges = false;
 };
 
 
@@ -0,0 +1,220 @@
+#include "analysis/ElementUses.h"
+#include "analysis/Traversal.h"
+#include "ast/ExpressionStat.hpp"
+#include "ast/ExpressionsStat.hpp"
+#include "ast/LetStat.hpp"
+#include "ast/VarStat.hpp"
+#include "ast/ReturnStat.hpp"
+#include "ast/CallExpr.hpp"
+#include "ast/InfixExpr.hpp"
+#include "ast/PrefixExpr.hpp"
+#include "ast/IfExpr.hpp"
+#include "ast/AssignExpr.hpp"
+#include "ast/InDecrementExpr.hpp"
+#include "ast/ArrayExpr.hpp"
+#include "ast/SliceExpr.hpp"
+#include "ast/WhileStat.hpp"
+#include "ast/InvariantExpr.hpp"
+#include "ast/TempExpr.hpp"
+
+namespace li
+{
+
+
+void ElementUses::analyze(const shared_ptr<Program>& program)
+{
+	Context context;
+	block(program->statements, true, context);
+	apply(context);
+}
+
+void ElementUses::analyze(const shared_ptr<FunctionExpr>& fun)
+{
+	Context context;
+	block(fun->body->statements, true, context);
+	apply(context);
+}
+
+void ElementUses::visit(const shared_ptr<Node>& node, bool retained, Context& context)
+{
+	if (!node) return;
+
+	switch (node->type)
+	{
+
+	case Node::Type::Program:
+		block(static_pointer_cast<Program>(node)->statements, true, context);
+		return;
+
+	case Node::Type::Block:
+		block(static_pointer_cast<BlockStat>(node)->statements, retained, context);
+		return;
+
+	case Node::Type::ExprStat:
+		visit(static_pointer_cast<ExpressionStat>(node)->expression, retained, context);
+		return;
+
+	case Node::Type::Identifier:
+		reference(static_pointer_cast<IdentifierExpr>(node)->symbol, retained, context);
+		return;
+
+	case Node::Type::Function:
+		context.depth++;
+		visit(static_pointer_cast<FunctionExpr>(node)->body, true, context);
+		context.depth--;
+		return;
+
+	// Arguments are copied into the frame of the callee
+	case Node::Type::Call:
+	{
+		auto cast = static_pointer_cast<CallExpr>(node);
+		visit(cast->fun, false, context);
+		for (const auto& arg : cast->exprs->expressions)
+		{
+			visit(arg, false, context);
+		}
+		return;
+	}
+
+	case Node::Type::Infix:
+	{
+		auto cast = static_pointer_cast<InfixExpr>(node);
+		visit(cast->left, false, context);
+		visit(cast->right, false, context);
+		return;
+	}
+
+	case Node::Type::Prefix:
+		visit(static_pointer_cast<PrefixExpr>(node)->right, false, context);
+		return;
+
+	case Node::Type::If:
+	{
+		auto cast = static_pointer_cast<IfExpr>(node);
+		visit(cast->condition, false, context);
+		visit(cast->consequence, retained, context);
+		visit(cast->alternative, retained, context);
+		return;
+	}
+
+	// = results in its value, the other assignments in a new object
+	case Node::Type::Assign:
+	{
+		auto cast = static_pointer_cast<AssignExpr>(node);
+		target(cast->id, context);
+		visit(cast->value, retained && cast->operatorName == "=", context);
+		return;
+	}
+
+	case Node::Type::InDecrement:
+		target(static_pointer_cast<InDecrementExpr>(node)->id, context);
+		return;
+
+	case Node::Type::Index:
+	{
+		auto cast = static_pointer_cast<IndexExpr>(node);
+		context.indexes[cast.get()] |= retained;
+		visit(cast->left, false, context);
+		visit(cast->index, false, context);
+		return;
+	}
+
+	// A view keeps the array it is made of, not its elements, and the bounds are only read
+	case Node::Type::Slice:
+	{
+		auto cast = static_pointer_cast<SliceExpr>(node);
+		visit(cast->left, retained, context);
+		visit(cast->from, false, context);
+		visit(cast->to, false, context);
+		return;
+	}
+
+	// The value of the body is dropped after every iteration
+	case Node::Type::While:
+	{
+		auto cast = static_pointer_cast<WhileStat>(node);
+		visit(cast->condition, false, context);
+		visit(cast->body, false, context);
+		return;
+	}
+
+	case Node::Type::For:
+	{
+		auto cast = static_pointer_cast<ForStat>(node);
+		visit(cast->iterable, false, context);
+		visit(cast->end, false, context);
+		context.fors[cast.get()];
+		context.loops.push_back({ cast.get(), context.depth });
+		visit(cast->body, false, context);
+		context.loops.pop_back();
+		return;
+	}
+
+	case Node::Type::Invariant:
+		visit(static_pointer_cast<InvariantExpr>(node)->expr, retained, context);
+		return;
+
+	case Node::Type::Temp:
+		visit(static_pointer_cast<TempExpr>(node)->expr, retained, context);
+		return;
+
+	// Names, arrays and return values keep what they are given
+	default:
+		for_each_child(node, [&](const shared_ptr<Node>& child) { visit(child, true, context); });
+		return;
+
+	}
+}
+
+void ElementUses::block(const vector<shared_ptr<Stat>>& statements, bool retained, Context& context)
+{
+	for (size_t i = 0; i < statements.size(); i++)
+	{
+		visit(statements[i], retained && i + 1 == statements.size(), context);
+	}
+}
+
+// An element assigned is stored back into its array, a name is changed in place
+void ElementUses::target(const shared_ptr<Expr>& id, Context& context)
+{
+	if (id->type == Node::Type::Index)
+	{
+		auto cast = static_pointer_cast<IndexExpr>(id);
+		context.indexes[cast.get()];
+		visit(cast->left, false, context);
+		visit(cast->index, false, context);
+		return;
+	}
+	if (id->type == Node::Type::Identifier)
+	{
+		reference(static_pointer_cast<IdentifierExpr>(id)->symbol, true, context);
+		return;
+	}
+	visit(id, true, context);
+}
+
+void ElementUses::reference(symbol_t symbol, bool retained, Context& context)
+{
+	for (const auto& loop : context.loops)
+	{
+		if (loop.node->name->symbol == symbol && (retained || context.depth > loop.depth))
+		{
+			context.fors[loop.node] = true;
+		}
+	}
+}
+
+void ElementUses::apply(Context& context)
+{
+	for (const auto& [index, retained] : context.indexes)
+	{
+		index->consumed = !retained;
+	}
+	for (const auto& [loop, retained] : context.fors)
+	{
+		loop->copies = !retained;
+	}
+}
+
+
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "analysis/FreeVariables.h"
+#include "analysis/Traversal.h"
+#include "ast/LetStat.hpp"
+#include "ast/VarStat.hpp"
+#include "ast/ForStat.hpp"
+
+namespace li
+{
+
+
+void FreeVariables::analyze(shared_ptr<Program> program)
+{
+	Context context;
+	context.isProgram = true;
+	collect(program, context);
+	analyze_nested(context, &context.declared);
+	program->analyzed = true;
+}
+
+void FreeVariables::analyze(shared_ptr<FunctionExpr> fun)
+{
+	analyze_function(fun, nullptr);
+}
+
+void FreeVariables::analyze_function(shared_ptr<FunctionExpr> fun, const unordered_set<symbol_t>* enclosing)
+{
+	Context context;
+	collect(fun->body, context);
+
+	// Declarations of every enclosing function may also be late for the nested ones
+	unordered_set<symbol_t> scope = context.declared;
+	if (enclosing)
+	{
+		scope.insert(enclosing->begin(), enclosing->end());
+	}
+	analyze_nested(context, enclosing ? &scope : nullptr);
+
+	unordered_set<symbol_t> args;
+	for (const auto& arg : fun->args->args)
+	{
+		args.insert(arg->symbol);
+	}
+
+	auto freeVars = make_shared<vector<symbol_t>>();
+	fun->lateBound.clear();
+	for (auto symbol : context.references)
+	{
+		if (args.count(symbol)) continue;
+
+		// A name also declared in this function may refer to either binding, so it is looked up by name
+		if (!context.declared.count(symbol))
+		{
+			for (const auto& id : context.ids[symbol])
+			{
+				id->captureIndex = static_cast<int>(freeVars->size());
+			}
+		}
+		freeVars->push_back(symbol);
+		fun->lateBound.push_back(!enclosing || enclosing->count(symbol));
+	}
+
+	// Escape analysis of the frame: a nested function only falls back to keeping its defining chain
+	// when one of its free variables may be declared late by the enclosing code
+	fun->frameEscapes = false;
+	for (const auto& nested : context.functions)
+	{
+		for (bool late : nested->lateBound)
+		{
+			fun->frameEscapes = fun->frameEscapes || late;
+		}
+	}
+
+	fun->freeVars = freeVars;
+	fun->analyzed = true;
+}
+
+void FreeVariables::analyze_nested(Context& context, const unordered_set<symbol_t>* enclosing)
+{
+	for (const auto& nested : context.functions)
+	{
+		analyze_function(nested, enclosing);
+		for (auto symbol : *nested->freeVars)
+		{
+			reference(context, symbol);
+		}
+	}
+}
+
+void FreeVariables::collect(const shared_ptr<Node>& node, Context& context)
+{
+	switch (node->type)
+	{
+
+	case Node::Type::Identifier:
+	{
+		auto cast = static_pointer_cast<IdentifierExpr>(node);
+		reference(context, cast->symbol);
+		context.ids[cast->symbol].push_back(cast);
+		return;
+	}
+
+	case Node::Type::Let:
+		declare(context, static_pointer_cast<LetStat>(node)->name->symbol);
+		break;
+
+	case Node::Type::Var:
+		declare(context, static_pointer_cast<VarStat>(node)->name->symbol);
+		break;
+
+	case Node::Type::Function:
+		context.functions.push_back(static_pointer_cast<FunctionExpr>(node));
+		return;
+
+	case Node::Type::While:
+	{
+		context.loopDepth++;
+		for_each_child(node, [&](const shared_ptr<Node>& child) { collect(child, context); });
+		context.loopDepth--;
+		return;
+	}
+
+	case Node::Type::For:
+	{
+		// The range is evaluated once outside of the scope the name is bound in
+		auto cast = static_pointer_cast<ForStat>(node);
+		collect(cast->iterable, context);
+		if (cast->end) collect(cast->end, context);
+		context.loopDepth++;
+		declare(context, cast->name->symbol);
+		collect(cast->body, context);
+		context.loopDepth--;
+		return;
+	}
+
+	default:
+		break;
+
+	}
+
+	for_each_child(node, [&](const shared_ptr<Node>& child) { collect(child, context); });
+}
+
+void FreeVariables::reference(Context& context, symbol_t symbol)
+{
+	if (context.ids.count(symbol)) return;
+
+	context.ids[symbol];
+	context.references.push_back(symbol);
+}
+
+void FreeVariables::declare(Context& context, symbol_t symbol)
+{
+	// Top level declarations outside of loops live in the global scope
+	if (context.isProgram && context.loopDepth == 0) return;
+
+	context.declared.insert(symbol);
+}
+
+
+}
\ No newline at end of file
@@ -0,0 +1,286 @@
+#include "analysis/Traversal.h"
+#include "ast/Program.hpp"
+#include "ast/ExpressionStat.hpp"
+#include "ast/LetStat.hpp"
+#include "ast/VarStat.hpp"
+#include "ast/ReturnStat.hpp"
+#include "ast/BlockStat.hpp"
+#include "ast/ExpressionsStat.hpp"
+#include "ast/CallExpr.hpp"
+#include "ast/FunctionExpr.hpp"
+#include "ast/InfixExpr.hpp"
+#include "ast/PrefixExpr.hpp"
+#include "ast/IfExpr.hpp"
+#include "ast/AssignExpr.hpp"
+#include "ast/InDecrementExpr.hpp"
+#include "ast/ArrayExpr.hpp"
+#include "ast/MapExpr.hpp"
+#include "ast/IndexExpr.hpp"
+#include "ast/SliceExpr.hpp"
+#include "ast/WhileStat.hpp"
+#include "ast/ForStat.hpp"
+#include "ast/InvariantExpr.hpp"
+#include "ast/TempExpr.hpp"
+
+namespace li
+{
+
+
+void for_each_child(const shared_ptr<Node>& node, const function<void(const shared_ptr<Node>&)>& visit)
+{
+	auto visit_if = [&](const shared_ptr<Node>& child)
+	{
+		if (child) visit(child);
+	};
+
+	switch (node->type)
+	{
+
+	case Node::Type::Program:
+		for (const auto& statement : static_pointer_cast<Program>(node)->statements)
+		{
+			visit_if(statement);
+		}
+		break;
+
+	case Node::Type::Block:
+		for (const auto& statement : static_pointer_cast<BlockStat>(node)->statements)
+		{
+			visit_if(statement);
+		}
+		break;
+
+	case Node::Type::Exprs:
+		for (const auto& expr : static_pointer_cast<ExpressionsStat>(node)->expressions)
+		{
+			visit_if(expr);
+		}
+		break;
+
+	case Node::Type::ExprStat:
+		visit_if(static_pointer_cast<ExpressionStat>(node)->expression);
+		break;
+
+	case Node::Type::Let:
+		visit_if(static_pointer_cast<LetStat>(node)->value);
+		break;
+
+	case Node::Type::Var:
+		visit_if(static_pointer_cast<VarStat>(node)->value);
+		break;
+
+	case Node::Type::Return:
+		visit_if(static_pointer_cast<ReturnStat>(node)->value);
+		break;
+
+	case Node::Type::Call:
+	{
+		auto cast = static_pointer_cast<CallExpr>(node);
+		visit_if(cast->fun);
+		visit_if(cast->exprs);
+		break;
+	}
+
+	case Node::Type::Function:
+		visit_if(static_pointer_cast<FunctionExpr>(node)->body);
+		break;
+
+	case Node::Type::Infix:
+	{
+		auto cast = static_pointer_cast<InfixExpr>(node);
+		visit_if(cast->left);
+		visit_if(cast->right);
+		break;
+	}
+
+	case Node::Type::Prefix:
+		visit_if(static_pointer_cast<PrefixExpr>(node)->right);
+		break;
+
+	case Node::Type::If:
+	{
+		auto cast = static_pointer_cast<IfExpr>(node);
+		visit_if(cast->condition);
+		visit_if(cast->consequence);
+		visit_if(cast->alternative);
+		break;
+	}
+
+	case Node::Type::Assign:
+	{
+		auto cast = static_pointer_cast<AssignExpr>(node);
+		visit_if(cast->id);
+		visit_if(cast->value);
+		break;
+	}
+
+	case Node::Type::InDecrement:
+		visit_if(static_pointer_cast<InDecrementExpr>(node)->id);
+		break;
+
+	case Node::Type::Array:
+		visit_if(static_pointer_cast<ArrayExpr>(node)->elements);
+		break;
+
+	case Node::Type::Map:
+		visit_if(static_pointer_cast<MapExpr>(node)->entries);
+		break;
+
+	case Node::Type::Index:
+	{
+		auto cast = static_pointer_cast<IndexExpr>(node);
+		visit_if(cast->left);
+		visit_if(cast->index);
+		break;
+	}
+
+	case Node::Type::Slice:
+	{
+		auto cast = static_pointer_cast<SliceExpr>(node);
+		visit_if(cast->left);
+		visit_if(cast->from);
+		visit_if(cast->to);
+		break;
+	}
+
+	case Node::Type::While:
+	{
+		auto cast = static_pointer_cast<WhileStat>(node);
+		visit_if(cast->condition);
+		visit_if(cast->body);
+		break;
+	}
+
+	case Node::Type::For:
+	{
+		auto cast = static_pointer_cast<ForStat>(node);
+		visit_if(cast->iterable);
+		visit_if(cast->end);
+		visit_if(cast->body);
+		break;
+	}
+
+	case Node::Type::Invariant:
+		visit_if(static_pointer_cast<InvariantExpr>(node)->expr);
+		break;
+
+	case Node::Type::Temp:
+		visit_if(static_pointer_cast<TempExpr>(node)->expr);
+		break;
+
+	default:
+		break;
+
+	}
+}
+
+void for_each_expr_slot(const shared_ptr<Node>& node, const function<void(shared_ptr<Expr>&)>& visit)
+{
+	auto visit_if = [&](shared_ptr<Expr>& child)
+	{
+		if (child) visit(child);
+	};
+
+	switch (node->type)
+	{
+
+	case Node::Type::Exprs:
+		for (auto& expr : static_pointer_cast<ExpressionsStat>(node)->expressions)
+		{
+			visit_if(expr);
+		}
+		break;
+
+	case Node::Type::ExprStat:
+		visit_if(static_pointer_cast<ExpressionStat>(node)->expression);
+		break;
+
+	case Node::Type::Let:
+		visit_if(static_pointer_cast<LetStat>(node)->value);
+		break;
+
+	case Node::Type::Var:
+		visit_if(static_pointer_cast<VarStat>(node)->value);
+		break;
+
+	case Node::Type::Return:
+		visit_if(static_pointer_cast<ReturnStat>(node)->value);
+		break;
+
+	case Node::Type::Call:
+		visit_if(static_pointer_cast<CallExpr>(node)->fun);
+		break;
+
+	case Node::Type::Infix:
+	{
+		auto cast = static_pointer_cast<InfixExpr>(node);
+		visit_if(cast->left);
+		visit_if(cast->right);
+		break;
+	}
+
+	case Node::Type::Prefix:
+		visit_if(static_pointer_cast<PrefixExpr>(node)->right);
+		break;
+
+	case Node::Type::If:
+		visit_if(static_pointer_cast<IfExpr>(node)->condition);
+		break;
+
+	case Node::Type::Assign:
+	{
+		auto cast = static_pointer_cast<AssignExpr>(node);
+		visit_if(cast->id);
+		visit_if(cast->value);
+		break;
+	}
+
+	case Node::Type::InDecrement:
+		visit_if(static_pointer_cast<InDecrementExpr>(node)->id);
+		break;
+
+	case Node::Type::Index:
+	{
+		auto cast = static_pointer_cast<IndexExpr>(node);
+		visit_if(cast->left);
+		visit_if(cast->index);
+		break;
+	}
+
+	case Node::Type::Slice:
+	{
+		auto cast = static_pointer_cast<SliceExpr>(node);
+		visit_if(cast->left);
+		visit_if(cast->from);
+		visit_if(cast->to);
+		break;
+	}
+
+	case Node::Type::While:
+		visit_if(static_pointer_cast<WhileStat>(node)->condition);
+		break;
+
+	case Node::Type::For:
+	{
+		auto cast = static_pointer_cast<ForStat>(node);
+		visit_if(cast->iterable);
+		visit_if(cast->end);
+		break;
+	}
+
+	case Node::Type::Invariant:
+		visit_if(static_pointer_cast<InvariantExpr>(node)->expr);
+		break;
+
+	case Node::Type::Temp:
+		visit_if(static_pointer_cast<TempExpr>(node)->expr);
+		break;
+
+	default:
+		break;
+
+	}
+}
+
+
+}
\ No newline at end of file
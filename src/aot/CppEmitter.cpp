@@ -0,0 +1,485 @@
+#include "aot/CppEmitter.h"
+#include "ir/Builder.h"
+#include "ir/PassManager.h"
+#include "ir/Lowering.h"
+#include "analysis/ElementUses.h"
+#include "ast/ExpressionStat.hpp"
+#include "ast/LetStat.hpp"
+#include "ast/VarStat.hpp"
+#include "ast/ReturnStat.hpp"
+#include "ast/IntegerExpr.hpp"
+#include "ast/FloatExpr.hpp"
+#include "ast/BoolExpr.hpp"
+#include "ast/StringExpr.hpp"
+#include "ast/PrefixExpr.hpp"
+#include "ast/InfixExpr.hpp"
+#include "ast/IfExpr.hpp"
+#include "ast/CallExpr.hpp"
+#include "ast/AssignExpr.hpp"
+#include "ast/ArrayExpr.hpp"
+#include "ast/MapExpr.hpp"
+#include "ast/IndexExpr.hpp"
+#include "ast/SliceExpr.hpp"
+#include "ast/InDecrementExpr.hpp"
+#include "ast/InvariantExpr.hpp"
+#include "ast/TempExpr.hpp"
+#include <iomanip>
+
+namespace li::aot
+{
+
+
+static const char* numeric_op_name(NumericOp op)
+{
+	switch (op)
+	{
+	case NumericOp::Add: return "Add";
+	case NumericOp::Subtract: return "Subtract";
+	case NumericOp::Multiply: return "Multiply";
+	case NumericOp::Divide: return "Divide";
+	case NumericOp::Remainder: return "Remainder";
+	case NumericOp::Equal: return "Equal";
+	case NumericOp::NotEqual: return "NotEqual";
+	case NumericOp::Less: return "Less";
+	case NumericOp::Greater: return "Greater";
+	case NumericOp::LessEqual: return "LessEqual";
+	case NumericOp::GreaterEqual: return "GreaterEqual";
+	default: return "None";
+	}
+}
+
+void CppEmitter::emit(const shared_ptr<Program>& prelude, const shared_ptr<Program>& program, const string& sourceName, ostream& out)
+{
+	for (const auto& node : { prelude, program })
+	{
+		auto module = ir::Builder::build(node);
+		ir::PassManager::specialization()->run(*module);
+		ir::Lowering::run(*module);
+		ElementUses::analyze(node);
+	}
+
+	CppEmitter emitter;
+	auto preludeName = emitter.program(prelude);
+	auto programName = emitter.program(program);
+
+	out << "// Translated from " << sourceName << " by li --emit-cpp\n";
+	out << "#include \"aot/Runtime.h\"\n\n";
+	out << "using namespace li;\n";
+	out << "using namespace li::aot;\n\n";
+	out << "static Runtime rt;\n";
+	for (const auto& text : emitter._statics)
+	{
+		out << text << '\n';
+	}
+	out << '\n';
+	for (const auto& text : emitter._declarations)
+	{
+		out << text << ";\n";
+	}
+	for (const auto& text : emitter._definitions)
+	{
+		out << '\n' << text;
+	}
+	out << "\nint main()\n{\n\treturn rt.run(" << preludeName << ", " << programName << ");\n}\n";
+}
+
+// Returns the value of a return statement and stops at the first error, as evaluate_program does
+string CppEmitter::program(const shared_ptr<Program>& node)
+{
+	begin();
+	line("shared_ptr<Object> result;");
+	for (const auto& stat : node->statements)
+	{
+		statement(stat);
+		line("if (result && result->type == Object::Type::ReturnValue) return static_cast<ReturnValue&>(*result).value;");
+		line("if (result && result->type == Object::Type::Error) return result;");
+	}
+	line("return result;");
+	return end("program", "(const shared_ptr<Environment>& env)");
+}
+
+string CppEmitter::block(const vector<shared_ptr<Stat>>& statements)
+{
+	begin();
+	line("shared_ptr<Object> result;");
+	for (const auto& stat : statements)
+	{
+		statement(stat);
+		line("if (Runtime::ends_block(result)) return result;");
+	}
+	line("return result;");
+	return end("block", "(const shared_ptr<Environment>& env)");
+}
+
+// An expression whose error is its value rather than the end of the enclosing block
+string CppEmitter::expression_function(const shared_ptr<Expr>& expr)
+{
+	begin();
+	line("return " + expression(expr) + ";");
+	return end("expression", "(const shared_ptr<Environment>& env)");
+}
+
+// The element an assignment stores back, with the array and the index it was read with
+string CppEmitter::element_function(const shared_ptr<IndexExpr>& node)
+{
+	begin();
+	auto left = operand(node->left);
+	auto index = operand(node->index);
+	line("array = " + left + ";");
+	line("position = " + index + ";");
+	line(string("return rt.index(array, position, ") + (node->consumed ? "true" : "false") + ");");
+	return end("element", "(const shared_ptr<Environment>& env, shared_ptr<Object>& array, shared_ptr<Object>& position)");
+}
+
+void CppEmitter::statement(const shared_ptr<Stat>& stat)
+{
+	switch (stat->type)
+	{
+
+	case Node::Type::ExprStat:
+		line("result = " + expression(static_pointer_cast<ExpressionStat>(stat)->expression) + ";");
+		break;
+
+	case Node::Type::Let:
+	{
+		auto cast = static_pointer_cast<LetStat>(stat);
+		auto value = operand(cast->value);
+		line("result = rt.declare(env, " + symbol(*cast->name) + ", " + quote(cast->name->value) + ", " + annotation(cast->annotation) + ", " + value + ", false);");
+		break;
+	}
+
+	case Node::Type::Var:
+	{
+		auto cast = static_pointer_cast<VarStat>(stat);
+		auto value = operand(cast->value);
+		line("result = rt.declare(env, " + symbol(*cast->name) + ", " + quote(cast->name->value) + ", " + annotation(cast->annotation) + ", " + value + ", true);");
+		break;
+	}
+
+	case Node::Type::Return:
+		line("result = Runtime::return_value(" + operand(static_pointer_cast<ReturnStat>(stat)->value) + ");");
+		break;
+
+	case Node::Type::Block:
+		line("result = " + block(static_pointer_cast<BlockStat>(stat)->statements) + "(env);");
+		break;
+
+	case Node::Type::While:
+	{
+		// The value of the body is dropped, errors included, and every iteration has its own scope
+		auto cast = static_pointer_cast<WhileStat>(stat);
+		auto condition = expression_function(cast->condition);
+		auto body = block(cast->body->statements);
+		line("while (rt.is_true(" + condition + "(env)))");
+		line("{");
+		line("\t" + body + "(make_shared<Environment>(env, Environment::Kind::Scope));");
+		line("}");
+		line("result = Evaluator::null;");
+		break;
+	}
+
+	case Node::Type::For:
+	{
+		// Unlike a while, the body ends the loop and the enclosing block with a return or an error
+		auto cast = static_pointer_cast<ForStat>(stat);
+		auto iterable = operand(cast->iterable);
+		auto end = cast->end ? operand(cast->end) : "nullptr";
+		auto body = block(cast->body->statements);
+		auto copies = cast->copies ? "true" : "false";
+		line("result = rt.iterate(env, " + symbol(*cast->name) + ", " + iterable + ", " + end + ", " + copies + ", " + body + ");");
+		break;
+	}
+
+	default:
+		line("result = Evaluator::null;");
+		break;
+
+	}
+}
+
+string CppEmitter::expression(const shared_ptr<Expr>& expr)
+{
+	switch (expr->type)
+	{
+
+	case Node::Type::Integer:
+		return value("Runtime::integer(UINT64_C(" + to_string(static_pointer_cast<IntegerExpr>(expr)->value) + "))");
+
+	case Node::Type::Float:
+	{
+		// A hexadecimal literal keeps every bit of the double
+		stringstream literal;
+		literal << hexfloat << static_pointer_cast<FloatExpr>(expr)->value;
+		return value("Runtime::number(" + literal.str() + ")");
+	}
+
+	case Node::Type::Bool:
+		return value(static_pointer_cast<BoolExpr>(expr)->value ? "Evaluator::bool_true" : "Evaluator::bool_false");
+
+	case Node::Type::String:
+		return value("Runtime::string(" + quote(static_pointer_cast<StringExpr>(expr)->value) + ")");
+
+	case Node::Type::Identifier:
+	{
+		auto cast = static_pointer_cast<IdentifierExpr>(expr);
+		return value("rt.identifier(env, " + symbol(*cast) + ", " + quote(cast->value) + ")");
+	}
+
+	case Node::Type::Prefix:
+	{
+		auto cast = static_pointer_cast<PrefixExpr>(expr);
+		auto right = operand(cast->right);
+		return value("rt.prefix(" + quote(cast->operatorName) + ", " + right + ")");
+	}
+
+	case Node::Type::Infix:
+	{
+		auto cast = static_pointer_cast<InfixExpr>(expr);
+		auto left = operand(cast->left);
+		auto right = operand(cast->right);
+		if (cast->feedback.state == Feedback::State::Proven)
+		{
+			return value(string("Runtime::numeric<NumericOp::") + numeric_op_name(cast->numericOp) + ", " +
+				(cast->leftFloat ? "true" : "false") + ", " + (cast->rightFloat ? "true" : "false") + ">(" + left + ", " + right + ")");
+		}
+		return value("rt.infix(" + left + ", " + quote(cast->operatorName) + ", " + right + ")");
+	}
+
+	case Node::Type::If:
+	{
+		auto cast = static_pointer_cast<IfExpr>(expr);
+		auto condition = expression_function(cast->condition);
+		auto consequence = block(cast->consequence->statements);
+		auto alternative = cast->alternative ? block(cast->alternative->statements) + "(env)" : "Evaluator::null";
+		return value("rt.is_true(" + condition + "(env)) ? " + consequence + "(env) : " + alternative);
+	}
+
+	case Node::Type::Function:
+	{
+		auto cast = static_pointer_cast<FunctionExpr>(expr);
+		string args = "static const auto arguments_" + to_string(_statics.size()) + " = Runtime::arguments({ ";
+		for (size_t i = 0; i < cast->args->args.size(); i++)
+		{
+			args += (i ? ", " : "") + string("{ ") + quote(cast->args->args[i]->value) + ", " + annotation(cast->args->annotation(i)) + " }";
+		}
+		args += " }, " + annotation(cast->args->result) + ");";
+		auto name = "arguments_" + to_string(_statics.size());
+		_statics.push_back(args);
+
+		auto body = block(cast->body->statements);
+		return value("rt.closure(env, " + name + ", " + quote(cast->body->toString()) + ", " + body + ")");
+	}
+
+	case Node::Type::Call:
+	{
+		auto cast = static_pointer_cast<CallExpr>(expr);
+		auto callee = operand(cast->fun);
+		return call(cast->exprs->expressions, callee);
+	}
+
+	case Node::Type::Assign:
+	{
+		// Both sides are evaluated before either is checked for an error
+		auto cast = static_pointer_cast<AssignExpr>(expr);
+		if (cast->id->type == Node::Type::Index)
+		{
+			auto left = value("shared_ptr<Object>()");
+			auto index = value("shared_ptr<Object>()");
+			auto id = value(element_function(static_pointer_cast<IndexExpr>(cast->id)) + "(env, " + left + ", " + index + ")");
+			auto assigned = isolated(cast->value);
+			line("if (Runtime::is_error(" + id + ")) return " + id + ";");
+			line("if (Runtime::is_error(" + assigned + ")) return " + assigned + ";");
+			return value("rt.assign_element(" + left + ", " + index + ", " + id + ", " + quote(cast->id->literal()) + ", " + quote(cast->operatorName) + ", " + assigned + ")");
+		}
+		auto id = isolated(cast->id);
+		auto assigned = isolated(cast->value);
+		line("if (Runtime::is_error(" + id + ")) return " + id + ";");
+		line("if (Runtime::is_error(" + assigned + ")) return " + assigned + ";");
+		return value("rt.assign(" + id + ", " + quote(cast->id->literal()) + ", " + quote(cast->operatorName) + ", " + assigned + ")");
+	}
+
+	case Node::Type::Array:
+	{
+		string elements;
+		for (const auto& element : static_pointer_cast<ArrayExpr>(expr)->elements->expressions)
+		{
+			elements += (elements.empty() ? "" : ", ") + operand(element);
+		}
+		return value("Runtime::array({ " + elements + " })");
+	}
+
+	case Node::Type::Map:
+	{
+		string entries;
+		for (const auto& entry : static_pointer_cast<MapExpr>(expr)->entries->expressions)
+		{
+			entries += (entries.empty() ? "" : ", ") + operand(entry);
+		}
+		return value("Evaluator::new_map({ " + entries + " })");
+	}
+
+	case Node::Type::Index:
+	{
+		auto cast = static_pointer_cast<IndexExpr>(expr);
+		auto left = operand(cast->left);
+		auto index = operand(cast->index);
+		return value("rt.index(" + left + ", " + index + ", " + (cast->consumed ? "true" : "false") + ")");
+	}
+
+	case Node::Type::Slice:
+	{
+		auto cast = static_pointer_cast<SliceExpr>(expr);
+		auto left = operand(cast->left);
+		auto from = cast->from ? operand(cast->from) : "nullptr";
+		auto to = cast->to ? operand(cast->to) : "nullptr";
+		return value("Evaluator::evaluate_slice(" + left + ", " + from + ", " + to + ")");
+	}
+
+	case Node::Type::InDecrement:
+	{
+		auto cast = static_pointer_cast<InDecrementExpr>(expr);
+		auto id = operand(cast->id);
+		return value("rt.in_decrement(" + id + ", " + quote(cast->operatorName) + ")");
+	}
+
+	// Values the IR or the loop optimizer would save, computed again
+	case Node::Type::Invariant:
+		return expression(static_pointer_cast<InvariantExpr>(expr)->expr);
+
+	case Node::Type::Temp:
+		return expression(static_pointer_cast<TempExpr>(expr)->expr);
+
+	default:
+		return value("Evaluator::null");
+
+	}
+}
+
+string CppEmitter::operand(const shared_ptr<Expr>& expr)
+{
+	auto name = expression(expr);
+	switch (expr->type)
+	{
+	case Node::Type::Integer:
+	case Node::Type::Float:
+	case Node::Type::Bool:
+	case Node::Type::String:
+	case Node::Type::Function:
+	case Node::Type::Array:
+		break;
+	default:
+		line("if (Runtime::is_error(" + name + ")) return " + name + ";");
+		break;
+	}
+	return name;
+}
+
+// The value of expr without returning from the enclosing function on an error in it
+string CppEmitter::isolated(const shared_ptr<Expr>& expr)
+{
+	switch (expr->type)
+	{
+	case Node::Type::Integer:
+	case Node::Type::Float:
+	case Node::Type::Bool:
+	case Node::Type::String:
+	case Node::Type::Identifier:
+		return expression(expr);
+	default:
+		return value(expression_function(expr) + "(env)");
+	}
+}
+
+string CppEmitter::call(const vector<shared_ptr<Expr>>& args, const string& callee)
+{
+	string values;
+	for (const auto& arg : args)
+	{
+		values += (values.empty() ? "" : ", ") + operand(arg);
+	}
+	return value("rt.call(" + callee + ", { " + values + " })");
+}
+
+CppEmitter::Function& CppEmitter::begin()
+{
+	_stack.emplace_back();
+	return _stack.back();
+}
+
+string CppEmitter::end(const string& prefix, const string& signature)
+{
+	auto name = prefix + "_" + to_string(_functions++);
+	auto head = "static shared_ptr<Object> " + name + signature;
+	_declarations.push_back(head);
+	_definitions.push_back(head + "\n{\n" + _stack.back().body.str() + "}\n");
+	_stack.pop_back();
+	return name;
+}
+
+string CppEmitter::value(const string& init)
+{
+	auto name = "v" + to_string(_stack.back().values++);
+	line("auto " + name + " = " + init + ";");
+	return name;
+}
+
+void CppEmitter::line(const string& text)
+{
+	_stack.back().body << '\t' << text << '\n';
+}
+
+string CppEmitter::symbol(const IdentifierExpr& id)
+{
+	auto symbol = SymbolTable::intern(id.value);
+	auto it = _symbols.find(symbol);
+	if (it != _symbols.end())
+	{
+		return it->second;
+	}
+
+	auto name = "symbol_" + to_string(_symbols.size());
+	_statics.push_back("static const symbol_t " + name + " = SymbolTable::intern(" + quote(id.value) + ");");
+	_symbols.emplace(symbol, name);
+	return name;
+}
+
+string CppEmitter::quote(const string& text)
+{
+	stringstream buffer;
+	buffer << '"';
+	for (unsigned char c : text)
+	{
+		if (c == '"' || c == '\\')
+		{
+			buffer << '\\' << c;
+		}
+		else if (c < 0x20 || c >= 0x7F)
+		{
+			// Always three octal digits, so that a digit after it is not taken as part of it
+			buffer << '\\' << oct << setw(3) << setfill('0') << static_cast<int>(c) << dec;
+		}
+		else
+		{
+			buffer << c;
+		}
+	}
+	buffer << '"';
+	return buffer.str();
+}
+
+string CppEmitter::annotation(Annotation annotation)
+{
+	switch (annotation)
+	{
+	case Annotation::Integer: return "Annotation::Integer";
+	case Annotation::Float: return "Annotation::Float";
+	case Annotation::Bool: return "Annotation::Bool";
+	case Annotation::String: return "Annotation::String";
+	case Annotation::Array: return "Annotation::Array";
+	case Annotation::Function: return "Annotation::Function";
+	default: return "Annotation::None";
+	}
+}
+
+
+}
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include "aot/Runtime.h"
+#include <iostream>
+
+namespace li::aot
+{
+
+
+shared_ptr<ArgumentsStat> Runtime::arguments(initializer_list<pair<const char*, Annotation>> args, Annotation result)
+{
+	auto stat = make_shared<ArgumentsStat>(nullptr);
+	for (const auto& [name, annotation] : args)
+	{
+		auto id = make_shared<IdentifierExpr>(nullptr);
+		id->value = name;
+		id->symbol = SymbolTable::intern(name);
+		stat->args.push_back(id);
+		stat->annotations.push_back(annotation);
+	}
+	stat->result = result;
+	return stat;
+}
+
+bool Runtime::is_true(const Value& value)
+{
+	return _evaluator.is_true(value);
+}
+
+Runtime::Value Runtime::identifier(const shared_ptr<Environment>& env, symbol_t symbol, const char* name)
+{
+	if (auto* value = env->get(symbol))
+	{
+		return *value;
+	}
+
+	auto it = Evaluator::builtinFuns.find(name);
+	if (it == Evaluator::builtinFuns.end())
+	{
+		return Evaluator::identifier_not_found(name);
+	}
+	return it->second;
+}
+
+Runtime::Value Runtime::declare(const shared_ptr<Environment>& env, symbol_t symbol, const char* name, Annotation annotation, const Value& value, bool isMutable)
+{
+	if (!Evaluator::is_annotated(annotation, value))
+	{
+		return Evaluator::annotation_mismatch(name, annotation, value->typeName());
+	}
+	if (env->find(symbol) != nullptr)
+	{
+		return Evaluator::repeat_declaration(name);
+	}
+
+	env->add(symbol, Evaluator::declared(value, isMutable));
+	return Evaluator::null;
+}
+
+Runtime::Value Runtime::prefix(const char* operatorName, const Value& right)
+{
+	return _evaluator.evaluate_prefix(operatorName, right);
+}
+
+Runtime::Value Runtime::infix(const Value& left, const char* operatorName, const Value& right)
+{
+	return _evaluator.evaluate_infix(left, operatorName, right);
+}
+
+Runtime::Value Runtime::assign(const Value& id, const char* literal, const char* operatorName, const Value& value)
+{
+	if (!id->isMutable)
+	{
+		return Evaluator::access_immutable_var(literal);
+	}
+	return _evaluator.evaluate_assign(id, operatorName, value, nullptr);
+}
+
+Runtime::Value Runtime::in_decrement(const Value& id, const char* operatorName)
+{
+	return _evaluator.evaluate_in_decrement(id, operatorName, nullptr);
+}
+
+Runtime::Value Runtime::index(const Value& left, const Value& index, bool consumed)
+{
+	return _evaluator.evaluate_index(left, index, consumed);
+}
+
+Runtime::Value Runtime::assign_element(const Value& left, const Value& index, const Value& element, const char* literal, const char* operatorName, const Value& value)
+{
+	return _evaluator.assign_element(left, index, element, literal, operatorName, value, nullptr);
+}
+
+Runtime::Value Runtime::call(const Value& fun, const vector<Value>& args)
+{
+	return _evaluator.evaluate_fun(fun, args);
+}
+
+Runtime::Value Runtime::closure(const shared_ptr<Environment>& env, const shared_ptr<ArgumentsStat>& args, const char* text, Function::Native native)
+{
+	// Without the analysis of free variables the function keeps the whole chain it was created in
+	auto fun = make_shared<Function>(args, nullptr, env);
+	fun->native = native;
+	fun->text = text;
+	return fun;
+}
+
+Runtime::Value Runtime::iterate(const shared_ptr<Environment>& env, symbol_t symbol, const Value& iterable, const Value& end, bool copies, Function::Native body)
+{
+	return _evaluator.iterate(symbol, iterable, end, copies, env, body);
+}
+
+int Runtime::run(Function::Native prelude, Function::Native program)
+{
+	auto preludeEnv = make_shared<Environment>();
+	report(prelude(preludeEnv));
+	report(program(make_shared<Environment>(preludeEnv)));
+	return 0;
+}
+
+void Runtime::report(const Value& value)
+{
+	if (!value || value->type == Object::Type::Null)
+	{
+		return;
+	}
+
+	if (value->type == Object::Type::Error)
+	{
+		cerr << "evaluator has an error: " << '\n';
+	}
+	cout << value->inspect() << '\n';
+}
+
+
+}
\ No newline at end of file
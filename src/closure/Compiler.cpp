@@ -0,0 +1,728 @@
+#include "closure/Compiler.h"
+#include "object/Error.hpp"
+#include "object/ReturnValue.hpp"
+#include "object/String.hpp"
+#include "ast/IntegerExpr.hpp"
+#include "ast/FloatExpr.hpp"
+#include "ast/StringExpr.hpp"
+#include "ast/ArrayExpr.hpp"
+#include "ast/MapExpr.hpp"
+#include "ast/SliceExpr.hpp"
+#include "ast/ReturnStat.hpp"
+#include "ast/LetStat.hpp"
+#include "ast/VarStat.hpp"
+#include "ast/ExpressionStat.hpp"
+
+namespace li::closure
+{
+
+
+Value Compiler::run(Evaluator& evaluator, Program& program, const shared_ptr<Environment>& env)
+{
+	if (!program.tree)
+	{
+		auto statements = Compiler::statements(program.statements);
+		program.tree = make_shared<Tree>();
+		program.tree->code = [statements = move(statements)](Evaluator& evaluator, const shared_ptr<Environment>& env) -> Value
+		{
+			auto result = statements(evaluator, env);
+			if (result && result->type == Object::Type::ReturnValue)
+			{
+				return static_cast<ReturnValue&>(*result).value;
+			}
+			return result;
+		};
+	}
+	return program.tree->code(evaluator, env);
+}
+
+Value Compiler::call(Evaluator& evaluator, FunctionExpr& fun, const shared_ptr<Environment>& env)
+{
+	if (!fun.tree)
+	{
+		fun.tree = make_shared<Tree>();
+		fun.tree->code = statements(fun.body->statements);
+	}
+	return fun.tree->code(evaluator, env);
+}
+
+Code Compiler::statements(const vector<shared_ptr<Stat>>& statements)
+{
+	vector<Code> codes;
+	for (const auto& statement : statements)
+	{
+		codes.push_back(node(statement));
+	}
+
+	if (codes.size() == 1)
+	{
+		return codes.front();
+	}
+	return [codes = move(codes)](Evaluator& evaluator, const shared_ptr<Environment>& env) -> Value
+	{
+		Value result;
+		for (const auto& code : codes)
+		{
+			result = code(evaluator, env);
+
+			if (!result) continue;
+
+			if (result->type == Object::Type::ReturnValue || result->type == Object::Type::Error)
+			{
+				return result;
+			}
+		}
+		return result;
+	};
+}
+
+vector<Code> Compiler::nodes(const vector<shared_ptr<Expr>>& exprs)
+{
+	vector<Code> codes;
+	for (const auto& expr : exprs)
+	{
+		codes.push_back(node(expr));
+	}
+	return codes;
+}
+
+Value Compiler::values(const vector<Code>& exprs, Evaluator& evaluator, const shared_ptr<Environment>& env, vector<Value>& values)
+{
+	values.reserve(exprs.size());
+	for (const auto& expr : exprs)
+	{
+		auto value = expr(evaluator, env);
+		if (value->type == Object::Type::Error)
+		{
+			return value;
+		}
+		values.push_back(move(value));
+	}
+	return nullptr;
+}
+
+Code Compiler::node(const shared_ptr<Node>& node)
+{
+	switch (node->type)
+	{
+
+	case Node::Type::ExprStat:
+		return Compiler::node(static_pointer_cast<ExpressionStat>(node)->expression);
+
+	case Node::Type::Block:
+		return statements(static_pointer_cast<BlockStat>(node)->statements);
+
+	case Node::Type::Integer:
+		return [value = static_pointer_cast<IntegerExpr>(node)->value](Evaluator&, const shared_ptr<Environment>&) -> Value
+		{
+			return make_shared<Integer>(value);
+		};
+
+	case Node::Type::Float:
+		return [value = static_pointer_cast<FloatExpr>(node)->value](Evaluator&, const shared_ptr<Environment>&) -> Value
+		{
+			return make_shared<Float>(value);
+		};
+
+	case Node::Type::Bool:
+		return [value = Evaluator::bool_to_object(static_pointer_cast<BoolExpr>(node)->value)](Evaluator&, const shared_ptr<Environment>&) -> Value
+		{
+			return value;
+		};
+
+	case Node::Type::String:
+		return [value = static_pointer_cast<StringExpr>(node)->value](Evaluator&, const shared_ptr<Environment>&) -> Value
+		{
+			return make_shared<String>(value);
+		};
+
+	case Node::Type::Prefix:
+		return prefix(static_pointer_cast<PrefixExpr>(node));
+
+	case Node::Type::Infix:
+		return infix(static_pointer_cast<InfixExpr>(node));
+
+	case Node::Type::If:
+		return if_(static_pointer_cast<IfExpr>(node));
+
+	case Node::Type::Return:
+		return [value = Compiler::node(static_pointer_cast<ReturnStat>(node)->value)](Evaluator& evaluator, const shared_ptr<Environment>& env) -> Value
+		{
+			auto result = value(evaluator, env);
+			if (result->type == Object::Type::Error)
+			{
+				return result;
+			}
+			return make_shared<ReturnValue>(result);
+		};
+
+	case Node::Type::Let:
+	{
+		auto cast = static_pointer_cast<LetStat>(node);
+		return declaration(cast->name, cast->annotation, cast->value, false);
+	}
+
+	case Node::Type::Var:
+	{
+		auto cast = static_pointer_cast<VarStat>(node);
+		return declaration(cast->name, cast->annotation, cast->value, true);
+	}
+
+	case Node::Type::Identifier:
+		return [id = static_pointer_cast<IdentifierExpr>(node)](Evaluator& evaluator, const shared_ptr<Environment>& env)
+		{
+			return evaluator.evaluate_id(id, env);
+		};
+
+	case Node::Type::Function:
+		return [fun = static_pointer_cast<FunctionExpr>(node)](Evaluator& evaluator, const shared_ptr<Environment>& env)
+		{
+			return evaluator.evaluate_closure(fun, env);
+		};
+
+	case Node::Type::Call:
+		return call(static_pointer_cast<CallExpr>(node));
+
+	case Node::Type::Assign:
+		return assign(static_pointer_cast<AssignExpr>(node));
+
+	case Node::Type::Array:
+		return [elements = nodes(static_pointer_cast<ArrayExpr>(node)->elements->expressions)](Evaluator& evaluator, const shared_ptr<Environment>& env) -> Value
+		{
+			vector<Value> objects;
+			if (auto error = values(elements, evaluator, env, objects))
+			{
+				return error;
+			}
+			return make_shared<Array>(move(objects));
+		};
+
+	case Node::Type::Map:
+		return [entries = nodes(static_pointer_cast<MapExpr>(node)->entries->expressions)](Evaluator& evaluator, const shared_ptr<Environment>& env) -> Value
+		{
+			vector<Value> objects;
+			if (auto error = values(entries, evaluator, env, objects))
+			{
+				return error;
+			}
+			return Evaluator::new_map(move(objects));
+		};
+
+	case Node::Type::Index:
+		return index(static_pointer_cast<IndexExpr>(node));
+
+	case Node::Type::Slice:
+	{
+		auto cast = static_pointer_cast<SliceExpr>(node);
+		auto from = cast->from ? Compiler::node(cast->from) : Code();
+		auto to = cast->to ? Compiler::node(cast->to) : Code();
+		return [left = Compiler::node(cast->left), from, to](Evaluator& evaluator, const shared_ptr<Environment>& env) -> Value
+		{
+			auto leftValue = left(evaluator, env);
+			if (leftValue->type == Object::Type::Error)
+			{
+				return leftValue;
+			}
+			auto fromValue = from ? from(evaluator, env) : nullptr;
+			if (fromValue && fromValue->type == Object::Type::Error)
+			{
+				return fromValue;
+			}
+			auto toValue = to ? to(evaluator, env) : nullptr;
+			if (toValue && toValue->type == Object::Type::Error)
+			{
+				return toValue;
+			}
+			return Evaluator::evaluate_slice(leftValue, fromValue, toValue);
+		};
+	}
+
+	case Node::Type::While:
+		return while_(static_pointer_cast<WhileStat>(node));
+
+	case Node::Type::For:
+		return for_(static_pointer_cast<ForStat>(node));
+
+	case Node::Type::Invariant:
+		return invariant(static_pointer_cast<InvariantExpr>(node));
+
+	case Node::Type::Temp:
+		return temp(static_pointer_cast<TempExpr>(node));
+
+	case Node::Type::InDecrement:
+		return in_decrement(static_pointer_cast<InDecrementExpr>(node));
+
+	default:
+		return [](Evaluator&, const shared_ptr<Environment>&) -> Value
+		{
+			return Evaluator::null;
+		};
+
+	}
+}
+
+Code Compiler::prefix(const shared_ptr<PrefixExpr>& node)
+{
+	auto right = Compiler::node(node->right);
+
+	// Only the negation of a number specializes itself, the other operators never leave the generic path
+	if (node->operatorName == "!")
+	{
+		return [right = move(right)](Evaluator& evaluator, const shared_ptr<Environment>& env)
+		{
+			auto value = right(evaluator, env);
+			if (value->type == Object::Type::Error)
+			{
+				return value;
+			}
+			return evaluator.evaluate_prefix_bang(value);
+		};
+	}
+	if (node->operatorName != "-")
+	{
+		return [node, right = move(right)](Evaluator& evaluator, const shared_ptr<Environment>& env)
+		{
+			auto value = right(evaluator, env);
+			if (value->type == Object::Type::Error)
+			{
+				return value;
+			}
+			return Evaluator::unknown_prefix(node->operatorName, value->typeName());
+		};
+	}
+
+	return [node, right = move(right)](Evaluator& evaluator, const shared_ptr<Environment>& env) -> Value
+	{
+		auto value = right(evaluator, env);
+		if (value->type == Object::Type::Error)
+		{
+			return value;
+		}
+
+		if (node->feedback.state != Feedback::State::Generic)
+		{
+			bool specializable = value->type == Object::Type::Integer || value->type == Object::Type::Float;
+			if (evaluator.guard(node->feedback, value->type, value->type, specializable))
+			{
+				if (value->type == Object::Type::Integer)
+				{
+					return make_shared<Integer>(-static_cast<Integer&>(*value).value);
+				}
+				return make_shared<Float>(-static_cast<Float&>(*value).value);
+			}
+		}
+		return evaluator.evaluate_prefix_minus(value);
+	};
+}
+
+Code Compiler::infix(const shared_ptr<InfixExpr>& node)
+{
+	auto left = Compiler::node(node->left);
+	auto right = Compiler::node(node->right);
+
+	if (node->feedback.state == Feedback::State::Proven && node->numericOp != NumericOp::None)
+	{
+		return numeric(node->numericOp, node->leftFloat, node->rightFloat, move(left), move(right));
+	}
+
+	return [node, left = move(left), right = move(right)](Evaluator& evaluator, const shared_ptr<Environment>& env)
+	{
+		auto leftValue = left(evaluator, env);
+		if (leftValue->type == Object::Type::Error)
+		{
+			return leftValue;
+		}
+		auto rightValue = right(evaluator, env);
+		if (rightValue->type == Object::Type::Error)
+		{
+			return rightValue;
+		}
+
+		if (node->feedback.state != Feedback::State::Generic && evaluator.specialize_infix(*node, *leftValue, *rightValue))
+		{
+			return evaluator.evaluate_infix_numeric(*node, leftValue, rightValue);
+		}
+		return evaluator.evaluate_infix(leftValue, node->operatorName, rightValue);
+	};
+}
+
+Code Compiler::numeric(NumericOp op, bool leftFloat, bool rightFloat, Code left, Code right)
+{
+	switch (op)
+	{
+	case NumericOp::Add: return numeric<NumericOp::Add>(leftFloat, rightFloat, move(left), move(right));
+	case NumericOp::Subtract: return numeric<NumericOp::Subtract>(leftFloat, rightFloat, move(left), move(right));
+	case NumericOp::Multiply: return numeric<NumericOp::Multiply>(leftFloat, rightFloat, move(left), move(right));
+	case NumericOp::Divide: return numeric<NumericOp::Divide>(leftFloat, rightFloat, move(left), move(right));
+	case NumericOp::Remainder: return numeric<NumericOp::Remainder>(leftFloat, rightFloat, move(left), move(right));
+	case NumericOp::Equal: return numeric<NumericOp::Equal>(leftFloat, rightFloat, move(left), move(right));
+	case NumericOp::NotEqual: return numeric<NumericOp::NotEqual>(leftFloat, rightFloat, move(left), move(right));
+	case NumericOp::Less: return numeric<NumericOp::Less>(leftFloat, rightFloat, move(left), move(right));
+	case NumericOp::Greater: return numeric<NumericOp::Greater>(leftFloat, rightFloat, move(left), move(right));
+	case NumericOp::LessEqual: return numeric<NumericOp::LessEqual>(leftFloat, rightFloat, move(left), move(right));
+	default: return numeric<NumericOp::GreaterEqual>(leftFloat, rightFloat, move(left), move(right));
+	}
+}
+
+template <NumericOp op>
+Code Compiler::numeric(bool leftFloat, bool rightFloat, Code left, Code right)
+{
+	if (leftFloat)
+	{
+		return rightFloat ? numeric<op, true, true>(move(left), move(right)) : numeric<op, true, false>(move(left), move(right));
+	}
+	return rightFloat ? numeric<op, false, true>(move(left), move(right)) : numeric<op, false, false>(move(left), move(right));
+}
+
+template <NumericOp op, bool leftFloat, bool rightFloat>
+Code Compiler::numeric(Code left, Code right)
+{
+	return [left = move(left), right = move(right)](Evaluator& evaluator, const shared_ptr<Environment>& env)
+	{
+		auto leftValue = left(evaluator, env);
+		if (leftValue->type == Object::Type::Error)
+		{
+			return leftValue;
+		}
+		auto rightValue = right(evaluator, env);
+		if (rightValue->type == Object::Type::Error)
+		{
+			return rightValue;
+		}
+
+		evaluator._stats.numericOperations++;
+		return Evaluator::numeric<op, leftFloat, rightFloat>(leftValue, rightValue);
+	};
+}
+
+Code Compiler::declaration(const shared_ptr<IdentifierExpr>& name, Annotation annotation, const shared_ptr<Expr>& value, bool isMutable)
+{
+	return [name, annotation, value = node(value), isMutable](Evaluator& evaluator, const shared_ptr<Environment>& env) -> Value
+	{
+		auto result = value(evaluator, env);
+		if (result->type == Object::Type::Error)
+		{
+			return result;
+		}
+		if (!Evaluator::is_annotated(annotation, result))
+		{
+			return Evaluator::annotation_mismatch(name->value, annotation, result->typeName());
+		}
+
+		if (env->find(name->symbol) != nullptr)
+		{
+			return Evaluator::repeat_declaration(name->value);
+		}
+
+		env->add(name->symbol, Evaluator::declared(move(result), isMutable));
+		return Evaluator::null;
+	};
+}
+
+Code Compiler::if_(const shared_ptr<IfExpr>& node)
+{
+	auto condition = Compiler::node(node->condition);
+	auto consequence = statements(node->consequence->statements);
+	if (!node->alternative)
+	{
+		return [condition = move(condition), consequence = move(consequence)](Evaluator& evaluator, const shared_ptr<Environment>& env) -> Value
+		{
+			if (evaluator.is_true(condition(evaluator, env)))
+			{
+				return consequence(evaluator, env);
+			}
+			return Evaluator::null;
+		};
+	}
+
+	auto alternative = statements(node->alternative->statements);
+	return [condition = move(condition), consequence = move(consequence), alternative = move(alternative)](Evaluator& evaluator, const shared_ptr<Environment>& env)
+	{
+		if (evaluator.is_true(condition(evaluator, env)))
+		{
+			return consequence(evaluator, env);
+		}
+		return alternative(evaluator, env);
+	};
+}
+
+Code Compiler::call(const shared_ptr<CallExpr>& node)
+{
+	return [node, fun = Compiler::node(node->fun), args = nodes(node->exprs->expressions)](Evaluator& evaluator, const shared_ptr<Environment>& env) -> Value
+	{
+		auto callee = fun(evaluator, env);
+		if (callee->type == Object::Type::Error)
+		{
+			return callee;
+		}
+
+		vector<Value> objects;
+		if (auto error = values(args, evaluator, env, objects))
+		{
+			return error;
+		}
+
+		if (node->feedback.state != Feedback::State::Generic)
+		{
+			bool specializable = callee->type == Object::Type::Function || callee->type == Object::Type::BuiltinFun;
+			if (evaluator.guard(node->feedback, callee->type, callee->type, specializable))
+			{
+				if (callee->type == Object::Type::Function)
+				{
+					return evaluator.call_function(static_pointer_cast<Function>(callee), objects);
+				}
+				return static_cast<BuiltinFun&>(*callee).fun(evaluator, objects);
+			}
+		}
+		return evaluator.evaluate_fun(callee, objects);
+	};
+}
+
+Code Compiler::assign(const shared_ptr<AssignExpr>& node)
+{
+	if (node->id->type == Node::Type::Index)
+	{
+		return [node, id = element(static_pointer_cast<IndexExpr>(node->id)), value = Compiler::node(node->value)](Evaluator& evaluator, const shared_ptr<Environment>& env)
+		{
+			Value left;
+			Value index;
+			auto target = id(evaluator, env, left, index);
+			auto result = value(evaluator, env);
+			if (target->type == Object::Type::Error)
+			{
+				return target;
+			}
+			if (result->type == Object::Type::Error)
+			{
+				return result;
+			}
+
+			return evaluator.assign_element(left, index, target, node->id->literal(), node->operatorName, result, env);
+		};
+	}
+
+	return [node, id = Compiler::node(node->id), value = Compiler::node(node->value)](Evaluator& evaluator, const shared_ptr<Environment>& env)
+	{
+		auto target = id(evaluator, env);
+		auto result = value(evaluator, env);
+		if (target->type == Object::Type::Error)
+		{
+			return target;
+		}
+		if (result->type == Object::Type::Error)
+		{
+			return result;
+		}
+		if (!target->isMutable)
+		{
+			return Evaluator::access_immutable_var(node->id->literal());
+		}
+
+		return evaluator.evaluate_assign(target, node->operatorName, result, env);
+	};
+}
+
+Code Compiler::index(const shared_ptr<IndexExpr>& node)
+{
+	return [node, left = Compiler::node(node->left), index = Compiler::node(node->index)](Evaluator& evaluator, const shared_ptr<Environment>& env)
+	{
+		auto leftValue = left(evaluator, env);
+		if (leftValue->type == Object::Type::Error)
+		{
+			return leftValue;
+		}
+		auto indexValue = index(evaluator, env);
+		if (indexValue->type == Object::Type::Error)
+		{
+			return indexValue;
+		}
+
+		if (node->feedback.state != Feedback::State::Generic)
+		{
+			bool specializable = leftValue->type == Object::Type::Array && indexValue->type == Object::Type::Integer;
+			if (evaluator.guard(node->feedback, leftValue->type, indexValue->type, specializable))
+			{
+				auto& array = static_cast<Array&>(*leftValue);
+				auto value = static_cast<Integer&>(*indexValue).value;
+				if (!node->consumed)
+				{
+					evaluator.box(array);
+				}
+				if (node->inBounds)
+				{
+					evaluator._stats.uncheckedIndexes++;
+					return evaluator.read(array, value);
+				}
+				if (value >= static_cast<int64_t>(array.size()) || value < 0)
+				{
+					return static_pointer_cast<Object>(Evaluator::null);
+				}
+				return evaluator.read(array, value);
+			}
+		}
+		return evaluator.evaluate_index(leftValue, indexValue, node->consumed);
+	};
+}
+
+Element Compiler::element(const shared_ptr<IndexExpr>& node)
+{
+	return [node, left = Compiler::node(node->left), index = Compiler::node(node->index)](Evaluator& evaluator, const shared_ptr<Environment>& env, Value& leftValue, Value& indexValue)
+	{
+		auto array = left(evaluator, env);
+		if (array->type == Object::Type::Error)
+		{
+			return array;
+		}
+		auto position = index(evaluator, env);
+		if (position->type == Object::Type::Error)
+		{
+			return position;
+		}
+
+		leftValue = move(array);
+		indexValue = move(position);
+		return evaluator.read_index(*node, leftValue, indexValue);
+	};
+}
+
+Code Compiler::while_(const shared_ptr<WhileStat>& node)
+{
+	return [node, condition = Compiler::node(node->condition), body = statements(node->body->statements)](Evaluator& evaluator, const shared_ptr<Environment>& env) -> Value
+	{
+		if (node->invariants != 0)
+		{
+			evaluator._loops.push_back({ node.get(), vector<Evaluator::CachedValue>(node->invariants) });
+		}
+
+		while (true)
+		{
+			auto& jit = evaluator._jit;
+			if (jit && jit->run_loop(node, env, evaluator._running))
+			{
+				if (jit->mutated())
+				{
+					evaluator._mutations++;
+				}
+				break;
+			}
+			if (!evaluator.is_true(condition(evaluator, env)))
+			{
+				break;
+			}
+			body(evaluator, make_shared<Environment>(env, Environment::Kind::Scope));
+		}
+
+		if (node->invariants != 0)
+		{
+			evaluator._loops.pop_back();
+		}
+		return Evaluator::null;
+	};
+}
+
+Code Compiler::for_(const shared_ptr<ForStat>& node)
+{
+	auto iterable = Compiler::node(node->iterable);
+	auto end = node->end ? Compiler::node(node->end) : Code();
+	auto body = statements(node->body->statements);
+	return [node, iterable = move(iterable), end = move(end), body = move(body)](Evaluator& evaluator, const shared_ptr<Environment>& env) -> Value
+	{
+		auto first = iterable(evaluator, env);
+		if (first->type == Object::Type::Error)
+		{
+			return first;
+		}
+
+		Value last;
+		if (end)
+		{
+			last = end(evaluator, env);
+			if (last->type == Object::Type::Error)
+			{
+				return last;
+			}
+		}
+
+		return evaluator.iterate(node->name->symbol, first, last, node->copies, env, [&](const shared_ptr<Environment>& scope)
+		{
+			return body(evaluator, scope);
+		});
+	};
+}
+
+Code Compiler::invariant(const shared_ptr<InvariantExpr>& node)
+{
+	return [node, expr = Compiler::node(node->expr)](Evaluator& evaluator, const shared_ptr<Environment>& env)
+	{
+		// The innermost activation of the loop, a recursive call may have entered it again
+		for (auto it = evaluator._loops.rbegin(); it != evaluator._loops.rend(); ++it)
+		{
+			if (it->loop != node->loop) continue;
+
+			auto& cached = it->values.at(node->slot);
+			uint64_t version = node->shapeOnly ? evaluator._reshapes : evaluator._mutations;
+			if (cached.value && cached.version == version)
+			{
+				evaluator._stats.invariantHits++;
+				return cached.value;
+			}
+
+			auto value = expr(evaluator, env);
+			if (value->type != Object::Type::Error)
+			{
+				cached.value = value;
+				cached.version = version;
+			}
+			return value;
+		}
+		return expr(evaluator, env);
+	};
+}
+
+Code Compiler::temp(const shared_ptr<TempExpr>& node)
+{
+	return [node, expr = Compiler::node(node->expr)](Evaluator& evaluator, const shared_ptr<Environment>& env)
+	{
+		// Slots belong to the function activation rather than to the scopes of its loops
+		auto* frame = env.get();
+		while (frame->kind == Environment::Kind::Scope && frame->outer)
+		{
+			frame = frame->outer.get();
+		}
+
+		auto& temps = frame->temps;
+		if (node->reuse && node->slot < temps.size() && temps[node->slot])
+		{
+			evaluator._stats.reusedValues++;
+			return temps[node->slot];
+		}
+
+		auto value = expr(evaluator, env);
+		if (!node->reuse)
+		{
+			if (temps.size() <= node->slot)
+			{
+				temps.resize(node->slot + 1);
+			}
+			temps[node->slot] = value;
+		}
+		return value;
+	};
+}
+
+Code Compiler::in_decrement(const shared_ptr<InDecrementExpr>& node)
+{
+	return [node, id = Compiler::node(node->id)](Evaluator& evaluator, const shared_ptr<Environment>& env)
+	{
+		auto target = id(evaluator, env);
+		if (target->type == Object::Type::Error)
+		{
+			return target;
+		}
+
+		return evaluator.evaluate_in_decrement(target, node->operatorName, env);
+	};
+}
+
+
+}
\ No newline at end of file
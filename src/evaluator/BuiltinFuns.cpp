@@ -1,17 +1,40 @@
 #include "evaluator/BuiltinFuns.h"
 #include "evaluator/Evaluator.h"
+#include "evaluator/Sharing.h"
+#include "evaluator/ThreadPool.h"
 #include "object/String.hpp"
 #include <iostream>
+#include <cmath>
 
 namespace li
 {
 
 const map<string, shared_ptr<BuiltinFun>> Evaluator::builtinFuns = 
 {
-	{ "_builtin_", make_shared<BuiltinFun>(BuiltinFuns::_builtin_, "_builtin_") }
+	{ "_builtin_", make_shared<BuiltinFun>(BuiltinFuns::_builtin_, "_builtin_") },
+	{ "sort", make_shared<BuiltinFun>(BuiltinFuns::sort, "sort") },
+	{ "join", make_shared<BuiltinFun>(BuiltinFuns::join, "join") },
+	{ "slice", make_shared<BuiltinFun>(BuiltinFuns::slice, "slice") },
+	{ "substr", make_shared<BuiltinFun>(BuiltinFuns::substr, "substr") },
+	{ "map", make_shared<BuiltinFun>(BuiltinFuns::map, "map") },
+	{ "filter", make_shared<BuiltinFun>(BuiltinFuns::filter, "filter") },
+	{ "reduce", make_shared<BuiltinFun>(BuiltinFuns::reduce, "reduce") },
+	{ "each", make_shared<BuiltinFun>(BuiltinFuns::each, "each") },
+	{ "pmap", make_shared<BuiltinFun>(BuiltinFuns::pmap, "pmap") },
+	{ "preduce", make_shared<BuiltinFun>(BuiltinFuns::preduce, "preduce") },
+	{ "keys", make_shared<BuiltinFun>(BuiltinFuns::keys, "keys") },
+	{ "values", make_shared<BuiltinFun>(BuiltinFuns::values, "values") },
+	{ "has", make_shared<BuiltinFun>(BuiltinFuns::has, "has") },
+	{ "remove", make_shared<BuiltinFun>(BuiltinFuns::remove, "remove") },
+	{ "ordered", make_shared<BuiltinFun>(BuiltinFuns::ordered, "ordered") },
+	{ "insert", make_shared<BuiltinFun>(BuiltinFuns::insert, "insert") },
+	{ "lower_bound", make_shared<BuiltinFun>(BuiltinFuns::lower_bound, "lower_bound") },
+	{ "range", make_shared<BuiltinFun>(BuiltinFuns::range, "range") },
+	{ "first", make_shared<BuiltinFun>(BuiltinFuns::first, "first") },
+	{ "last", make_shared<BuiltinFun>(BuiltinFuns::last, "last") }
 };
 
-shared_ptr<Object> BuiltinFuns::_builtin_(const vector<shared_ptr<Object>>& objs)
+shared_ptr<Object> BuiltinFuns::_builtin_(Evaluator&, const vector<shared_ptr<Object>>& objs)
 {
 	if (objs.empty())
 	{
@@ -34,6 +57,29 @@ shared_ptr<Object> BuiltinFuns::_builtin_(const vector<shared_ptr<Object>>& objs
 	case Len:
 		return len(extraction);
 
+	case Sum:
+	case Min:
+	case Max:
+		return fold(opcode, extraction);
+
+	case Dot:
+		return dot(extraction);
+
+	case Scale:
+		return scale(extraction);
+
+	case Add:
+		return combine(Kernels::Op::Add, extraction);
+
+	case Sub:
+		return combine(Kernels::Op::Sub, extraction);
+
+	case Mul:
+		return combine(Kernels::Op::Mul, extraction);
+
+	case Fill:
+		return fill(extraction);
+
 	default:
 		return Evaluator::invalid_arguments("unknown opcode: " + to_string(opcode));
 		
@@ -56,7 +102,7 @@ shared_ptr<Object> BuiltinFuns::print(const vector<shared_ptr<Object>>& objs)
 	}
 
 	cout << objs.at(0)->inspect();
-	if (objs.at(1) == Evaluator::bool_true)
+	if (dynamic_pointer_cast<Bool>(objs.at(1))->value)
 	{
 		cout << '\n';
 	}
@@ -75,21 +121,1217 @@ shared_ptr<Object> BuiltinFuns::len(const vector<shared_ptr<Object>>& objs)
 	
 	case Object::Type::String:
 	{
-		auto cast = dynamic_pointer_cast<String>(objs.at(0));
-		return make_shared<Integer>(cast->value.size());
+		return make_shared<Integer>(static_cast<String&>(*objs.at(0)).size());
 	}
 
 	case Object::Type::Array:
 	{
 		auto cast = dynamic_pointer_cast<Array>(objs.at(0));
-		return make_shared<Integer>(cast->elements.size());
+		return make_shared<Integer>(cast->size());
 	}
 
+	case Object::Type::Map:
+		return make_shared<Integer>(static_cast<Map&>(*objs.at(0)).size());
+
+	case Object::Type::OrderedMap:
+		return make_shared<Integer>(static_cast<OrderedMap&>(*objs.at(0)).size());
+
 	default:
 		return Evaluator::invalid_arguments("unknown function for argument type " + objs.at(0)->typeName());
 
 	}
 }
 
+shared_ptr<Object> BuiltinFuns::fold(int64_t opcode, const vector<shared_ptr<Object>>& objs)
+{
+	if (objs.size() != 1)
+	{
+		return Evaluator::invalid_arguments("expected the number of them to be 1, but got " + to_string(objs.size()));
+	}
+
+	Numbers a;
+	if (auto error = numbers(objs.at(0), "first", a))
+	{
+		return error;
+	}
+	if (opcode != Sum && a.size == 0)
+	{
+		return Evaluator::invalid_arguments("expected a non-empty array");
+	}
+
+	if (a.isFloat)
+	{
+		switch (opcode)
+		{
+		case Sum: return make_shared<Float>(Kernels::sum(a.floats, a.size));
+		case Min: return make_shared<Float>(Kernels::min(a.floats, a.size));
+		default: return make_shared<Float>(Kernels::max(a.floats, a.size));
+		}
+	}
+	switch (opcode)
+	{
+	case Sum: return make_shared<Integer>(Kernels::sum(a.integers, a.size));
+	case Min: return make_shared<Integer>(Kernels::min(a.integers, a.size));
+	default: return make_shared<Integer>(Kernels::max(a.integers, a.size));
+	}
+}
+
+shared_ptr<Object> BuiltinFuns::dot(const vector<shared_ptr<Object>>& objs)
+{
+	Numbers a, b;
+	if (auto error = pair(objs, a, b))
+	{
+		return error;
+	}
+	if (a.isFloat)
+	{
+		return make_shared<Float>(Kernels::dot(a.floats, b.floats, a.size));
+	}
+	return make_shared<Integer>(Kernels::dot(a.integers, b.integers, a.size));
+}
+
+shared_ptr<Object> BuiltinFuns::scale(const vector<shared_ptr<Object>>& objs)
+{
+	if (objs.size() != 2)
+	{
+		return Evaluator::invalid_arguments("expected the number of them to be 2, but got " + to_string(objs.size()));
+	}
+
+	Numbers a;
+	if (auto error = numbers(objs.at(0), "first", a))
+	{
+		return error;
+	}
+
+	auto result = make_shared<Array>();
+	const auto& factor = objs.at(1);
+	if (factor->type == Object::Type::Integer && !a.isFloat)
+	{
+		result->kind = Array::Kind::Integer;
+		result->integers.resize(a.size);
+		Kernels::scale(a.integers, static_cast<Integer&>(*factor).value, result->integers.data(), a.size);
+		return result;
+	}
+
+	double k = 0;
+	switch (factor->type)
+	{
+	case Object::Type::Integer: k = static_cast<double>(static_cast<Integer&>(*factor).value); break;
+	case Object::Type::Float: k = static_cast<Float&>(*factor).value; break;
+	default: return Evaluator::invalid_arguments("expected the type of second argument to be integer or float, but got " + factor->typeName());
+	}
+	a.to_floats();
+	result->kind = Array::Kind::Float;
+	result->floats.resize(a.size);
+	Kernels::scale(a.floats, k, result->floats.data(), a.size);
+	return result;
+}
+
+shared_ptr<Object> BuiltinFuns::combine(Kernels::Op op, const vector<shared_ptr<Object>>& objs)
+{
+	Numbers a, b;
+	if (auto error = pair(objs, a, b))
+	{
+		return error;
+	}
+
+	auto result = make_shared<Array>();
+	if (a.isFloat)
+	{
+		result->kind = Array::Kind::Float;
+		result->floats.resize(a.size);
+		Kernels::combine(op, a.floats, b.floats, result->floats.data(), a.size);
+		return result;
+	}
+	result->kind = Array::Kind::Integer;
+	result->integers.resize(a.size);
+	Kernels::combine(op, a.integers, b.integers, result->integers.data(), a.size);
+	return result;
+}
+
+shared_ptr<Object> BuiltinFuns::fill(const vector<shared_ptr<Object>>& objs)
+{
+	if (objs.size() != 2)
+	{
+		return Evaluator::invalid_arguments("expected the number of them to be 2, but got " + to_string(objs.size()));
+	}
+	if (objs.at(0)->type != Object::Type::Integer)
+	{
+		return Evaluator::invalid_arguments("expected the type of first argument to be integer, but got " + objs.at(0)->typeName());
+	}
+	int64_t count = static_cast<Integer&>(*objs.at(0)).value;
+	if (count < 0)
+	{
+		return Evaluator::invalid_arguments("expected a non-negative length, but got " + to_string(count));
+	}
+
+	auto result = make_shared<Array>();
+	const auto& value = objs.at(1);
+	switch (value->type)
+	{
+
+	case Object::Type::Integer:
+		result->kind = Array::Kind::Integer;
+		result->integers.assign(count, static_cast<Integer&>(*value).value);
+		break;
+
+	case Object::Type::Float:
+		result->kind = Array::Kind::Float;
+		result->floats.assign(count, static_cast<Float&>(*value).value);
+		break;
+
+	case Object::Type::Bool:
+		result->kind = Array::Kind::Bool;
+		result->bools.assign(count, static_cast<Bool&>(*value).value);
+		break;
+
+	// Every element is an object of its own, as in an array literal
+	default:
+		result->elements.reserve(count);
+		for (int64_t i = 0; i < count; i++)
+		{
+			result->elements.push_back(value->copy());
+		}
+		break;
+
+	}
+	return result;
+}
+
+//	NaN goes after every other float, so that they can be sorted
+static bool less_float(double a, double b)
+{
+	return std::isnan(b) ? !std::isnan(a) : a < b;
+}
+
+//	An integer and a float are compared exactly, long double holds every int64_t
+static bool less_number(const Object& a, const Object& b)
+{
+	if (a.type == Object::Type::Integer && b.type == Object::Type::Integer)
+	{
+		return static_cast<const Integer&>(a).value < static_cast<const Integer&>(b).value;
+	}
+
+	auto value = [](const Object& number) -> long double {
+		return number.type == Object::Type::Float ? static_cast<const Float&>(number).value : static_cast<const Integer&>(number).value;
+	};
+	long double left = value(a), right = value(b);
+	return std::isnan(right) ? !std::isnan(left) : left < right;
+}
+
+shared_ptr<Object> BuiltinFuns::sort(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs)
+{
+	if (objs.size() != 1 && objs.size() != 2)
+	{
+		return Evaluator::invalid_arguments("expected the number of them to be 1 or 2, but got " + to_string(objs.size()));
+	}
+	if (objs.at(0)->type != Object::Type::Array)
+	{
+		return Evaluator::invalid_arguments("expected the type of first argument to be array, but got " + objs.at(0)->typeName());
+	}
+
+	// Called directly the argument is the array of the caller, which stays as it is, as does the
+	// parent of a view
+	auto sorted = static_cast<Array&>(*objs.at(0)).owned();
+	if (objs.size() == 2)
+	{
+		return sort_by(evaluator, sorted, objs.at(1));
+	}
+
+	switch (sorted->kind)
+	{
+
+	case Array::Kind::Integer:
+		Kernels::sort(sorted->integers.data(), sorted->integers.size(), std::less<int64_t>());
+		return sorted;
+
+	case Array::Kind::Float:
+		Kernels::sort(sorted->floats.data(), sorted->floats.size(), less_float);
+		return sorted;
+
+	case Array::Kind::Bool:
+		return Evaluator::invalid_arguments("expected the elements of first argument to be numbers or strings, but got bool");
+
+	default:
+		break;
+
+	}
+
+	auto& elements = sorted->elements;
+	if (elements.empty())
+	{
+		return sorted;
+	}
+
+	// The first element decides whether they are all strings or all numbers
+	bool strings = elements.front()->type == Object::Type::String;
+	for (const auto& element : elements)
+	{
+		bool number = element->type == Object::Type::Integer || element->type == Object::Type::Float;
+		if (strings ? element->type != Object::Type::String : !number)
+		{
+			return Evaluator::invalid_arguments(string("expected the elements of first argument to be ") +
+				(strings ? "strings" : "numbers") + ", but got " + element->typeName());
+		}
+	}
+
+	if (strings)
+	{
+		Kernels::sort(elements.data(), elements.size(), [](const shared_ptr<Object>& a, const shared_ptr<Object>& b) {
+			return static_cast<String&>(*a).view() < static_cast<String&>(*b).view();
+		});
+	}
+	else
+	{
+		Kernels::sort(elements.data(), elements.size(), [](const shared_ptr<Object>& a, const shared_ptr<Object>& b) {
+			return less_number(*a, *b);
+		});
+	}
+	return sorted;
+}
+
+//	Writes value into box when only the caller holds it, the binding of the previous call is gone
+static void rebox(shared_ptr<Object>& box, int64_t value)
+{
+	if (box && box.use_count() == 1 && box->type == Object::Type::Integer)
+	{
+		static_cast<Integer&>(*box).value = value;
+		return;
+	}
+	box = make_shared<Integer>(value);
+}
+
+static void rebox(shared_ptr<Object>& box, double value)
+{
+	if (box && box.use_count() == 1 && box->type == Object::Type::Float)
+	{
+		static_cast<Float&>(*box).value = value;
+		return;
+	}
+	box = make_shared<Float>(value);
+}
+
+// A stable merge sort, which stays in bounds even when cmp is not a consistent order. cmp runs in
+// one frame for the whole sort, and the numbers it compares are written into the boxes of the
+// previous comparison when it kept neither.
+shared_ptr<Object> BuiltinFuns::sort_by(Evaluator& evaluator, const shared_ptr<Array>& array, const shared_ptr<Object>& cmp)
+{
+	Evaluator::Callback callback(evaluator, cmp);
+	if (auto error = callback.check(2))
+	{
+		return error;
+	}
+
+	// After an error or a result other than a bool the rest of the sort compares nothing
+	shared_ptr<Object> failure;
+	vector<shared_ptr<Object>> args(2);
+	auto compare = [&]() {
+		if (failure)
+		{
+			return false;
+		}
+
+		auto result = callback.call(args);
+		if (result->type == Object::Type::Bool)
+		{
+			return static_cast<Bool&>(*result).value;
+		}
+		failure = result->type == Object::Type::Error ? result :
+			Evaluator::invalid_arguments("expected the comparator to return bool, but got " + result->typeName());
+		return false;
+	};
+
+	switch (array->kind)
+	{
+
+	case Array::Kind::Integer:
+		stable_sort(array->integers.begin(), array->integers.end(), [&](int64_t a, int64_t b) {
+			rebox(args[0], a);
+			rebox(args[1], b);
+			return compare();
+		});
+		break;
+
+	case Array::Kind::Float:
+		stable_sort(array->floats.begin(), array->floats.end(), [&](double a, double b) {
+			rebox(args[0], a);
+			rebox(args[1], b);
+			return compare();
+		});
+		break;
+
+	default:
+		array->box();
+		stable_sort(array->elements.begin(), array->elements.end(), [&](const shared_ptr<Object>& a, const shared_ptr<Object>& b) {
+			args[0] = a->copy();
+			args[1] = b->copy();
+			return compare();
+		});
+		break;
+
+	}
+	return failure ? failure : array;
+}
+
+// Elements appended by f are not visited, as in a for loop
+shared_ptr<Object> BuiltinFuns::join(Evaluator&, const vector<shared_ptr<Object>>& objs)
+{
+	if (objs.size() != 2)
+	{
+		return Evaluator::invalid_arguments("expected the number of them to be 2, but got " + to_string(objs.size()));
+	}
+	if (objs.at(0)->type != Object::Type::Array)
+	{
+		return Evaluator::invalid_arguments("expected the type of first argument to be array, but got " + objs.at(0)->typeName());
+	}
+	if (objs.at(1)->type != Object::Type::String)
+	{
+		return Evaluator::invalid_arguments("expected the type of second argument to be string, but got " + objs.at(1)->typeName());
+	}
+
+	const auto& array = static_cast<Array&>(*objs.at(0));
+	auto separator = static_cast<String&>(*objs.at(1)).view();
+	size_t from;
+	const auto& source = array.storage(from);
+	if (array.size() == 0)
+	{
+		return make_shared<String>();
+	}
+	if (source.kind != Array::Kind::Boxed)
+	{
+		return Evaluator::invalid_arguments("expected every element of the array to be a string, but got " + array.get(0)->typeName());
+	}
+
+	auto first = source.elements.begin() + from;
+	auto last = first + array.size();
+	size_t size = separator.size() * (array.size() - 1);
+	for (auto it = first; it != last; ++it)
+	{
+		if ((*it)->type != Object::Type::String)
+		{
+			return Evaluator::invalid_arguments("expected every element of the array to be a string, but got " + (*it)->typeName());
+		}
+		size += static_cast<String&>(**it).size();
+	}
+
+	string joined;
+	joined.reserve(size);
+	for (auto it = first; it != last; ++it)
+	{
+		if (it != first) joined.append(separator);
+		joined.append(static_cast<String&>(**it).view());
+	}
+	return make_shared<String>(move(joined));
+}
+
+shared_ptr<Object> BuiltinFuns::slice(Evaluator&, const vector<shared_ptr<Object>>& objs)
+{
+	size_t from, to;
+	if (auto error = string_arguments(objs, false, from, to))
+	{
+		return error;
+	}
+	return static_cast<String&>(*objs.at(0)).slice(from, to - from);
+}
+
+shared_ptr<Object> BuiltinFuns::substr(Evaluator&, const vector<shared_ptr<Object>>& objs)
+{
+	size_t from, to;
+	if (auto error = string_arguments(objs, true, from, to))
+	{
+		return error;
+	}
+	return static_cast<String&>(*objs.at(0)).slice(from, to - from);
+}
+
+shared_ptr<Object> BuiltinFuns::map(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs)
+{
+	if (auto error = higher_order(objs, 0))
+	{
+		return error;
+	}
+
+	const auto& array = static_cast<Array&>(*objs.at(0));
+	Evaluator::Callback callback(evaluator, objs.at(1));
+	if (auto error = callback.check(1))
+	{
+		return error;
+	}
+
+	size_t size = array.size();
+	vector<shared_ptr<Object>> results;
+	results.reserve(size);
+	vector<shared_ptr<Object>> args(1);
+	for (size_t i = 0; i < size; i++)
+	{
+		argument(array, i, args[0]);
+		auto result = callback.call(args);
+		if (result->type == Object::Type::Error)
+		{
+			return result;
+		}
+		results.push_back(move(result));
+	}
+
+	// A result that is the argument itself is unboxed like any other
+	args.clear();
+	return make_shared<Array>(move(results));
+}
+
+shared_ptr<Object> BuiltinFuns::filter(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs)
+{
+	if (auto error = higher_order(objs, 0))
+	{
+		return error;
+	}
+
+	const auto& array = static_cast<Array&>(*objs.at(0));
+	Evaluator::Callback callback(evaluator, objs.at(1));
+	if (auto error = callback.check(1))
+	{
+		return error;
+	}
+
+	auto kept = make_shared<Array>();
+	size_t size = array.size();
+	vector<shared_ptr<Object>> args(1);
+	for (size_t i = 0; i < size; i++)
+	{
+		argument(array, i, args[0]);
+		auto result = callback.call(args);
+		if (result->type == Object::Type::Error)
+		{
+			return result;
+		}
+		if (result->type != Object::Type::Bool)
+		{
+			return Evaluator::invalid_arguments("expected the predicate to return bool, but got " + result->typeName());
+		}
+		if (!static_cast<Bool&>(*result).value)
+		{
+			continue;
+		}
+
+		// The element as it is now, f may have changed the array
+		size_t from;
+		const auto& source = array.storage(from);
+		if (kept->size() == 0 && kept->kind == Array::Kind::Boxed)
+		{
+			kept->kind = source.kind;
+		}
+		if (kept->kind != source.kind)
+		{
+			kept->box();
+		}
+		switch (kept->kind)
+		{
+		case Array::Kind::Integer: kept->integers.push_back(source.integers[from + i]); break;
+		case Array::Kind::Float: kept->floats.push_back(source.floats[from + i]); break;
+		case Array::Kind::Bool: kept->bools.push_back(source.bools[from + i]); break;
+		default: kept->elements.push_back(source.kind == Array::Kind::Boxed ? source.elements[from + i]->copy() : array.get(i)); break;
+		}
+	}
+	return kept;
+}
+
+shared_ptr<Object> BuiltinFuns::reduce(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs)
+{
+	if (auto error = higher_order(objs, 1))
+	{
+		return error;
+	}
+
+	const auto& array = static_cast<Array&>(*objs.at(0));
+	Evaluator::Callback callback(evaluator, objs.at(1));
+	if (auto error = callback.check(2))
+	{
+		return error;
+	}
+
+	return accumulate(callback, array, 0, array.size(), objs.at(2)->copy());
+}
+
+shared_ptr<Object> BuiltinFuns::each(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs)
+{
+	if (auto error = higher_order(objs, 0))
+	{
+		return error;
+	}
+
+	const auto& array = static_cast<Array&>(*objs.at(0));
+	Evaluator::Callback callback(evaluator, objs.at(1));
+	if (auto error = callback.check(1))
+	{
+		return error;
+	}
+
+	size_t size = array.size();
+	vector<shared_ptr<Object>> args(1);
+	for (size_t i = 0; i < size; i++)
+	{
+		argument(array, i, args[0]);
+		auto result = callback.call(args);
+		if (result->type == Object::Type::Error)
+		{
+			return result;
+		}
+	}
+	return Evaluator::null;
+}
+
+shared_ptr<Object> BuiltinFuns::pmap(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs)
+{
+	if (auto error = higher_order(objs, 0))
+	{
+		return error;
+	}
+	if (auto error = Evaluator::Callback(evaluator, objs.at(1)).check(1))
+	{
+		return error;
+	}
+
+	const auto& array = static_cast<Array&>(*objs.at(0));
+	vector<shared_ptr<Object>> results(array.size());
+	shared_ptr<Object> error;
+	bool parallel = in_parallel(evaluator, objs, array.size(), [&](Evaluator& worker, size_t, size_t first, size_t last) -> shared_ptr<Object>
+	{
+		Evaluator::Callback callback(worker, objs.at(1));
+		vector<shared_ptr<Object>> args(1);
+		for (size_t i = first; i < last; i++)
+		{
+			argument(array, i, args[0]);
+			auto result = callback.call(args);
+			if (result->type == Object::Type::Error)
+			{
+				return result;
+			}
+			results[i] = move(result);
+		}
+		return nullptr;
+	}, error);
+
+	if (!parallel)
+	{
+		return map(evaluator, objs);
+	}
+	return error ? error : make_shared<Array>(move(results));
+}
+
+shared_ptr<Object> BuiltinFuns::preduce(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs)
+{
+	if (auto error = higher_order(objs, 1))
+	{
+		return error;
+	}
+	if (auto error = Evaluator::Callback(evaluator, objs.at(1)).check(2))
+	{
+		return error;
+	}
+
+	const auto& array = static_cast<Array&>(*objs.at(0));
+	vector<shared_ptr<Object>> partial(runs(array.size()));
+	shared_ptr<Object> error;
+	bool parallel = in_parallel(evaluator, objs, array.size(), [&](Evaluator& worker, size_t run, size_t first, size_t last) -> shared_ptr<Object>
+	{
+		// Only the first run starts from init, every other one from its first element
+		shared_ptr<Object> start;
+		if (run == 0)
+		{
+			start = objs.at(2)->copy();
+		}
+		else
+		{
+			argument(array, first++, start);
+		}
+
+		Evaluator::Callback callback(worker, objs.at(1));
+		partial[run] = accumulate(callback, array, first, last, move(start));
+		return partial[run]->type == Object::Type::Error ? partial[run] : nullptr;
+	}, error);
+
+	if (!parallel)
+	{
+		return reduce(evaluator, objs);
+	}
+	if (error)
+	{
+		return error;
+	}
+
+	// Only the calling thread holds the results of the runs now
+	Evaluator::Callback callback(evaluator, objs.at(1));
+	shared_ptr<Object> accumulated;
+	vector<shared_ptr<Object>> args(2);
+	for (auto& result : partial)
+	{
+		if (!accumulated)
+		{
+			accumulated = move(result);
+			continue;
+		}
+		args[0] = move(accumulated);
+		args[1] = move(result);
+		accumulated = callback.call(args);
+		if (accumulated->type == Object::Type::Error)
+		{
+			return accumulated;
+		}
+	}
+	return accumulated ? accumulated : objs.at(2)->copy();
+}
+
+shared_ptr<Object> BuiltinFuns::accumulate(Evaluator::Callback& callback, const Array& array, size_t first, size_t last, shared_ptr<Object> accumulated)
+{
+	vector<shared_ptr<Object>> args(2);
+	for (size_t i = first; i < last; i++)
+	{
+		// The previous result is bound as it is unless something else, such as a name, holds it
+		args[0] = move(accumulated);
+		if (args[0].use_count() != 1)
+		{
+			args[0] = args[0]->copy();
+		}
+		argument(array, i, args[1]);
+
+		accumulated = callback.call(args);
+		if (accumulated->type == Object::Type::Error)
+		{
+			return accumulated;
+		}
+	}
+	return accumulated;
+}
+
+shared_ptr<Object> BuiltinFuns::keys(Evaluator&, const vector<shared_ptr<Object>>& objs)
+{
+	if (auto error = map_arguments(objs, 0, 0))
+	{
+		return error;
+	}
+
+	vector<shared_ptr<Object>> keys;
+	if (objs.at(0)->type == Object::Type::OrderedMap)
+	{
+		const auto& map = static_cast<OrderedMap&>(*objs.at(0));
+		keys.reserve(map.size());
+		map.visit(nullptr, [&](const shared_ptr<Object>& key, const shared_ptr<Object>&)
+		{
+			keys.push_back(key->copy());
+			return true;
+		});
+		return make_shared<Array>(move(keys));
+	}
+
+	const auto& map = static_cast<Map&>(*objs.at(0));
+	keys.reserve(map.size());
+	for (const auto& entry : map.entries())
+	{
+		if (entry.key) keys.push_back(entry.key->copy());
+	}
+	return make_shared<Array>(move(keys));
+}
+
+shared_ptr<Object> BuiltinFuns::values(Evaluator&, const vector<shared_ptr<Object>>& objs)
+{
+	if (auto error = map_arguments(objs, 0, 0))
+	{
+		return error;
+	}
+
+	vector<shared_ptr<Object>> values;
+	if (objs.at(0)->type == Object::Type::OrderedMap)
+	{
+		const auto& map = static_cast<OrderedMap&>(*objs.at(0));
+		values.reserve(map.size());
+		map.visit(nullptr, [&](const shared_ptr<Object>&, const shared_ptr<Object>& value)
+		{
+			values.push_back(value->copy());
+			return true;
+		});
+		return make_shared<Array>(move(values));
+	}
+
+	const auto& map = static_cast<Map&>(*objs.at(0));
+	values.reserve(map.size());
+	for (const auto& entry : map.entries())
+	{
+		if (entry.key) values.push_back(entry.value->copy());
+	}
+	return make_shared<Array>(move(values));
+}
+
+shared_ptr<Object> BuiltinFuns::has(Evaluator&, const vector<shared_ptr<Object>>& objs)
+{
+	if (auto error = map_arguments(objs, 1, 1))
+	{
+		return error;
+	}
+
+	if (objs.at(0)->type == Object::Type::OrderedMap)
+	{
+		return Evaluator::bool_to_object(static_cast<OrderedMap&>(*objs.at(0)).find(*objs.at(1)) != nullptr);
+	}
+	return Evaluator::bool_to_object(static_cast<Map&>(*objs.at(0)).find(*objs.at(1)) != nullptr);
+}
+
+bool BuiltinFuns::changes_arguments(const string& name)
+{
+	return name == "remove" || name == "insert";
+}
+
+shared_ptr<Object> BuiltinFuns::remove(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs)
+{
+	if (auto error = map_arguments(objs, 1, 1))
+	{
+		return error;
+	}
+	if (!objs.at(0)->isMutable)
+	{
+		return Evaluator::invalid_arguments("expected the map to be mutable");
+	}
+
+	auto removed = objs.at(0)->type == Object::Type::OrderedMap
+		? static_cast<OrderedMap&>(*objs.at(0)).remove(*objs.at(1))
+		: static_cast<Map&>(*objs.at(0)).remove(*objs.at(1));
+	if (!removed)
+	{
+		return Evaluator::null;
+	}
+	evaluator._mutations++;
+	evaluator._reshapes++;
+	return removed;
+}
+
+shared_ptr<Object> BuiltinFuns::ordered(Evaluator&, const vector<shared_ptr<Object>>& objs)
+{
+	if (objs.size() > 1)
+	{
+		return Evaluator::invalid_arguments("expected the number of them to be at most 1, but got " + to_string(objs.size()));
+	}
+
+	auto ordered = make_shared<OrderedMap>();
+	if (objs.empty())
+	{
+		return ordered;
+	}
+
+	switch (objs.at(0)->type)
+	{
+
+	case Object::Type::Map:
+		for (const auto& entry : static_cast<Map&>(*objs.at(0)).entries())
+		{
+			if (!entry.key) continue;
+			if (!ordered->accepts(*entry.key))
+			{
+				return key_error(*ordered, *entry.key, "every key of the map");
+			}
+			ordered->set(entry.key, entry.value);
+		}
+		return ordered;
+
+	case Object::Type::Array:
+	{
+		const auto& array = static_cast<Array&>(*objs.at(0));
+		for (size_t i = 0; i < array.size(); i++)
+		{
+			auto key = array.get(i);
+			if (!ordered->accepts(*key))
+			{
+				return key_error(*ordered, *key, "every element of the array");
+			}
+			ordered->insert(move(key), Evaluator::bool_true);
+		}
+		return ordered;
+	}
+
+	default:
+		return Evaluator::invalid_arguments("expected the type of first argument to be map or array, but got " + objs.at(0)->typeName());
+
+	}
+}
+
+shared_ptr<Object> BuiltinFuns::insert(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs)
+{
+	if (objs.size() != 2 && objs.size() != 3)
+	{
+		return Evaluator::invalid_arguments("expected the number of them to be 2 or 3, but got " + to_string(objs.size()));
+	}
+	if (auto error = map_arguments(objs, objs.size() - 1, 1, true))
+	{
+		return error;
+	}
+
+	auto& map = static_cast<OrderedMap&>(*objs.at(0));
+	if (!map.isMutable)
+	{
+		return Evaluator::invalid_arguments("expected the map to be mutable");
+	}
+	bool inserted = map.set(objs.at(1), objs.size() == 3 ? objs.at(2) : Evaluator::bool_true);
+	evaluator._mutations++;
+	evaluator._reshapes++;
+	return Evaluator::bool_to_object(inserted);
+}
+
+shared_ptr<Object> BuiltinFuns::lower_bound(Evaluator&, const vector<shared_ptr<Object>>& objs)
+{
+	if (auto error = map_arguments(objs, 1, 1, true))
+	{
+		return error;
+	}
+
+	auto found = static_cast<OrderedMap&>(*objs.at(0)).lower_bound(*objs.at(1));
+	return found ? found->copy() : Evaluator::null;
+}
+
+shared_ptr<Object> BuiltinFuns::range(Evaluator&, const vector<shared_ptr<Object>>& objs)
+{
+	if (auto error = map_arguments(objs, 2, 2, true))
+	{
+		return error;
+	}
+
+	const auto& end = *objs.at(2);
+	vector<shared_ptr<Object>> keys;
+	static_cast<OrderedMap&>(*objs.at(0)).visit(objs.at(1).get(), [&](const shared_ptr<Object>& key, const shared_ptr<Object>&)
+	{
+		if (OrderedMap::compare(*key, end) >= 0) return false;
+		keys.push_back(key->copy());
+		return true;
+	});
+	return make_shared<Array>(move(keys));
+}
+
+shared_ptr<Object> BuiltinFuns::first(Evaluator&, const vector<shared_ptr<Object>>& objs)
+{
+	if (auto error = map_arguments(objs, 0, 0, true))
+	{
+		return error;
+	}
+
+	auto found = static_cast<OrderedMap&>(*objs.at(0)).first();
+	return found ? found->copy() : Evaluator::null;
+}
+
+shared_ptr<Object> BuiltinFuns::last(Evaluator&, const vector<shared_ptr<Object>>& objs)
+{
+	if (auto error = map_arguments(objs, 0, 0, true))
+	{
+		return error;
+	}
+
+	auto found = static_cast<OrderedMap&>(*objs.at(0)).last();
+	return found ? found->copy() : Evaluator::null;
+}
+
+shared_ptr<Object> BuiltinFuns::string_arguments(const vector<shared_ptr<Object>>& objs, bool count, size_t& from, size_t& to)
+{
+	if (objs.size() != 3)
+	{
+		return Evaluator::invalid_arguments("expected the number of them to be 3, but got " + to_string(objs.size()));
+	}
+	if (objs.at(0)->type != Object::Type::String)
+	{
+		return Evaluator::invalid_arguments("expected the type of first argument to be string, but got " + objs.at(0)->typeName());
+	}
+	if (objs.at(1)->type != Object::Type::Integer || objs.at(2)->type != Object::Type::Integer)
+	{
+		const auto& wrong = objs.at(1)->type != Object::Type::Integer ? objs.at(1) : objs.at(2);
+		return Evaluator::invalid_arguments(string("expected the type of ") + (wrong == objs.at(1) ? "second" : "third") + " argument to be integer, but got " + wrong->typeName());
+	}
+
+	auto size = static_cast<int64_t>(static_cast<String&>(*objs.at(0)).size());
+	auto first = clamp<int64_t>(static_cast<Integer&>(*objs.at(1)).value, 0, size);
+	auto second = static_cast<Integer&>(*objs.at(2)).value;
+	// The count is added where it can not overflow
+	auto last = count ? first + clamp<int64_t>(second, 0, size - first) : clamp<int64_t>(second, first, size);
+	from = static_cast<size_t>(first);
+	to = static_cast<size_t>(last);
+	return nullptr;
+}
+
+shared_ptr<Object> BuiltinFuns::map_arguments(const vector<shared_ptr<Object>>& objs, size_t extra, size_t keys, bool ordered)
+{
+	static const char* const positions[] = { "second", "third" };
+
+	if (objs.size() != 1 + extra)
+	{
+		return Evaluator::invalid_arguments("expected the number of them to be " + to_string(1 + extra) + ", but got " + to_string(objs.size()));
+	}
+
+	const auto& map = *objs.at(0);
+	if (map.type == Object::Type::OrderedMap)
+	{
+		for (size_t i = 1; i <= keys; i++)
+		{
+			if (!static_cast<const OrderedMap&>(map).accepts(*objs.at(i)))
+			{
+				return key_error(static_cast<const OrderedMap&>(map), *objs.at(i), string("the ") + positions[i - 1] + " argument");
+			}
+		}
+		return nullptr;
+	}
+
+	if (ordered || map.type != Object::Type::Map)
+	{
+		return Evaluator::invalid_arguments(string("expected the type of first argument to be ") + (ordered ? "ordered_map" : "map") + ", but got " + map.typeName());
+	}
+	for (size_t i = 1; i <= keys; i++)
+	{
+		if (Float::is_nan(*objs.at(i)))
+		{
+			return Evaluator::invalid_arguments(string("expected the ") + positions[i - 1] + " argument to be a key that is not NaN");
+		}
+		if (!Map::hashable(*objs.at(i)))
+		{
+			return Evaluator::invalid_arguments(string("expected the type of ") + positions[i - 1] + " argument to be a key, but got " + objs.at(i)->typeName());
+		}
+	}
+	return nullptr;
+}
+
+shared_ptr<Object> BuiltinFuns::key_error(const OrderedMap& map, const Object& key, const string& what)
+{
+	if (Float::is_nan(key))
+	{
+		return Evaluator::invalid_arguments("expected " + what + " to be a key that is not NaN");
+	}
+	if (!OrderedMap::orderable(key))
+	{
+		return Evaluator::invalid_arguments("expected " + what + " to be a number or a string, but got " + key.typeName());
+	}
+	string kind = map.first()->type == Object::Type::String ? "a string" : "a number";
+	return Evaluator::invalid_arguments("expected " + what + " to be " + kind + " like the keys of the map, but got " + key.typeName());
+}
+
+//	Whether Sharing allows all of objs on several threads
+static bool shareable(const vector<shared_ptr<Object>>& objs)
+{
+	for (const auto& obj : objs)
+	{
+		if (!Sharing::check(obj))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+size_t BuiltinFuns::runs(size_t count)
+{
+	return count == 0 ? 0 : 1 + min(count - 1, ThreadPool::shared().size() * 4);
+}
+
+bool BuiltinFuns::in_parallel(Evaluator& evaluator, const vector<shared_ptr<Object>>& objs, size_t count, const Run& run, shared_ptr<Object>& error)
+{
+	if (!evaluator._threads)
+	{
+		return false;
+	}
+	// A worker runs the builtins it calls on its own thread
+	if (ThreadPool::inside() || !shareable(objs))
+	{
+		evaluator._stats.serialCallbacks++;
+		return false;
+	}
+
+	size_t total = runs(count);
+	if (total == 0)
+	{
+		return true;
+	}
+	if ((error = run(evaluator, 0, 0, 1)))
+	{
+		return true;
+	}
+
+	// The first run may have made mutable what the workers would read, running it again changes nothing
+	if (!shareable(objs))
+	{
+		evaluator._stats.serialCallbacks++;
+		return false;
+	}
+
+	auto& pool = ThreadPool::shared();
+	vector<unique_ptr<Evaluator>> workers(pool.size());
+	for (auto& worker : workers)
+	{
+		worker = make_unique<Evaluator>();
+		worker->_shared = true;
+	}
+
+	size_t rest = count - 1, split = total - 1;
+	vector<shared_ptr<Object>> errors(split);
+	pool.run(split, [&](size_t index, size_t thread)
+	{
+		errors[index] = run(*workers[thread], index + 1, 1 + rest * index / split, 1 + rest * (index + 1) / split);
+	});
+
+	bool conflict = false;
+	for (const auto& worker : workers)
+	{
+		evaluator._stats += worker->_stats;
+		conflict = conflict || worker->_conflict;
+	}
+	evaluator._stats.parallelRuns += split;
+	if (conflict)
+	{
+		evaluator._stats.serialCallbacks++;
+		return false;
+	}
+
+	for (const auto& failure : errors)
+	{
+		if (failure)
+		{
+			error = failure;
+			break;
+		}
+	}
+	return true;
+}
+
+shared_ptr<Object> BuiltinFuns::higher_order(const vector<shared_ptr<Object>>& objs, size_t extra)
+{
+	if (objs.size() != 2 + extra)
+	{
+		return Evaluator::invalid_arguments("expected the number of them to be " + to_string(2 + extra) + ", but got " + to_string(objs.size()));
+	}
+	if (objs.at(0)->type != Object::Type::Array)
+	{
+		return Evaluator::invalid_arguments("expected the type of first argument to be array, but got " + objs.at(0)->typeName());
+	}
+	return nullptr;
+}
+
+void BuiltinFuns::argument(const Array& array, size_t i, shared_ptr<Object>& box)
+{
+	size_t from;
+	const auto& source = array.storage(from);
+	i += from;
+	switch (source.kind)
+	{
+
+	case Array::Kind::Integer:
+		rebox(box, source.integers[i]);
+		return;
+
+	case Array::Kind::Float:
+		rebox(box, source.floats[i]);
+		return;
+
+	// Not the shared constants, whose mutability the binding would change
+	case Array::Kind::Bool:
+		box = make_shared<Bool>(source.bools[i]);
+		return;
+
+	default:
+		box = source.elements[i]->copy();
+		return;
+
+	}
+}
+
+shared_ptr<Object> BuiltinFuns::numbers(const shared_ptr<Object>& obj, const string& position, Numbers& result)
+{
+	if (obj->type != Object::Type::Array)
+	{
+		return Evaluator::invalid_arguments("expected the type of " + position + " argument to be array, but got " + obj->typeName());
+	}
+
+	// The numbers of a view are read where its parent keeps them
+	size_t from;
+	const auto& array = static_cast<Array&>(*obj).storage(from);
+	result.size = static_cast<Array&>(*obj).size();
+	switch (array.kind)
+	{
+
+	case Array::Kind::Integer:
+		result.integers = array.integers.data() + from;
+		return nullptr;
+
+	case Array::Kind::Float:
+		result.isFloat = true;
+		result.floats = array.floats.data() + from;
+		return nullptr;
+
+	case Array::Kind::Bool:
+		return Evaluator::invalid_arguments("expected the elements of " + position + " argument to be numbers, but got bool");
+
+	default:
+		break;
+
+	}
+
+	// Numbers held elsewhere too leave an array boxed
+	auto first = array.elements.begin() + from;
+	auto last = first + result.size;
+	for (auto it = first; it != last; ++it)
+	{
+		const auto& element = *it;
+		if (element->type == Object::Type::Float)
+		{
+			result.isFloat = true;
+		}
+		else if (element->type != Object::Type::Integer)
+		{
+			return Evaluator::invalid_arguments("expected the elements of " + position + " argument to be numbers, but got " + element->typeName());
+		}
+	}
+	for (auto it = first; it != last; ++it)
+	{
+		const auto& element = *it;
+		if (result.isFloat)
+		{
+			result.floatValues.push_back(element->type == Object::Type::Float ?
+				static_cast<Float&>(*element).value : static_cast<double>(static_cast<Integer&>(*element).value));
+		}
+		else
+		{
+			result.integerValues.push_back(static_cast<Integer&>(*element).value);
+		}
+	}
+	result.integers = result.integerValues.data();
+	result.floats = result.floatValues.data();
+	return nullptr;
+}
+
+// Two arrays of numbers of the same length, both as floats when either has a float
+shared_ptr<Object> BuiltinFuns::pair(const vector<shared_ptr<Object>>& objs, Numbers& a, Numbers& b)
+{
+	if (objs.size() != 2)
+	{
+		return Evaluator::invalid_arguments("expected the number of them to be 2, but got " + to_string(objs.size()));
+	}
+	if (auto error = numbers(objs.at(0), "first", a))
+	{
+		return error;
+	}
+	if (auto error = numbers(objs.at(1), "second", b))
+	{
+		return error;
+	}
+	if (a.size != b.size)
+	{
+		return Evaluator::invalid_arguments("expected the arrays to have the same length, but got " + to_string(a.size) + " and " + to_string(b.size));
+	}
+
+	if (a.isFloat || b.isFloat)
+	{
+		a.to_floats();
+		b.to_floats();
+	}
+	return nullptr;
+}
+
+void BuiltinFuns::Numbers::to_floats()
+{
+	if (isFloat) return;
+
+	floatValues.assign(integers, integers + size);
+	floats = floatValues.data();
+	isFloat = true;
+}
+
 
 }
\ No newline at end of file
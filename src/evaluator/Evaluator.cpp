@@ -20,18 +20,44 @@
 #include "ast/ExpressionStat.hpp"
 #include "ast/FloatExpr.hpp"
 #include "ast/ArrayExpr.hpp"
+#include "ast/MapExpr.hpp"
 #include "ast/IndexExpr.hpp"
+#include "ast/SliceExpr.hpp"
 #include "ast/WhileStat.hpp"
 #include "ast/VarStat.hpp"
 #include "ast/InDecrementExpr.hpp"
+#include "ast/InvariantExpr.hpp"
+#include "analysis/FreeVariables.h"
+#include "analysis/ElementUses.h"
+#include "closure/Compiler.h"
 
 namespace li
 {
 
 
-const shared_ptr<Bool> Evaluator::bool_true = make_shared<Bool>(true);
-const shared_ptr<Bool> Evaluator::bool_false = make_shared<Bool>(false);
-const shared_ptr<Null> Evaluator::null = make_shared<Null>();
+const shared_ptr<Bool> Evaluator::bool_true = Bool::constant(true);
+const shared_ptr<Bool> Evaluator::bool_false = Bool::constant(false);
+const shared_ptr<Null> Evaluator::null = Null::constant();
+
+Evaluator::Stats& Evaluator::Stats::operator+=(const Stats& other)
+{
+	calls += other.calls;
+	pooledFrames += other.pooledFrames;
+	invariantHits += other.invariantHits;
+	reusedValues += other.reusedValues;
+	numericOperations += other.numericOperations;
+	unboxedValues += other.unboxedValues;
+	nativeStores += other.nativeStores;
+	reusedNumbers += other.reusedNumbers;
+	specializationHits += other.specializationHits;
+	specializationMisses += other.specializationMisses;
+	uncheckedIndexes += other.uncheckedIndexes;
+	reusedScopes += other.reusedScopes;
+	reusedFrames += other.reusedFrames;
+	parallelRuns += other.parallelRuns;
+	serialCallbacks += other.serialCallbacks;
+	return *this;
+}
 
 shared_ptr<Bool> Evaluator::evaluate_bool(shared_ptr<BoolExpr> node)
 {
@@ -40,6 +66,16 @@ shared_ptr<Bool> Evaluator::evaluate_bool(shared_ptr<BoolExpr> node)
 
 shared_ptr<Object> Evaluator::evaluate_program(shared_ptr<Program> node, shared_ptr<Environment> env)
 {
+	if (!node->analyzed)
+	{
+		FreeVariables::analyze(node);
+		ElementUses::analyze(node);
+	}
+	if (_closures)
+	{
+		return closure::Compiler::run(*this, *node, env);
+	}
+
 	shared_ptr<Object> result;
 	for (const auto& statement : node->statements)
 	{
@@ -71,15 +107,15 @@ shared_ptr<Object> Evaluator::evaluate_prefix_bang(shared_ptr<Object> value)
 		return bool_false;
 	}
 
-	if (value == bool_false || value == null)
+	if (value->type == Object::Type::Bool)
 	{
-		return bool_true;
+		return bool_to_object(!static_cast<Bool&>(*value).value);
 	}
-	if (value == bool_true)
+	if (value->type == Object::Type::Null)
 	{
-		return bool_false;
+		return bool_true;
 	}
-	
+
 	return operand_type_error("prefix", "!", value->typeName());
 }
 
@@ -162,6 +198,27 @@ shared_ptr<Object> Evaluator::index_operand_type(const string& left, const strin
 	return make_shared<Error>(buffer.str());
 }
 
+shared_ptr<Object> Evaluator::nan_key(const string& left)
+{
+	stringstream buffer;
+	buffer << "error - invalid key: expected a key of the " << left << " that is not NaN";
+	return make_shared<Error>(buffer.str());
+}
+
+shared_ptr<Object> Evaluator::range_operand_type(const string& start, const string& end)
+{
+	stringstream buffer;
+	buffer << "error - range operand type: " << start << ".." << end;
+	return make_shared<Error>(buffer.str());
+}
+
+shared_ptr<Object> Evaluator::not_iterable(const string& type)
+{
+	stringstream buffer;
+	buffer << "error - expected range or array to iterate: " << type;
+	return make_shared<Error>(buffer.str());
+}
+
 shared_ptr<Object> Evaluator::repeat_declaration(const string& name)
 {
 	stringstream buffer;
@@ -176,6 +233,58 @@ shared_ptr<Object> Evaluator::access_immutable_var(const string &name)
 	return make_shared<Error>(buffer.str());
 }
 
+shared_ptr<Object> Evaluator::annotation_mismatch(const string& name, Annotation annotation, const string& type)
+{
+	stringstream buffer;
+	buffer << "error - annotation mismatch: expected " << name << " to be " << annotation_name(annotation) << ", but got " << type;
+	return make_shared<Error>(buffer.str());
+}
+
+bool Evaluator::is_constant(const shared_ptr<Object>& obj)
+{
+	return obj == bool_true || obj == bool_false || obj == null;
+}
+
+shared_ptr<Object> Evaluator::declared(shared_ptr<Object> value, bool isMutable)
+{
+	if (isMutable && is_constant(value))
+	{
+		value = value->copy();
+	}
+	value->setMutable(isMutable);
+	return value;
+}
+
+shared_ptr<Object> Evaluator::new_map(vector<shared_ptr<Object>> entries)
+{
+	auto map = make_shared<Map>();
+	for (size_t i = 0; i + 1 < entries.size(); i += 2)
+	{
+		auto& key = entries[i];
+		if (!Map::hashable(*key))
+		{
+			return Float::is_nan(*key) ? nan_key(map->typeName()) : index_operand_type(map->typeName(), key->typeName());
+		}
+		size_t hash = Map::hash(*key);
+		map->insert(move(key), hash).value = move(entries[i + 1]);
+	}
+	return map;
+}
+
+bool Evaluator::is_annotated(Annotation annotation, const shared_ptr<Object>& obj)
+{
+	switch (annotation)
+	{
+	case Annotation::None: return true;
+	case Annotation::Integer: return obj->type == Object::Type::Integer;
+	case Annotation::Float: return obj->type == Object::Type::Float;
+	case Annotation::Bool: return obj->type == Object::Type::Bool;
+	case Annotation::String: return obj->type == Object::Type::String;
+	case Annotation::Array: return obj->type == Object::Type::Array;
+	default: return obj->type == Object::Type::Function || obj->type == Object::Type::BuiltinFun;
+	}
+}
+
 shared_ptr<Object> Evaluator::evaluate_prefix(const string& operatorName, shared_ptr<Object> right)
 {
 	if (operatorName == "!")
@@ -299,35 +408,293 @@ shared_ptr<Object> Evaluator::evaluate_infix_number(shared_ptr<Object> left, con
 	return unknown_infix(left->typeName(), operatorName, right->typeName());
 }
 
-bool Evaluator::is_true(shared_ptr<Object> obj)
+//	Whether a numeric operator gives a float, an integer it gives is truncated
+static bool gives_float(const InfixExpr& node)
+{
+	return (node.leftFloat || node.rightFloat) && node.numericOp != NumericOp::Remainder;
+}
+
+//	The sum, difference, product or quotient of two numbers, before it is truncated to an integer
+static double arithmetic(NumericOp op, double left, double right)
 {
-	if (obj == null || obj == bool_false)
+	switch (op)
 	{
-		return false;
+	case NumericOp::Add: return left + right;
+	case NumericOp::Subtract: return left - right;
+	case NumericOp::Multiply: return left * right;
+	default: return left / right;
+	}
+}
+
+shared_ptr<Object> Evaluator::evaluate_infix_numeric(const InfixExpr& node, const shared_ptr<Object>& left, const shared_ptr<Object>& right)
+{
+	if (node.numericOp == NumericOp::None)
+	{
+		return evaluate_infix_number(left, node.operatorName, right);
+	}
+
+	// The operand types were proven before evaluation or guarded by the feedback of the node, the
+	// numbers are read and combined exactly as evaluate_infix_number does
+	double leftValue = node.leftFloat ? static_cast<Float*>(left.get())->value : static_cast<Integer*>(left.get())->value;
+	double rightValue = node.rightFloat ? static_cast<Float*>(right.get())->value : static_cast<Integer*>(right.get())->value;
+	return evaluate_infix_numeric(node, leftValue, rightValue);
+}
+
+shared_ptr<Object> Evaluator::evaluate_infix_numeric(const InfixExpr& node, double left, double right)
+{
+	if (node.feedback.state == Feedback::State::Proven)
+	{
+		_stats.numericOperations++;
+	}
+
+	switch (node.numericOp)
+	{
+	case NumericOp::Remainder: return make_shared<Integer>(static_cast<int64_t>(left) % static_cast<int64_t>(right));
+	case NumericOp::Equal: return bool_to_object(left == right);
+	case NumericOp::NotEqual: return bool_to_object(left != right);
+	case NumericOp::Less: return bool_to_object(left < right);
+	case NumericOp::Greater: return bool_to_object(left > right);
+	case NumericOp::LessEqual: return bool_to_object(left <= right);
+	case NumericOp::GreaterEqual: return bool_to_object(left >= right);
+	default:
+		if (node.leftFloat || node.rightFloat)
+		{
+			return make_shared<Float>(arithmetic(node.numericOp, left, right));
+		}
+		return make_shared<Integer>(arithmetic(node.numericOp, left, right));
+	}
+}
+
+shared_ptr<Object> Evaluator::evaluate_number(const shared_ptr<Expr>& node, bool isFloat, const shared_ptr<Environment>& env, double& value)
+{
+	auto* infix = node->type == Node::Type::Infix ? static_cast<InfixExpr*>(node.get()) : nullptr;
+	if (infix == nullptr || !infix->unboxed || infix->feedback.state != Feedback::State::Proven)
+	{
+		auto obj = evaluate(node, env);
+		if (obj->type == Object::Type::Error)
+		{
+			return obj;
+		}
+		value = isFloat ? static_cast<Float&>(*obj).value : static_cast<Integer&>(*obj).value;
+		return nullptr;
+	}
+
+	if (auto error = evaluate_unboxed(*infix, env, value))
+	{
+		return error;
+	}
+	_stats.unboxedValues++;
+
+	// The number is the one the user would read from the object evaluate_infix_numeric creates
+	if (!gives_float(*infix))
+	{
+		value = static_cast<double>(static_cast<int64_t>(value));
+	}
+	return nullptr;
+}
+
+shared_ptr<Object> Evaluator::evaluate_unboxed(const InfixExpr& node, const shared_ptr<Environment>& env, double& value)
+{
+	double left = 0;
+	double right = 0;
+	if (auto error = evaluate_number(node.left, node.leftFloat, env, left))
+	{
+		return error;
+	}
+	if (auto error = evaluate_number(node.right, node.rightFloat, env, right))
+	{
+		return error;
+	}
+	_stats.numericOperations++;
+
+	if (node.numericOp == NumericOp::Remainder)
+	{
+		value = static_cast<double>(static_cast<int64_t>(left) % static_cast<int64_t>(right));
+	}
+	else
+	{
+		value = arithmetic(node.numericOp, left, right);
+	}
+	return nullptr;
+}
+
+shared_ptr<Object> Evaluator::assign_number(const AssignExpr& node, const shared_ptr<Environment>& env)
+{
+	auto id = evaluate(node.id, env);
+	auto* infix = node.value->type == Node::Type::Infix ? static_cast<InfixExpr*>(node.value.get()) : nullptr;
+	if (infix && (infix->feedback.state != Feedback::State::Proven || !InfixExpr::is_arithmetic(infix->numericOp)))
+	{
+		infix = nullptr;
+	}
+
+	shared_ptr<Object> value;
+	double number = 0;
+	bool isFloat = false;
+	if (infix)
+	{
+		value = evaluate_unboxed(*infix, env, number);
+		isFloat = gives_float(*infix);
+	}
+	else
+	{
+		value = evaluate(node.value, env);
+	}
+	if (id->type == Object::Type::Error)
+	{
+		return id;
+	}
+	if (value && value->type == Object::Type::Error)
+	{
+		return value;
+	}
+	if (!id->isMutable)
+	{
+		return access_immutable_var(node.id->literal());
+	}
+
+	// The proof holds as long as the names are bound as the analysis saw them
+	bool numbers = id->type == Object::Type::Integer || id->type == Object::Type::Float;
+	if (value && (value->type == Object::Type::Integer || value->type == Object::Type::Float) && node.operatorName != "=")
+	{
+		isFloat = value->type == Object::Type::Float;
+		number = isFloat ? static_cast<Float&>(*value).value : static_cast<Integer&>(*value).value;
+	}
+	else if (value)
+	{
+		return evaluate_assign(id, node.operatorName, value, env);
+	}
+	if (!numbers || !AssignExpr::keeps_type(node.operatorName, id->type == Object::Type::Float, isFloat))
+	{
+		if (!value)
+		{
+			value = isFloat ? static_pointer_cast<Object>(make_shared<Float>(number)) : make_shared<Integer>(number);
+		}
+		return evaluate_assign(id, node.operatorName, value, env);
+	}
+
+	_mutations++;
+	_stats.nativeStores++;
+	if (node.operatorName != "=")
+	{
+		// Combined with the number of the name as evaluate_infix_number combines their objects
+		if (infix && !isFloat)
+		{
+			number = static_cast<double>(static_cast<int64_t>(number));
+		}
+		double current = id->type == Object::Type::Float ? static_cast<Float&>(*id).value : static_cast<Integer&>(*id).value;
+		switch (node.operatorName.at(0))
+		{
+		case '+': number = current + number; break;
+		case '-': number = current - number; break;
+		case '*': number = current * number; break;
+		case '/': number = current / number; break;
+		default:
+			static_cast<Integer&>(*id).value = static_cast<int64_t>(current) % static_cast<int64_t>(number);
+			return id;
+		}
+	}
+
+	if (id->type == Object::Type::Float)
+	{
+		static_cast<Float&>(*id).value = number;
+	}
+	else
+	{
+		static_cast<Integer&>(*id).value = static_cast<int64_t>(number);
 	}
-	if (obj == bool_true)
+	return id;
+}
+
+bool Evaluator::guard(Feedback& feedback, Object::Type left, Object::Type right, bool specializable)
+{
+	switch (feedback.state)
 	{
+
+	case Feedback::State::Proven:
 		return true;
+
+	case Feedback::State::Specialized:
+		if (feedback.left == static_cast<uint8_t>(left) && feedback.right == static_cast<uint8_t>(right))
+		{
+			_stats.specializationHits++;
+			return true;
+		}
+		_stats.specializationMisses++;
+		if (!_shared)
+		{
+			feedback.state = Feedback::State::Generic;
+		}
+		return false;
+
+	// Workers leave the tree to the evaluator that started them
+	case Feedback::State::Uninitialized:
+		if (_shared)
+		{
+			return false;
+		}
+		feedback.state = specializable ? Feedback::State::Specialized : Feedback::State::Generic;
+		feedback.left = static_cast<uint8_t>(left);
+		feedback.right = static_cast<uint8_t>(right);
+		return specializable;
+
+	default:
+		return false;
+
 	}
-	return true;
+}
+
+bool Evaluator::specialize_infix(InfixExpr& node, const Object& left, const Object& right)
+{
+	bool specializable = false;
+	if (node.feedback.state == Feedback::State::Uninitialized && !_shared)
+	{
+		bool numbers = (left.type == Object::Type::Integer || left.type == Object::Type::Float) &&
+			(right.type == Object::Type::Integer || right.type == Object::Type::Float);
+		if (numbers)
+		{
+			node.leftFloat = left.type == Object::Type::Float;
+			node.rightFloat = right.type == Object::Type::Float;
+			node.numericOp = InfixExpr::numeric_op(node.operatorName, node.leftFloat, node.rightFloat);
+			specializable = node.numericOp != NumericOp::None;
+		}
+	}
+	return guard(node.feedback, left.type, right.type, specializable);
+}
+
+// Names bound to bools and nulls may hold copies of the constants, so they are compared by value
+bool Evaluator::is_true(shared_ptr<Object> obj)
+{
+	if (obj->type == Object::Type::Bool)
+	{
+		return static_cast<Bool&>(*obj).value;
+	}
+	return obj->type != Object::Type::Null;
 }
 
 shared_ptr<Object> Evaluator::evaluate_infix_string(shared_ptr<Object> left, const string& operatorName, shared_ptr<Object> right)
 {
-	auto leftValue = dynamic_pointer_cast<String>(left)->value;
-	auto rightValue = dynamic_pointer_cast<String>(right)->value;
+	if (right->type != Object::Type::String)
+	{
+		return infix_operand_type_mismatch(left->typeName(), operatorName, right->typeName());
+	}
+	const auto& leftString = static_cast<String&>(*left);
+	auto rightValue = static_cast<String&>(*right).view();
 
+	// The sum starts as a copy of left sharing its buffer, see String
 	if (operatorName == "+")
 	{
-		return make_shared<String>(leftValue + rightValue);
+		auto sum = make_shared<String>(leftString);
+		sum->isMutable = false;
+		sum->append(rightValue, _shared);
+		return sum;
 	}
 	if (operatorName == "==")
 	{
-		bool_to_object(leftValue == rightValue);
+		return bool_to_object(leftString.view() == rightValue);
 	}
 	if (operatorName == "!=")
 	{
-		bool_to_object(leftValue != rightValue);
+		return bool_to_object(leftString.view() != rightValue);
 	}
 
 	return unknown_infix(left->typeName(), operatorName, right->typeName());
@@ -348,14 +715,23 @@ shared_ptr<Object> Evaluator::evaluate_infix(shared_ptr<Object> left, const stri
 	{
 		return infix_operand_type_mismatch(left->typeName(), operatorName, right->typeName());
 	}
-	// Compare address directly
+	// Bools and nulls are compared by value, anything else by address
+	bool equal = left == right;
+	if (left->type == Object::Type::Bool)
+	{
+		equal = static_cast<Bool&>(*left).value == static_cast<Bool&>(*right).value;
+	}
+	else if (left->type == Object::Type::Null)
+	{
+		equal = true;
+	}
 	if (operatorName == "==")
 	{
-		return bool_to_object(left == right);
+		return bool_to_object(equal);
 	}
 	if (operatorName == "!=")
 	{
-		return bool_to_object(left != right);
+		return bool_to_object(!equal);
 	}
 
 	return unknown_infix(left->typeName(), operatorName, right->typeName());
@@ -393,19 +769,50 @@ shared_ptr<Object> Evaluator::evaluate_if(shared_ptr<IfExpr> node, shared_ptr<En
 
 shared_ptr<Object> Evaluator::evaluate_id(shared_ptr<IdentifierExpr> id, shared_ptr<Environment> env)
 {
-	auto* value = env->get(id->value);
+	if (id->captureIndex >= 0 && env->captures)
+	{
+		auto& captured = env->captures->values[id->captureIndex];
+		if (captured)
+		{
+			_stats.specializationHits++;
+			return captured;
+		}
+	}
+
+	// The inline cache is the specialization of an identifier, a new version of the bindings fails its guard
+	if (id->cacheVersion == Environment::version())
+	{
+		_stats.specializationHits++;
+		return id->cache;
+	}
+	if (id->cacheVersion != 0)
+	{
+		_stats.specializationMisses++;
+	}
+
+	shared_ptr<Object> resolved;
+	auto* value = env->get(id->symbol);
 	if (value != nullptr)
 	{
-		return *value;
+		resolved = *value;
 	}
-	
-	auto it = builtinFuns.find(id->value);
-	if (it != builtinFuns.end())
+	else
 	{
-		return it->second;
+		auto it = builtinFuns.find(id->value);
+		if (it == builtinFuns.end())
+		{
+			return identifier_not_found(id->value);
+		}
+		resolved = it->second;
 	}
 
-	return identifier_not_found(id->value);
+	// A symbol never declared in a local scope resolves to the same global binding from every site
+	if (!_shared && !Environment::is_local_symbol(id->symbol))
+	{
+		id->cache = resolved;
+		id->cacheVersion = Environment::version();
+	}
+	return resolved;
 }
 
 vector<shared_ptr<Object>> Evaluator::evaluate_exprs(shared_ptr<ExpressionsStat> exprs, shared_ptr<Environment> env)
@@ -423,102 +830,735 @@ vector<shared_ptr<Object>> Evaluator::evaluate_exprs(shared_ptr<ExpressionsStat>
 	return result;
 }
 
-tuple<shared_ptr<Object>, shared_ptr<Environment>> Evaluator::bind_fun_args_to_objects(shared_ptr<Function> fun, const vector<shared_ptr<Object>>& objects)
+shared_ptr<Object> Evaluator::bind_fun_args_to_objects(shared_ptr<Function> fun, const vector<shared_ptr<Object>>& objects, shared_ptr<Environment> env)
 {
 	if (fun->args->args.size() != objects.size())
 	{
-		return { invalid_arguments(string("expected the number of them to be 2, but got ") + to_string(objects.size())), nullptr};
+		return invalid_arguments(string("expected the number of them to be 2, but got ") + to_string(objects.size()));
 	}
 
-	auto env = make_shared<Environment>(fun->env);
+	env->outer = fun->env;
+	env->kind = Environment::Kind::Frame;
+	env->captures = fun->captures;
 	for (int i = 0; i < fun->args->args.size(); i++)
 	{
 		auto id = fun->args->args.at(i);
-		auto copied = objects.at(i)->copy();
+		if (!is_annotated(fun->args->annotation(i), objects.at(i)))
+		{
+			return annotation_mismatch(id->value, fun->args->annotation(i), objects.at(i)->typeName());
+		}
+
+		auto annotation = fun->args->annotation(i);
+		auto copied = annotation == Annotation::Integer || annotation == Annotation::Float ? copy_number(objects.at(i)) : objects.at(i)->copy();
 		copied->setMutable(true);
-		env->add(id->value, copied);
+		env->add(id->symbol, copied);
 	}
-	return { nullptr, env };
+	return nullptr;
 }
 
-shared_ptr<Object> Evaluator::evaluate_fun(shared_ptr<Object> fun, const vector<shared_ptr<Object>>& args)
+Environment* Evaluator::acquire_frame()
 {
-	switch (fun->type)
+	if (_framePool.empty())
 	{
+		return new Environment();
+	}
 
-	case Object::Type::Function:
-	{
-		auto cast = dynamic_pointer_cast<Function>(fun);
+	auto* frame = _framePool.back().release();
+	_framePool.pop_back();
+	return frame;
+}
 
-		auto [error, innerEnv] = bind_fun_args_to_objects(cast, args);
-		if (error) return error;
+void Evaluator::release_frame(Environment* frame)
+{
+	frame->clear();
+	_framePool.emplace_back(frame);
+}
 
-		auto evaluated = evaluate(cast->body, innerEnv);
+shared_ptr<Object> Evaluator::copy_number(const shared_ptr<Object>& number)
+{
+	for (auto it = _spareNumbers.rbegin(); it != _spareNumbers.rend(); ++it)
+	{
+		if ((*it)->type != number->type) continue;
 
-		if (evaluated->type == Object::Type::ReturnValue)
+		auto spare = move(*it);
+		_spareNumbers.erase(next(it).base());
+		if (number->type == Object::Type::Float)
+		{
+			static_cast<Float&>(*spare).value = static_cast<Float&>(*number).value;
+		}
+		else
 		{
-			return dynamic_pointer_cast<ReturnValue>(evaluated)->value;
+			static_cast<Integer&>(*spare).value = static_cast<Integer&>(*number).value;
 		}
-		return evaluated;
+		_stats.reusedNumbers++;
+		return spare;
 	}
+	return number->copy();
+}
 
-	case Object::Type::BuiltinFun:
+void Evaluator::keep_numbers(const Function& fun, Environment& frame)
+{
+	for (size_t i = 0; i < fun.args->args.size(); i++)
 	{
-		auto cast = dynamic_pointer_cast<BuiltinFun>(fun);
-		return cast->fun(args);
-	}
+		auto annotation = fun.args->annotation(i);
+		if (annotation != Annotation::Integer && annotation != Annotation::Float) continue;
 
-	default:
-		return not_function(fun->typeName());
+		// Enough for the arguments of a few nested calls, the others are freed
+		if (_spareNumbers.size() >= MAX_SPARE_NUMBERS) return;
+
+		auto* slot = frame.find(fun.args->args[i]->symbol);
+		if (slot != nullptr && slot->use_count() == 1)
+		{
+			_spareNumbers.push_back(move(*slot));
+		}
 	}
 }
 
-shared_ptr<Object> Evaluator::evaluate_index(shared_ptr<Object> left, shared_ptr<Object> index)
+shared_ptr<Object> Evaluator::evaluate_closure(shared_ptr<FunctionExpr> node, shared_ptr<Environment> env)
 {
-	if (left->type == Object::Type::Array && index->type == Object::Type::Integer)
+	if (!node->analyzed)
 	{
-		return evaluate_index_array(dynamic_pointer_cast<Array>(left), dynamic_pointer_cast<Integer>(index));
+		FreeVariables::analyze(node);
+		ElementUses::analyze(node);
 	}
 
-	return index_operand_type(left->typeName(), index->typeName());
+	// Functions defined in a global scope resolve every free variable by name
+	if (env->kind == Environment::Kind::Global || node->freeVars->empty())
+	{
+		auto fun = make_shared<Function>(node->args, node->body, Environment::global(env));
+		fun->frameEscapes = node->frameEscapes;
+		fun->node = node;
+		return fun;
+	}
+
+	auto captures = make_shared<Captures>();
+	captures->symbols = node->freeVars;
+	captures->values.resize(node->freeVars->size());
+	for (size_t i = 0; i < node->freeVars->size(); i++)
+	{
+		auto* found = env->get_local(node->freeVars->at(i));
+		if (found != nullptr)
+		{
+			captures->values[i] = *found;
+		}
+		else if (node->lateBound.at(i))
+		{
+			// The variable may still be declared by the enclosing code, keep the whole chain
+			auto fun = make_shared<Function>(node->args, node->body, env);
+			fun->frameEscapes = node->frameEscapes;
+			fun->node = node;
+			return fun;
+		}
+	}
+
+	auto fun = make_shared<Function>(node->args, node->body, Environment::global(env), captures);
+	fun->frameEscapes = node->frameEscapes;
+	fun->node = node;
+	return fun;
 }
 
-shared_ptr<Object> Evaluator::evaluate_index_array(shared_ptr<Array> array, shared_ptr<Integer> index)
+bool Evaluator::enable_jit(uint32_t threshold)
 {
-	size_t size = array->elements.size();
-	if (index->value >= size || index->value < 0)
+	if (!jit::Jit::supported())
 	{
-		return null;
+		return false;
 	}
-	return array->elements.at(index->value);
+	_jit = make_unique<jit::Jit>(threshold);
+	return true;
 }
 
-shared_ptr<Object> Evaluator::evaluate_in_decrement(shared_ptr<Object> id, const string& operatorName, shared_ptr<Environment> env)
+shared_ptr<Object> Evaluator::evaluate_while(shared_ptr<WhileStat> node, shared_ptr<Environment> env)
 {
-	if (operatorName == "++")
+	if (node->invariants != 0)
 	{
-		switch (id->type)
-		{
+		_loops.push_back({ node.get(), vector<CachedValue>(node->invariants) });
+	}
 
-		case Object::Type::Integer:
+	// Between two iterations a hot loop continues in its machine code until it ends
+	while (true)
+	{
+		if (_jit && _jit->run_loop(node, env, _running))
 		{
-			auto cast = dynamic_pointer_cast<Integer>(id);
-			cast->value++;
-			return cast;
+			if (_jit->mutated())
+			{
+				_mutations++;
+			}
+			break;
 		}
-
-		default:
-			return operand_type_error("increment or decrement", operatorName, id->typeName());
+		if (!is_true(evaluate(node->condition, env)))
+		{
+			break;
 		}
+		evaluate(node->body, make_shared<Environment>(env, Environment::Kind::Scope));
 	}
 
-	if (operatorName == "--")
+	if (node->invariants != 0)
 	{
-		switch (id->type)
-		{
+		_loops.pop_back();
+	}
+	return null;
+}
 
-		case Object::Type::Integer:
-		{
+shared_ptr<Object> Evaluator::evaluate_for(shared_ptr<ForStat> node, shared_ptr<Environment> env)
+{
+	auto iterable = evaluate(node->iterable, env);
+	if (iterable->type == Object::Type::Error)
+	{
+		return iterable;
+	}
+
+	shared_ptr<Object> end;
+	if (node->end)
+	{
+		end = evaluate(node->end, env);
+		if (end->type == Object::Type::Error)
+		{
+			return end;
+		}
+	}
+
+	return iterate(node->name->symbol, iterable, end, node->copies, env, [&](const shared_ptr<Environment>& scope)
+	{
+		return evaluate(node->body, scope);
+	});
+}
+
+shared_ptr<Object> Evaluator::evaluate_invariant(shared_ptr<InvariantExpr> node, shared_ptr<Environment> env)
+{
+	// The innermost activation of the loop, a recursive call may have entered it again
+	for (auto it = _loops.rbegin(); it != _loops.rend(); ++it)
+	{
+		if (it->loop != node->loop) continue;
+
+		auto& cached = it->values.at(node->slot);
+		uint64_t version = node->shapeOnly ? _reshapes : _mutations;
+		if (cached.value && cached.version == version)
+		{
+			_stats.invariantHits++;
+			return cached.value;
+		}
+
+		auto value = evaluate(node->expr, env);
+		if (value->type != Object::Type::Error)
+		{
+			cached.value = value;
+			cached.version = version;
+		}
+		return value;
+	}
+	return evaluate(node->expr, env);
+}
+
+shared_ptr<Object> Evaluator::evaluate_temp(shared_ptr<TempExpr> node, shared_ptr<Environment> env)
+{
+	// Slots belong to the function activation rather than to the scopes of its loops
+	auto* frame = env.get();
+	while (frame->kind == Environment::Kind::Scope && frame->outer)
+	{
+		frame = frame->outer.get();
+	}
+
+	auto& temps = frame->temps;
+	if (node->reuse && node->slot < temps.size() && temps[node->slot])
+	{
+		_stats.reusedValues++;
+		return temps[node->slot];
+	}
+
+	auto value = evaluate(node->expr, env);
+	if (!node->reuse)
+	{
+		if (temps.size() <= node->slot)
+		{
+			temps.resize(node->slot + 1);
+		}
+		temps[node->slot] = value;
+	}
+	return value;
+}
+
+shared_ptr<Object> Evaluator::evaluate_fun(shared_ptr<Object> fun, const vector<shared_ptr<Object>>& args)
+{
+	switch (fun->type)
+	{
+
+	case Object::Type::Function:
+		return call_function(dynamic_pointer_cast<Function>(fun), args);
+
+	case Object::Type::BuiltinFun:
+	{
+		auto cast = dynamic_pointer_cast<BuiltinFun>(fun);
+		return cast->fun(*this, args);
+	}
+
+	default:
+		return not_function(fun->typeName());
+	}
+}
+
+shared_ptr<Object> Evaluator::call_function(const shared_ptr<Function>& fun, const vector<shared_ptr<Object>>& args)
+{
+	_stats.calls++;
+
+	if (_jit)
+	{
+		if (auto result = _jit->call(*fun, args))
+		{
+			if (_jit->mutated())
+			{
+				_mutations++;
+			}
+			return result;
+		}
+	}
+
+	// Nothing can retain a frame that no closure captures, so it comes from the pool and
+	// is referenced without ownership for the duration of the call
+	Environment* frame = nullptr;
+	shared_ptr<Environment> innerEnv;
+	if (!fun->frameEscapes)
+	{
+		_stats.pooledFrames++;
+		frame = acquire_frame();
+		innerEnv = shared_ptr<Environment>(shared_ptr<Environment>(), frame);
+	}
+	else
+	{
+		innerEnv = make_shared<Environment>();
+	}
+
+	auto evaluated = bind_fun_args_to_objects(fun, args, innerEnv);
+	if (!evaluated)
+	{
+		evaluated = run_function(*fun, innerEnv);
+	}
+	if (frame)
+	{
+		keep_numbers(*fun, *frame);
+		release_frame(frame);
+	}
+	return evaluated;
+}
+
+shared_ptr<Object> Evaluator::run_function(Function& fun, const shared_ptr<Environment>& frame)
+{
+	auto running = _running;
+	_running = fun.node.get();
+	shared_ptr<Object> evaluated;
+	if (fun.native)
+	{
+		evaluated = fun.native(frame);
+	}
+	else if (_closures && fun.node)
+	{
+		evaluated = closure::Compiler::call(*this, *fun.node, frame);
+	}
+	else
+	{
+		evaluated = evaluate(fun.body, frame);
+	}
+	_running = running;
+
+	if (evaluated->type == Object::Type::ReturnValue)
+	{
+		evaluated = dynamic_pointer_cast<ReturnValue>(evaluated)->value;
+	}
+	if (evaluated->type != Object::Type::Error && !is_annotated(fun.args->result, evaluated))
+	{
+		return annotation_mismatch("result", fun.args->result, evaluated->typeName());
+	}
+	return evaluated;
+}
+
+Evaluator::Callback::Callback(Evaluator& evaluator, const shared_ptr<Object>& fun) : _evaluator(evaluator), _fun(fun)
+{
+	if (fun->type != Object::Type::Function)
+	{
+		return;
+	}
+
+	_function = static_cast<Function*>(fun.get());
+	if (!_function->frameEscapes)
+	{
+		_evaluator._stats.pooledFrames++;
+		_frame = _evaluator.acquire_frame();
+		_frame->outer = _function->env;
+		_frame->kind = Environment::Kind::Frame;
+		_frame->captures = _function->captures;
+		_env = shared_ptr<Environment>(shared_ptr<Environment>(), _frame);
+	}
+}
+
+Evaluator::Callback::~Callback()
+{
+	if (_frame)
+	{
+		_evaluator.release_frame(_frame);
+	}
+}
+
+shared_ptr<Object> Evaluator::Callback::check(size_t arity) const
+{
+	if (_function)
+	{
+		size_t count = _function->args->args.size();
+		if (count != arity)
+		{
+			return invalid_arguments("expected a function of " + to_string(arity) + " arguments, but got one of " + to_string(count));
+		}
+		return nullptr;
+	}
+	if (_fun->type != Object::Type::BuiltinFun)
+	{
+		return invalid_arguments("expected the type of second argument to be function, but got " + _fun->typeName());
+	}
+	return nullptr;
+}
+
+shared_ptr<Object> Evaluator::Callback::call(const vector<shared_ptr<Object>>& args)
+{
+	if (!_function)
+	{
+		return static_cast<BuiltinFun&>(*_fun).fun(_evaluator, args);
+	}
+
+	_evaluator._stats.calls++;
+	if (_evaluator._jit)
+	{
+		if (auto result = _evaluator._jit->call(*_function, args))
+		{
+			if (_evaluator._jit->mutated())
+			{
+				_evaluator._mutations++;
+			}
+			return result;
+		}
+	}
+
+	auto env = _env;
+	if (_frame)
+	{
+		_evaluator._stats.reusedFrames += _used;
+		_used = true;
+	}
+	else
+	{
+		env = make_shared<Environment>(_function->env, Environment::Kind::Frame);
+		env->captures = _function->captures;
+	}
+
+	const auto& names = _function->args->args;
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		if (!is_annotated(_function->args->annotation(i), args[i]))
+		{
+			if (_frame) _frame->unbind();
+			return annotation_mismatch(names[i]->value, _function->args->annotation(i), args[i]->typeName());
+		}
+		args[i]->setMutable(true);
+		env->add(names[i]->symbol, args[i]);
+	}
+
+	auto result = _evaluator.run_function(*_function, env);
+	// The bindings of this call go, so that the caller may reuse what only it holds now. A frame
+	// closures may keep is left to them.
+	if (_frame)
+	{
+		_frame->unbind();
+		_frame->temps.clear();
+	}
+	return result;
+}
+
+shared_ptr<Object> Evaluator::evaluate_index(shared_ptr<Object> left, shared_ptr<Object> index, bool consumed)
+{
+	if (left->type == Object::Type::Array && index->type == Object::Type::Integer)
+	{
+		return evaluate_index_array(static_cast<Array&>(*left), static_cast<Integer&>(*index).value, consumed);
+	}
+
+	// A character is a string of its own, out of range reads null as for an array
+	if (left->type == Object::Type::String && index->type == Object::Type::Integer)
+	{
+		const auto& text = static_cast<String&>(*left);
+		auto i = static_cast<Integer&>(*index).value;
+		if (i < 0 || i >= static_cast<int64_t>(text.size()))
+		{
+			return null;
+		}
+		return text.slice(i, 1);
+	}
+
+	if (left->type == Object::Type::Map && Map::hashable(*index))
+	{
+		return evaluate_index_map(static_cast<Map&>(*left), index);
+	}
+
+	if (left->type == Object::Type::OrderedMap && static_cast<OrderedMap&>(*left).accepts(*index))
+	{
+		return evaluate_index_map(static_cast<OrderedMap&>(*left), index);
+	}
+
+	if ((left->type == Object::Type::Map || left->type == Object::Type::OrderedMap) && Float::is_nan(*index))
+	{
+		return nan_key(left->typeName());
+	}
+
+	return index_operand_type(left->typeName(), index->typeName());
+}
+
+shared_ptr<Object> Evaluator::evaluate_slice(const shared_ptr<Object>& left, const shared_ptr<Object>& from, const shared_ptr<Object>& to)
+{
+	bool sliced = left->type == Object::Type::Array || left->type == Object::Type::String;
+	if (!sliced || (from && from->type != Object::Type::Integer) || (to && to->type != Object::Type::Integer))
+	{
+		return index_operand_type(left->typeName(), (from ? from->typeName() : "") + ":" + (to ? to->typeName() : ""));
+	}
+
+	// Clamped into the array or string, as slice() clamps its bounds
+	auto size = static_cast<int64_t>(left->type == Object::Type::Array ? static_cast<Array&>(*left).size() : static_cast<String&>(*left).size());
+	auto first = from ? clamp<int64_t>(static_cast<Integer&>(*from).value, 0, size) : 0;
+	auto last = to ? clamp<int64_t>(static_cast<Integer&>(*to).value, first, size) : size;
+	if (left->type == Object::Type::Array)
+	{
+		return Array::view(static_pointer_cast<Array>(left), first, last - first);
+	}
+	return static_cast<String&>(*left).slice(first, last - first);
+}
+
+template <typename Table>
+shared_ptr<Object> Evaluator::evaluate_index_map(Table& map, const shared_ptr<Object>& key)
+{
+	auto* found = map.find(*key);
+	return found ? *found : null;
+}
+
+shared_ptr<Object> Evaluator::evaluate_index_array(Array& array, int64_t index, bool consumed)
+{
+	if (!consumed)
+	{
+		box(array);
+	}
+	if (index >= static_cast<int64_t>(array.size()) || index < 0)
+	{
+		return null;
+	}
+	return read(array, index);
+}
+
+// The arrays workers may change are their own, the others are only read. An immutable array is
+// not boxed for them, no name can see its elements change. Whether the elements are shared is up
+// to the array holding them, a mutable view of an immutable array is only boxed once it has elements
+// of its own, and its reads leave the scratch box of the immutable array alone.
+void Evaluator::box(Array& array)
+{
+	size_t from;
+	if (!_shared || array.storage(from).isMutable || array.isMutable)
+	{
+		array.box();
+	}
+}
+
+shared_ptr<Object> Evaluator::read(Array& array, size_t i)
+{
+	size_t from;
+	return !_shared || array.storage(from).isMutable ? array.read(i) : array.get(i);
+}
+
+shared_ptr<Object> Evaluator::evaluate_element(IndexExpr& node, shared_ptr<Environment> env, shared_ptr<Object>& left, shared_ptr<Object>& index)
+{
+	auto array = evaluate(node.left, env);
+	if (array->type == Object::Type::Error)
+	{
+		return array;
+	}
+
+	auto position = evaluate(node.index, env);
+	if (position->type == Object::Type::Error)
+	{
+		return position;
+	}
+
+	left = move(array);
+	index = move(position);
+	return read_index(node, left, index);
+}
+
+shared_ptr<Object> Evaluator::read_index(IndexExpr& node, const shared_ptr<Object>& left, const shared_ptr<Object>& index)
+{
+	if (node.feedback.state != Feedback::State::Generic)
+	{
+		bool specializable = left->type == Object::Type::Array && index->type == Object::Type::Integer;
+		if (guard(node.feedback, left->type, index->type, specializable))
+		{
+			auto& array = static_cast<Array&>(*left);
+			auto value = static_cast<Integer&>(*index).value;
+			if (!node.consumed)
+			{
+				box(array);
+			}
+			if (node.inBounds)
+			{
+				_stats.uncheckedIndexes++;
+				return read(array, value);
+			}
+			if (value >= static_cast<int64_t>(array.size()) || value < 0)
+			{
+				return null;
+			}
+			return read(array, value);
+		}
+	}
+	return evaluate_index(left, index, node.consumed);
+}
+
+shared_ptr<Object> Evaluator::assign_element(const shared_ptr<Object>& left, const shared_ptr<Object>& index, const shared_ptr<Object>& element, const string& literal, const string& operatorName, const shared_ptr<Object>& value, shared_ptr<Environment> env)
+{
+	if (left->type == Object::Type::Map)
+	{
+		return assign_entry(static_cast<Map&>(*left), index, element, literal, operatorName, value, env);
+	}
+	if (left->type == Object::Type::OrderedMap)
+	{
+		return assign_entry(static_cast<OrderedMap&>(*left), index, element, literal, operatorName, value, env);
+	}
+
+	auto* array = left->type == Object::Type::Array ? static_cast<Array*>(left.get()) : nullptr;
+	auto i = index->type == Object::Type::Integer ? static_cast<Integer&>(*index).value : -1;
+	bool inRange = array && i >= 0 && i < static_cast<int64_t>(array->size());
+
+	// A view changes the element in its parent, unless only the view is mutable and gets elements
+	// of its own first, which the element read is not one of
+	auto target = element;
+	if (inRange && array->isView() && array->isMutable)
+	{
+		size_t at = static_cast<size_t>(i);
+		auto* parent = &array->writable(at);
+		if (parent == array)
+		{
+			target = array->get(at);
+		}
+		array = parent;
+		i = static_cast<int64_t>(at);
+	}
+
+	// The elements of an unboxed array are as mutable as the array, the constants read from it or
+	// kept by a boxed one are not and are replaced instead
+	bool replaced = inRange && (array->kind != Array::Kind::Boxed || is_constant(target));
+	if (!(replaced ? array->isMutable : target->isMutable))
+	{
+		return access_immutable_var(literal);
+	}
+	if (!inRange)
+	{
+		return evaluate_assign(target, operatorName, value, env);
+	}
+
+	// Evaluating the value may have changed the element or boxed the array, so it is read again
+	auto result = value;
+	if (operatorName != "=")
+	{
+		auto current = array->read(i);
+		if (operatorName.size() != 2)
+		{
+			return unknown_infix(current->typeName(), operatorName, value->typeName());
+		}
+		result = evaluate_infix(current, string(1, operatorName.at(0)), value);
+		if (result->type == Object::Type::Error)
+		{
+			return result;
+		}
+	}
+
+	if (array->kind == Array::Kind::Boxed)
+	{
+		auto current = array->elements[i];
+		if (current->type == result->type && !is_constant(current))
+		{
+			evaluate_assign(current, "=", result, env);
+			return result;
+		}
+		// A value of another type replaces the element
+		_reshapes++;
+	}
+
+	_mutations++;
+	auto kind = array->kind;
+	array->set(i, result);
+	if (array->kind != kind)
+	{
+		_reshapes++;
+	}
+	return result;
+}
+
+template <typename Table>
+shared_ptr<Object> Evaluator::assign_entry(Table& map, const shared_ptr<Object>& key, const shared_ptr<Object>& element, const string& literal, const string& operatorName, const shared_ptr<Object>& value, shared_ptr<Environment> env)
+{
+	// Like the elements of a boxed array, a new key and a constant are set in the map, which must
+	// be mutable for it, and other values are assigned in place
+	auto* found = map.find(*key);
+	bool replaced = !found || is_constant(*found);
+	if (!(replaced ? map.isMutable : element->isMutable))
+	{
+		return access_immutable_var(literal);
+	}
+
+	auto result = value;
+	if (operatorName != "=")
+	{
+		if (operatorName.size() != 2)
+		{
+			return unknown_infix(element->typeName(), operatorName, value->typeName());
+		}
+		result = evaluate_infix(element, string(1, operatorName.at(0)), value);
+		if (result->type == Object::Type::Error)
+		{
+			return result;
+		}
+	}
+
+	// Evaluating the value may have removed the key
+	found = map.find(*key);
+	if (found && (*found)->type == result->type && !is_constant(*found))
+	{
+		evaluate_assign(*found, "=", result, env);
+		return result;
+	}
+
+	_mutations++;
+	_reshapes++;
+	map.set(key, result);
+	return result;
+}
+
+shared_ptr<Object> Evaluator::evaluate_in_decrement(shared_ptr<Object> id, const string& operatorName, shared_ptr<Environment> env)
+{
+	_mutations++;
+	if (operatorName == "++")
+	{
+		switch (id->type)
+		{
+
+		case Object::Type::Integer:
+		{
+			auto cast = dynamic_pointer_cast<Integer>(id);
+			cast->value++;
+			return cast;
+		}
+
+		default:
+			return operand_type_error("increment or decrement", operatorName, id->typeName());
+		}
+	}
+
+	if (operatorName == "--")
+	{
+		switch (id->type)
+		{
+
+		case Object::Type::Integer:
+		{
 			auto cast = dynamic_pointer_cast<Integer>(id);
 			cast->value--;
 			return cast;
@@ -534,6 +1574,18 @@ shared_ptr<Object> Evaluator::evaluate_in_decrement(shared_ptr<Object> id, const
 
 shared_ptr<Object> Evaluator::evaluate_assign(shared_ptr<Object> id, const string& operatorName, shared_ptr<Object> value, shared_ptr<Environment> env)
 {
+	_mutations++;
+	// Appending a boxed array shares its elements and makes them mutable, see Var
+	if (_shared && value->type == Object::Type::Array && !value->isMutable && static_cast<Array&>(*value).kind == Array::Kind::Boxed)
+	{
+		_conflict = true;
+		value = static_cast<Array&>(*value).owned();
+	}
+	if (id->type != Object::Type::Integer && id->type != Object::Type::Float && id->type != Object::Type::Bool)
+	{
+		_reshapes++;
+	}
+
 	if (operatorName == "=")
 	{
 		bool origin = id->isMutable;
@@ -547,6 +1599,13 @@ shared_ptr<Object> Evaluator::evaluate_assign(shared_ptr<Object> id, const strin
 		return unknown_infix(id->typeName(), operatorName, value->typeName());
 	}
 
+	// Appending to a string grows it in place rather than making the sum and copying it back
+	if (operatorName == "+=" && id->type == Object::Type::String && value->type == Object::Type::String)
+	{
+		static_cast<String&>(*id).append(static_cast<String&>(*value).view(), _shared);
+		return id;
+	}
+
 	auto result = evaluate_infix(id, string(1, operatorName.at(0)), value);
 
 	bool origin = id->isMutable;
@@ -598,12 +1657,40 @@ shared_ptr<Object> Evaluator::evaluate(shared_ptr<Node> node, shared_ptr<Environ
 			return right;
 		}
 
+		// Negating a number is the only prefix operation with a fast path
+		if (cast->feedback.state != Feedback::State::Generic)
+		{
+			bool specializable = cast->operatorName == "-" && (right->type == Object::Type::Integer || right->type == Object::Type::Float);
+			if (guard(cast->feedback, right->type, right->type, specializable))
+			{
+				if (right->type == Object::Type::Integer)
+				{
+					return make_shared<Integer>(-static_cast<Integer&>(*right).value);
+				}
+				return make_shared<Float>(-static_cast<Float&>(*right).value);
+			}
+		}
 		return evaluate_prefix(cast->operatorName, right);
 	}
 
 	case Node::Type::Infix:
 	{
 		auto cast = dynamic_pointer_cast<InfixExpr>(node);
+		if (cast->feedback.state == Feedback::State::Proven)
+		{
+			double left = 0;
+			double right = 0;
+			if (auto error = evaluate_number(cast->left, cast->leftFloat, env, left))
+			{
+				return error;
+			}
+			if (auto error = evaluate_number(cast->right, cast->rightFloat, env, right))
+			{
+				return error;
+			}
+			return evaluate_infix_numeric(*cast, left, right);
+		}
+
 		auto left = evaluate(cast->left, env);
 		if (left->type == Object::Type::Error)
 		{
@@ -615,6 +1702,10 @@ shared_ptr<Object> Evaluator::evaluate(shared_ptr<Node> node, shared_ptr<Environ
 			return right;
 		}
 
+		if (cast->feedback.state != Feedback::State::Generic && specialize_infix(*cast, *left, *right))
+		{
+			return evaluate_infix_numeric(*cast, left, right);
+		}
 		return evaluate_infix(left, cast->operatorName, right);
 	}
 
@@ -650,16 +1741,17 @@ shared_ptr<Object> Evaluator::evaluate(shared_ptr<Node> node, shared_ptr<Environ
 		{
 			return value;
 		}
+		if (!is_annotated(cast->annotation, value))
+		{
+			return annotation_mismatch(cast->name->value, cast->annotation, value->typeName());
+		}
 
-		string name = cast->name->value;
-		auto found = env->store.find(name);
-		if (found != env->store.end())
+		if (env->find(cast->name->symbol) != nullptr)
 		{
-			return repeat_declaration(name);
+			return repeat_declaration(cast->name->value);
 		}
 
-		value->setMutable(false);
-		env->add(name, value);
+		env->add(cast->name->symbol, declared(move(value), false));
 		return null;
 	}
 
@@ -671,16 +1763,24 @@ shared_ptr<Object> Evaluator::evaluate(shared_ptr<Node> node, shared_ptr<Environ
 		{
 			return value;
 		}
+		if (!is_annotated(cast->annotation, value))
+		{
+			return annotation_mismatch(cast->name->value, cast->annotation, value->typeName());
+		}
 
-		string name = cast->name->value;
-		auto found = env->store.find(name);
-		if (found != env->store.end())
+		if (env->find(cast->name->symbol) != nullptr)
 		{
-			return repeat_declaration(name);
+			return repeat_declaration(cast->name->value);
 		}
 
-		value->setMutable(true);
-		env->add(name, value);
+		// A worker may not make an object the other threads read mutable, the var gets a copy and
+		// the builtin that started the workers runs the function on its own thread instead
+		if (_shared && !value->isMutable && value.use_count() > 1 && !is_constant(value))
+		{
+			_conflict = true;
+			value = value->copy();
+		}
+		env->add(cast->name->symbol, declared(move(value), true));
 		return null;
 	}
 
@@ -693,7 +1793,7 @@ shared_ptr<Object> Evaluator::evaluate(shared_ptr<Node> node, shared_ptr<Environ
 	case Node::Type::Function:
 	{
 		auto cast = dynamic_pointer_cast<FunctionExpr>(node);
-		return make_shared<Function>(cast->args, cast->body, env);
+		return evaluate_closure(cast, env);
 	}
 
 	case Node::Type::Call:
@@ -710,7 +1810,20 @@ shared_ptr<Object> Evaluator::evaluate(shared_ptr<Node> node, shared_ptr<Environ
 		{
 			return args.at(0);
 		}
-		
+
+		// A call site rarely sees both kinds of callee
+		if (cast->feedback.state != Feedback::State::Generic)
+		{
+			bool specializable = fun->type == Object::Type::Function || fun->type == Object::Type::BuiltinFun;
+			if (guard(cast->feedback, fun->type, fun->type, specializable))
+			{
+				if (fun->type == Object::Type::Function)
+				{
+					return call_function(static_pointer_cast<Function>(fun), args);
+				}
+				return static_cast<BuiltinFun&>(*fun).fun(*this, args);
+			}
+		}
 		return evaluate_fun(fun, args);
 	}
 
@@ -723,7 +1836,15 @@ shared_ptr<Object> Evaluator::evaluate(shared_ptr<Node> node, shared_ptr<Environ
 	case Node::Type::Assign:
 	{
 		auto cast = dynamic_pointer_cast<AssignExpr>(node);
-		auto id = evaluate(cast->id, env);		// This code is only for detecting whether identifier is found
+		if (cast->unboxed && cast->id->type == Node::Type::Identifier)
+		{
+			return assign_number(*cast, env);
+		}
+		shared_ptr<Object> left;
+		shared_ptr<Object> index;
+		auto id = cast->id->type == Node::Type::Index ?
+			evaluate_element(static_cast<IndexExpr&>(*cast->id), env, left, index) :
+			evaluate(cast->id, env);		// This code is only for detecting whether identifier is found
 		auto value = evaluate(cast->value, env);
 		if (id->type == Object::Type::Error)
 		{
@@ -733,6 +1854,10 @@ shared_ptr<Object> Evaluator::evaluate(shared_ptr<Node> node, shared_ptr<Environ
 		{
 			return value;
 		}
+		if (left)
+		{
+			return assign_element(left, index, id, cast->id->literal(), cast->operatorName, value, env);
+		}
 		if (!id->isMutable)
 		{
 			return access_immutable_var(cast->id->literal());
@@ -750,35 +1875,73 @@ shared_ptr<Object> Evaluator::evaluate(shared_ptr<Node> node, shared_ptr<Environ
 			return elements.at(0);
 		}
 
-		return make_shared<Array>(elements);
+		return make_shared<Array>(move(elements));
+	}
+
+	case Node::Type::Map:
+	{
+		auto cast = dynamic_pointer_cast<MapExpr>(node);
+		auto entries = evaluate_exprs(cast->entries, env);
+		if (entries.size() == 1 && entries.at(0)->type == Object::Type::Error)
+		{
+			return entries.at(0);
+		}
+
+		return new_map(move(entries));
 	}
 
 	case Node::Type::Index:
 	{
 		auto cast = dynamic_pointer_cast<IndexExpr>(node);
+		shared_ptr<Object> left;
+		shared_ptr<Object> index;
+		return evaluate_element(*cast, env, left, index);
+	}
+
+	case Node::Type::Slice:
+	{
+		auto cast = dynamic_pointer_cast<SliceExpr>(node);
 		auto left = evaluate(cast->left, env);
 		if (left->type == Object::Type::Error)
 		{
 			return left;
 		}
 
-		auto index = evaluate(cast->index, env);
-		if (index->type == Object::Type::Error)
+		auto from = cast->from ? evaluate(cast->from, env) : nullptr;
+		if (from && from->type == Object::Type::Error)
 		{
-			return index;
+			return from;
 		}
-
-		return evaluate_index(left, index);
+		auto to = cast->to ? evaluate(cast->to, env) : nullptr;
+		if (to && to->type == Object::Type::Error)
+		{
+			return to;
+		}
+		return evaluate_slice(left, from, to);
 	}
 
 	case Node::Type::While:
 	{
 		auto cast = dynamic_pointer_cast<WhileStat>(node);
-		while (is_true(evaluate(cast->condition, env)))
-		{
-			evaluate(cast->body, make_shared<Environment>(env));
-		}
-		return null;
+		return evaluate_while(cast, env);
+	}
+
+	case Node::Type::For:
+	{
+		auto cast = dynamic_pointer_cast<ForStat>(node);
+		return evaluate_for(cast, env);
+	}
+
+	case Node::Type::Invariant:
+	{
+		auto cast = dynamic_pointer_cast<InvariantExpr>(node);
+		return evaluate_invariant(cast, env);
+	}
+
+	case Node::Type::Temp:
+	{
+		auto cast = dynamic_pointer_cast<TempExpr>(node);
+		return evaluate_temp(cast, env);
 	}
 
 	case Node::Type::InDecrement:
@@ -0,0 +1,466 @@
+#include "evaluator/Kernels.h"
+
+// SSE2 is part of x86-64, AVX2 is compiled into functions of its own and chosen at run time
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define LI_SIMD_X86 1
+#define LI_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#else
+#define LI_SIMD_X86 0
+#endif
+
+namespace li
+{
+
+
+using Op = Kernels::Op;
+
+//	Integers are computed unsigned so that they wrap around
+static int64_t add(int64_t a, int64_t b) { return static_cast<int64_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b)); }
+static int64_t sub(int64_t a, int64_t b) { return static_cast<int64_t>(static_cast<uint64_t>(a) - static_cast<uint64_t>(b)); }
+static int64_t mul(int64_t a, int64_t b) { return static_cast<int64_t>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b)); }
+static double add(double a, double b) { return a + b; }
+static double sub(double a, double b) { return a - b; }
+static double mul(double a, double b) { return a * b; }
+
+template <typename T>
+static T apply(Op op, T a, T b)
+{
+	switch (op)
+	{
+	case Op::Add: return add(a, b);
+	case Op::Sub: return sub(a, b);
+	default: return mul(a, b);
+	}
+}
+
+//	Scalar loops from the element i on, which finish what the vector loops leave over
+template <typename T>
+static T sum_from(const T* a, size_t i, size_t n, T total)
+{
+	for (; i < n; i++) total = add(total, a[i]);
+	return total;
+}
+
+template <typename T>
+static T min_from(const T* a, size_t i, size_t n, T result)
+{
+	for (; i < n; i++) result = a[i] < result ? a[i] : result;
+	return result;
+}
+
+template <typename T>
+static T max_from(const T* a, size_t i, size_t n, T result)
+{
+	for (; i < n; i++) result = a[i] > result ? a[i] : result;
+	return result;
+}
+
+template <typename T>
+static T dot_from(const T* a, const T* b, size_t i, size_t n, T total)
+{
+	for (; i < n; i++) total = add(total, mul(a[i], b[i]));
+	return total;
+}
+
+template <typename T>
+static void combine_from(Op op, const T* a, const T* b, T* out, size_t i, size_t n)
+{
+	for (; i < n; i++) out[i] = apply(op, a[i], b[i]);
+}
+
+template <typename T>
+static void scale_from(const T* a, T k, T* out, size_t i, size_t n)
+{
+	for (; i < n; i++) out[i] = mul(a[i], k);
+}
+
+#if LI_SIMD_X86
+
+static bool has_avx2()
+{
+	static const bool supported = __builtin_cpu_supports("avx2");
+	return supported;
+}
+
+//	AVX2, four integers or four floats at a time
+
+//	The low 64 bits of the products, from the 32-bit multiplications AVX2 has
+LI_AVX2 static __m256i mul_epi64(__m256i a, __m256i b)
+{
+	__m256i low = _mm256_mul_epu32(a, b);
+	__m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b), _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+	return _mm256_add_epi64(low, _mm256_slli_epi64(cross, 32));
+}
+
+template <Op op>
+LI_AVX2 static __m256i avx2_apply(__m256i a, __m256i b)
+{
+	if constexpr (op == Op::Add) return _mm256_add_epi64(a, b);
+	else if constexpr (op == Op::Sub) return _mm256_sub_epi64(a, b);
+	else return mul_epi64(a, b);
+}
+
+template <Op op>
+LI_AVX2 static __m256d avx2_apply(__m256d a, __m256d b)
+{
+	if constexpr (op == Op::Add) return _mm256_add_pd(a, b);
+	else if constexpr (op == Op::Sub) return _mm256_sub_pd(a, b);
+	else return _mm256_mul_pd(a, b);
+}
+
+LI_AVX2 static __m256i avx2_load(const int64_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+LI_AVX2 static __m256d avx2_load(const double* p) { return _mm256_loadu_pd(p); }
+LI_AVX2 static void avx2_store(int64_t* p, __m256i v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+LI_AVX2 static void avx2_store(double* p, __m256d v) { _mm256_storeu_pd(p, v); }
+
+LI_AVX2 static int64_t avx2_sum(const int64_t* a, size_t n)
+{
+	__m256i total = _mm256_setzero_si256();
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		total = _mm256_add_epi64(total, avx2_load(a + i));
+	}
+	int64_t lanes[4];
+	avx2_store(lanes, total);
+	return sum_from(a, i, n, sum_from(lanes, 0, 4, int64_t(0)));
+}
+
+LI_AVX2 static double avx2_sum(const double* a, size_t n)
+{
+	__m256d first = _mm256_setzero_pd(), second = _mm256_setzero_pd();
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		first = _mm256_add_pd(first, avx2_load(a + i));
+		second = _mm256_add_pd(second, avx2_load(a + i + 4));
+	}
+	double lanes[4];
+	avx2_store(lanes, _mm256_add_pd(first, second));
+	return sum_from(a, i, n, (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]));
+}
+
+LI_AVX2 static int64_t avx2_min(const int64_t* a, size_t n)
+{
+	__m256i result = _mm256_set1_epi64x(a[0]);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m256i value = avx2_load(a + i);
+		result = _mm256_blendv_epi8(result, value, _mm256_cmpgt_epi64(result, value));
+	}
+	int64_t lanes[4];
+	avx2_store(lanes, result);
+	return min_from(a, i, n, min_from(lanes, 1, 4, lanes[0]));
+}
+
+LI_AVX2 static int64_t avx2_max(const int64_t* a, size_t n)
+{
+	__m256i result = _mm256_set1_epi64x(a[0]);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m256i value = avx2_load(a + i);
+		result = _mm256_blendv_epi8(result, value, _mm256_cmpgt_epi64(value, result));
+	}
+	int64_t lanes[4];
+	avx2_store(lanes, result);
+	return max_from(a, i, n, max_from(lanes, 1, 4, lanes[0]));
+}
+
+LI_AVX2 static double avx2_min(const double* a, size_t n)
+{
+	__m256d result = _mm256_set1_pd(a[0]);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		result = _mm256_min_pd(avx2_load(a + i), result);
+	}
+	double lanes[4];
+	avx2_store(lanes, result);
+	return min_from(a, i, n, min_from(lanes, 1, 4, lanes[0]));
+}
+
+LI_AVX2 static double avx2_max(const double* a, size_t n)
+{
+	__m256d result = _mm256_set1_pd(a[0]);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		result = _mm256_max_pd(avx2_load(a + i), result);
+	}
+	double lanes[4];
+	avx2_store(lanes, result);
+	return max_from(a, i, n, max_from(lanes, 1, 4, lanes[0]));
+}
+
+LI_AVX2 static int64_t avx2_dot(const int64_t* a, const int64_t* b, size_t n)
+{
+	__m256i total = _mm256_setzero_si256();
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		total = _mm256_add_epi64(total, mul_epi64(avx2_load(a + i), avx2_load(b + i)));
+	}
+	int64_t lanes[4];
+	avx2_store(lanes, total);
+	return dot_from(a, b, i, n, sum_from(lanes, 0, 4, int64_t(0)));
+}
+
+LI_AVX2 static double avx2_dot(const double* a, const double* b, size_t n)
+{
+	__m256d first = _mm256_setzero_pd(), second = _mm256_setzero_pd();
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		first = _mm256_add_pd(first, _mm256_mul_pd(avx2_load(a + i), avx2_load(b + i)));
+		second = _mm256_add_pd(second, _mm256_mul_pd(avx2_load(a + i + 4), avx2_load(b + i + 4)));
+	}
+	double lanes[4];
+	avx2_store(lanes, _mm256_add_pd(first, second));
+	return dot_from(a, b, i, n, (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]));
+}
+
+template <Op op, typename T>
+LI_AVX2 static void avx2_combine(const T* a, const T* b, T* out, size_t n)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		avx2_store(out + i, avx2_apply<op>(avx2_load(a + i), avx2_load(b + i)));
+	}
+	combine_from(op, a, b, out, i, n);
+}
+
+template <typename T>
+static void avx2_combine(Op op, const T* a, const T* b, T* out, size_t n)
+{
+	switch (op)
+	{
+	case Op::Add: avx2_combine<Op::Add>(a, b, out, n); return;
+	case Op::Sub: avx2_combine<Op::Sub>(a, b, out, n); return;
+	default: avx2_combine<Op::Mul>(a, b, out, n); return;
+	}
+}
+
+LI_AVX2 static void avx2_scale(const int64_t* a, int64_t k, int64_t* out, size_t n)
+{
+	__m256i factor = _mm256_set1_epi64x(k);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		avx2_store(out + i, mul_epi64(avx2_load(a + i), factor));
+	}
+	scale_from(a, k, out, i, n);
+}
+
+LI_AVX2 static void avx2_scale(const double* a, double k, double* out, size_t n)
+{
+	__m256d factor = _mm256_set1_pd(k);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		avx2_store(out + i, _mm256_mul_pd(avx2_load(a + i), factor));
+	}
+	scale_from(a, k, out, i, n);
+}
+
+//	SSE2, two at a time. It cannot compare 64-bit integers, their minimum and maximum are left scalar.
+
+static __m128i mul_epi64(__m128i a, __m128i b)
+{
+	__m128i low = _mm_mul_epu32(a, b);
+	__m128i cross = _mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(a, 32), b), _mm_mul_epu32(a, _mm_srli_epi64(b, 32)));
+	return _mm_add_epi64(low, _mm_slli_epi64(cross, 32));
+}
+
+template <Op op>
+static __m128i sse2_apply(__m128i a, __m128i b)
+{
+	if constexpr (op == Op::Add) return _mm_add_epi64(a, b);
+	else if constexpr (op == Op::Sub) return _mm_sub_epi64(a, b);
+	else return mul_epi64(a, b);
+}
+
+template <Op op>
+static __m128d sse2_apply(__m128d a, __m128d b)
+{
+	if constexpr (op == Op::Add) return _mm_add_pd(a, b);
+	else if constexpr (op == Op::Sub) return _mm_sub_pd(a, b);
+	else return _mm_mul_pd(a, b);
+}
+
+static __m128i sse2_load(const int64_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+static __m128d sse2_load(const double* p) { return _mm_loadu_pd(p); }
+static void sse2_store(int64_t* p, __m128i v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+static void sse2_store(double* p, __m128d v) { _mm_storeu_pd(p, v); }
+
+static int64_t sse2_sum(const int64_t* a, size_t n)
+{
+	__m128i total = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		total = _mm_add_epi64(total, sse2_load(a + i));
+	}
+	int64_t lanes[2];
+	sse2_store(lanes, total);
+	return sum_from(a, i, n, add(lanes[0], lanes[1]));
+}
+
+static double sse2_sum(const double* a, size_t n)
+{
+	__m128d first = _mm_setzero_pd(), second = _mm_setzero_pd();
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		first = _mm_add_pd(first, sse2_load(a + i));
+		second = _mm_add_pd(second, sse2_load(a + i + 2));
+	}
+	double lanes[2];
+	sse2_store(lanes, _mm_add_pd(first, second));
+	return sum_from(a, i, n, lanes[0] + lanes[1]);
+}
+
+static double sse2_min(const double* a, size_t n)
+{
+	__m128d result = _mm_set1_pd(a[0]);
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		result = _mm_min_pd(sse2_load(a + i), result);
+	}
+	double lanes[2];
+	sse2_store(lanes, result);
+	return min_from(a, i, n, min_from(lanes, 1, 2, lanes[0]));
+}
+
+static double sse2_max(const double* a, size_t n)
+{
+	__m128d result = _mm_set1_pd(a[0]);
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		result = _mm_max_pd(sse2_load(a + i), result);
+	}
+	double lanes[2];
+	sse2_store(lanes, result);
+	return max_from(a, i, n, max_from(lanes, 1, 2, lanes[0]));
+}
+
+static int64_t sse2_dot(const int64_t* a, const int64_t* b, size_t n)
+{
+	__m128i total = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		total = _mm_add_epi64(total, mul_epi64(sse2_load(a + i), sse2_load(b + i)));
+	}
+	int64_t lanes[2];
+	sse2_store(lanes, total);
+	return dot_from(a, b, i, n, add(lanes[0], lanes[1]));
+}
+
+static double sse2_dot(const double* a, const double* b, size_t n)
+{
+	__m128d total = _mm_setzero_pd();
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		total = _mm_add_pd(total, _mm_mul_pd(sse2_load(a + i), sse2_load(b + i)));
+	}
+	double lanes[2];
+	sse2_store(lanes, total);
+	return dot_from(a, b, i, n, lanes[0] + lanes[1]);
+}
+
+template <Op op, typename T>
+static void sse2_combine(const T* a, const T* b, T* out, size_t n)
+{
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		sse2_store(out + i, sse2_apply<op>(sse2_load(a + i), sse2_load(b + i)));
+	}
+	combine_from(op, a, b, out, i, n);
+}
+
+template <typename T>
+static void sse2_combine(Op op, const T* a, const T* b, T* out, size_t n)
+{
+	switch (op)
+	{
+	case Op::Add: sse2_combine<Op::Add>(a, b, out, n); return;
+	case Op::Sub: sse2_combine<Op::Sub>(a, b, out, n); return;
+	default: sse2_combine<Op::Mul>(a, b, out, n); return;
+	}
+}
+
+static void sse2_scale(const int64_t* a, int64_t k, int64_t* out, size_t n)
+{
+	__m128i factor = _mm_set1_epi64x(k);
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		sse2_store(out + i, mul_epi64(sse2_load(a + i), factor));
+	}
+	scale_from(a, k, out, i, n);
+}
+
+static void sse2_scale(const double* a, double k, double* out, size_t n)
+{
+	__m128d factor = _mm_set1_pd(k);
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		sse2_store(out + i, _mm_mul_pd(sse2_load(a + i), factor));
+	}
+	scale_from(a, k, out, i, n);
+}
+
+int64_t Kernels::sum(const int64_t* a, size_t n) { return has_avx2() ? avx2_sum(a, n) : sse2_sum(a, n); }
+double Kernels::sum(const double* a, size_t n) { return has_avx2() ? avx2_sum(a, n) : sse2_sum(a, n); }
+int64_t Kernels::min(const int64_t* a, size_t n) { return has_avx2() ? avx2_min(a, n) : min_from(a, 1, n, a[0]); }
+double Kernels::min(const double* a, size_t n) { return has_avx2() ? avx2_min(a, n) : sse2_min(a, n); }
+int64_t Kernels::max(const int64_t* a, size_t n) { return has_avx2() ? avx2_max(a, n) : max_from(a, 1, n, a[0]); }
+double Kernels::max(const double* a, size_t n) { return has_avx2() ? avx2_max(a, n) : sse2_max(a, n); }
+int64_t Kernels::dot(const int64_t* a, const int64_t* b, size_t n) { return has_avx2() ? avx2_dot(a, b, n) : sse2_dot(a, b, n); }
+double Kernels::dot(const double* a, const double* b, size_t n) { return has_avx2() ? avx2_dot(a, b, n) : sse2_dot(a, b, n); }
+
+void Kernels::combine(Op op, const int64_t* a, const int64_t* b, int64_t* out, size_t n)
+{
+	has_avx2() ? avx2_combine(op, a, b, out, n) : sse2_combine(op, a, b, out, n);
+}
+
+void Kernels::combine(Op op, const double* a, const double* b, double* out, size_t n)
+{
+	has_avx2() ? avx2_combine(op, a, b, out, n) : sse2_combine(op, a, b, out, n);
+}
+
+void Kernels::scale(const int64_t* a, int64_t k, int64_t* out, size_t n) { has_avx2() ? avx2_scale(a, k, out, n) : sse2_scale(a, k, out, n); }
+void Kernels::scale(const double* a, double k, double* out, size_t n) { has_avx2() ? avx2_scale(a, k, out, n) : sse2_scale(a, k, out, n); }
+
+const char* Kernels::isa() { return has_avx2() ? "avx2" : "sse2"; }
+
+#else
+
+int64_t Kernels::sum(const int64_t* a, size_t n) { return sum_from(a, 0, n, int64_t(0)); }
+double Kernels::sum(const double* a, size_t n) { return sum_from(a, 0, n, 0.0); }
+int64_t Kernels::min(const int64_t* a, size_t n) { return min_from(a, 1, n, a[0]); }
+double Kernels::min(const double* a, size_t n) { return min_from(a, 1, n, a[0]); }
+int64_t Kernels::max(const int64_t* a, size_t n) { return max_from(a, 1, n, a[0]); }
+double Kernels::max(const double* a, size_t n) { return max_from(a, 1, n, a[0]); }
+int64_t Kernels::dot(const int64_t* a, const int64_t* b, size_t n) { return dot_from(a, b, 0, n, int64_t(0)); }
+double Kernels::dot(const double* a, const double* b, size_t n) { return dot_from(a, b, 0, n, 0.0); }
+void Kernels::combine(Op op, const int64_t* a, const int64_t* b, int64_t* out, size_t n) { combine_from(op, a, b, out, 0, n); }
+void Kernels::combine(Op op, const double* a, const double* b, double* out, size_t n) { combine_from(op, a, b, out, 0, n); }
+void Kernels::scale(const int64_t* a, int64_t k, int64_t* out, size_t n) { scale_from(a, k, out, 0, n); }
+void Kernels::scale(const double* a, double k, double* out, size_t n) { scale_from(a, k, out, 0, n); }
+
+const char* Kernels::isa() { return "scalar"; }
+
+#endif
+
+
+}
\ No newline at end of file
@@ -0,0 +1,253 @@
+#include "evaluator/Sharing.h"
+#include "evaluator/Evaluator.h"
+#include "evaluator/BuiltinFuns.h"
+#include "analysis/Traversal.h"
+#include "ast/IntegerExpr.hpp"
+#include "ast/CallExpr.hpp"
+#include "ast/InDecrementExpr.hpp"
+#include "ast/LetStat.hpp"
+#include "ast/VarStat.hpp"
+
+namespace li
+{
+
+
+//	Where a name of fun that its code does not declare is bound
+static shared_ptr<Object>* resolve(symbol_t symbol, const Function& fun)
+{
+	shared_ptr<Object>* found = fun.captures ? fun.captures->find(symbol) : nullptr;
+	if (found == nullptr && fun.env)
+	{
+		found = fun.env->get(symbol);
+	}
+	return found;
+}
+
+bool Sharing::check(const shared_ptr<Object>& obj)
+{
+	Context context;
+	if (!value(obj, false, context))
+	{
+		return false;
+	}
+	for (auto symbol : context.locals)
+	{
+		Environment::mark_local(symbol);
+	}
+	return true;
+}
+
+bool Sharing::value(const shared_ptr<Object>& obj, bool read, Context& context)
+{
+	switch (obj->type)
+	{
+
+	case Object::Type::Function:
+		return function(static_cast<Function&>(*obj), context);
+
+	// _builtin_ performs any operation, only its calls with a literal opcode are looked into
+	case Object::Type::BuiltinFun:
+		return static_cast<BuiltinFun&>(*obj).inspectText != "_builtin_";
+
+	case Object::Type::Array:
+	{
+		if (read && obj->isMutable)
+		{
+			return false;
+		}
+		// The elements of a view are checked with all the others of its parent
+		size_t from;
+		const auto& source = static_cast<Array&>(*obj).storage(from);
+		for (const auto& element : source.elements)
+		{
+			if (!value(element, read, context))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	case Object::Type::Map:
+	{
+		if (read && obj->isMutable)
+		{
+			return false;
+		}
+		for (const auto& entry : static_cast<Map&>(*obj).entries())
+		{
+			if (entry.key && !value(entry.value, read, context))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	case Object::Type::OrderedMap:
+	{
+		if (read && obj->isMutable)
+		{
+			return false;
+		}
+		bool shared = true;
+		static_cast<OrderedMap&>(*obj).visit(nullptr, [&](const shared_ptr<Object>&, const shared_ptr<Object>& entry)
+		{
+			shared = value(entry, read, context);
+			return shared;
+		});
+		return shared;
+	}
+
+	default:
+		return !read || !obj->isMutable;
+
+	}
+}
+
+bool Sharing::function(const Function& fun, Context& context)
+{
+	if (fun.native || !fun.node)
+	{
+		return false;
+	}
+	if (!context.visited.insert(fun.node.get()).second)
+	{
+		return true;
+	}
+
+	unordered_set<symbol_t> declared;
+	for (const auto& arg : fun.args->args)
+	{
+		declared.insert(arg->symbol);
+	}
+	declarations(fun.body, declared);
+	context.locals.insert(context.locals.end(), declared.begin(), declared.end());
+	return code(fun.body, fun, declared, context);
+}
+
+bool Sharing::code(const shared_ptr<Node>& node, const Function& fun, const unordered_set<symbol_t>& declared, Context& context)
+{
+	switch (node->type)
+	{
+
+	case Node::Type::Identifier:
+	{
+		auto id = static_pointer_cast<IdentifierExpr>(node);
+		return declared.count(id->symbol) || name(id->symbol, id->value, fun, context);
+	}
+
+	case Node::Type::Assign:
+		if (!declared.count(root(static_pointer_cast<AssignExpr>(node)->id)))
+		{
+			return false;
+		}
+		break;
+
+	case Node::Type::InDecrement:
+		if (!declared.count(root(static_pointer_cast<InDecrementExpr>(node)->id)))
+		{
+			return false;
+		}
+		break;
+
+	case Node::Type::Call:
+	{
+		auto call = static_pointer_cast<CallExpr>(node);
+		if (call->fun->type != Node::Type::Identifier)
+		{
+			break;
+		}
+
+		auto id = static_pointer_cast<IdentifierExpr>(call->fun);
+		if (id->value != "_builtin_" || declared.count(id->symbol) || resolve(id->symbol, fun))
+		{
+			break;
+		}
+
+		const auto& args = call->exprs->expressions;
+		if (args.empty() || args.front()->type != Node::Type::Integer || static_pointer_cast<IntegerExpr>(args.front())->value == BuiltinFuns::Print)
+		{
+			return false;
+		}
+		for (size_t i = 1; i < args.size(); i++)
+		{
+			if (!code(args[i], fun, declared, context))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	default:
+		break;
+
+	}
+
+	bool shared = true;
+	for_each_child(node, [&](const shared_ptr<Node>& child)
+	{
+		shared = shared && code(child, fun, declared, context);
+	});
+	return shared;
+}
+
+bool Sharing::name(symbol_t symbol, const string& text, const Function& fun, Context& context)
+{
+	if (auto* found = resolve(symbol, fun))
+	{
+		return value(*found, true, context);
+	}
+
+	auto it = Evaluator::builtinFuns.find(text);
+	return it != Evaluator::builtinFuns.end() && value(it->second, true, context);
+}
+
+void Sharing::declarations(const shared_ptr<Node>& node, unordered_set<symbol_t>& declared)
+{
+	switch (node->type)
+	{
+
+	case Node::Type::Let:
+		declared.insert(static_pointer_cast<LetStat>(node)->name->symbol);
+		break;
+
+	case Node::Type::Var:
+		declared.insert(static_pointer_cast<VarStat>(node)->name->symbol);
+		break;
+
+	case Node::Type::For:
+		declared.insert(static_pointer_cast<ForStat>(node)->name->symbol);
+		break;
+
+	case Node::Type::Function:
+		for (const auto& arg : static_pointer_cast<FunctionExpr>(node)->args->args)
+		{
+			declared.insert(arg->symbol);
+		}
+		break;
+
+	default:
+		break;
+
+	}
+
+	for_each_child(node, [&](const shared_ptr<Node>& child)
+	{
+		declarations(child, declared);
+	});
+}
+
+symbol_t Sharing::root(const shared_ptr<Expr>& target)
+{
+	switch (target->type)
+	{
+	case Node::Type::Identifier: return static_pointer_cast<IdentifierExpr>(target)->symbol;
+	case Node::Type::Index: return root(static_pointer_cast<IndexExpr>(target)->left);
+	default: return SymbolTable::None;
+	}
+}
+
+
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "evaluator/ThreadPool.h"
+#include <algorithm>
+
+namespace li
+{
+
+
+using namespace std;
+
+//	The pool the calling thread belongs to, and its index in there
+static thread_local ThreadPool* currentPool = nullptr;
+static thread_local size_t currentWorker = 0;
+
+ThreadPool::ThreadPool(size_t threads)
+{
+	threads = max<size_t>(threads, 1);
+	for (size_t i = 0; i < threads; i++)
+	{
+		_queues.push_back(make_unique<Queue>());
+	}
+	for (size_t i = 0; i < threads; i++)
+	{
+		_threads.emplace_back([this, i] { work(i); });
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		lock_guard<mutex> guard(_lock);
+		_stop = true;
+	}
+	_wake.notify_all();
+	for (auto& thread : _threads)
+	{
+		thread.join();
+	}
+}
+
+ThreadPool& ThreadPool::shared()
+{
+	static ThreadPool pool(thread::hardware_concurrency());
+	return pool;
+}
+
+bool ThreadPool::inside()
+{
+	return currentPool != nullptr;
+}
+
+void ThreadPool::run(size_t count, const Task& task)
+{
+	if (count == 0) return;
+
+	// Waiting for the other threads could wait for this one
+	if (currentPool == this)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			task(i, currentWorker);
+		}
+		return;
+	}
+
+	lock_guard<mutex> running(_running);
+	{
+		lock_guard<mutex> guard(_lock);
+		_pending = count;
+	}
+
+	// Counted before they are queued, a thread still looking for work may take them at once
+	_task = &task;
+	_queued += count;
+	size_t threads = _queues.size();
+	for (size_t worker = 0; worker < threads; worker++)
+	{
+		auto& queue = *_queues[worker];
+		lock_guard<mutex> guard(queue.lock);
+		for (size_t i = count * worker / threads; i < count * (worker + 1) / threads; i++)
+		{
+			queue.tasks.push_back(i);
+		}
+	}
+
+	unique_lock<mutex> guard(_lock);
+	_wake.notify_all();
+	_done.wait(guard, [this] { return _pending == 0; });
+	_task = nullptr;
+}
+
+void ThreadPool::work(size_t worker)
+{
+	currentPool = this;
+	currentWorker = worker;
+	while (true)
+	{
+		{
+			unique_lock<mutex> guard(_lock);
+			_wake.wait(guard, [this] { return _stop || _queued > 0; });
+			if (_stop) return;
+		}
+
+		size_t index;
+		while (take(worker, index))
+		{
+			(*_task)(index, worker);
+
+			lock_guard<mutex> guard(_lock);
+			if (--_pending == 0)
+			{
+				_done.notify_all();
+			}
+		}
+	}
+}
+
+bool ThreadPool::take(size_t worker, size_t& index)
+{
+	size_t threads = _queues.size();
+	for (size_t i = 0; i < threads; i++)
+	{
+		auto& queue = *_queues[(worker + i) % threads];
+		lock_guard<mutex> guard(queue.lock);
+		if (queue.tasks.empty()) continue;
+
+		if (i == 0)
+		{
+			index = queue.tasks.front();
+			queue.tasks.pop_front();
+		}
+		else
+		{
+			index = queue.tasks.back();
+			queue.tasks.pop_back();
+			_steals++;
+		}
+		_queued--;
+		return true;
+	}
+	return false;
+}
+
+
+}
\ No newline at end of file
@@ -0,0 +1,521 @@
+#include "ir/Builder.h"
+#include "analysis/Traversal.h"
+#include "ast/ExpressionStat.hpp"
+#include "ast/LetStat.hpp"
+#include "ast/VarStat.hpp"
+#include "ast/ReturnStat.hpp"
+#include "ast/IdentifierExpr.hpp"
+#include "ast/PrefixExpr.hpp"
+#include "ast/InfixExpr.hpp"
+#include "ast/IndexExpr.hpp"
+#include "ast/ArrayExpr.hpp"
+#include "ast/CallExpr.hpp"
+#include "ast/AssignExpr.hpp"
+#include "ast/InDecrementExpr.hpp"
+
+namespace li::ir
+{
+
+
+unique_ptr<Module> Builder::build(shared_ptr<Program> program)
+{
+	auto module = make_unique<Module>();
+	module->program = program;
+
+	auto* main = module->create_function("<program>");
+	Builder builder(*module, *main);
+	builder.build_function(program->statements);
+
+	// Functions are built in the order they are found, each one may queue more
+	vector<pair<Function*, shared_ptr<FunctionExpr>>> queue = move(builder._nested);
+	for (size_t i = 0; i < queue.size(); i++)
+	{
+		auto [function, node] = queue[i];
+		function->node = node;
+
+		Builder nested(*module, *function);
+		nested.build_function(node->body->statements);
+		queue.insert(queue.end(), nested._nested.begin(), nested._nested.end());
+	}
+	return module;
+}
+
+void Builder::build_function(const vector<shared_ptr<Stat>>& statements)
+{
+	_function.entry = _function.create_block();
+	_current = _function.entry;
+	_sealed.insert(_current);
+	_scopes.push_back({ _scopeCount++, _current });
+
+	if (_function.node)
+	{
+		const auto& args = _function.node->args->args;
+		for (size_t i = 0; i < args.size(); i++)
+		{
+			auto* param = emit(Opcode::Param, args[i]);
+			param->symbol = args[i]->symbol;
+			param->index = i;
+			param->annotation = _function.node->args->annotation(i);
+			write(param->symbol, 0, _current, param);
+		}
+	}
+
+	auto* result = build_statements(statements);
+	if (!_current->terminator())
+	{
+		emit(Opcode::Return, nullptr, { result ? result : null_constant() });
+	}
+
+	for (const auto& [key, declarations] : _declarations)
+	{
+		if (declarations.size() > 1)
+		{
+			_function.repeated.insert(declarations.begin(), declarations.end());
+		}
+	}
+	_function.remove_unreachable();
+}
+
+Instruction* Builder::build_statements(const vector<shared_ptr<Stat>>& statements)
+{
+	Instruction* result = nullptr;
+	for (size_t i = 0; i < statements.size(); i++)
+	{
+		result = build_statement(statements[i], i + 1 == statements.size());
+	}
+	return result;
+}
+
+Instruction* Builder::build_statement(const shared_ptr<Stat>& stat, bool last)
+{
+	auto* enclosing = _statement;
+	_statement = stat.get();
+	Instruction* result = nullptr;
+
+	switch (stat->type)
+	{
+
+	case Node::Type::ExprStat:
+	{
+		auto cast = static_pointer_cast<ExpressionStat>(stat);
+		result = build_expr(cast->expression, true);
+		if (!last && result->statement == stat.get() && result->origin == cast->expression)
+		{
+			result->droppable = true;
+		}
+		break;
+	}
+
+	case Node::Type::Let:
+	case Node::Type::Var:
+	{
+		bool isMutable = stat->type == Node::Type::Var;
+		auto name = isMutable ? static_pointer_cast<VarStat>(stat)->name : static_pointer_cast<LetStat>(stat)->name;
+		auto value = isMutable ? static_pointer_cast<VarStat>(stat)->value : static_pointer_cast<LetStat>(stat)->value;
+		auto annotation = isMutable ? static_pointer_cast<VarStat>(stat)->annotation : static_pointer_cast<LetStat>(stat)->annotation;
+
+		_bindingName = name->value;
+		auto* bound = build_expr(value);
+		_bindingName.clear();
+
+		// Only the name is known to be of the annotated type, the value may be bound to others
+		if (annotation != Annotation::None)
+		{
+			bound = emit(Opcode::Check, stat, { bound });
+			bound->annotation = annotation;
+		}
+		auto* declare = emit(Opcode::Declare, stat, { bound });
+
+		declare->symbol = name->symbol;
+		declare->isMutable = isMutable;
+		declare->droppable = !last;
+		_declarations[key(_scopes.back().id, name->symbol)].push_back(stat.get());
+		write(name->symbol, _scopes.size() - 1, _current, declare->operands[0]);
+		result = last ? null_constant() : nullptr;
+		break;
+	}
+
+	case Node::Type::Return:
+	{
+		// The value of a return inside an expression would be bound like any other object
+		if (_ifValues != 0)
+		{
+			_function.supported = false;
+		}
+
+		auto* value = build_expr(static_pointer_cast<ReturnStat>(stat)->value);
+		if (!_loops.empty())
+		{
+			// A while discards what its body returns and goes on with the next iteration
+			jump(_loops.back());
+		}
+		else
+		{
+			emit(Opcode::Return, stat, { value });
+		}
+		_current = sealed_block();
+		break;
+	}
+
+	case Node::Type::While:
+		build_while(static_pointer_cast<WhileStat>(stat));
+		result = last ? null_constant() : nullptr;
+		break;
+
+	case Node::Type::Block:
+		result = build_statements(static_pointer_cast<BlockStat>(stat)->statements);
+		break;
+
+	default:
+		_function.supported = false;
+		break;
+
+	}
+
+	_statement = enclosing;
+	return result;
+}
+
+Instruction* Builder::build_expr(const shared_ptr<Expr>& expr, bool statement)
+{
+	Instruction* result = nullptr;
+
+	switch (expr->type)
+	{
+
+	case Node::Type::Integer:
+	case Node::Type::Float:
+	case Node::Type::Bool:
+	case Node::Type::String:
+		result = emit(Opcode::Const, expr);
+		break;
+
+	case Node::Type::Identifier:
+	{
+		auto symbol = static_pointer_cast<IdentifierExpr>(expr)->symbol;
+		result = read(symbol, _scopes.size() - 1, _current);
+		break;
+	}
+
+	case Node::Type::Prefix:
+	{
+		auto cast = static_pointer_cast<PrefixExpr>(expr);
+		result = emit(Opcode::Prefix, expr, { build_expr(cast->right) });
+		result->op = cast->operatorName;
+		break;
+	}
+
+	case Node::Type::Infix:
+	{
+		auto cast = static_pointer_cast<InfixExpr>(expr);
+		auto* left = build_expr(cast->left);
+		auto* right = build_expr(cast->right);
+		result = emit(Opcode::Infix, expr, { left, right });
+		result->op = cast->operatorName;
+		break;
+	}
+
+	case Node::Type::Index:
+	{
+		auto cast = static_pointer_cast<IndexExpr>(expr);
+		auto* left = build_expr(cast->left);
+		auto* index = build_expr(cast->index);
+		result = emit(Opcode::Index, expr, { left, index });
+		break;
+	}
+
+	case Node::Type::Array:
+	{
+		vector<Instruction*> elements;
+		for (const auto& element : static_pointer_cast<ArrayExpr>(expr)->elements->expressions)
+		{
+			elements.push_back(build_expr(element));
+		}
+		result = emit(Opcode::Array, expr, elements);
+		break;
+	}
+
+	case Node::Type::Call:
+	{
+		auto cast = static_pointer_cast<CallExpr>(expr);
+		vector<Instruction*> operands = { build_expr(cast->fun) };
+		if (cast->exprs)
+		{
+			for (const auto& arg : cast->exprs->expressions)
+			{
+				operands.push_back(build_expr(arg));
+			}
+		}
+		result = emit(Opcode::Call, expr, operands);
+		break;
+	}
+
+	case Node::Type::Function:
+		result = build_closure(static_pointer_cast<FunctionExpr>(expr));
+		break;
+
+	case Node::Type::If:
+		result = build_if(static_pointer_cast<IfExpr>(expr), statement);
+		break;
+
+	case Node::Type::Assign:
+	{
+		auto cast = static_pointer_cast<AssignExpr>(expr);
+		auto* id = build_expr(cast->id);
+		auto* value = build_expr(cast->value);
+		result = emit(Opcode::Assign, expr, { id, value });
+		result->op = cast->operatorName;
+		break;
+	}
+
+	case Node::Type::InDecrement:
+	{
+		auto cast = static_pointer_cast<InDecrementExpr>(expr);
+		result = emit(Opcode::InDecrement, expr, { build_expr(cast->id) });
+		result->op = cast->operatorName;
+		break;
+	}
+
+	default:
+		_function.supported = false;
+		result = null_constant();
+		break;
+
+	}
+
+	_function.values[expr.get()] = result;
+	return result;
+}
+
+Instruction* Builder::build_condition(const shared_ptr<Expr>& condition)
+{
+	auto outer = _condition;
+	if (!outer) _condition = condition;
+	auto* value = build_expr(condition);
+	_condition = outer;
+	return value;
+}
+
+Instruction* Builder::build_if(const shared_ptr<IfExpr>& node, bool statement)
+{
+	if (!statement) _ifValues++;
+
+	auto* condition = build_condition(node->condition);
+
+	auto* consequence = sealed_block();
+	auto* alternative = sealed_block();
+	auto* join = _function.create_block();
+	branch(condition, consequence, alternative);
+
+	_current = consequence;
+	auto* consequenceValue = build_statements(node->consequence->statements);
+	if (!consequenceValue) consequenceValue = null_constant();
+	auto* consequenceEnd = _current;
+	jump(join);
+
+	_current = alternative;
+	auto* alternativeValue = node->alternative ? build_statements(node->alternative->statements) : nullptr;
+	if (!alternativeValue) alternativeValue = null_constant();
+	jump(join);
+
+	seal(join);
+	_current = join;
+	if (!statement) _ifValues--;
+
+	if (join->preds.empty())
+	{
+		return null_constant();
+	}
+
+	auto* phi = create_phi(join);
+	for (auto* pred : join->preds)
+	{
+		phi->operands.push_back(pred == consequenceEnd ? consequenceValue : alternativeValue);
+		phi->targets.push_back(pred);
+	}
+	return phi;
+}
+
+void Builder::build_while(const shared_ptr<WhileStat>& node)
+{
+	auto* header = _function.create_block();
+	jump(header);
+	_current = header;
+
+	auto* condition = build_condition(node->condition);
+
+	auto* body = sealed_block();
+	auto* exit = _function.create_block();
+	branch(condition, body, exit);
+	seal(exit);
+
+	_scopes.push_back({ _scopeCount++, body });
+	_loops.push_back(header);
+	_current = body;
+	build_statements(node->body->statements);
+	jump(header);
+	_loops.pop_back();
+	_scopes.pop_back();
+
+	seal(header);
+	_current = exit;
+}
+
+Instruction* Builder::build_closure(const shared_ptr<FunctionExpr>& node)
+{
+	auto* callee = _module.create_function(_bindingName.empty() ? "<anonymous>" : _bindingName);
+	_bindingName.clear();
+	_nested.push_back({ callee, node });
+
+	// Whatever the nested function names may be bound by this one, also after it was created
+	function<void(const shared_ptr<Node>&)> collect = [&](const shared_ptr<Node>& child)
+	{
+		if (child->type == Node::Type::Identifier)
+		{
+			_function.nestedReferences.insert(static_pointer_cast<IdentifierExpr>(child)->symbol);
+		}
+		for_each_child(child, collect);
+	};
+	collect(node->body);
+
+	auto* closure = emit(Opcode::Closure, node);
+	closure->callee = callee;
+	return closure;
+}
+
+Instruction* Builder::emit(Opcode opcode, shared_ptr<Node> origin, vector<Instruction*> operands)
+{
+	auto* inst = _function.create(opcode, _current);
+	inst->origin = origin;
+	inst->operands = move(operands);
+	inst->statement = _statement;
+	inst->condition = _condition;
+	_current->instructions.push_back(inst);
+	return inst;
+}
+
+Instruction* Builder::null_constant()
+{
+	return emit(Opcode::Const, nullptr);
+}
+
+void Builder::branch(Instruction* condition, BasicBlock* consequence, BasicBlock* alternative)
+{
+	auto* inst = emit(Opcode::Branch, nullptr, { condition });
+	inst->targets = { consequence, alternative };
+	_function.add_edge(_current, consequence);
+	_function.add_edge(_current, alternative);
+}
+
+void Builder::jump(BasicBlock* target)
+{
+	// Code after a return is never reached, it must not add paths to the code it falls through to
+	if (_current->terminator() || (_current->preds.empty() && _current != _function.entry))
+	{
+		return;
+	}
+
+	auto* inst = emit(Opcode::Jump, nullptr);
+	inst->targets = { target };
+	_function.add_edge(_current, target);
+}
+
+BasicBlock* Builder::sealed_block()
+{
+	auto* block = _function.create_block();
+	_sealed.insert(block);
+	return block;
+}
+
+void Builder::write(symbol_t symbol, size_t level, BasicBlock* block, Instruction* value)
+{
+	_defs[key(_scopes[level].id, symbol)][block] = value;
+}
+
+Instruction* Builder::read(symbol_t symbol, size_t level, BasicBlock* block)
+{
+	auto& defs = _defs[key(_scopes[level].id, symbol)];
+	auto it = defs.find(block);
+	if (it != defs.end())
+	{
+		return it->second;
+	}
+	return read_recursive(symbol, level, block);
+}
+
+Instruction* Builder::read_recursive(symbol_t symbol, size_t level, BasicBlock* block)
+{
+	Instruction* value = nullptr;
+	if (block == _scopes[level].entry || block->preds.empty())
+	{
+		value = read_outside(symbol, level, block);
+	}
+	else if (!_sealed.count(block))
+	{
+		value = create_phi(block);
+		_pending[block].push_back({ value, symbol, level });
+	}
+	else if (block->preds.size() == 1)
+	{
+		value = read(symbol, level, block->preds.front());
+	}
+	else
+	{
+		// Written before the operands are read, a loop reaching back here finds the phi
+		value = create_phi(block);
+		write(symbol, level, block, value);
+		add_phi_operands(value, symbol, level);
+	}
+
+	write(symbol, level, block, value);
+	return value;
+}
+
+Instruction* Builder::read_outside(symbol_t symbol, size_t level, BasicBlock* block)
+{
+	if (level != 0)
+	{
+		return read(symbol, level - 1, block);
+	}
+
+	// Bindings outside of the function can not change while it runs, one lookup stands for all of them
+	auto& outer = _outer[symbol];
+	if (!outer)
+	{
+		outer = _function.create(Opcode::Outer, _function.entry);
+		outer->symbol = symbol;
+		auto& list = _function.entry->instructions;
+		list.insert(list.begin(), outer);
+	}
+	return outer;
+}
+
+Instruction* Builder::create_phi(BasicBlock* block)
+{
+	auto* phi = _function.create(Opcode::Phi, block);
+	block->instructions.insert(block->instructions.begin(), phi);
+	return phi;
+}
+
+void Builder::add_phi_operands(Instruction* phi, symbol_t symbol, size_t level)
+{
+	for (auto* pred : phi->block->preds)
+	{
+		phi->operands.push_back(read(symbol, level, pred));
+		phi->targets.push_back(pred);
+	}
+}
+
+void Builder::seal(BasicBlock* block)
+{
+	auto pending = move(_pending[block]);
+	_pending.erase(block);
+	_sealed.insert(block);
+	for (const auto& [phi, symbol, level] : pending)
+	{
+		add_phi_operands(phi, symbol, level);
+	}
+}
+
+
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "ir/CopyPropagation.h"
+
+namespace li::ir
+{
+
+
+size_t CopyPropagation::run(Function& function)
+{
+	size_t changes = 0;
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		for (const auto& block : function.blocks)
+		{
+			auto phis = block->instructions;
+			for (auto* phi : phis)
+			{
+				if (phi->opcode != Opcode::Phi) continue;
+
+				Instruction* same = nullptr;
+				bool trivial = true;
+				for (auto* operand : phi->operands)
+				{
+					if (operand == phi || operand == same) continue;
+					if (same)
+					{
+						trivial = false;
+						break;
+					}
+					same = operand;
+				}
+
+				if (trivial && same)
+				{
+					function.replace_uses(phi, same);
+					function.remove(phi);
+					changes++;
+					changed = true;
+				}
+			}
+		}
+	}
+
+	// A name read by a statement of its own still reads the binding, even if nothing uses the value
+	unordered_set<Instruction*> named;
+	for (const auto& [node, value] : function.values)
+	{
+		if (node->type == Node::Type::Identifier) named.insert(value);
+	}
+
+	// A phi is live if it is named or an instruction other than a phi uses it, or a live phi does
+	unordered_set<Instruction*> live;
+	vector<Instruction*> worklist;
+	for (auto* value : named)
+	{
+		if (value->opcode == Opcode::Phi && !value->removed && live.insert(value).second)
+		{
+			worklist.push_back(value);
+		}
+	}
+	for (const auto& block : function.blocks)
+	{
+		for (auto* inst : block->instructions)
+		{
+			if (inst->opcode == Opcode::Phi) continue;
+			for (auto* operand : inst->operands)
+			{
+				if (operand->opcode == Opcode::Phi && live.insert(operand).second)
+				{
+					worklist.push_back(operand);
+				}
+			}
+		}
+	}
+	while (!worklist.empty())
+	{
+		auto* phi = worklist.back();
+		worklist.pop_back();
+		for (auto* operand : phi->operands)
+		{
+			if (operand->opcode == Opcode::Phi && live.insert(operand).second)
+			{
+				worklist.push_back(operand);
+			}
+		}
+	}
+
+	auto remove_where = [&](auto dead)
+	{
+		for (const auto& block : function.blocks)
+		{
+			auto instructions = block->instructions;
+			for (auto* inst : instructions)
+			{
+				if (!dead(inst)) continue;
+				function.remove(inst);
+				changes++;
+			}
+		}
+	};
+
+	remove_where([&](Instruction* inst) { return inst->opcode == Opcode::Phi && !live.count(inst); });
+
+	// The null an if or a block evaluates to when nothing else gives it a value
+	auto users = function.users();
+	remove_where([&](Instruction* inst) { return inst->opcode == Opcode::Const && !inst->origin && !users.count(inst); });
+	return changes;
+}
+
+
+}
\ No newline at end of file
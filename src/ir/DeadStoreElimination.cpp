@@ -0,0 +1,170 @@
+#include "ir/DeadStoreElimination.h"
+#include "ast/LetStat.hpp"
+#include "ast/VarStat.hpp"
+#include "ast/IdentifierExpr.hpp"
+#include "ast/AssignExpr.hpp"
+
+namespace li::ir
+{
+
+
+size_t DeadStoreElimination::run(Function& function)
+{
+	size_t changes = dead_assignments(function);
+
+	// Bindings of the top-level code are global, any function may read them by name
+	if (function.node)
+	{
+		changes += dead_declarations(function);
+	}
+	return changes;
+}
+
+size_t DeadStoreElimination::dead_declarations(Function& function)
+{
+	unordered_set<Instruction*> named;
+	for (const auto& [node, value] : function.values)
+	{
+		if (node->type == Node::Type::Identifier) named.insert(value);
+	}
+
+	vector<Instruction*> declarations;
+	for (const auto& block : function.blocks)
+	{
+		for (auto* inst : block->instructions)
+		{
+			if (inst->opcode == Opcode::Declare) declarations.push_back(inst);
+		}
+	}
+
+	size_t changes = 0;
+	for (auto* declare : declarations)
+	{
+		const auto* stat = declare->statement;
+		if (!declare->droppable || function.repeated.count(stat) || function.nestedReferences.count(declare->symbol))
+		{
+			continue;
+		}
+
+		// Any other use of the value may be a read of the binding
+		auto* value = declare->operands[0];
+		auto users = function.users();
+		if (named.count(value) || users[value].size() != 1)
+		{
+			continue;
+		}
+		// An annotation fails the declaration unless the value is known to be of its type
+		if (value->opcode == Opcode::Check && value->operands[0]->type != value->type)
+		{
+			continue;
+		}
+
+		auto expr = declare->isMutable ? static_pointer_cast<VarStat>(declare->origin)->value : static_pointer_cast<LetStat>(declare->origin)->value;
+		if (self_contained(function, stat, users) && function.cannot_fail(expr))
+		{
+			drop(function, stat);
+			changes++;
+		}
+	}
+	return changes;
+}
+
+size_t DeadStoreElimination::dead_assignments(Function& function)
+{
+	size_t changes = 0;
+	for (const auto& block : function.blocks)
+	{
+		const auto& instructions = block->instructions;
+		for (size_t i = 0; i < instructions.size(); i++)
+		{
+			auto* first = instructions[i];
+			if (first->opcode != Opcode::Assign || first->op != "=" || !first->droppable)
+			{
+				continue;
+			}
+
+			// Only instructions that neither read the contents of an object nor change one may come between
+			Instruction* next = nullptr;
+			for (size_t j = i + 1; j < instructions.size(); j++)
+			{
+				auto* inst = instructions[j];
+				if (inst->opcode == Opcode::Assign && inst->operands[0] == first->operands[0])
+				{
+					next = inst;
+					break;
+				}
+				if (inst->opcode != Opcode::Const && inst->opcode != Opcode::Closure && inst->opcode != Opcode::Array)
+				{
+					break;
+				}
+			}
+			if (!next || next->op != "=")
+			{
+				continue;
+			}
+
+			// An assignment replaces a scalar, but appends to an array
+			auto type = first->operands[0]->type;
+			bool scalar = type == Type::Integer || type == Type::Float || type == Type::Bool || type == Type::String;
+			if (!scalar || first->operands[1]->type != type || next->operands[1]->type != type)
+			{
+				continue;
+			}
+
+			// The same name reports the same error if the object is immutable
+			auto firstExpr = static_pointer_cast<AssignExpr>(first->origin);
+			auto nextExpr = static_pointer_cast<AssignExpr>(next->origin);
+			if (firstExpr->id->type != Node::Type::Identifier || nextExpr->id->type != Node::Type::Identifier ||
+				static_pointer_cast<IdentifierExpr>(firstExpr->id)->symbol != static_pointer_cast<IdentifierExpr>(nextExpr->id)->symbol)
+			{
+				continue;
+			}
+
+			auto users = function.users();
+			if (users.count(first) || !self_contained(function, first->statement, users) || !function.cannot_fail(firstExpr))
+			{
+				continue;
+			}
+
+			drop(function, first->statement);
+			changes++;
+			i = static_cast<size_t>(-1);
+		}
+	}
+	return changes;
+}
+
+bool DeadStoreElimination::self_contained(const Function& function, const Stat* statement, const unordered_map<Instruction*, vector<Instruction*>>& users)
+{
+	for (const auto& block : function.blocks)
+	{
+		for (auto* inst : block->instructions)
+		{
+			if (inst->statement != statement) continue;
+
+			auto it = users.find(inst);
+			if (it == users.end()) continue;
+			for (auto* user : it->second)
+			{
+				if (user->statement != statement) return false;
+			}
+		}
+	}
+	return true;
+}
+
+void DeadStoreElimination::drop(Function& function, const Stat* statement)
+{
+	for (const auto& block : function.blocks)
+	{
+		auto instructions = block->instructions;
+		for (auto* inst : instructions)
+		{
+			if (inst->statement == statement) function.remove(inst);
+		}
+	}
+	function.droppedStatements.insert(statement);
+}
+
+
+}
\ No newline at end of file
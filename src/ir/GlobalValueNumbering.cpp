@@ -0,0 +1,138 @@
+#include "ir/GlobalValueNumbering.h"
+#include <functional>
+
+namespace li::ir
+{
+
+
+size_t GlobalValueNumbering::run(Function& function)
+{
+	auto order = function.reverse_post_order();
+	auto idom = function.dominators();
+
+	// Memory versions, a block continues the version its predecessors agree on
+	unordered_map<BasicBlock*, size_t> versionOut;
+	unordered_map<Instruction*, size_t> version;
+	size_t versions = 0;
+	for (auto* block : order)
+	{
+		bool agreed = !block->preds.empty();
+		size_t incoming = 0;
+		for (size_t i = 0; i < block->preds.size() && agreed; i++)
+		{
+			auto it = versionOut.find(block->preds[i]);
+			agreed = it != versionOut.end() && (i == 0 || it->second == incoming);
+			if (agreed) incoming = it->second;
+		}
+		size_t current = agreed ? incoming : versions++;
+
+		for (auto* inst : block->instructions)
+		{
+			version[inst] = current;
+			// Declarations only change bindings and mutability, never the contents of objects
+			if (inst->opcode == Opcode::Call || inst->opcode == Opcode::Assign || inst->opcode == Opcode::InDecrement)
+			{
+				current = versions++;
+			}
+		}
+		versionOut[block] = current;
+	}
+
+	unordered_map<BasicBlock*, vector<BasicBlock*>> children;
+	for (auto* block : order)
+	{
+		if (block != function.entry) children[idom[block]].push_back(block);
+	}
+
+	auto users = function.users();
+	unordered_map<string, Instruction*> available;
+	size_t changes = 0;
+
+	std::function<void(BasicBlock*)> visit = [&](BasicBlock* block)
+	{
+		vector<string> added;
+		auto instructions = block->instructions;
+		for (auto* inst : instructions)
+		{
+			if (!inst->reads_memory()) continue;
+
+			string key = opcode_name(inst->opcode) + ' ' + inst->op + " @" + to_string(version[inst]);
+			for (auto* operand : inst->operands)
+			{
+				key += ' ' + operand_key(operand);
+			}
+
+			auto it = available.find(key);
+			if (it == available.end())
+			{
+				available[key] = inst;
+				added.push_back(key);
+				continue;
+			}
+
+			// The reused object is stored when the dominating instruction runs, which a condition
+			// may skip after an operand before it failed
+			auto* dominating = it->second;
+			if (!function.always_reached(dominating) || !consumed(dominating, users) || !consumed(inst, users))
+			{
+				continue;
+			}
+
+			for (auto* user : users[inst])
+			{
+				replace(user->operands.begin(), user->operands.end(), inst, dominating);
+				users[dominating].push_back(user);
+			}
+			users.erase(inst);
+			for (auto& [node, value] : function.values)
+			{
+				if (value == inst) value = dominating;
+			}
+			function.remove(inst);
+			function.reuses.push_back({ inst, dominating });
+			changes++;
+		}
+
+		for (auto* child : children[block])
+		{
+			visit(child);
+		}
+		for (const auto& key : added)
+		{
+			available.erase(key);
+		}
+	};
+	visit(function.entry);
+	return changes;
+}
+
+string GlobalValueNumbering::operand_key(const Instruction* operand)
+{
+	// Every evaluation of a literal creates a new object, but equal literals read the same
+	if (operand->opcode == Opcode::Const && operand->origin)
+	{
+		return type_name(operand->type) + ':' + operand->origin->toString();
+	}
+	return to_string(operand->id);
+}
+
+bool GlobalValueNumbering::consumed(Instruction* inst, const unordered_map<Instruction*, vector<Instruction*>>& users)
+{
+	auto it = users.find(inst);
+	if (it == users.end())
+	{
+		return false;
+	}
+
+	for (auto* user : it->second)
+	{
+		if (!user->reads_memory() && user->opcode != Opcode::Branch)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+}
\ No newline at end of file
@@ -0,0 +1,555 @@
+#include "ir/IR.h"
+#include "ast/IdentifierExpr.hpp"
+#include "ast/ArrayExpr.hpp"
+#include "ast/PrefixExpr.hpp"
+#include "ast/InfixExpr.hpp"
+#include "ast/IndexExpr.hpp"
+#include "ast/AssignExpr.hpp"
+#include "ast/CallExpr.hpp"
+#include <algorithm>
+
+namespace li::ir
+{
+
+
+string type_name(Type type)
+{
+	switch (type)
+	{
+	case Type::Unknown: return "unknown";
+	case Type::Null: return "null";
+	case Type::Integer: return "int";
+	case Type::Float: return "float";
+	case Type::Bool: return "bool";
+	case Type::String: return "string";
+	case Type::Array: return "array";
+	case Type::Function: return "function";
+	default: return "any";
+	}
+}
+
+Type annotated_type(Annotation annotation)
+{
+	switch (annotation)
+	{
+	case Annotation::None: return Type::Any;
+	case Annotation::Integer: return Type::Integer;
+	case Annotation::Float: return Type::Float;
+	case Annotation::Bool: return Type::Bool;
+	case Annotation::String: return Type::String;
+	case Annotation::Array: return Type::Array;
+	default: return Type::Function;
+	}
+}
+
+Type join(Type left, Type right)
+{
+	if (left == Type::Unknown) return right;
+	if (right == Type::Unknown) return left;
+	return left == right ? left : Type::Any;
+}
+
+bool is_number(Type type)
+{
+	return type == Type::Integer || type == Type::Float;
+}
+
+string opcode_name(Opcode opcode)
+{
+	switch (opcode)
+	{
+	case Opcode::Const: return "const";
+	case Opcode::Param: return "param";
+	case Opcode::Outer: return "outer";
+	case Opcode::Phi: return "phi";
+	case Opcode::Prefix: return "prefix";
+	case Opcode::Infix: return "infix";
+	case Opcode::Index: return "index";
+	case Opcode::Array: return "array";
+	case Opcode::Closure: return "closure";
+	case Opcode::Call: return "call";
+	case Opcode::Check: return "check";
+	case Opcode::Declare: return "declare";
+	case Opcode::Assign: return "assign";
+	case Opcode::InDecrement: return "indecrement";
+	case Opcode::Jump: return "jump";
+	case Opcode::Branch: return "branch";
+	default: return "return";
+	}
+}
+
+bool Instruction::has_value() const
+{
+	return opcode != Opcode::Declare && !is_terminator();
+}
+
+bool Instruction::is_terminator() const
+{
+	return opcode == Opcode::Jump || opcode == Opcode::Branch || opcode == Opcode::Return;
+}
+
+bool Instruction::has_effect() const
+{
+	switch (opcode)
+	{
+	case Opcode::Call:
+	case Opcode::Declare:
+	case Opcode::Assign:
+	case Opcode::InDecrement:
+		return true;
+
+	default:
+		return is_terminator();
+	}
+}
+
+bool Instruction::reads_memory() const
+{
+	return opcode == Opcode::Prefix || opcode == Opcode::Infix || opcode == Opcode::Index;
+}
+
+Instruction* Function::create(Opcode opcode, BasicBlock* block)
+{
+	instructions.push_back(make_unique<Instruction>(opcode, instructions.size()));
+	auto* inst = instructions.back().get();
+	inst->block = block;
+	return inst;
+}
+
+BasicBlock* Function::create_block()
+{
+	blocks.push_back(make_unique<BasicBlock>(blocks.size()));
+	return blocks.back().get();
+}
+
+void Function::add_edge(BasicBlock* from, BasicBlock* to)
+{
+	from->succs.push_back(to);
+	to->preds.push_back(from);
+}
+
+void Function::remove(Instruction* inst)
+{
+	if (inst->removed)
+	{
+		return;
+	}
+
+	auto& list = inst->block->instructions;
+	list.erase(find(list.begin(), list.end(), inst));
+	inst->removed = true;
+}
+
+void Function::replace_uses(Instruction* from, Instruction* to)
+{
+	for (const auto& block : blocks)
+	{
+		for (auto* inst : block->instructions)
+		{
+			replace(inst->operands.begin(), inst->operands.end(), from, to);
+		}
+	}
+
+	for (auto& [node, value] : values)
+	{
+		if (value == from) value = to;
+	}
+}
+
+unordered_map<Instruction*, vector<Instruction*>> Function::users() const
+{
+	unordered_map<Instruction*, vector<Instruction*>> result;
+	for (const auto& block : blocks)
+	{
+		for (auto* inst : block->instructions)
+		{
+			for (auto* operand : inst->operands)
+			{
+				result[operand].push_back(inst);
+			}
+		}
+	}
+	return result;
+}
+
+vector<BasicBlock*> Function::reverse_post_order() const
+{
+	vector<BasicBlock*> order;
+	unordered_set<BasicBlock*> visited;
+	vector<pair<BasicBlock*, size_t>> stack = { { entry, 0 } };
+	visited.insert(entry);
+
+	while (!stack.empty())
+	{
+		auto& [block, next] = stack.back();
+		if (next < block->succs.size())
+		{
+			auto* succ = block->succs[next++];
+			if (visited.insert(succ).second)
+			{
+				stack.push_back({ succ, 0 });
+			}
+			continue;
+		}
+		order.push_back(block);
+		stack.pop_back();
+	}
+
+	reverse(order.begin(), order.end());
+	return order;
+}
+
+unordered_map<BasicBlock*, BasicBlock*> Function::dominators() const
+{
+	// Cooper, Harvey and Kennedy, "A Simple, Fast Dominance Algorithm"
+	auto order = reverse_post_order();
+	unordered_map<BasicBlock*, size_t> number;
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		number[order[i]] = i;
+	}
+
+	unordered_map<BasicBlock*, BasicBlock*> idom = { { entry, entry } };
+	auto intersect = [&](BasicBlock* a, BasicBlock* b)
+	{
+		while (a != b)
+		{
+			while (number[a] > number[b]) a = idom[a];
+			while (number[b] > number[a]) b = idom[b];
+		}
+		return a;
+	};
+
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		for (size_t i = 1; i < order.size(); i++)
+		{
+			BasicBlock* found = nullptr;
+			for (auto* pred : order[i]->preds)
+			{
+				if (!idom.count(pred)) continue;
+				found = found ? intersect(pred, found) : pred;
+			}
+
+			if (found && idom[order[i]] != found)
+			{
+				idom[order[i]] = found;
+				changed = true;
+			}
+		}
+	}
+	return idom;
+}
+
+void Function::remove_unreachable()
+{
+	auto order = reverse_post_order();
+	unordered_set<BasicBlock*> reachable(order.begin(), order.end());
+
+	for (const auto& block : blocks)
+	{
+		if (reachable.count(block.get())) continue;
+
+		for (auto* succ : block->succs)
+		{
+			auto& preds = succ->preds;
+			preds.erase(find(preds.begin(), preds.end(), block.get()));
+
+			for (auto* inst : succ->instructions)
+			{
+				if (inst->opcode != Opcode::Phi) continue;
+				for (size_t i = 0; i < inst->targets.size(); i++)
+				{
+					if (inst->targets[i] != block.get()) continue;
+					inst->targets.erase(inst->targets.begin() + i);
+					inst->operands.erase(inst->operands.begin() + i);
+					break;
+				}
+			}
+		}
+		for (auto* inst : block->instructions)
+		{
+			inst->removed = true;
+			inst->block = nullptr;
+		}
+	}
+
+	blocks.erase(remove_if(blocks.begin(), blocks.end(), [&](const unique_ptr<BasicBlock>& block)
+	{
+		return !reachable.count(block.get());
+	}), blocks.end());
+}
+
+Instruction* Function::value(const Node* expr) const
+{
+	auto it = values.find(expr);
+	return it == values.end() ? nullptr : it->second;
+}
+
+static bool bound(Instruction* value, unordered_set<Instruction*>& visited)
+{
+	if (!visited.insert(value).second)
+	{
+		return true;
+	}
+
+	if (value->opcode == Opcode::Outer)
+	{
+		return false;
+	}
+	if (value->opcode == Opcode::Phi)
+	{
+		for (auto* operand : value->operands)
+		{
+			if (!bound(operand, visited)) return false;
+		}
+	}
+	return true;
+}
+
+bool Function::cannot_fail(const shared_ptr<Expr>& expr) const
+{
+	switch (expr->type)
+	{
+
+	case Node::Type::Integer:
+	case Node::Type::Float:
+	case Node::Type::Bool:
+	case Node::Type::String:
+	case Node::Type::Function:
+		return true;
+
+	case Node::Type::Identifier:
+	{
+		auto* found = value(expr.get());
+		unordered_set<Instruction*> visited;
+		return found && bound(found, visited);
+	}
+
+	case Node::Type::Array:
+		for (const auto& element : static_pointer_cast<ArrayExpr>(expr)->elements->expressions)
+		{
+			if (!cannot_fail(element)) return false;
+		}
+		return true;
+
+	case Node::Type::Prefix:
+	{
+		auto cast = static_pointer_cast<PrefixExpr>(expr);
+		auto* right = value(cast->right.get());
+		return cast->operatorName == "-" && right && is_number(right->type) && cannot_fail(cast->right);
+	}
+
+	case Node::Type::Infix:
+	{
+		auto cast = static_pointer_cast<InfixExpr>(expr);
+		auto* left = value(cast->left.get());
+		auto* right = value(cast->right.get());
+		if (!left || !right || !cannot_fail(cast->left) || !cannot_fail(cast->right))
+		{
+			return false;
+		}
+
+		// The remainder of an integer division by zero is undefined
+		const auto& op = cast->operatorName;
+		if (is_number(left->type) && is_number(right->type))
+		{
+			return op == "+" || op == "-" || op == "*" || op == "/" || op == "==" || op == "!=" || op == "<" || op == ">" || op == "<=" || op == ">=";
+		}
+		return op == "+" && left->type == Type::String && right->type == Type::String;
+	}
+
+	case Node::Type::Assign:
+	{
+		auto cast = static_pointer_cast<AssignExpr>(expr);
+		return cannot_fail(cast->id) && cannot_fail(cast->value);
+	}
+
+	default:
+		return false;
+
+	}
+}
+
+// Finds target in the evaluation of node and whether every node evaluated before it can not fail
+static bool find_evaluated(const Function& function, const shared_ptr<Expr>& node, const Node* target, bool& safe)
+{
+	if (node.get() == target)
+	{
+		return true;
+	}
+
+	vector<shared_ptr<Expr>> children;
+	switch (node->type)
+	{
+	case Node::Type::Prefix: children = { static_pointer_cast<PrefixExpr>(node)->right }; break;
+	case Node::Type::Infix: children = { static_pointer_cast<InfixExpr>(node)->left, static_pointer_cast<InfixExpr>(node)->right }; break;
+	case Node::Type::Index: children = { static_pointer_cast<IndexExpr>(node)->left, static_pointer_cast<IndexExpr>(node)->index }; break;
+	case Node::Type::Assign: children = { static_pointer_cast<AssignExpr>(node)->id, static_pointer_cast<AssignExpr>(node)->value }; break;
+	case Node::Type::Array: children = static_pointer_cast<ArrayExpr>(node)->elements->expressions; break;
+	case Node::Type::Call:
+		children = { static_pointer_cast<CallExpr>(node)->fun };
+		for (const auto& arg : static_pointer_cast<CallExpr>(node)->exprs->expressions)
+		{
+			children.push_back(arg);
+		}
+		break;
+	default: break;
+	}
+
+	for (const auto& child : children)
+	{
+		if (find_evaluated(function, child, target, safe))
+		{
+			return true;
+		}
+		safe = safe && function.cannot_fail(child);
+	}
+	return false;
+}
+
+bool Function::always_reached(const Instruction* inst) const
+{
+	if (!inst->condition)
+	{
+		return true;
+	}
+
+	bool safe = true;
+	return find_evaluated(*this, inst->condition, inst->origin.get(), safe) && safe;
+}
+
+void Function::print(ostream& out) const
+{
+	// Values and blocks are numbered in the order they are printed
+	auto order = reverse_post_order();
+	unordered_map<const BasicBlock*, size_t> blockNumbers;
+	unordered_map<const Instruction*, size_t> valueNumbers;
+	for (auto* block : order)
+	{
+		blockNumbers[block] = blockNumbers.size();
+		for (auto* inst : block->instructions)
+		{
+			if (inst->has_value())
+			{
+				valueNumbers[inst] = valueNumbers.size();
+			}
+		}
+	}
+
+	auto block_name = [&](const BasicBlock* block) { return "b" + to_string(blockNumbers.at(block)); };
+	auto value_name = [&](const Instruction* inst)
+	{
+		auto it = valueNumbers.find(inst);
+		return it == valueNumbers.end() ? string("%?") : "%" + to_string(it->second);
+	};
+
+	out << "function @" << id << ' ' << name;
+	if (node)
+	{
+		out << node->args->toString();
+	}
+	out << '\n';
+
+	if (!supported)
+	{
+		out << "  ; not modeled\n";
+		return;
+	}
+
+	for (auto* block : order)
+	{
+		out << block_name(block) << ':';
+		for (size_t i = 0; i < block->preds.size(); i++)
+		{
+			out << (i == 0 ? " ; preds " : ", ") << block_name(block->preds[i]);
+		}
+		out << '\n';
+
+		for (auto* inst : block->instructions)
+		{
+			out << "  ";
+			if (inst->has_value())
+			{
+				out << value_name(inst) << " = ";
+			}
+			out << opcode_name(inst->opcode);
+
+			switch (inst->opcode)
+			{
+
+			case Opcode::Const:
+				if (!inst->origin) out << " null";
+				else if (inst->origin->type == Node::Type::String) out << " \"" << inst->origin->toString() << '"';
+				else out << ' ' << inst->origin->toString();
+				break;
+
+			case Opcode::Param:
+			case Opcode::Outer:
+				out << ' ' << annotated_name(SymbolTable::name(inst->symbol), inst->annotation);
+				break;
+
+			case Opcode::Check:
+				out << ' ' << annotation_name(inst->annotation) << ", " << value_name(inst->operands[0]);
+				break;
+
+			case Opcode::Phi:
+				for (size_t i = 0; i < inst->operands.size(); i++)
+				{
+					out << (i == 0 ? " [" : ", [") << value_name(inst->operands[i]) << ", " << block_name(inst->targets[i]) << ']';
+				}
+				break;
+
+			case Opcode::Closure:
+				out << " @" << inst->callee->id;
+				break;
+
+			case Opcode::Declare:
+				out << (inst->isMutable ? " var " : " let ") << SymbolTable::name(inst->symbol) << ", " << value_name(inst->operands[0]);
+				break;
+
+			default:
+				if (!inst->op.empty())
+				{
+					out << ' ' << inst->op;
+				}
+				for (size_t i = 0; i < inst->operands.size(); i++)
+				{
+					out << (i == 0 ? " " : ", ") << value_name(inst->operands[i]);
+				}
+				for (size_t i = 0; i < inst->targets.size(); i++)
+				{
+					out << (i == 0 && inst->operands.empty() ? " " : ", ") << block_name(inst->targets[i]);
+				}
+				break;
+
+			}
+
+			if (inst->has_value())
+			{
+				out << " : " << type_name(inst->type);
+			}
+			out << '\n';
+		}
+	}
+}
+
+Function* Module::create_function(const string& name)
+{
+	functions.push_back(make_unique<Function>(functions.size(), name));
+	return functions.back().get();
+}
+
+void Module::print(ostream& out) const
+{
+	for (size_t i = 0; i < functions.size(); i++)
+	{
+		if (i != 0) out << '\n';
+		functions[i]->print(out);
+	}
+}
+
+
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include "ir/Lowering.h"
+#include "analysis/Traversal.h"
+#include "ast/BlockStat.hpp"
+#include "ast/TempExpr.hpp"
+#include "ast/AssignExpr.hpp"
+#include <algorithm>
+#include <functional>
+
+namespace li::ir
+{
+
+
+void Lowering::run(Module& module)
+{
+	unordered_set<const Stat*> dropped;
+	unordered_map<const Node*, shared_ptr<Expr>> replacements;
+
+	for (const auto& function : module.functions)
+	{
+		if (!function->supported) continue;
+
+		dropped.insert(function->droppedStatements.begin(), function->droppedStatements.end());
+
+		for (const auto& block : function->blocks)
+		{
+			for (auto* inst : block->instructions)
+			{
+				if (inst->opcode == Opcode::Assign && inst->unboxed)
+				{
+					static_pointer_cast<AssignExpr>(inst->origin)->unboxed = true;
+				}
+				if (inst->numericOp == NumericOp::None) continue;
+
+				auto node = static_pointer_cast<InfixExpr>(inst->origin);
+				node->numericOp = inst->numericOp;
+				node->leftFloat = inst->operands[0]->type == Type::Float;
+				node->rightFloat = inst->operands[1]->type == Type::Float;
+				node->unboxed = inst->unboxed;
+				node->feedback.state = Feedback::State::Proven;
+			}
+		}
+
+		// One slot for every instruction reused, slots are numbered per function since they live in its frame
+		unordered_map<Instruction*, size_t> slots;
+		for (const auto& [redundant, dominating] : function->reuses)
+		{
+			auto [it, inserted] = slots.emplace(dominating, slots.size());
+			if (inserted)
+			{
+				auto expr = static_pointer_cast<Expr>(dominating->origin);
+				replacements[expr.get()] = make_shared<TempExpr>(expr, it->second, false);
+			}
+			auto expr = static_pointer_cast<Expr>(redundant->origin);
+			replacements[expr.get()] = make_shared<TempExpr>(expr, it->second, true);
+		}
+	}
+
+	auto erase_dropped = [&](vector<shared_ptr<Stat>>& statements)
+	{
+		statements.erase(remove_if(statements.begin(), statements.end(), [&](const shared_ptr<Stat>& stat)
+		{
+			return dropped.count(stat.get()) != 0;
+		}), statements.end());
+	};
+
+	// Children are rewritten before their parents, so a replaced expression keeps its rewritten operands
+	std::function<void(const shared_ptr<Node>&)> rewrite = [&](const shared_ptr<Node>& node)
+	{
+		for_each_child(node, rewrite);
+
+		if (node->type == Node::Type::Program)
+		{
+			erase_dropped(static_pointer_cast<Program>(node)->statements);
+		}
+		else if (node->type == Node::Type::Block)
+		{
+			erase_dropped(static_pointer_cast<BlockStat>(node)->statements);
+		}
+
+		for_each_expr_slot(node, [&](shared_ptr<Expr>& slot)
+		{
+			auto it = replacements.find(slot.get());
+			if (it != replacements.end())
+			{
+				slot = it->second;
+			}
+		});
+	};
+	rewrite(module.program);
+}
+
+
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "ir/NumericSpecialization.h"
+#include "ast/AssignExpr.hpp"
+
+namespace li::ir
+{
+
+
+size_t NumericSpecialization::run(Function& function)
+{
+	size_t changes = 0;
+	for (const auto& block : function.blocks)
+	{
+		for (auto* inst : block->instructions)
+		{
+			if (inst->opcode != Opcode::Infix) continue;
+
+			inst->numericOp = numeric_op(inst->op, inst->operands[0]->type, inst->operands[1]->type);
+			if (inst->numericOp != NumericOp::None) changes++;
+		}
+	}
+
+	// A value reused through a frame slot or bound to a name has other users, the value of an
+	// assignment has one when it is the value of its block
+	auto users = function.users();
+	for (const auto& block : function.blocks)
+	{
+		for (auto* inst : block->instructions)
+		{
+			auto found = users.find(inst);
+			if (inst->opcode == Opcode::Assign)
+			{
+				auto* name = inst->operands[0];
+				auto* value = inst->operands[1];
+				inst->unboxed = found == users.end() && name->opcode != Opcode::Index && is_number(name->type) && is_number(value->type) &&
+					AssignExpr::keeps_type(inst->op, name->type == Type::Float, value->type == Type::Float);
+				continue;
+			}
+			if (inst->opcode != Opcode::Infix || !InfixExpr::is_arithmetic(inst->numericOp)) continue;
+
+			inst->unboxed = found != users.end() && found->second.size() == 1 &&
+				found->second[0]->opcode == Opcode::Infix && found->second[0]->numericOp != NumericOp::None;
+		}
+	}
+	return changes;
+}
+
+void NumericSpecialization::report(const Module& module, ostream& out)
+{
+	for (const auto& function : module.functions)
+	{
+		if (!function->supported) continue;
+
+		size_t operators = 0;
+		size_t specialized = 0;
+		size_t unboxed = 0;
+		for (const auto& block : function->blocks)
+		{
+			for (auto* inst : block->instructions)
+			{
+				if (inst->opcode != Opcode::Infix) continue;
+				operators++;
+				if (inst->numericOp != NumericOp::None) specialized++;
+				if (inst->unboxed) unboxed++;
+			}
+		}
+
+		if (operators == 0) continue;
+		if (specialized == operators)
+		{
+			out << "fully specialized: " << function->name;
+		}
+		else
+		{
+			out << "partially specialized: " << function->name << " (" << specialized << " of " << operators << " operators)";
+		}
+		if (unboxed != 0)
+		{
+			out << ", " << unboxed << " unboxed";
+		}
+		out << '\n';
+	}
+}
+
+NumericOp NumericSpecialization::numeric_op(const string& op, Type left, Type right)
+{
+	if (!is_number(left) || !is_number(right))
+	{
+		return NumericOp::None;
+	}
+	return InfixExpr::numeric_op(op, left == Type::Float, right == Type::Float);
+}
+
+
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include "ir/PassManager.h"
+#include "ir/CopyPropagation.h"
+#include "ir/TypePropagation.h"
+#include "ir/GlobalValueNumbering.h"
+#include "ir/DeadStoreElimination.h"
+#include "ir/NumericSpecialization.h"
+
+namespace li::ir
+{
+
+
+unique_ptr<PassManager> PassManager::standard()
+{
+	auto manager = make_unique<PassManager>();
+	manager->add(make_unique<CopyPropagation>());
+	manager->add(make_unique<TypePropagation>());
+	manager->add(make_unique<GlobalValueNumbering>());
+	manager->add(make_unique<DeadStoreElimination>());
+	manager->add(make_unique<NumericSpecialization>());
+	manager->add(make_unique<CopyPropagation>());
+	return manager;
+}
+
+unique_ptr<PassManager> PassManager::specialization()
+{
+	auto manager = make_unique<PassManager>();
+	manager->add(make_unique<CopyPropagation>());
+	manager->add(make_unique<TypePropagation>());
+	manager->add(make_unique<NumericSpecialization>());
+	return manager;
+}
+
+void PassManager::add(unique_ptr<Pass> pass)
+{
+	_changes[pass->name()];
+	_passes.push_back(move(pass));
+}
+
+void PassManager::run(Module& module)
+{
+	for (const auto& function : module.functions)
+	{
+		if (!function->supported) continue;
+
+		for (const auto& pass : _passes)
+		{
+			_changes[pass->name()] += pass->run(*function);
+		}
+	}
+}
+
+
+}
\ No newline at end of file
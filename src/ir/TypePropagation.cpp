@@ -0,0 +1,129 @@
+#include "ir/TypePropagation.h"
+
+namespace li::ir
+{
+
+
+size_t TypePropagation::run(Function& function)
+{
+	auto order = function.reverse_post_order();
+
+	// Types only move up the lattice, so iterating until nothing changes terminates
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		for (auto* block : order)
+		{
+			for (auto* inst : block->instructions)
+			{
+				if (!inst->has_value()) continue;
+
+				auto type = join(inst->type, infer(inst));
+				if (type != inst->type)
+				{
+					inst->type = type;
+					changed = true;
+				}
+			}
+		}
+	}
+
+	size_t known = 0;
+	for (auto* block : order)
+	{
+		for (auto* inst : block->instructions)
+		{
+			if (inst->has_value() && inst->type != Type::Unknown && inst->type != Type::Any) known++;
+		}
+	}
+	return known;
+}
+
+Type TypePropagation::infer(const Instruction* inst)
+{
+	switch (inst->opcode)
+	{
+
+	case Opcode::Const:
+		if (!inst->origin) return Type::Null;
+		switch (inst->origin->type)
+		{
+		case Node::Type::Integer: return Type::Integer;
+		case Node::Type::Float: return Type::Float;
+		case Node::Type::Bool: return Type::Bool;
+		default: return Type::String;
+		}
+
+	case Opcode::Param:
+	case Opcode::Check:
+		return annotated_type(inst->annotation);
+
+	case Opcode::Phi:
+	{
+		auto type = Type::Unknown;
+		for (auto* operand : inst->operands)
+		{
+			type = join(type, operand->type);
+		}
+		return type;
+	}
+
+	case Opcode::Prefix:
+	{
+		auto right = inst->operands[0]->type;
+		if (inst->op == "!") return Type::Bool;
+		if (inst->op == "-" && (right == Type::Unknown || is_number(right))) return right;
+		return Type::Any;
+	}
+
+	case Opcode::Infix:
+		return infer_infix(inst->op, inst->operands[0]->type, inst->operands[1]->type);
+
+	case Opcode::Assign:
+		if (inst->op == "=") return inst->operands[1]->type;
+		return infer_infix(inst->op.substr(0, 1), inst->operands[0]->type, inst->operands[1]->type);
+
+	case Opcode::InDecrement:
+		return Type::Integer;
+
+	case Opcode::Array:
+		return Type::Array;
+
+	case Opcode::Closure:
+		return Type::Function;
+
+	default:
+		return Type::Any;
+
+	}
+}
+
+Type TypePropagation::infer_infix(const string& op, Type left, Type right)
+{
+	if (op == "==" || op == "!=" || op == "<" || op == ">" || op == "<=" || op == ">=")
+	{
+		return Type::Bool;
+	}
+	if (left == Type::Unknown || right == Type::Unknown)
+	{
+		return Type::Unknown;
+	}
+
+	if (is_number(left) && is_number(right))
+	{
+		if (op == "%") return Type::Integer;
+		if (op == "+" || op == "-" || op == "*" || op == "/")
+		{
+			return left == Type::Float || right == Type::Float ? Type::Float : Type::Integer;
+		}
+	}
+	if (op == "+" && left == Type::String && right == Type::String)
+	{
+		return Type::String;
+	}
+	return Type::Any;
+}
+
+
+}
\ No newline at end of file
@@ -0,0 +1,332 @@
+#include "jit/Assembler.h"
+#include <cstring>
+
+namespace li::jit
+{
+
+
+static uint8_t number(Reg reg)
+{
+	return static_cast<uint8_t>(reg);
+}
+
+static uint8_t number(Xmm reg)
+{
+	return static_cast<uint8_t>(reg);
+}
+
+void Assembler::byte(uint8_t value)
+{
+	_code.push_back(value);
+}
+
+void Assembler::imm32(int32_t value)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		byte(static_cast<uint8_t>(static_cast<uint32_t>(value) >> (i * 8)));
+	}
+}
+
+void Assembler::patch32(size_t position, int32_t value)
+{
+	memcpy(&_code[position], &value, sizeof(value));
+}
+
+void Assembler::rex(bool wide, uint8_t reg, uint8_t base)
+{
+	uint8_t prefix = 0x40 | (wide ? 0x08 : 0) | ((reg & 8) ? 0x04 : 0) | ((base & 8) ? 0x01 : 0);
+	if (prefix != 0x40)
+	{
+		byte(prefix);
+	}
+}
+
+void Assembler::modrm(uint8_t reg, uint8_t rm)
+{
+	byte(0xC0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+void Assembler::memory(uint8_t reg, Reg base, int32_t disp)
+{
+	// mod 10 is a 32-bit displacement, rsp and r12 as a base need a SIB byte
+	byte(0x80 | ((reg & 7) << 3) | (number(base) & 7));
+	if ((number(base) & 7) == 4)
+	{
+		byte(0x24);
+	}
+	imm32(disp);
+}
+
+void Assembler::sse(uint8_t prefix, uint8_t opcode, uint8_t reg, uint8_t rm, bool wide)
+{
+	byte(prefix);
+	rex(wide, reg, rm);
+	byte(0x0F);
+	byte(opcode);
+	modrm(reg, rm);
+}
+
+void Assembler::link(Label& label)
+{
+	if (label.position != SIZE_MAX)
+	{
+		imm32(static_cast<int32_t>(label.position - (position() + 4)));
+		return;
+	}
+	label.patches.push_back(position());
+	imm32(0);
+}
+
+void Assembler::bind(Label& label)
+{
+	label.position = position();
+	for (auto patch : label.patches)
+	{
+		patch32(patch, static_cast<int32_t>(label.position - (patch + 4)));
+	}
+	label.patches.clear();
+}
+
+void Assembler::jmp(Label& label)
+{
+	byte(0xE9);
+	link(label);
+}
+
+void Assembler::jcc(Condition condition, Label& label)
+{
+	byte(0x0F);
+	byte(0x80 | static_cast<uint8_t>(condition));
+	link(label);
+}
+
+void Assembler::call(Label& label)
+{
+	byte(0xE8);
+	link(label);
+}
+
+void Assembler::ret()
+{
+	byte(0xC3);
+}
+
+void Assembler::push(Reg reg)
+{
+	rex(false, 0, number(reg));
+	byte(0x50 | (number(reg) & 7));
+}
+
+void Assembler::pop(Reg reg)
+{
+	rex(false, 0, number(reg));
+	byte(0x58 | (number(reg) & 7));
+}
+
+void Assembler::mov(Reg dst, Reg src)
+{
+	rex(true, number(src), number(dst));
+	byte(0x89);
+	modrm(number(src), number(dst));
+}
+
+void Assembler::mov(Reg dst, int64_t imm)
+{
+	rex(true, 0, number(dst));
+	byte(0xB8 | (number(dst) & 7));
+	for (int i = 0; i < 8; i++)
+	{
+		byte(static_cast<uint8_t>(static_cast<uint64_t>(imm) >> (i * 8)));
+	}
+}
+
+void Assembler::mov(Reg dst, Reg base, int32_t disp)
+{
+	rex(true, number(dst), number(base));
+	byte(0x8B);
+	memory(number(dst), base, disp);
+}
+
+void Assembler::mov(Reg base, int32_t disp, Reg src)
+{
+	rex(true, number(src), number(base));
+	byte(0x89);
+	memory(number(src), base, disp);
+}
+
+void Assembler::movsd(Xmm dst, Reg base, int32_t disp)
+{
+	byte(0xF2);
+	rex(false, number(dst), number(base));
+	byte(0x0F);
+	byte(0x10);
+	memory(number(dst), base, disp);
+}
+
+void Assembler::movsd(Reg base, int32_t disp, Xmm src)
+{
+	byte(0xF2);
+	rex(false, number(src), number(base));
+	byte(0x0F);
+	byte(0x11);
+	memory(number(src), base, disp);
+}
+
+void Assembler::movq(Xmm dst, Reg src)
+{
+	sse(0x66, 0x6E, number(dst), number(src), true);
+}
+
+void Assembler::movq(Reg dst, Xmm src)
+{
+	sse(0x66, 0x7E, number(src), number(dst), true);
+}
+
+void Assembler::lea(Reg dst, Reg base, int32_t disp)
+{
+	rex(true, number(dst), number(base));
+	byte(0x8D);
+	memory(number(dst), base, disp);
+}
+
+size_t Assembler::sub(Reg dst, int32_t imm)
+{
+	rex(true, 0, number(dst));
+	byte(0x81);
+	modrm(5, number(dst));
+	size_t at = position();
+	imm32(imm);
+	return at;
+}
+
+void Assembler::add(Reg dst, int32_t imm)
+{
+	rex(true, 0, number(dst));
+	byte(0x81);
+	modrm(0, number(dst));
+	imm32(imm);
+}
+
+void Assembler::neg(Reg reg)
+{
+	rex(true, 0, number(reg));
+	byte(0xF7);
+	modrm(3, number(reg));
+}
+
+void Assembler::btc(Reg reg, uint8_t bit)
+{
+	rex(true, 0, number(reg));
+	byte(0x0F);
+	byte(0xBA);
+	modrm(7, number(reg));
+	byte(bit);
+}
+
+void Assembler::xor_(Reg reg, int8_t imm)
+{
+	rex(true, 0, number(reg));
+	byte(0x83);
+	modrm(6, number(reg));
+	byte(static_cast<uint8_t>(imm));
+}
+
+void Assembler::inc(Reg base, int32_t disp)
+{
+	rex(true, 0, number(base));
+	byte(0xFF);
+	memory(0, base, disp);
+}
+
+void Assembler::dec(Reg base, int32_t disp)
+{
+	rex(true, 0, number(base));
+	byte(0xFF);
+	memory(1, base, disp);
+}
+
+void Assembler::test(Reg left, Reg right)
+{
+	rex(true, number(right), number(left));
+	byte(0x85);
+	modrm(number(right), number(left));
+}
+
+void Assembler::cqo()
+{
+	byte(0x48);
+	byte(0x99);
+}
+
+void Assembler::idiv(Reg divisor)
+{
+	rex(true, 0, number(divisor));
+	byte(0xF7);
+	modrm(7, number(divisor));
+}
+
+// The byte registers below are only used with rax, rcx and rdx, which need no REX prefix
+void Assembler::setcc(Condition condition, Reg dst)
+{
+	byte(0x0F);
+	byte(0x90 | static_cast<uint8_t>(condition));
+	modrm(0, number(dst));
+}
+
+void Assembler::and8(Reg dst, Reg src)
+{
+	byte(0x20);
+	modrm(number(src), number(dst));
+}
+
+void Assembler::or8(Reg dst, Reg src)
+{
+	byte(0x08);
+	modrm(number(src), number(dst));
+}
+
+void Assembler::movzx8(Reg dst, Reg src)
+{
+	byte(0x0F);
+	byte(0xB6);
+	modrm(number(dst), number(src));
+}
+
+void Assembler::cvtsi2sd(Xmm dst, Reg src)
+{
+	sse(0xF2, 0x2A, number(dst), number(src), true);
+}
+
+void Assembler::cvttsd2si(Reg dst, Xmm src)
+{
+	sse(0xF2, 0x2C, number(dst), number(src), true);
+}
+
+void Assembler::addsd(Xmm dst, Xmm src)
+{
+	sse(0xF2, 0x58, number(dst), number(src));
+}
+
+void Assembler::subsd(Xmm dst, Xmm src)
+{
+	sse(0xF2, 0x5C, number(dst), number(src));
+}
+
+void Assembler::mulsd(Xmm dst, Xmm src)
+{
+	sse(0xF2, 0x59, number(dst), number(src));
+}
+
+void Assembler::divsd(Xmm dst, Xmm src)
+{
+	sse(0xF2, 0x5E, number(dst), number(src));
+}
+
+void Assembler::ucomisd(Xmm left, Xmm right)
+{
+	sse(0x66, 0x2E, number(left), number(right));
+}
+
+
+}
\ No newline at end of file
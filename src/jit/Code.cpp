@@ -0,0 +1,45 @@
+#include "jit/Code.h"
+#include <cstring>
+#if LI_JIT_SUPPORTED
+#include <sys/mman.h>
+#endif
+
+namespace li::jit
+{
+
+
+Code::~Code()
+{
+#if LI_JIT_SUPPORTED
+	if (_memory)
+	{
+		munmap(_memory, _size);
+	}
+#endif
+}
+
+bool Code::load(const vector<uint8_t>& bytes)
+{
+#if LI_JIT_SUPPORTED
+	// Pages are never writable and executable at the same time
+	void* memory = mmap(nullptr, bytes.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED)
+	{
+		return false;
+	}
+	memcpy(memory, bytes.data(), bytes.size());
+	if (mprotect(memory, bytes.size(), PROT_READ | PROT_EXEC) != 0)
+	{
+		munmap(memory, bytes.size());
+		return false;
+	}
+	_memory = memory;
+	_size = bytes.size();
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+}
\ No newline at end of file
@@ -0,0 +1,1046 @@
+#include "jit/Compiler.h"
+#include "ast/ExpressionStat.hpp"
+#include "ast/LetStat.hpp"
+#include "ast/VarStat.hpp"
+#include "ast/ReturnStat.hpp"
+#include "ast/IntegerExpr.hpp"
+#include "ast/FloatExpr.hpp"
+#include "ast/BoolExpr.hpp"
+#include "ast/TempExpr.hpp"
+#include "ast/InvariantExpr.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace li::jit
+{
+
+
+static int64_t bits(double value)
+{
+	int64_t result;
+	memcpy(&result, &value, sizeof(result));
+	return result;
+}
+
+shared_ptr<Code> Compiler::compile_function(const Function& fun, const vector<Object::Type>& params)
+{
+	if (params.size() > Code::MAX_OPERANDS)
+	{
+		return nullptr;
+	}
+
+	// Where the function calls itself the type of its result is needed before the body is compiled,
+	// so it is guessed and the body compiled again if a return disagrees
+	for (auto result : { Object::Type::Integer, Object::Type::Float, Object::Type::Bool, Object::Type::Null })
+	{
+		auto code = make_shared<Code>();
+		code->params = params;
+		code->result = result;
+
+		Compiler compiler(*code, [&fun](symbol_t symbol) { return resolve(fun, symbol); }, &fun);
+		compiler.prologue();
+		compiler._scopes.emplace_back();
+
+		const auto& args = fun.args->args;
+		if (args.size() != params.size() || !is_annotated(fun.args->result, result))
+		{
+			return nullptr;
+		}
+		for (size_t i = 0; i < args.size(); i++)
+		{
+			auto& scope = compiler._scopes.back();
+			if (!is_number(params[i]) || !is_annotated(fun.args->annotation(i), params[i]) || scope.count(args[i]->symbol))
+			{
+				return nullptr;
+			}
+
+			// Arguments are copies, mutable and owned by the call
+			Variable param { params[i], true, false, compiler._slots++ };
+			compiler._asm.mov(Reg::Rax, Reg::Rdi, static_cast<int32_t>(8 * (args.size() - 1 - i)));
+			compiler._asm.mov(Reg::Rbp, -16 - static_cast<int32_t>(8 * param.index), Reg::Rax);
+			scope.emplace(args[i]->symbol, param);
+		}
+
+		compiler.statements(fun.body->statements, true);
+		compiler.epilogue();
+
+		if (compiler._supported)
+		{
+			return code->load(compiler._asm.code()) ? code : nullptr;
+		}
+		if (compiler._resultMatches)
+		{
+			return nullptr;
+		}
+	}
+	return nullptr;
+}
+
+shared_ptr<Code> Compiler::compile_loop(const shared_ptr<WhileStat>& loop, const shared_ptr<Environment>& env)
+{
+	auto code = make_shared<Code>();
+	Compiler compiler(*code, [env](symbol_t symbol) {
+		auto* found = env->get(symbol);
+		return found ? *found : nullptr;
+	}, nullptr);
+
+	compiler.prologue();
+	compiler._scopes.emplace_back();
+	compiler.while_(loop);
+	compiler.epilogue();
+
+	if (!compiler._supported)
+	{
+		return nullptr;
+	}
+	return code->load(compiler._asm.code()) ? code : nullptr;
+}
+
+shared_ptr<Object> Compiler::resolve(const Function& fun, symbol_t symbol)
+{
+	// A call frame finds a name in the captures of the function first, then in the scope it was defined in
+	if (fun.captures)
+	{
+		if (auto* found = fun.captures->find(symbol))
+		{
+			return *found;
+		}
+	}
+	auto* found = fun.env ? fun.env->get(symbol) : nullptr;
+	return found ? *found : nullptr;
+}
+
+void Compiler::prologue()
+{
+	_asm.bind(_entry);
+	_asm.push(Reg::Rbp);
+	_asm.mov(Reg::Rbp, Reg::Rsp);
+	_asm.push(Reg::R12);
+	_asm.mov(Reg::R12, Reg::Rsi);
+	_frameSize = _asm.sub(Reg::Rsp, 0);
+}
+
+void Compiler::epilogue()
+{
+	_asm.bind(_exit);
+	_asm.lea(Reg::Rsp, Reg::Rbp, -8);
+	_asm.pop(Reg::R12);
+	_asm.pop(Reg::Rbp);
+	_asm.ret();
+
+	// Slots are below the saved r12, the stack stays 16-byte aligned without pushed values
+	size_t size = 8 * _slots + (_slots % 2 == 0 ? 8 : 0);
+	_asm.patch32(_frameSize, static_cast<int32_t>(size));
+
+	if (_externals.size() > Code::MAX_OPERANDS)
+	{
+		unsupported();
+	}
+	_code.externals.resize(_externals.size());
+	for (const auto& [symbol, variable] : _externals)
+	{
+		_code.externals[variable.index].symbol = symbol;
+		_code.externals[variable.index].type = variable.type;
+		_code.externals[variable.index].assigned = variable.assigned;
+	}
+}
+
+void Compiler::statements(const vector<shared_ptr<Stat>>& statements, bool tail)
+{
+	// The value of an empty block is no object at all, which the templates can not produce
+	if (tail && statements.empty())
+	{
+		unsupported();
+		return;
+	}
+
+	for (size_t i = 0; i < statements.size(); i++)
+	{
+		statement(statements[i], tail && i + 1 == statements.size());
+	}
+}
+
+void Compiler::statement(const shared_ptr<Stat>& stat, bool tail)
+{
+	switch (stat->type)
+	{
+
+	case Node::Type::ExprStat:
+	{
+		auto expr = static_pointer_cast<ExpressionStat>(stat)->expression;
+		if (expr->type == Node::Type::If)
+		{
+			if_(static_pointer_cast<IfExpr>(expr), tail);
+		}
+		else if (tail)
+		{
+			result(expr);
+		}
+		else
+		{
+			value(expr);
+		}
+		return;
+	}
+
+	case Node::Type::Let:
+	{
+		auto cast = static_pointer_cast<LetStat>(stat);
+		declare(cast->name, cast->annotation, cast->value, false);
+		break;
+	}
+
+	case Node::Type::Var:
+	{
+		auto cast = static_pointer_cast<VarStat>(stat);
+		declare(cast->name, cast->annotation, cast->value, true);
+		break;
+	}
+
+	case Node::Type::Return:
+	{
+		auto cast = static_pointer_cast<ReturnStat>(stat);
+		if (!cast->value)
+		{
+			unsupported();
+			return;
+		}
+		if (_loops.empty())
+		{
+			result(cast->value);
+			return;
+		}
+		value(cast->value);
+		_asm.jmp(*_loops.back());
+		return;
+	}
+
+	case Node::Type::Block:
+		statements(static_pointer_cast<BlockStat>(stat)->statements, tail);
+		return;
+
+	case Node::Type::While:
+		while_(static_pointer_cast<WhileStat>(stat));
+		break;
+
+	default:
+		unsupported();
+		return;
+
+	}
+
+	if (tail)
+	{
+		null_result();
+	}
+}
+
+void Compiler::declare(const shared_ptr<IdentifierExpr>& name, Annotation annotation, const shared_ptr<Expr>& value, bool isMutable)
+{
+	// A declaration binds the object of its value, one bound to another name would be shared
+	if (!_declarations || is_reference(value))
+	{
+		unsupported();
+		return;
+	}
+
+	auto type = this->value(value);
+	auto& scope = _scopes.back();
+	if (!is_number(type) || !is_annotated(annotation, type) || scope.count(name->symbol))
+	{
+		unsupported();
+		return;
+	}
+
+	Variable variable { type, isMutable, false, _slots++ };
+	store(variable);
+	scope.emplace(name->symbol, variable);
+}
+
+void Compiler::if_(const shared_ptr<IfExpr>& node, bool tail)
+{
+	Assembler::Label alternative, end;
+	condition(node->condition, alternative);
+
+	// The branches share the enclosing scope, a name declared in one may or may not be bound after
+	bool declarations = _declarations;
+	_declarations = false;
+
+	statements(node->consequence->statements, tail);
+	_asm.jmp(end);
+	_asm.bind(alternative);
+	if (node->alternative)
+	{
+		statements(node->alternative->statements, tail);
+	}
+	else if (tail)
+	{
+		null_result();
+	}
+	_asm.bind(end);
+
+	_declarations = declarations;
+}
+
+void Compiler::while_(const shared_ptr<WhileStat>& node)
+{
+	Assembler::Label head, exit;
+	_asm.bind(head);
+	_outerCondition = !_self && _loops.empty();
+	condition(node->condition, exit);
+	_outerCondition = false;
+
+	// The body is a new scope on every iteration
+	bool declarations = _declarations;
+	_declarations = true;
+	_scopes.emplace_back();
+	_loops.push_back(&head);
+
+	statements(node->body->statements, false);
+
+	_loops.pop_back();
+	_scopes.pop_back();
+	_declarations = declarations;
+
+	_asm.jmp(head);
+	_asm.bind(exit);
+}
+
+void Compiler::condition(const shared_ptr<Expr>& expr, Assembler::Label& otherwise)
+{
+	auto inner = unwrap(expr);
+	if (inner->type == Node::Type::Infix)
+	{
+		const auto& node = static_cast<const InfixExpr&>(*inner);
+		const auto& name = node.operatorName;
+		if (name == "<" || name == "<=" || name == ">" || name == ">=" || name == "==" || name == "!=")
+		{
+			auto [left, right] = operands(node.left, node.right);
+			if (!is_number(left) || !is_number(right))
+			{
+				unsupported();
+				return;
+			}
+
+			// An unordered comparison sets the carry, parity and zero flags, so a NaN compares false
+			if (name == "<" || name == "<=")
+			{
+				_asm.ucomisd(Xmm::Xmm1, Xmm::Xmm0);
+				_asm.jcc(name == "<" ? Condition::BelowEqual : Condition::Below, otherwise);
+			}
+			else if (name == ">" || name == ">=")
+			{
+				_asm.ucomisd(Xmm::Xmm0, Xmm::Xmm1);
+				_asm.jcc(name == ">" ? Condition::BelowEqual : Condition::Below, otherwise);
+			}
+			else if (name == "==")
+			{
+				_asm.ucomisd(Xmm::Xmm0, Xmm::Xmm1);
+				_asm.jcc(Condition::NotEqual, otherwise);
+				_asm.jcc(Condition::Parity, otherwise);
+			}
+			else
+			{
+				Assembler::Label unequal;
+				_asm.ucomisd(Xmm::Xmm0, Xmm::Xmm1);
+				_asm.jcc(Condition::Parity, unequal);
+				_asm.jcc(Condition::Equal, otherwise);
+				_asm.bind(unequal);
+			}
+			return;
+		}
+	}
+
+	// Every object but null and false is true, numbers included
+	switch (value(expr))
+	{
+
+	case Object::Type::Bool:
+		_asm.test(Reg::Rax, Reg::Rax);
+		_asm.jcc(Condition::Equal, otherwise);
+		break;
+
+	case Object::Type::Null:
+		_asm.jmp(otherwise);
+		break;
+
+	default:
+		break;
+
+	}
+}
+
+void Compiler::result(const shared_ptr<Expr>& expr)
+{
+	int flag = result_flag(expr);
+	auto type = value(expr);
+	if (type != _code.result)
+	{
+		_resultMatches = false;
+		unsupported();
+		return;
+	}
+
+	if (type == Object::Type::Float)
+	{
+		_asm.movq(Reg::Rax, Xmm::Xmm0);
+	}
+	if (flag >= 0)
+	{
+		_asm.mov(Reg::Rdx, static_cast<int64_t>(flag));
+	}
+	_asm.jmp(_exit);
+}
+
+void Compiler::null_result()
+{
+	if (_code.result != Object::Type::Null)
+	{
+		_resultMatches = false;
+		unsupported();
+		return;
+	}
+	_asm.jmp(_exit);
+}
+
+// Whether the object a result expression evaluates to is mutable, -1 if the result of a call is
+// returned and with it the flag the call returned
+int Compiler::result_flag(const shared_ptr<Expr>& expr)
+{
+	if (expr->type == Node::Type::Temp && static_pointer_cast<TempExpr>(expr)->reuse)
+	{
+		unsupported();
+		return 0;
+	}
+
+	auto inner = unwrap(expr);
+	const Variable* target = nullptr;
+	switch (inner->type)
+	{
+
+	case Node::Type::Identifier:
+		target = variable(static_pointer_cast<IdentifierExpr>(inner)->symbol);
+		break;
+
+	case Node::Type::InDecrement:
+	{
+		auto id = unwrap(static_pointer_cast<InDecrementExpr>(inner)->id);
+		if (id->type == Node::Type::Identifier)
+		{
+			target = variable(static_pointer_cast<IdentifierExpr>(id)->symbol);
+		}
+		break;
+	}
+
+	case Node::Type::Assign:
+	{
+		auto cast = static_pointer_cast<AssignExpr>(inner);
+		return cast->operatorName == "=" ? result_flag(cast->value) : 0;
+	}
+
+	case Node::Type::Call:
+		return -1;
+
+	default:
+		return 0;
+
+	}
+
+	// The object bound outside would be handed to the caller itself
+	if (!target || target->external)
+	{
+		unsupported();
+		return 0;
+	}
+	return target->isMutable ? 1 : 0;
+}
+
+Object::Type Compiler::value(const shared_ptr<Expr>& expr)
+{
+	auto inner = unwrap(expr);
+	switch (inner->type)
+	{
+
+	case Node::Type::Integer:
+		_asm.mov(Reg::Rax, static_cast<int64_t>(static_pointer_cast<IntegerExpr>(inner)->value));
+		return Object::Type::Integer;
+
+	case Node::Type::Float:
+		_asm.mov(Reg::Rax, bits(static_pointer_cast<FloatExpr>(inner)->value));
+		_asm.movq(Xmm::Xmm0, Reg::Rax);
+		return Object::Type::Float;
+
+	case Node::Type::Bool:
+		_asm.mov(Reg::Rax, static_pointer_cast<BoolExpr>(inner)->value ? 1 : 0);
+		return Object::Type::Bool;
+
+	case Node::Type::Identifier:
+	{
+		auto* found = variable(static_pointer_cast<IdentifierExpr>(inner)->symbol);
+		if (!found)
+		{
+			return unsupported();
+		}
+		load(*found);
+		return found->type;
+	}
+
+	case Node::Type::Prefix:
+		return prefix(static_cast<const PrefixExpr&>(*inner));
+
+	case Node::Type::Infix:
+		return infix(static_cast<const InfixExpr&>(*inner));
+
+	case Node::Type::Assign:
+		return assign(static_cast<const AssignExpr&>(*inner));
+
+	case Node::Type::InDecrement:
+		return in_decrement(static_cast<const InDecrementExpr&>(*inner));
+
+	case Node::Type::Call:
+		return call(static_cast<const CallExpr&>(*inner));
+
+	default:
+		return unsupported();
+
+	}
+}
+
+Object::Type Compiler::prefix(const PrefixExpr& node)
+{
+	auto type = value(node.right);
+	if (node.operatorName == "-")
+	{
+		if (type == Object::Type::Integer)
+		{
+			_asm.neg(Reg::Rax);
+			return type;
+		}
+		if (type == Object::Type::Float)
+		{
+			_asm.movq(Reg::Rax, Xmm::Xmm0);
+			_asm.btc(Reg::Rax, 63);
+			_asm.movq(Xmm::Xmm0, Reg::Rax);
+			return type;
+		}
+	}
+	else if (node.operatorName == "!")
+	{
+		switch (type)
+		{
+
+		case Object::Type::Integer:
+			_asm.test(Reg::Rax, Reg::Rax);
+			_asm.setcc(Condition::Equal, Reg::Rax);
+			_asm.movzx8(Reg::Rax, Reg::Rax);
+			return Object::Type::Bool;
+
+		case Object::Type::Bool:
+			_asm.xor_(Reg::Rax, 1);
+			return Object::Type::Bool;
+
+		case Object::Type::Null:
+			_asm.mov(Reg::Rax, 1);
+			return Object::Type::Bool;
+
+		default:
+			break;
+
+		}
+	}
+	return unsupported();
+}
+
+Object::Type Compiler::infix(const InfixExpr& node)
+{
+	auto [left, right] = operands(node.left, node.right);
+	if (!is_number(left) || !is_number(right))
+	{
+		return unsupported();
+	}
+
+	const auto& name = node.operatorName;
+	if (name.size() == 1 && name != "<" && name != ">")
+	{
+		return arithmetic(name[0], left, right);
+	}
+	return comparison(name);
+}
+
+Object::Type Compiler::assign(const AssignExpr& node)
+{
+	auto id = unwrap(node.id);
+	auto* target = id->type == Node::Type::Identifier ? variable(static_pointer_cast<IdentifierExpr>(id)->symbol) : nullptr;
+	if (!target || (!target->external && !target->isMutable))
+	{
+		return unsupported();
+	}
+	auto variable = *target;
+	mark_assigned(variable);
+
+	// Assigning an object of another type is not defined
+	if (node.operatorName == "=")
+	{
+		auto type = value(node.value);
+		if (type != variable.type)
+		{
+			return unsupported();
+		}
+		store(variable);
+		return type;
+	}
+
+	// The value is evaluated before the object assigned is read, as the evaluator does
+	if (node.operatorName.size() != 2)
+	{
+		return unsupported();
+	}
+	auto type = value(node.value);
+	to_double(type, Xmm::Xmm1);
+	load(variable);
+	to_double(variable.type, Xmm::Xmm0);
+
+	auto combined = arithmetic(node.operatorName[0], variable.type, type);
+	if (combined != variable.type)
+	{
+		return unsupported();
+	}
+	store(variable);
+	return combined;
+}
+
+Object::Type Compiler::in_decrement(const InDecrementExpr& node)
+{
+	auto id = unwrap(node.id);
+	auto* target = id->type == Node::Type::Identifier ? variable(static_pointer_cast<IdentifierExpr>(id)->symbol) : nullptr;
+	if (!target || target->type != Object::Type::Integer || (node.operatorName != "++" && node.operatorName != "--"))
+	{
+		return unsupported();
+	}
+	auto variable = *target;
+	if (variable.external)
+	{
+		_code.mutates = true;
+	}
+
+	// Incremented in place without going through doubles, mutability is not checked
+	auto [base, disp] = address(variable);
+	if (node.operatorName == "++")
+	{
+		_asm.inc(base, disp);
+	}
+	else
+	{
+		_asm.dec(base, disp);
+	}
+	_asm.mov(Reg::Rax, base, disp);
+	return Object::Type::Integer;
+}
+
+Object::Type Compiler::call(const CallExpr& node)
+{
+	// Only calls of the function compiled are direct, the name is guarded to still be bound to it
+	auto callee = unwrap(node.fun);
+	if (!_self || callee->type != Node::Type::Identifier)
+	{
+		return unsupported();
+	}
+	auto symbol = static_pointer_cast<IdentifierExpr>(callee)->symbol;
+	if (lookup_local(symbol) || (_code.self != SymbolTable::None && _code.self != symbol) || _resolve(symbol).get() != _self)
+	{
+		return unsupported();
+	}
+	_code.self = symbol;
+
+	const auto& args = node.exprs->expressions;
+	if (args.size() != _code.params.size())
+	{
+		return unsupported();
+	}
+
+	// Arguments are copied once all are evaluated, an argument bound to a name must not change after
+	for (size_t i = 0; i < args.size(); i++)
+	{
+		if (is_reference(args[i]) && any_of(args.begin() + i + 1, args.end(), [this](const auto& arg) { return has_effects(arg); }))
+		{
+			return unsupported();
+		}
+	}
+
+	for (size_t i = 0; i < args.size(); i++)
+	{
+		auto type = value(args[i]);
+		if (type != _code.params[i])
+		{
+			return unsupported();
+		}
+		if (type == Object::Type::Float)
+		{
+			_asm.movq(Reg::Rax, Xmm::Xmm0);
+		}
+		_asm.push(Reg::Rax);
+		_depth++;
+	}
+
+	size_t padding = _depth % 2;
+	_asm.mov(Reg::Rdi, Reg::Rsp);
+	if (padding)
+	{
+		_asm.sub(Reg::Rsp, 8);
+	}
+	_asm.mov(Reg::Rsi, Reg::R12);
+	_asm.call(_entry);
+	_asm.add(Reg::Rsp, static_cast<int32_t>(8 * (args.size() + padding)));
+	_depth -= args.size();
+
+	if (_code.result == Object::Type::Float)
+	{
+		_asm.movq(Xmm::Xmm0, Reg::Rax);
+	}
+	return _code.result;
+}
+
+pair<Object::Type, Object::Type> Compiler::operands(const shared_ptr<Expr>& left, const shared_ptr<Expr>& right)
+{
+	// The evaluator reads the object of a name only when it combines both operands, after the right
+	// one may have changed it
+	if (is_reference(left) && has_effects(right))
+	{
+		if (unwrap(left)->type != Node::Type::Identifier)
+		{
+			return { unsupported(), Object::Type::Null };
+		}
+		auto rightType = value(right);
+		to_double(rightType, Xmm::Xmm1);
+		auto leftType = load_double(left, Xmm::Xmm0);
+		return { leftType, rightType };
+	}
+
+	auto leftType = value(left);
+	to_double(leftType, Xmm::Xmm0);
+
+	auto inner = unwrap(right);
+	if (inner->type == Node::Type::Identifier || inner->type == Node::Type::Integer || inner->type == Node::Type::Float)
+	{
+		return { leftType, load_double(right, Xmm::Xmm1) };
+	}
+
+	_asm.movq(Reg::Rax, Xmm::Xmm0);
+	_asm.push(Reg::Rax);
+	_depth++;
+	auto rightType = value(right);
+	to_double(rightType, Xmm::Xmm1);
+	_asm.pop(Reg::Rax);
+	_depth--;
+	_asm.movq(Xmm::Xmm0, Reg::Rax);
+	return { leftType, rightType };
+}
+
+Object::Type Compiler::arithmetic(char operatorName, Object::Type left, Object::Type right)
+{
+	bool integer = left == Object::Type::Integer && right == Object::Type::Integer;
+	switch (operatorName)
+	{
+
+	case '+': _asm.addsd(Xmm::Xmm0, Xmm::Xmm1); break;
+	case '-': _asm.subsd(Xmm::Xmm0, Xmm::Xmm1); break;
+	case '*': _asm.mulsd(Xmm::Xmm0, Xmm::Xmm1); break;
+	case '/': _asm.divsd(Xmm::Xmm0, Xmm::Xmm1); break;
+
+	case '%':
+		// Both operands are truncated to integers, a remainder of two floats is an error
+		if (left == Object::Type::Float && right == Object::Type::Float)
+		{
+			return unsupported();
+		}
+		_asm.cvttsd2si(Reg::Rax, Xmm::Xmm0);
+		_asm.cvttsd2si(Reg::Rcx, Xmm::Xmm1);
+		_asm.cqo();
+		_asm.idiv(Reg::Rcx);
+		_asm.mov(Reg::Rax, Reg::Rdx);
+		return Object::Type::Integer;
+
+	default:
+		return unsupported();
+
+	}
+
+	if (integer)
+	{
+		_asm.cvttsd2si(Reg::Rax, Xmm::Xmm0);
+		return Object::Type::Integer;
+	}
+	return Object::Type::Float;
+}
+
+Object::Type Compiler::comparison(const string& operatorName)
+{
+	if (operatorName == "<" || operatorName == "<=")
+	{
+		_asm.ucomisd(Xmm::Xmm1, Xmm::Xmm0);
+		_asm.setcc(operatorName == "<" ? Condition::Above : Condition::AboveEqual, Reg::Rax);
+	}
+	else if (operatorName == ">" || operatorName == ">=")
+	{
+		_asm.ucomisd(Xmm::Xmm0, Xmm::Xmm1);
+		_asm.setcc(operatorName == ">" ? Condition::Above : Condition::AboveEqual, Reg::Rax);
+	}
+	else if (operatorName == "==")
+	{
+		_asm.ucomisd(Xmm::Xmm0, Xmm::Xmm1);
+		_asm.setcc(Condition::Equal, Reg::Rax);
+		_asm.setcc(Condition::NotParity, Reg::Rcx);
+		_asm.and8(Reg::Rax, Reg::Rcx);
+	}
+	else if (operatorName == "!=")
+	{
+		_asm.ucomisd(Xmm::Xmm0, Xmm::Xmm1);
+		_asm.setcc(Condition::NotEqual, Reg::Rax);
+		_asm.setcc(Condition::Parity, Reg::Rcx);
+		_asm.or8(Reg::Rax, Reg::Rcx);
+	}
+	else
+	{
+		return unsupported();
+	}
+	_asm.movzx8(Reg::Rax, Reg::Rax);
+	return Object::Type::Bool;
+}
+
+void Compiler::to_double(Object::Type type, Xmm dst)
+{
+	if (type == Object::Type::Integer)
+	{
+		_asm.cvtsi2sd(dst, Reg::Rax);
+	}
+	else if (type == Object::Type::Float)
+	{
+		if (dst != Xmm::Xmm0)
+		{
+			_asm.movq(Reg::Rax, Xmm::Xmm0);
+			_asm.movq(dst, Reg::Rax);
+		}
+	}
+	else
+	{
+		unsupported();
+	}
+}
+
+// Loads a name or a literal converted to a double without touching xmm0 or rax
+Object::Type Compiler::load_double(const shared_ptr<Expr>& expr, Xmm dst)
+{
+	auto inner = unwrap(expr);
+	if (inner->type == Node::Type::Integer || inner->type == Node::Type::Float)
+	{
+		bool integer = inner->type == Node::Type::Integer;
+		double value = integer ? static_cast<int64_t>(static_pointer_cast<IntegerExpr>(inner)->value) : static_pointer_cast<FloatExpr>(inner)->value;
+		_asm.mov(Reg::Rcx, bits(value));
+		_asm.movq(dst, Reg::Rcx);
+		return integer ? Object::Type::Integer : Object::Type::Float;
+	}
+
+	auto* found = inner->type == Node::Type::Identifier ? variable(static_pointer_cast<IdentifierExpr>(inner)->symbol) : nullptr;
+	if (!found)
+	{
+		return unsupported();
+	}
+	auto [base, disp] = address(*found);
+	if (found->type == Object::Type::Integer)
+	{
+		_asm.mov(Reg::Rcx, base, disp);
+		_asm.cvtsi2sd(dst, Reg::Rcx);
+	}
+	else
+	{
+		_asm.movsd(dst, base, disp);
+	}
+	return found->type;
+}
+
+const Compiler::Variable* Compiler::lookup_local(symbol_t symbol) const
+{
+	for (auto it = _scopes.rbegin(); it != _scopes.rend(); ++it)
+	{
+		auto found = it->find(symbol);
+		if (found != it->end())
+		{
+			return &found->second;
+		}
+	}
+	return nullptr;
+}
+
+// A name not declared by the code so far is bound outside of it, to an object that has to be a number
+const Compiler::Variable* Compiler::variable(symbol_t symbol)
+{
+	if (auto* local = lookup_local(symbol))
+	{
+		return local;
+	}
+
+	auto found = _externals.find(symbol);
+	if (found != _externals.end())
+	{
+		return &found->second;
+	}
+
+	auto object = _resolve(symbol);
+	if (!object || !is_number(object->type))
+	{
+		unsupported();
+		return nullptr;
+	}
+	return &_externals.emplace(symbol, Variable { object->type, true, true, _externals.size() }).first->second;
+}
+
+pair<Reg, int32_t> Compiler::address(const Variable& variable)
+{
+	if (variable.external)
+	{
+		_asm.mov(Reg::Rcx, Reg::R12, static_cast<int32_t>(8 * variable.index));
+		return { Reg::Rcx, 0 };
+	}
+	return { Reg::Rbp, -16 - static_cast<int32_t>(8 * variable.index) };
+}
+
+void Compiler::load(const Variable& variable)
+{
+	auto [base, disp] = address(variable);
+	if (variable.type == Object::Type::Float)
+	{
+		_asm.movsd(Xmm::Xmm0, base, disp);
+	}
+	else
+	{
+		_asm.mov(Reg::Rax, base, disp);
+	}
+}
+
+void Compiler::store(const Variable& variable)
+{
+	auto [base, disp] = address(variable);
+	if (variable.type == Object::Type::Float)
+	{
+		_asm.movsd(base, disp, Xmm::Xmm0);
+	}
+	else
+	{
+		_asm.mov(base, disp, Reg::Rax);
+	}
+}
+
+void Compiler::mark_assigned(const Variable& variable)
+{
+	if (!variable.external)
+	{
+		return;
+	}
+
+	_code.mutates = true;
+	for (auto& [symbol, external] : _externals)
+	{
+		if (external.index == variable.index)
+		{
+			external.assigned = true;
+		}
+	}
+}
+
+// Temps and invariants only save evaluations, their expressions compute the same values again. The
+// code after a loop may read a temp stored by its condition, which compiled code would leave unset.
+shared_ptr<Expr> Compiler::unwrap(shared_ptr<Expr> expr)
+{
+	while (true)
+	{
+		if (expr->type == Node::Type::Temp)
+		{
+			auto cast = static_pointer_cast<TempExpr>(expr);
+			if (!cast->reuse && _outerCondition)
+			{
+				unsupported();
+			}
+			expr = cast->expr;
+		}
+		else if (expr->type == Node::Type::Invariant)
+		{
+			expr = static_pointer_cast<InvariantExpr>(expr)->expr;
+		}
+		else
+		{
+			return expr;
+		}
+	}
+}
+
+// Whether expr evaluates to an object bound to a name, rather than to a new one
+bool Compiler::is_reference(const shared_ptr<Expr>& expr)
+{
+	// A reused temp is the very object the first evaluation produced
+	if (expr->type == Node::Type::Temp && static_pointer_cast<TempExpr>(expr)->reuse)
+	{
+		return true;
+	}
+
+	auto inner = unwrap(expr);
+	switch (inner->type)
+	{
+	case Node::Type::Identifier:
+	case Node::Type::InDecrement:
+		return true;
+	case Node::Type::Assign:
+	{
+		auto cast = static_pointer_cast<AssignExpr>(inner);
+		return cast->operatorName == "=" && is_reference(cast->value);
+	}
+	default:
+		return false;
+	}
+}
+
+bool Compiler::has_effects(const shared_ptr<Expr>& expr)
+{
+	auto inner = unwrap(expr);
+	switch (inner->type)
+	{
+	case Node::Type::InDecrement:
+	case Node::Type::Assign:
+	case Node::Type::Call:
+		return true;
+	case Node::Type::Prefix:
+		return has_effects(static_pointer_cast<PrefixExpr>(inner)->right);
+	case Node::Type::Infix:
+	{
+		auto cast = static_pointer_cast<InfixExpr>(inner);
+		return has_effects(cast->left) || has_effects(cast->right);
+	}
+	default:
+		return false;
+	}
+}
+
+bool Compiler::is_number(Object::Type type)
+{
+	return type == Object::Type::Integer || type == Object::Type::Float;
+}
+
+bool Compiler::is_annotated(Annotation annotation, Object::Type type)
+{
+	switch (annotation)
+	{
+	case Annotation::None: return true;
+	case Annotation::Integer: return type == Object::Type::Integer;
+	case Annotation::Float: return type == Object::Type::Float;
+	case Annotation::Bool: return type == Object::Type::Bool;
+	default: return false;
+	}
+}
+
+Object::Type Compiler::unsupported()
+{
+	_supported = false;
+	return Object::Type::Null;
+}
+
+
+}
@@ -0,0 +1,184 @@
+#include "jit/Jit.h"
+#include "jit/Compiler.h"
+#include "evaluator/Evaluator.h"
+#include "object/Integer.hpp"
+#include "object/Float.hpp"
+#include <cstring>
+
+namespace li::jit
+{
+
+
+shared_ptr<Object> Jit::call(const Function& fun, const vector<shared_ptr<Object>>& args)
+{
+	if (!fun.node)
+	{
+		return nullptr;
+	}
+
+	auto& profile = fun.node->profile;
+	if (!profile.code)
+	{
+		if (profile.rejected || ++profile.hotness < _threshold)
+		{
+			return nullptr;
+		}
+
+		vector<Object::Type> params;
+		for (const auto& arg : args)
+		{
+			params.push_back(arg->type);
+		}
+		profile.code = Compiler::compile_function(fun, params);
+		if (!profile.code)
+		{
+			profile.rejected = true;
+			return nullptr;
+		}
+		_stats.compiledFunctions++;
+	}
+
+	// The guards: the types of the arguments and of the objects the names resolve to, and the
+	// name the function calls itself by still being bound to it
+	const auto& code = *profile.code;
+	bool matches = args.size() == code.params.size();
+	for (size_t i = 0; matches && i < args.size(); i++)
+	{
+		matches = args[i]->type == code.params[i];
+	}
+
+	void* externals[Code::MAX_OPERANDS];
+	auto resolve = [&fun](symbol_t symbol) { return Compiler::resolve(fun, symbol); };
+	if (!matches || !bind(code, resolve, externals) || (code.self != SymbolTable::None && resolve(code.self).get() != &fun))
+	{
+		_stats.bailouts++;
+		return nullptr;
+	}
+
+	uint64_t values[Code::MAX_OPERANDS];
+	for (size_t i = 0; i < args.size(); i++)
+	{
+		values[args.size() - 1 - i] = bits(*args[i]);
+	}
+
+	_stats.entries++;
+	_mutated = code.mutates;
+	return box(code.result, code.run(values, externals));
+}
+
+bool Jit::run_loop(const shared_ptr<WhileStat>& loop, const shared_ptr<Environment>& env, FunctionExpr* running)
+{
+	auto& profile = loop->profile;
+	if (!profile.code)
+	{
+		if (profile.rejected)
+		{
+			return false;
+		}
+
+		// A function spending its time in a loop is hot as well
+		if (running && !running->profile.code && !running->profile.rejected && running->profile.hotness < _threshold)
+		{
+			running->profile.hotness++;
+		}
+		if (++profile.hotness < _threshold)
+		{
+			return false;
+		}
+
+		profile.code = Compiler::compile_loop(loop, env);
+		if (!profile.code)
+		{
+			profile.rejected = true;
+			return false;
+		}
+		_stats.compiledLoops++;
+	}
+
+	void* externals[Code::MAX_OPERANDS];
+	auto resolve = [&env](symbol_t symbol) {
+		auto* found = env->get(symbol);
+		return found ? *found : nullptr;
+	};
+	if (!bind(*profile.code, resolve, externals))
+	{
+		_stats.bailouts++;
+		return false;
+	}
+
+	_stats.entries++;
+	_mutated = profile.code->mutates;
+	profile.code->run(nullptr, externals);
+	return true;
+}
+
+bool Jit::bind(const Code& code, const function<shared_ptr<Object>(symbol_t)>& resolve, void** externals)
+{
+	for (size_t i = 0; i < code.externals.size(); i++)
+	{
+		const auto& external = code.externals[i];
+		auto object = resolve(external.symbol);
+		if (!object || object->type != external.type || (external.assigned && !object->isMutable))
+		{
+			return false;
+		}
+
+		// The code reads and writes the value in place, the object stays alive in its scope
+		if (object->type == Object::Type::Integer)
+		{
+			externals[i] = &static_cast<Integer&>(*object).value;
+		}
+		else
+		{
+			externals[i] = &static_cast<Float&>(*object).value;
+		}
+	}
+	return true;
+}
+
+uint64_t Jit::bits(const Object& object)
+{
+	uint64_t result = 0;
+	if (object.type == Object::Type::Integer)
+	{
+		result = static_cast<uint64_t>(static_cast<const Integer&>(object).value);
+	}
+	else if (object.type == Object::Type::Float)
+	{
+		memcpy(&result, &static_cast<const Float&>(object).value, sizeof(result));
+	}
+	return result;
+}
+
+shared_ptr<Object> Jit::box(Object::Type type, const Code::Result& result)
+{
+	switch (type)
+	{
+
+	case Object::Type::Integer:
+	{
+		auto integer = make_shared<Integer>(static_cast<int64_t>(result.value));
+		integer->isMutable = result.isMutable;
+		return integer;
+	}
+
+	case Object::Type::Float:
+	{
+		double value;
+		memcpy(&value, &result.value, sizeof(value));
+		auto number = make_shared<Float>(value);
+		number->isMutable = result.isMutable;
+		return number;
+	}
+
+	case Object::Type::Bool:
+		return result.value ? Evaluator::bool_true : Evaluator::bool_false;
+
+	default:
+		return Evaluator::null;
+
+	}
+}
+
+
+}
\ No newline at end of file
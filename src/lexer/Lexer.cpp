@@ -46,6 +46,10 @@ shared_ptr<Token> Lexer::parseToken()
 		token = make_shared<Token>(";", Token::Semicolon);
 		break;
 
+	case ':':
+		token = make_shared<Token>(":", Token::Colon);
+		break;
+
 	case '=':
 		if (_pos + 1 < _input.size() && _input.at(_pos + 1) == '=')
 		{
@@ -185,12 +189,26 @@ shared_ptr<Token> Lexer::parseToken()
 		token = make_shared<Token>("]", Token::RBracket);
 		break;
 
+	case '.':
+		if (_pos + 1 < _input.size() && _input.at(_pos + 1) == '.')
+		{
+			token = make_shared<Token>("..", Token::Range);
+			_pos += 2;
+		}
+		else
+		{
+			token = make_shared<Token>(".", Token::Illegal);
+			_pos++;
+		}
+		return token;
+
 	default:
 		if (isalpha(_input.at(_pos)) || _input.at(_pos) == '_')
 		{
 			// identifier or keyword
 			auto id = read_identifier();
-			token = make_shared<Token>(id, lookup_id(id));
+			auto type = lookup_id(id);
+			token = make_shared<Token>(id, type, type == Token::Identifier ? SymbolTable::intern(id) : SymbolTable::None);
 		}
 		else if (isdigit(_input.at(_pos)))
 		{
@@ -247,7 +265,12 @@ tuple<string, Token::Type> Lexer::read_number()
 	bool isFloat = false;
     while (_pos < _input.size() && (isdigit(_input.at(_pos)) || _input.at(_pos) == '.'))
     {
-		if (_input.at(_pos) == '.') isFloat = true;
+		if (_input.at(_pos) == '.')
+		{
+			// The dots of a range such as 0..n end the number
+			if (_pos + 1 < _input.size() && _input.at(_pos + 1) == '.') break;
+			isFloat = true;
+		}
 
         number += _input.at(_pos);
         _pos++;
@@ -0,0 +1,44 @@
+#include "lexer/SymbolTable.h"
+
+namespace li
+{
+
+
+unordered_map<string, symbol_t>& SymbolTable::symbols()
+{
+	static unordered_map<string, symbol_t> symbols = { { "", None } };
+	return symbols;
+}
+
+deque<string>& SymbolTable::names()
+{
+	static deque<string> names = { "" };
+	return names;
+}
+
+symbol_t SymbolTable::intern(const string& name)
+{
+	auto [it, inserted] = symbols().try_emplace(name, static_cast<symbol_t>(names().size()));
+	if (inserted)
+	{
+		names().push_back(name);
+	}
+	return it->second;
+}
+
+const string& SymbolTable::name(symbol_t symbol)
+{
+	if (symbol >= names().size())
+	{
+		return names().front();
+	}
+	return names().at(symbol);
+}
+
+size_t SymbolTable::size()
+{
+	return names().size();
+}
+
+
+}
\ No newline at end of file
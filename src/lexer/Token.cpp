@@ -11,6 +11,7 @@ const map<Token::Type, string> Token::typeNames =
 	{ Identifier,		"identifier"},
 	{ Semicolon,		"semicolon(\";\")"},
 	{ Comma,			"comma(\",\")"},
+	{ Colon,			"colon(\":\")"},
 	{ LParen,			"left_parenthese(\"(\")"},
 	{ RParen,			"right_parenthese(\")\")"},
 	{ LBrace,			"left_brace(\"{\")"},
@@ -18,6 +19,7 @@ const map<Token::Type, string> Token::typeNames =
 	{ DoubleQuotes,		"double_quotes(\")" },
 	{ LBracket,			"left_bracket(\"[\")" },
 	{ RBracket,			"right_bracket(\"]\")" },
+	{ Range,			"range(\"..\")" },
 
 	{ Integer,			"integer" },
 	{ String,			"string" },
@@ -50,7 +52,9 @@ const map<Token::Type, string> Token::typeNames =
 	{ If,				"if" },
 	{ Else,				"else" },
 	{ Return,			"return" },
-	{ While,			"while" }
+	{ While,			"while" },
+	{ For,				"for" },
+	{ In,				"in" }
 };
 
 
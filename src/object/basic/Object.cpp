@@ -13,7 +13,9 @@ const map<Object::Type, string> Object::typeNames = {
 	{ Type::Function,	"function" },
 	{ Type::String,		"string" },
 	{ Type::BuiltinFun,	"builtin_fun" },
-	{ Type::Array,		"array" }
+	{ Type::Array,		"array" },
+	{ Type::Map,		"map" },
+	{ Type::OrderedMap,"ordered_map" }
 };
 
 
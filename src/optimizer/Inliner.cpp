@@ -0,0 +1,556 @@
+#include "optimizer/Inliner.h"
+#include "analysis/Traversal.h"
+#include "evaluator/Evaluator.h"
+#include "evaluator/BuiltinFuns.h"
+#include "ast/IntegerExpr.hpp"
+#include "ast/FloatExpr.hpp"
+#include "ast/BoolExpr.hpp"
+#include "ast/StringExpr.hpp"
+#include "ast/PrefixExpr.hpp"
+#include "ast/InfixExpr.hpp"
+#include "ast/ArrayExpr.hpp"
+#include "ast/MapExpr.hpp"
+#include "ast/IndexExpr.hpp"
+#include "ast/SliceExpr.hpp"
+#include "ast/VarStat.hpp"
+#include "ast/ForStat.hpp"
+#include "ast/ReturnStat.hpp"
+#include "ast/ExpressionStat.hpp"
+#include "ast/FunctionExpr.hpp"
+
+namespace li
+{
+
+
+void Inliner::run(shared_ptr<Program> program)
+{
+	Context context;
+	context.program = ++_runs;
+	for (const auto& statement : program->statements)
+	{
+		if (!statement) continue;
+
+		if (statement->type == Node::Type::Let)
+		{
+			context.topLevel[static_pointer_cast<LetStat>(statement)->name->symbol]++;
+		}
+		if (statement->type == Node::Type::Var)
+		{
+			context.topLevel[static_pointer_cast<VarStat>(statement)->name->symbol]++;
+		}
+		scan(statement, context);
+	}
+	_poisoned.insert(context.valueUses.begin(), context.valueUses.end());
+
+	// A function only becomes a candidate after its definition, calls that precede it keep failing
+	for (const auto& statement : program->statements)
+	{
+		if (!statement) continue;
+
+		unordered_set<symbol_t> expanded;
+		inline_calls(statement, context, expanded);
+		if (statement->type == Node::Type::Let)
+		{
+			try_register(static_pointer_cast<LetStat>(statement), context, expanded);
+		}
+	}
+}
+
+void Inliner::scan(const shared_ptr<Node>& node, Context& context)
+{
+	switch (node->type)
+	{
+
+	case Node::Type::Identifier:
+		context.valueUses.insert(static_pointer_cast<IdentifierExpr>(node)->symbol);
+		return;
+
+	case Node::Type::Let:
+		context.declarations[static_pointer_cast<LetStat>(node)->name->symbol]++;
+		break;
+
+	case Node::Type::Var:
+		context.declarations[static_pointer_cast<VarStat>(node)->name->symbol]++;
+		break;
+
+	case Node::Type::For:
+		context.declarations[static_pointer_cast<ForStat>(node)->name->symbol]++;
+		break;
+
+	case Node::Type::Function:
+	{
+		auto cast = static_pointer_cast<FunctionExpr>(node);
+		for (const auto& arg : cast->args->args)
+		{
+			context.declarations[arg->symbol]++;
+		}
+		break;
+	}
+
+	case Node::Type::Call:
+	{
+		// Calling a function by name is the only use that can not observe or change the function object
+		auto cast = static_pointer_cast<CallExpr>(node);
+		if (cast->fun->type == Node::Type::Identifier)
+		{
+			if (cast->exprs) scan(cast->exprs, context);
+			return;
+		}
+		break;
+	}
+
+	default:
+		break;
+
+	}
+
+	for_each_child(node, [&](const shared_ptr<Node>& child) { scan(child, context); });
+}
+
+void Inliner::inline_calls(const shared_ptr<Node>& node, Context& context, unordered_set<symbol_t>& expanded)
+{
+	// Arguments are handled first, so an expansion is never visited again
+	for_each_child(node, [&](const shared_ptr<Node>& child) { inline_calls(child, context, expanded); });
+	for_each_expr_slot(node, [&](shared_ptr<Expr>& slot)
+	{
+		if (slot->type != Node::Type::Call) return;
+
+		auto expansion = expand(static_pointer_cast<CallExpr>(slot), context, expanded);
+		if (expansion)
+		{
+			slot = expansion;
+		}
+	});
+}
+
+shared_ptr<Expr> Inliner::expand(const shared_ptr<CallExpr>& call, Context& context, unordered_set<symbol_t>& expanded)
+{
+	if (call->fun->type != Node::Type::Identifier || !call->exprs)
+	{
+		return nullptr;
+	}
+
+	auto symbol = static_pointer_cast<IdentifierExpr>(call->fun)->symbol;
+	auto it = _candidates.find(symbol);
+	if (it == _candidates.end())
+	{
+		return nullptr;
+	}
+
+	const auto& candidate = it->second;
+	const auto& args = call->exprs->expressions;
+	if (args.size() != candidate.args.size() || !usable(symbol, candidate, context))
+	{
+		return nullptr;
+	}
+
+	// An argument other than a literal must still be evaluated exactly once, in the original order
+	// and before anything in the body that could fail or have a side effect
+	vector<size_t> counts(args.size());
+	size_t next = 0;
+	for (const auto& use : candidate.uses)
+	{
+		counts[use.arg]++;
+		if (is_literal(args.at(use.arg))) continue;
+
+		if (use.afterEffect || use.arg < next)
+		{
+			return nullptr;
+		}
+		next = use.arg + 1;
+	}
+	for (size_t i = 0; i < args.size(); i++)
+	{
+		if (!is_literal(args.at(i)) && counts[i] != 1)
+		{
+			return nullptr;
+		}
+	}
+
+	unordered_map<symbol_t, shared_ptr<Expr>> substitutions;
+	for (size_t i = 0; i < args.size(); i++)
+	{
+		substitutions[candidate.args.at(i)] = args.at(i);
+	}
+
+	expanded.insert(symbol);
+	expanded.insert(candidate.expanded.begin(), candidate.expanded.end());
+	_inlined++;
+	return clone(candidate.body, substitutions);
+}
+
+void Inliner::try_register(const shared_ptr<LetStat>& let, Context& context, const unordered_set<symbol_t>& expanded)
+{
+	auto symbol = let->name->symbol;
+	if (let->value->type != Node::Type::Function)
+	{
+		return;
+	}
+
+	// A name defined by several programs is ambiguous across them
+	if (_candidates.count(symbol))
+	{
+		_candidates.erase(symbol);
+		_poisoned.insert(symbol);
+		return;
+	}
+
+	// Only a body made of a single expression can replace a call expression
+	auto fun = static_pointer_cast<FunctionExpr>(let->value);
+	if (fun->body->statements.size() != 1 || !fun->body->statements.front())
+	{
+		return;
+	}
+
+	shared_ptr<Expr> body;
+	auto statement = fun->body->statements.front();
+	if (statement->type == Node::Type::ExprStat)
+	{
+		body = static_pointer_cast<ExpressionStat>(statement)->expression;
+	}
+	if (statement->type == Node::Type::Return)
+	{
+		body = static_pointer_cast<ReturnStat>(statement)->value;
+	}
+	if (!body)
+	{
+		return;
+	}
+
+	Candidate candidate;
+	candidate.program = context.program;
+	candidate.body = body;
+	candidate.expanded = expanded;
+
+	unordered_map<symbol_t, size_t> args;
+	for (const auto& arg : fun->args->args)
+	{
+		if (!args.emplace(arg->symbol, candidate.args.size()).second)
+		{
+			return;
+		}
+		candidate.args.push_back(arg->symbol);
+	}
+
+	bool effect = false;
+	size_t size = 0;
+	if (!check_body(body, args, candidate, effect, size) || size > _threshold)
+	{
+		return;
+	}
+	if (candidate.names.count(symbol) || candidate.expanded.count(symbol) || !usable(symbol, candidate, context))
+	{
+		return;
+	}
+
+	_candidates.emplace(symbol, move(candidate));
+}
+
+bool Inliner::check_body(const shared_ptr<Expr>& node, const unordered_map<symbol_t, size_t>& args, Candidate& candidate, bool& effect, size_t& size)
+{
+	size++;
+	switch (node->type)
+	{
+
+	case Node::Type::Integer:
+	case Node::Type::Float:
+	case Node::Type::Bool:
+	case Node::Type::String:
+		return true;
+
+	case Node::Type::Identifier:
+	{
+		// Arguments are copied when a function is called, so they may only be passed on to other calls,
+		// which copy them again or leave them untouched, see Call
+		auto cast = static_pointer_cast<IdentifierExpr>(node);
+		if (args.count(cast->symbol))
+		{
+			return false;
+		}
+
+		// Looking up a name that is not a builtin fails if it has not been declared yet
+		candidate.names.insert(cast->symbol);
+		if (!Evaluator::builtinFuns.count(cast->value))
+		{
+			effect = true;
+		}
+		return true;
+	}
+
+	case Node::Type::Prefix:
+	{
+		auto cast = static_pointer_cast<PrefixExpr>(node);
+		if (!check_body(cast->right, args, candidate, effect, size))
+		{
+			return false;
+		}
+		effect = true;
+		return true;
+	}
+
+	case Node::Type::Infix:
+	{
+		auto cast = static_pointer_cast<InfixExpr>(node);
+		if (!check_body(cast->left, args, candidate, effect, size) || !check_body(cast->right, args, candidate, effect, size))
+		{
+			return false;
+		}
+		effect = true;
+		return true;
+	}
+
+	case Node::Type::Index:
+	{
+		auto cast = static_pointer_cast<IndexExpr>(node);
+		if (!check_body(cast->left, args, candidate, effect, size) || !check_body(cast->index, args, candidate, effect, size))
+		{
+			return false;
+		}
+		effect = true;
+		return true;
+	}
+
+	case Node::Type::Slice:
+	{
+		auto cast = static_pointer_cast<SliceExpr>(node);
+		for (const auto& child : { cast->left, cast->from, cast->to })
+		{
+			if (child && !check_body(child, args, candidate, effect, size))
+			{
+				return false;
+			}
+		}
+		effect = true;
+		return true;
+	}
+
+	case Node::Type::Array:
+	{
+		auto cast = static_pointer_cast<ArrayExpr>(node);
+		for (const auto& element : cast->elements->expressions)
+		{
+			if (!check_body(element, args, candidate, effect, size))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	case Node::Type::Map:
+	{
+		auto cast = static_pointer_cast<MapExpr>(node);
+		for (const auto& entry : cast->entries->expressions)
+		{
+			if (!check_body(entry, args, candidate, effect, size))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	case Node::Type::Call:
+	{
+		auto cast = static_pointer_cast<CallExpr>(node);
+		if (!check_body(cast->fun, args, candidate, effect, size))
+		{
+			return false;
+		}
+
+		// Inlined, a builtin changing an argument would change the object of the caller instead of
+		// the copy the function was given
+		bool changes = cast->fun->type == Node::Type::Identifier &&
+			BuiltinFuns::changes_arguments(static_pointer_cast<IdentifierExpr>(cast->fun)->value);
+		for (const auto& arg : cast->exprs->expressions)
+		{
+			if (arg->type == Node::Type::Identifier)
+			{
+				auto found = args.find(static_pointer_cast<IdentifierExpr>(arg)->symbol);
+				if (found != args.end() && changes)
+				{
+					return false;
+				}
+				if (found != args.end())
+				{
+					candidate.uses.push_back({ found->second, effect });
+					size++;
+					continue;
+				}
+			}
+			if (!check_body(arg, args, candidate, effect, size))
+			{
+				return false;
+			}
+		}
+		effect = true;
+		return true;
+	}
+
+	default:
+		return false;
+
+	}
+}
+
+bool Inliner::resolves_same(symbol_t symbol, const Candidate& candidate, const Context& context) const
+{
+	auto count = [&](const unordered_map<symbol_t, size_t>& counts)
+	{
+		auto it = counts.find(symbol);
+		return it == counts.end() ? 0 : it->second;
+	};
+
+	// The body resolves names in the global scope of the program defining it, so the call site must
+	// not see any other declaration of them
+	size_t global = candidate.program == context.program ? count(context.topLevel) : 0;
+	return global <= 1 && count(context.declarations) == global;
+}
+
+bool Inliner::usable(symbol_t symbol, const Candidate& candidate, const Context& context) const
+{
+	if (_poisoned.count(symbol) || !resolves_same(symbol, candidate, context))
+	{
+		return false;
+	}
+	for (auto name : candidate.expanded)
+	{
+		if (_poisoned.count(name) || !resolves_same(name, candidate, context))
+		{
+			return false;
+		}
+	}
+	for (auto name : candidate.names)
+	{
+		if (!resolves_same(name, candidate, context))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+shared_ptr<Expr> Inliner::clone(const shared_ptr<Expr>& node, const unordered_map<symbol_t, shared_ptr<Expr>>& args)
+{
+	switch (node->type)
+	{
+
+	case Node::Type::Integer:
+		return make_shared<IntegerExpr>(*static_pointer_cast<IntegerExpr>(node));
+
+	case Node::Type::Float:
+		return make_shared<FloatExpr>(*static_pointer_cast<FloatExpr>(node));
+
+	case Node::Type::Bool:
+		return make_shared<BoolExpr>(*static_pointer_cast<BoolExpr>(node));
+
+	case Node::Type::String:
+		return make_shared<StringExpr>(*static_pointer_cast<StringExpr>(node));
+
+	case Node::Type::Identifier:
+	{
+		auto cast = static_pointer_cast<IdentifierExpr>(node);
+		auto it = args.find(cast->symbol);
+		if (it != args.end())
+		{
+			// Literals may be used any number of times, anything else is used exactly once
+			return is_literal(it->second) ? clone(it->second, {}) : it->second;
+		}
+
+		auto copied = make_shared<IdentifierExpr>(cast->token);
+		copied->value = cast->value;
+		copied->symbol = cast->symbol;
+		return copied;
+	}
+
+	case Node::Type::Prefix:
+	{
+		auto copied = make_shared<PrefixExpr>(*static_pointer_cast<PrefixExpr>(node));
+		copied->right = clone(copied->right, args);
+		return copied;
+	}
+
+	case Node::Type::Infix:
+	{
+		auto copied = make_shared<InfixExpr>(*static_pointer_cast<InfixExpr>(node));
+		copied->left = clone(copied->left, args);
+		copied->right = clone(copied->right, args);
+		return copied;
+	}
+
+	case Node::Type::Index:
+	{
+		auto copied = make_shared<IndexExpr>(*static_pointer_cast<IndexExpr>(node));
+		copied->left = clone(copied->left, args);
+		copied->index = clone(copied->index, args);
+		return copied;
+	}
+
+	case Node::Type::Slice:
+	{
+		auto copied = make_shared<SliceExpr>(*static_pointer_cast<SliceExpr>(node));
+		copied->left = clone(copied->left, args);
+		copied->from = copied->from ? clone(copied->from, args) : nullptr;
+		copied->to = copied->to ? clone(copied->to, args) : nullptr;
+		return copied;
+	}
+
+	case Node::Type::Array:
+	{
+		auto copied = make_shared<ArrayExpr>(*static_pointer_cast<ArrayExpr>(node));
+		copied->elements = make_shared<ExpressionsStat>(*copied->elements);
+		for (auto& element : copied->elements->expressions)
+		{
+			element = clone(element, args);
+		}
+		return copied;
+	}
+
+	case Node::Type::Map:
+	{
+		auto copied = make_shared<MapExpr>(*static_pointer_cast<MapExpr>(node));
+		copied->entries = make_shared<ExpressionsStat>(*copied->entries);
+		for (auto& entry : copied->entries->expressions)
+		{
+			entry = clone(entry, args);
+		}
+		return copied;
+	}
+
+	case Node::Type::Call:
+	{
+		auto copied = make_shared<CallExpr>(*static_pointer_cast<CallExpr>(node));
+		copied->fun = clone(copied->fun, args);
+		copied->exprs = make_shared<ExpressionsStat>(*copied->exprs);
+		for (auto& expr : copied->exprs->expressions)
+		{
+			expr = clone(expr, args);
+		}
+		return copied;
+	}
+
+	default:
+		return node;
+
+	}
+}
+
+bool Inliner::is_literal(const shared_ptr<Expr>& node)
+{
+	switch (node->type)
+	{
+
+	case Node::Type::Integer:
+	case Node::Type::Float:
+	case Node::Type::Bool:
+	case Node::Type::String:
+		return true;
+
+	default:
+		return false;
+
+	}
+}
+
+
+}
\ No newline at end of file
@@ -0,0 +1,298 @@
+#include "optimizer/LoopInvariants.h"
+#include "analysis/Traversal.h"
+#include "evaluator/BuiltinFuns.h"
+#include "ast/IntegerExpr.hpp"
+#include "ast/IdentifierExpr.hpp"
+#include "ast/PrefixExpr.hpp"
+#include "ast/InfixExpr.hpp"
+#include "ast/IndexExpr.hpp"
+#include "ast/IfExpr.hpp"
+#include "ast/LetStat.hpp"
+#include "ast/VarStat.hpp"
+#include "ast/FunctionExpr.hpp"
+#include "ast/ForStat.hpp"
+#include "ast/InvariantExpr.hpp"
+
+namespace li
+{
+
+
+const map<string, LoopInvariants::Purity> LoopInvariants::stdlibPurity =
+{
+	{ "print", Purity::Io },
+	{ "println", Purity::Io },
+	{ "len", Purity::Shape },
+	{ "sum", Purity::Pure },
+	{ "min", Purity::Pure },
+	{ "max", Purity::Pure },
+	{ "dot", Purity::Pure }
+};
+
+const map<int64_t, LoopInvariants::Purity> LoopInvariants::builtinPurity =
+{
+	{ BuiltinFuns::Print, Purity::Io },
+	{ BuiltinFuns::Len, Purity::Shape },
+	{ BuiltinFuns::Sum, Purity::Pure },
+	{ BuiltinFuns::Min, Purity::Pure },
+	{ BuiltinFuns::Max, Purity::Pure },
+	{ BuiltinFuns::Dot, Purity::Pure }
+};
+
+size_t LoopInvariants::run(shared_ptr<Program> program)
+{
+	Context context;
+	scan(program, context);
+	find_loops(program, context);
+	return context.hoisted;
+}
+
+void LoopInvariants::scan(const shared_ptr<Node>& node, Context& context)
+{
+	switch (node->type)
+	{
+
+	case Node::Type::Let:
+		context.declarations[static_pointer_cast<LetStat>(node)->name->symbol]++;
+		break;
+
+	case Node::Type::Var:
+		context.declarations[static_pointer_cast<VarStat>(node)->name->symbol]++;
+		break;
+
+	case Node::Type::For:
+		context.declarations[static_pointer_cast<ForStat>(node)->name->symbol]++;
+		break;
+
+	case Node::Type::Function:
+		for (const auto& arg : static_pointer_cast<FunctionExpr>(node)->args->args)
+		{
+			context.declarations[arg->symbol]++;
+		}
+		break;
+
+	default:
+		break;
+
+	}
+
+	for_each_child(node, [&](const shared_ptr<Node>& child) { scan(child, context); });
+}
+
+void LoopInvariants::find_loops(const shared_ptr<Node>& node, Context& context)
+{
+	// Outer loops go first, so an expression is attached to the outermost loop it is invariant in
+	if (node->type == Node::Type::While)
+	{
+		Loop loop;
+		loop.stat = static_pointer_cast<WhileStat>(node);
+		summarize(loop.stat->condition, loop);
+		summarize(loop.stat->body, loop);
+		try_hoist(loop.stat->condition, loop, context);
+		hoist(loop.stat->body, loop, context);
+	}
+
+	for_each_child(node, [&](const shared_ptr<Node>& child) { find_loops(child, context); });
+}
+
+void LoopInvariants::summarize(const shared_ptr<Node>& node, Loop& loop)
+{
+	switch (node->type)
+	{
+
+	case Node::Type::Let:
+		loop.declared.insert(static_pointer_cast<LetStat>(node)->name->symbol);
+		break;
+
+	case Node::Type::Var:
+		loop.declared.insert(static_pointer_cast<VarStat>(node)->name->symbol);
+		break;
+
+	case Node::Type::For:
+		loop.declared.insert(static_pointer_cast<ForStat>(node)->name->symbol);
+		break;
+
+	case Node::Type::Assign:
+	case Node::Type::InDecrement:
+		loop.mutates = true;
+		break;
+
+	case Node::Type::Function:
+		return;
+
+	default:
+		break;
+
+	}
+
+	for_each_child(node, [&](const shared_ptr<Node>& child) { summarize(child, loop); });
+}
+
+void LoopInvariants::hoist(const shared_ptr<Node>& node, Loop& loop, Context& context)
+{
+	// Only operands that are consumed on the spot are hoisted, the cached object must never be bound
+	// to a name or stored, since it is returned again by the next iteration
+	switch (node->type)
+	{
+
+	case Node::Type::Function:
+	case Node::Type::Invariant:
+		return;
+
+	case Node::Type::Infix:
+	{
+		auto cast = static_pointer_cast<InfixExpr>(node);
+		try_hoist(cast->left, loop, context);
+		try_hoist(cast->right, loop, context);
+		return;
+	}
+
+	case Node::Type::Prefix:
+		try_hoist(static_pointer_cast<PrefixExpr>(node)->right, loop, context);
+		return;
+
+	case Node::Type::Index:
+	{
+		auto cast = static_pointer_cast<IndexExpr>(node);
+		hoist(cast->left, loop, context);
+		try_hoist(cast->index, loop, context);
+		return;
+	}
+
+	case Node::Type::If:
+	{
+		auto cast = static_pointer_cast<IfExpr>(node);
+		try_hoist(cast->condition, loop, context);
+		hoist(cast->consequence, loop, context);
+		if (cast->alternative) hoist(cast->alternative, loop, context);
+		return;
+	}
+
+	case Node::Type::While:
+	{
+		auto cast = static_pointer_cast<WhileStat>(node);
+		try_hoist(cast->condition, loop, context);
+		hoist(cast->body, loop, context);
+		return;
+	}
+
+	default:
+		for_each_child(node, [&](const shared_ptr<Node>& child) { hoist(child, loop, context); });
+		return;
+
+	}
+}
+
+void LoopInvariants::try_hoist(shared_ptr<Expr>& slot, Loop& loop, Context& context)
+{
+	bool shapeOnly = true;
+	bool worthwhile = false;
+	// Contents read by the loop are invalidated by every mutation, caching them would not pay off
+	if (invariant(slot, loop, context, shapeOnly, worthwhile) && worthwhile && (shapeOnly || !loop.mutates))
+	{
+		slot = make_shared<InvariantExpr>(slot, loop.stat.get(), loop.stat->invariants++, shapeOnly);
+		context.hoisted++;
+		return;
+	}
+	hoist(slot, loop, context);
+}
+
+bool LoopInvariants::invariant(const shared_ptr<Expr>& node, const Loop& loop, const Context& context, bool& shapeOnly, bool& worthwhile)
+{
+	switch (node->type)
+	{
+
+	case Node::Type::Integer:
+	case Node::Type::Float:
+	case Node::Type::Bool:
+	case Node::Type::String:
+		return true;
+
+	case Node::Type::Identifier:
+		shapeOnly = false;
+		return !loop.declared.count(static_pointer_cast<IdentifierExpr>(node)->symbol);
+
+	case Node::Type::Prefix:
+		worthwhile = true;
+		return invariant(static_pointer_cast<PrefixExpr>(node)->right, loop, context, shapeOnly, worthwhile);
+
+	case Node::Type::Infix:
+	{
+		auto cast = static_pointer_cast<InfixExpr>(node);
+		worthwhile = true;
+		return invariant(cast->left, loop, context, shapeOnly, worthwhile) && invariant(cast->right, loop, context, shapeOnly, worthwhile);
+	}
+
+	case Node::Type::Index:
+	{
+		auto cast = static_pointer_cast<IndexExpr>(node);
+		worthwhile = true;
+		return invariant(cast->left, loop, context, shapeOnly, worthwhile) && invariant(cast->index, loop, context, shapeOnly, worthwhile);
+	}
+
+	case Node::Type::Call:
+	{
+		auto cast = static_pointer_cast<CallExpr>(node);
+		auto* found = purity(cast, context);
+		if (found == nullptr || *found == Purity::Io)
+		{
+			return false;
+		}
+
+		worthwhile = true;
+		for (const auto& arg : cast->exprs->expressions)
+		{
+			// The length of the object bound to a name is all a shape function reads of it
+			if (*found == Purity::Shape && arg->type == Node::Type::Identifier)
+			{
+				if (loop.declared.count(static_pointer_cast<IdentifierExpr>(arg)->symbol))
+				{
+					return false;
+				}
+				continue;
+			}
+			if (!invariant(arg, loop, context, shapeOnly, worthwhile))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	default:
+		return false;
+
+	}
+}
+
+const LoopInvariants::Purity* LoopInvariants::purity(const shared_ptr<CallExpr>& call, const Context& context)
+{
+	if (call->fun->type != Node::Type::Identifier || !call->exprs)
+	{
+		return nullptr;
+	}
+
+	// The program must not declare the name anywhere, otherwise the call may reach another function
+	auto id = static_pointer_cast<IdentifierExpr>(call->fun);
+	if (context.declarations.count(id->symbol))
+	{
+		return nullptr;
+	}
+
+	if (id->value == "_builtin_")
+	{
+		const auto& args = call->exprs->expressions;
+		if (args.empty() || args.front()->type != Node::Type::Integer)
+		{
+			return nullptr;
+		}
+
+		auto it = builtinPurity.find(static_pointer_cast<IntegerExpr>(args.front())->value);
+		return it == builtinPurity.end() ? nullptr : &it->second;
+	}
+
+	auto it = stdlibPurity.find(id->value);
+	return it == stdlibPurity.end() ? nullptr : &it->second;
+}
+
+
+}
\ No newline at end of file
@@ -0,0 +1,633 @@
+#include "optimizer/RangeAnalysis.h"
+#include "optimizer/LoopInvariants.h"
+#include "analysis/Traversal.h"
+#include "evaluator/BuiltinFuns.h"
+#include "ast/IntegerExpr.hpp"
+#include "ast/IdentifierExpr.hpp"
+#include "ast/InfixExpr.hpp"
+#include "ast/IfExpr.hpp"
+#include "ast/LetStat.hpp"
+#include "ast/VarStat.hpp"
+#include "ast/ReturnStat.hpp"
+#include "ast/ArrayExpr.hpp"
+#include "ast/MapExpr.hpp"
+#include "ast/AssignExpr.hpp"
+#include "ast/InDecrementExpr.hpp"
+#include "ast/ExpressionStat.hpp"
+#include "ast/WhileStat.hpp"
+#include "ast/ForStat.hpp"
+#include "ast/InvariantExpr.hpp"
+#include "ast/TempExpr.hpp"
+#include <algorithm>
+
+namespace li
+{
+
+
+size_t RangeAnalysis::run(shared_ptr<Program> program)
+{
+	Context context;
+	vector<shared_ptr<CallExpr>> calls;
+	scan(program, nullptr, context, calls);
+
+	// Whether a call passes its arguments to a builtin function is known once every name is declared
+	for (const auto& call : calls)
+	{
+		if (!is_pure(call, context))
+		{
+			for (const auto& arg : call->exprs->expressions)
+			{
+				escape(arg, context);
+			}
+		}
+	}
+
+	vector<Fact> facts;
+	walk(program, facts, context);
+
+	// Every index is assigned, those copied by the inliner carry the result of another program
+	size_t proven = 0;
+	for (const auto& [index, inBounds] : context.indexes)
+	{
+		index->inBounds = inBounds;
+		proven += inBounds;
+	}
+	return proven;
+}
+
+void RangeAnalysis::scan(const shared_ptr<Node>& node, const FunctionExpr* function, Context& context, vector<shared_ptr<CallExpr>>& calls)
+{
+	auto declare = [&](const shared_ptr<IdentifierExpr>& name, const shared_ptr<Expr>& value)
+	{
+		auto& variable = context.variables[name->symbol];
+		variable.declarations++;
+		variable.value = value;
+		variable.function = function;
+	};
+
+	switch (node->type)
+	{
+
+	case Node::Type::Let:
+	{
+		auto cast = static_pointer_cast<LetStat>(node);
+		declare(cast->name, cast->value);
+		escape(cast->value, context);
+		break;
+	}
+
+	case Node::Type::Var:
+	{
+		auto cast = static_pointer_cast<VarStat>(node);
+		declare(cast->name, cast->value);
+		escape(cast->value, context);
+		break;
+	}
+
+	case Node::Type::For:
+	{
+		// The number starts at the beginning of the range, the element of an array may be anything
+		auto cast = static_pointer_cast<ForStat>(node);
+		declare(cast->name, cast->end ? cast->iterable : nullptr);
+		break;
+	}
+
+	case Node::Type::Function:
+	{
+		auto cast = static_pointer_cast<FunctionExpr>(node);
+		for (const auto& arg : cast->args->args)
+		{
+			context.variables[arg->symbol].declarations++;
+		}
+		// The value of the last statement is returned to the caller
+		if (!cast->body->statements.empty())
+		{
+			escape(cast->body->statements.back(), context);
+		}
+		for_each_child(node, [&](const shared_ptr<Node>& child) { scan(child, cast.get(), context, calls); });
+		return;
+	}
+
+	case Node::Type::Identifier:
+		context.variables[static_pointer_cast<IdentifierExpr>(node)->symbol].users.insert(function);
+		break;
+
+	case Node::Type::Return:
+		escape(static_pointer_cast<ReturnStat>(node)->value, context);
+		break;
+
+	case Node::Type::Array:
+		for (const auto& element : static_pointer_cast<ArrayExpr>(node)->elements->expressions)
+		{
+			escape(element, context);
+		}
+		break;
+
+	case Node::Type::Map:
+		for (const auto& entry : static_pointer_cast<MapExpr>(node)->entries->expressions)
+		{
+			escape(entry, context);
+		}
+		break;
+
+	case Node::Type::Call:
+		calls.push_back(static_pointer_cast<CallExpr>(node));
+		break;
+
+	case Node::Type::Assign:
+	{
+		auto cast = static_pointer_cast<AssignExpr>(node);
+		if (cast->id->type == Node::Type::Identifier)
+		{
+			auto symbol = static_pointer_cast<IdentifierExpr>(cast->id)->symbol;
+			context.variables[symbol].updates.emplace_back(cast->operatorName, cast->value);
+		}
+		break;
+	}
+
+	case Node::Type::InDecrement:
+	{
+		auto cast = static_pointer_cast<InDecrementExpr>(node);
+		if (cast->id->type == Node::Type::Identifier)
+		{
+			auto symbol = static_pointer_cast<IdentifierExpr>(cast->id)->symbol;
+			context.variables[symbol].updates.emplace_back(cast->operatorName, nullptr);
+		}
+		break;
+	}
+
+	default:
+		break;
+
+	}
+
+	for_each_child(node, [&](const shared_ptr<Node>& child) { scan(child, function, context, calls); });
+}
+
+void RangeAnalysis::escape(const shared_ptr<Node>& node, Context& context)
+{
+	// The expressions whose value may be the very object bound to a name
+	switch (node->type)
+	{
+
+	case Node::Type::Identifier:
+		context.variables[static_pointer_cast<IdentifierExpr>(node)->symbol].escapes = true;
+		return;
+
+	case Node::Type::ExprStat:
+		escape(static_pointer_cast<ExpressionStat>(node)->expression, context);
+		return;
+
+	case Node::Type::InDecrement:
+		escape(static_pointer_cast<InDecrementExpr>(node)->id, context);
+		return;
+
+	case Node::Type::Assign:
+	{
+		auto cast = static_pointer_cast<AssignExpr>(node);
+		if (cast->operatorName == "=")
+		{
+			escape(cast->value, context);
+		}
+		return;
+	}
+
+	case Node::Type::If:
+	{
+		auto cast = static_pointer_cast<IfExpr>(node);
+		if (!cast->consequence->statements.empty())
+		{
+			escape(cast->consequence->statements.back(), context);
+		}
+		if (cast->alternative && !cast->alternative->statements.empty())
+		{
+			escape(cast->alternative->statements.back(), context);
+		}
+		return;
+	}
+
+	case Node::Type::Invariant:
+		escape(static_pointer_cast<InvariantExpr>(node)->expr, context);
+		return;
+
+	case Node::Type::Temp:
+		escape(static_pointer_cast<TempExpr>(node)->expr, context);
+		return;
+
+	default:
+		return;
+
+	}
+}
+
+void RangeAnalysis::walk(const shared_ptr<Node>& node, vector<Fact>& facts, Context& context)
+{
+	switch (node->type)
+	{
+
+	case Node::Type::Let:
+	{
+		auto cast = static_pointer_cast<LetStat>(node);
+		walk(cast->value, facts, context);
+		kill(facts, cast->name->symbol);
+		return;
+	}
+
+	case Node::Type::Var:
+	{
+		auto cast = static_pointer_cast<VarStat>(node);
+		walk(cast->value, facts, context);
+		kill(facts, cast->name->symbol);
+		return;
+	}
+
+	case Node::Type::Function:
+	{
+		// The body runs when the function is called, where nothing is known
+		vector<Fact> none;
+		walk(static_pointer_cast<FunctionExpr>(node)->body, none, context);
+		return;
+	}
+
+	case Node::Type::If:
+	{
+		auto cast = static_pointer_cast<IfExpr>(node);
+		walk(cast->condition, facts, context);
+		auto otherwise = facts;
+		walk(cast->consequence, facts, context);
+		if (cast->alternative)
+		{
+			walk(cast->alternative, otherwise, context);
+		}
+
+		facts.erase(remove_if(facts.begin(), facts.end(), [&](const Fact& fact)
+		{
+			return none_of(otherwise.begin(), otherwise.end(), [&](const Fact& other)
+			{
+				return other.index == fact.index && other.array == fact.array;
+			});
+		}), facts.end());
+		return;
+	}
+
+	case Node::Type::While:
+	{
+		// What holds before the loop holds in every iteration unless the loop may change it
+		auto cast = static_pointer_cast<WhileStat>(node);
+		Summary summary;
+		summarize(cast->condition, summary, context);
+		summarize(cast->body, summary, context);
+		if (summary.all)
+		{
+			facts.clear();
+		}
+		for (auto symbol : summary.symbols)
+		{
+			kill(facts, symbol);
+		}
+
+		walk(cast->condition, facts, context);
+		auto body = facts;
+		Fact fact;
+		if (bound(cast->condition, fact, context))
+		{
+			body.push_back(fact);
+		}
+		walk(cast->body, body, context);
+		return;
+	}
+
+	case Node::Type::For:
+	{
+		// The end is evaluated once and arrays only grow, so the number stays below the length of the
+		// array the end was taken from as long as the name refers to that array
+		auto cast = static_pointer_cast<ForStat>(node);
+		walk(cast->iterable, facts, context);
+		if (cast->end)
+		{
+			walk(cast->end, facts, context);
+		}
+
+		Summary summary;
+		summarize(cast->body, summary, context);
+		if (summary.all)
+		{
+			facts.clear();
+		}
+		for (auto symbol : summary.symbols)
+		{
+			kill(facts, symbol);
+		}
+
+		auto body = facts;
+		kill(body, cast->name->symbol);
+		if (cast->end)
+		{
+			if (auto* array = limit(cast->end, context))
+			{
+				body.push_back({ cast->name->symbol, array->symbol });
+			}
+		}
+		walk(cast->body, body, context);
+		return;
+	}
+
+	case Node::Type::Index:
+	{
+		auto cast = static_pointer_cast<IndexExpr>(node);
+		walk(cast->left, facts, context);
+		walk(cast->index, facts, context);
+
+		bool proven = false;
+		if (cast->left->type == Node::Type::Identifier && cast->index->type == Node::Type::Identifier)
+		{
+			auto array = static_pointer_cast<IdentifierExpr>(cast->left)->symbol;
+			auto index = static_pointer_cast<IdentifierExpr>(cast->index)->symbol;
+			proven = any_of(facts.begin(), facts.end(), [&](const Fact& fact) { return fact.index == index && fact.array == array; }) &&
+				non_negative(index, context);
+		}
+
+		auto [it, inserted] = context.indexes.emplace(cast.get(), proven);
+		it->second = it->second && proven;
+		return;
+	}
+
+	case Node::Type::Call:
+	{
+		auto cast = static_pointer_cast<CallExpr>(node);
+		walk(cast->fun, facts, context);
+		if (cast->exprs)
+		{
+			walk(cast->exprs, facts, context);
+		}
+		if (!is_pure(cast, context))
+		{
+			facts.clear();
+		}
+		return;
+	}
+
+	case Node::Type::Assign:
+	{
+		// Another name may refer to the array, an assignment to anything may change its length
+		auto cast = static_pointer_cast<AssignExpr>(node);
+		walk(cast->id, facts, context);
+		walk(cast->value, facts, context);
+		facts.clear();
+		return;
+	}
+
+	case Node::Type::InDecrement:
+	{
+		auto cast = static_pointer_cast<InDecrementExpr>(node);
+		walk(cast->id, facts, context);
+		if (cast->id->type == Node::Type::Identifier)
+		{
+			kill(facts, static_pointer_cast<IdentifierExpr>(cast->id)->symbol);
+		}
+		return;
+	}
+
+	default:
+		for_each_child(node, [&](const shared_ptr<Node>& child) { walk(child, facts, context); });
+		return;
+
+	}
+}
+
+void RangeAnalysis::summarize(const shared_ptr<Node>& node, Summary& summary, const Context& context)
+{
+	switch (node->type)
+	{
+
+	case Node::Type::Function:
+		return;
+
+	case Node::Type::Let:
+		summary.symbols.insert(static_pointer_cast<LetStat>(node)->name->symbol);
+		break;
+
+	case Node::Type::Var:
+		summary.symbols.insert(static_pointer_cast<VarStat>(node)->name->symbol);
+		break;
+
+	case Node::Type::For:
+		summary.symbols.insert(static_pointer_cast<ForStat>(node)->name->symbol);
+		break;
+
+	case Node::Type::Assign:
+		summary.all = true;
+		break;
+
+	case Node::Type::Call:
+		summary.all = summary.all || !is_pure(static_pointer_cast<CallExpr>(node), context);
+		break;
+
+	case Node::Type::InDecrement:
+	{
+		auto cast = static_pointer_cast<InDecrementExpr>(node);
+		if (cast->id->type == Node::Type::Identifier)
+		{
+			summary.symbols.insert(static_pointer_cast<IdentifierExpr>(cast->id)->symbol);
+		}
+		break;
+	}
+
+	default:
+		break;
+
+	}
+
+	for_each_child(node, [&](const shared_ptr<Node>& child) { summarize(child, summary, context); });
+}
+
+bool RangeAnalysis::bound(const shared_ptr<Expr>& condition, Fact& fact, Context& context)
+{
+	if (condition->type != Node::Type::Infix)
+	{
+		return false;
+	}
+
+	auto cast = static_pointer_cast<InfixExpr>(condition);
+	if (cast->operatorName != "<" && cast->operatorName != ">")
+	{
+		return false;
+	}
+	auto index = cast->operatorName == "<" ? cast->left : cast->right;
+	auto* array = limit(cast->operatorName == "<" ? cast->right : cast->left, context);
+	if (index->type != Node::Type::Identifier || !array)
+	{
+		return false;
+	}
+	fact = { static_pointer_cast<IdentifierExpr>(index)->symbol, array->symbol };
+	return true;
+}
+
+const IdentifierExpr* RangeAnalysis::limit(shared_ptr<Expr> length, Context& context)
+{
+	// len(a) - k is not above the length either
+	if (length->type == Node::Type::Infix)
+	{
+		auto difference = static_pointer_cast<InfixExpr>(length);
+		if (difference->operatorName == "-" && non_negative(difference->right, context))
+		{
+			length = difference->left;
+		}
+	}
+	return length_of(length, context);
+}
+
+bool RangeAnalysis::non_negative(symbol_t symbol, Context& context)
+{
+	auto it = context.variables.find(symbol);
+	if (it == context.variables.end())
+	{
+		return false;
+	}
+
+	auto& variable = it->second;
+	switch (variable.nonNegative)
+	{
+	case Variable::Yes: return true;
+	case Variable::No: return false;
+	// Assumed while its own updates are checked, they keep it non-negative by induction
+	case Variable::Visiting: return true;
+	default: break;
+	}
+
+	bool result = variable.declarations == 1 && variable.value && !variable.escapes;
+	for (const auto* user : variable.users)
+	{
+		result = result && user == variable.function;
+	}
+
+	variable.nonNegative = Variable::Visiting;
+	result = result && non_negative(variable.value, context);
+	for (const auto& [operatorName, value] : variable.updates)
+	{
+		if (!result) break;
+
+		if (!value)
+		{
+			result = operatorName == "++";
+			continue;
+		}
+		result = (operatorName == "=" || operatorName == "+=" || operatorName == "*=") && non_negative(value, context);
+	}
+
+	// The variables found non-negative meanwhile may have assumed this one to be, they are visited again
+	if (!result)
+	{
+		for (auto& [other, visited] : context.variables)
+		{
+			if (visited.nonNegative == Variable::Yes)
+			{
+				visited.nonNegative = Variable::Unknown;
+			}
+		}
+	}
+	variable.nonNegative = result ? Variable::Yes : Variable::No;
+	return result;
+}
+
+bool RangeAnalysis::non_negative(const shared_ptr<Expr>& expr, Context& context)
+{
+	switch (expr->type)
+	{
+
+	case Node::Type::Integer:
+		return static_pointer_cast<IntegerExpr>(expr)->value <= static_cast<uint64_t>(INT64_MAX);
+
+	case Node::Type::Identifier:
+		return non_negative(static_pointer_cast<IdentifierExpr>(expr)->symbol, context);
+
+	case Node::Type::Infix:
+	{
+		auto cast = static_pointer_cast<InfixExpr>(expr);
+		if (cast->operatorName == "+" || cast->operatorName == "*")
+		{
+			return non_negative(cast->left, context) && non_negative(cast->right, context);
+		}
+		// The remainder has the sign of the dividend
+		if (cast->operatorName == "%")
+		{
+			return non_negative(cast->left, context);
+		}
+		return false;
+	}
+
+	case Node::Type::Call:
+		return length_of(expr, context) != nullptr;
+
+	default:
+		return false;
+
+	}
+}
+
+bool RangeAnalysis::is_pure(const shared_ptr<CallExpr>& call, const Context& context)
+{
+	// Neither the standard functions nor the builtins they call change any object
+	if (call->fun->type != Node::Type::Identifier || !call->exprs)
+	{
+		return false;
+	}
+
+	auto id = static_pointer_cast<IdentifierExpr>(call->fun);
+	auto it = context.variables.find(id->symbol);
+	if (it != context.variables.end() && it->second.declarations != 0)
+	{
+		return false;
+	}
+
+	if (id->value == "_builtin_")
+	{
+		const auto& args = call->exprs->expressions;
+		return !args.empty() && args.front()->type == Node::Type::Integer &&
+			LoopInvariants::builtinPurity.count(static_pointer_cast<IntegerExpr>(args.front())->value);
+	}
+	return LoopInvariants::stdlibPurity.count(id->value) != 0;
+}
+
+const IdentifierExpr* RangeAnalysis::length_of(const shared_ptr<Expr>& expr, const Context& context)
+{
+	if (expr->type != Node::Type::Call)
+	{
+		return nullptr;
+	}
+
+	auto call = static_pointer_cast<CallExpr>(expr);
+	if (!is_pure(call, context))
+	{
+		return nullptr;
+	}
+
+	const auto& args = call->exprs->expressions;
+	auto name = static_pointer_cast<IdentifierExpr>(call->fun)->value;
+	shared_ptr<Expr> array;
+	if (name == "len" && args.size() == 1)
+	{
+		array = args[0];
+	}
+	else if (name == "_builtin_" && args.size() == 2 && static_pointer_cast<IntegerExpr>(args[0])->value == BuiltinFuns::Len)
+	{
+		array = args[1];
+	}
+
+	if (!array || array->type != Node::Type::Identifier)
+	{
+		return nullptr;
+	}
+	return static_cast<const IdentifierExpr*>(array.get());
+}
+
+void RangeAnalysis::kill(vector<Fact>& facts, symbol_t symbol)
+{
+	facts.erase(remove_if(facts.begin(), facts.end(), [symbol](const Fact& fact)
+	{
+		return fact.index == symbol || fact.array == symbol;
+	}), facts.end());
+}
+
+
+}
\ No newline at end of file
@@ -11,7 +11,9 @@
 #include "ast/AssignExpr.hpp"
 #include "ast/FloatExpr.hpp"
 #include "ast/ArrayExpr.hpp"
+#include "ast/MapExpr.hpp"
 #include "ast/IndexExpr.hpp"
+#include "ast/SliceExpr.hpp"
 #include "ast/InDecrementExpr.hpp"
 
 namespace li
@@ -124,6 +126,9 @@ shared_ptr<Stat> Parser::parse_statement()
 	case Token::While:
 		return parse_while_stat();
 
+	case Token::For:
+		return parse_for_stat();
+
 	default:
 		return parse_expr_stat();
 
@@ -152,6 +157,31 @@ shared_ptr<WhileStat> Parser::parse_while_stat()
 	return stat;
 }
 
+shared_ptr<ForStat> Parser::parse_for_stat()
+{
+	auto stat = make_shared<ForStat>(_current);
+	parse_token();
+	if (expect_token_type(Token::LParen)) return nullptr;
+	parse_token();
+
+	if (expect_token_type(Token::Identifier)) return nullptr;
+	stat->name = dynamic_pointer_cast<IdentifierExpr>(parse_identifier());
+	if (expect_token_type(Token::In)) return nullptr;
+	parse_token();
+
+	stat->iterable = parse_expr(Lowest);
+	if (_current->type == Token::Range)
+	{
+		parse_token();
+		stat->end = parse_expr(Lowest);
+	}
+	if (expect_token_type(Token::RParen)) return nullptr;
+	parse_token();
+
+	stat->body = parse_block_stat();
+	return stat;
+}
+
 shared_ptr<Expr> Parser::parse_expr(PrecedenceType precedence)
 {
     auto prefixFun = _prefixParseFuns.find(_current->type);
@@ -184,6 +214,7 @@ shared_ptr<Stat> Parser::parse_declaration_stat()
 		parse_token();
 		if (expect_token_type(Token::Identifier)) return nullptr;
 		stat->name = dynamic_pointer_cast<IdentifierExpr>(parse_identifier());
+		if (!parse_annotation(stat->annotation)) return nullptr;
 	
 		if(expect_token_type(Token::Assign)) return nullptr;
 		parse_token();
@@ -199,6 +230,7 @@ shared_ptr<Stat> Parser::parse_declaration_stat()
 		parse_token();
 		if (expect_token_type(Token::Identifier)) return nullptr;
 		stat->name = dynamic_pointer_cast<IdentifierExpr>(parse_identifier());
+		if (!parse_annotation(stat->annotation)) return nullptr;
 	
 		if(expect_token_type(Token::Assign)) return nullptr;
 		parse_token();
@@ -269,6 +301,7 @@ shared_ptr<Expr> Parser::parse_identifier()
 {
 	auto expr = make_shared<IdentifierExpr>(_current);
 	expr->value = _current->literal;
+	expr->symbol = _current->symbol;
 
 	parse_token();
 	return expr;
@@ -366,6 +399,8 @@ shared_ptr<ArgumentsStat> Parser::parse_args()
 	while (_current->type != Token::RParen && _current->type != Token::Eof)
 	{
 		args->args.push_back(dynamic_pointer_cast<IdentifierExpr>(parse_identifier()));
+		args->annotations.emplace_back();
+		if (!parse_annotation(args->annotations.back())) return nullptr;
 
 		if (_current->type == Token::Comma)
 		{
@@ -375,9 +410,33 @@ shared_ptr<ArgumentsStat> Parser::parse_args()
 
 	if (expect_token_type(Token::RParen)) return nullptr;
 	parse_token();
+	if (!parse_annotation(args->result)) return nullptr;
 	return args;
 }
 
+bool Parser::parse_annotation(Annotation& annotation)
+{
+	if (_current->type != Token::Colon)
+	{
+		return true;
+	}
+	parse_token();
+
+	// Type names are read by their literal, since some of them are lexed as keywords
+	auto it = annotations().find(_current->literal);
+	if (it == annotations().end())
+	{
+		stringstream stream;
+		stream << pos_string() << "error: unknown type annotation: " << _current->literal;
+		_outputs.push_back(stream.str());
+		return false;
+	}
+
+	annotation = it->second;
+	parse_token();
+	return true;
+}
+
 shared_ptr<Expr> Parser::parse_function()
 {
 	auto fun = make_shared<FunctionExpr>(_current);
@@ -460,6 +519,28 @@ shared_ptr<Expr> Parser::parse_array()
 	return expr;
 }
 
+shared_ptr<Expr> Parser::parse_map()
+{
+	auto expr = make_shared<MapExpr>(_current);
+	expr->entries = make_shared<ExpressionsStat>(_current);
+	parse_token();
+
+	while (_current->type != Token::RBrace && _current->type != Token::Eof)
+	{
+		expr->entries->expressions.push_back(parse_expr(Lowest));
+		if (expect_token_type(Token::Colon)) return nullptr;
+		parse_token();
+		expr->entries->expressions.push_back(parse_expr(Lowest));
+
+		if (_current->type != Token::Comma) break;
+		parse_token();
+	}
+
+	if (expect_token_type(Token::RBrace)) return nullptr;
+	parse_token();
+	return expr;
+}
+
 shared_ptr<Expr> Parser::parse_in_decrement()
 {
 	auto expr = make_shared<InDecrementExpr>(_current);
@@ -486,11 +567,34 @@ shared_ptr<Expr> Parser::parse_in_decrement()
 
 shared_ptr<Expr> Parser::parse_index(shared_ptr<Expr> left)
 {
-	auto expr = make_shared<IndexExpr>(_current);
-	expr->left = left;
+	auto token = _current;
 	parse_token();
-	
-	expr->index = parse_expr(Lowest);
+
+	shared_ptr<Expr> index;
+	if (_current->type != Token::Colon)
+	{
+		index = parse_expr(Lowest);
+	}
+
+	// left[from:to], where either bound may be left out
+	if (_current->type == Token::Colon)
+	{
+		auto slice = make_shared<SliceExpr>(token);
+		slice->left = left;
+		slice->from = index;
+		parse_token();
+		if (_current->type != Token::RBracket)
+		{
+			slice->to = parse_expr(Lowest);
+		}
+		if (expect_token_type(Token::RBracket)) return nullptr;
+		parse_token();
+		return slice;
+	}
+
+	auto expr = make_shared<IndexExpr>(token);
+	expr->left = left;
+	expr->index = index;
 	if (expect_token_type(Token::RBracket)) return nullptr;
 	parse_token();
 
@@ -4,6 +4,10 @@
 #include "program/initialization.h"
 #include "parser/Parser.h"
 #include "evaluator/Evaluator.h"
+#include "ir/Builder.h"
+#include "ir/Lowering.h"
+#include "ir/NumericSpecialization.h"
+#include "aot/CppEmitter.h"
 #include "config.h"
 
 namespace li::program
@@ -15,7 +19,8 @@ const filesystem::path Program::PREREAD_SOURCES_PATH = executable_path().parent_
 Program::Program(int argc, char* argv[]) :
 	_program(EXECUTABLE_NAME, PROJECT_VERSION),
 	_out(&cout),
-	_prereadEnv(make_shared<Environment>())
+	_prereadEnv(make_shared<Environment>()),
+	_evaluator(make_shared<Evaluator>())
 {
 	_program.add_description(EXECUTABLE_DESCRIPTION);
 
@@ -31,12 +36,54 @@ Program::Program(int argc, char* argv[]) :
 	_program.add_argument("--output", "-o")
 		.help("specify the output file, the default is standard output");
 
+	_program.add_argument("--stats")
+		.flag()
+		.help("print evaluator statistics to standard error on exit");
+
+	_program.add_argument("--no-inline")
+		.flag()
+		.help("do not inline calls to small functions");
+
+	_program.add_argument("--no-licm")
+		.flag()
+		.help("do not reuse the values of loop invariant expressions");
+
+	_program.add_argument("--no-range-analysis")
+		.flag()
+		.help("check the bounds of every array access");
+
+	_program.add_argument("--no-ir")
+		.flag()
+		.help("do not optimize the SSA form of the source");
+
+	_program.add_argument("--emit-ir")
+		.flag()
+		.help("print the optimized SSA form of the source instead of running it");
+
+	_program.add_argument("--type-report")
+		.flag()
+		.help("print which functions had all their operators specialized to standard error");
+
+	_program.add_argument("--emit-cpp")
+		.flag()
+		.help("translate the source and the standard library to C++ instead of running it");
+
+	_program.add_argument("--jit")
+		.flag()
+		.help("compile hot numeric functions and loops to machine code");
+
+	_program.add_argument("--closures")
+		.flag()
+		.help("run the source translated to a tree of closures instead of walking its syntax tree");
+
+	_program.add_argument("--threads")
+		.flag()
+		.help("run pmap and preduce on threads even on a single hardware thread");
+
 	for (int i = 0; i < argc; i++)
 	{
 		_argv.push_back(argv[i]);
 	}
-
-	parse_source(read_folder_sources(PREREAD_SOURCES_PATH), _prereadEnv, nullptr);
 }
 
 string Program::get_source_file_name()
@@ -68,9 +115,13 @@ int Program::run()
 		return -1;
     }
 
+	load_preread_sources();
+
 	if (_program["--repl"] == true)
 	{
-		return repl();
+		int code = repl();
+		print_stats();
+		return code;
 	}
 
 	string fileName = get_source_file_name();
@@ -84,10 +135,86 @@ int Program::run()
 		change_write_file(outFileName.value());
 	}
 
+	if (_program["--emit-ir"] == true)
+	{
+		return emit_ir(input);
+	}
+	if (_program["--emit-cpp"] == true)
+	{
+		return emit_cpp(input, fileName);
+	}
+
 	parse_source(input, make_shared<Environment>(), _prereadEnv);
+	print_stats();
 	return 0;
 }
 
+void Program::load_preread_sources()
+{
+	// Every line of the repl is a separate program that may redeclare the names the optimizations rely on
+	if (_program["--no-inline"] == false && _program["--repl"] == false)
+	{
+		_inliner = make_shared<Inliner>();
+	}
+	if (_program["--no-ir"] == false && _program["--repl"] == false)
+	{
+		_passes = ir::PassManager::standard();
+	}
+	_licm = _program["--no-licm"] == false && _program["--repl"] == false;
+	_ranges = _program["--no-range-analysis"] == false && _program["--repl"] == false;
+	if (_program["--jit"] == true && !_evaluator->enable_jit())
+	{
+		cerr << "--jit is not supported on this platform, everything is interpreted\n";
+	}
+	if (_program["--closures"] == true)
+	{
+		_evaluator->enable_closures();
+	}
+	if (_program["--threads"] == true)
+	{
+		_evaluator->enable_threads();
+	}
+
+	parse_source(read_folder_sources(PREREAD_SOURCES_PATH), _prereadEnv, nullptr);
+}
+
+void Program::print_stats()
+{
+	if (_program["--stats"] == false)
+	{
+		return;
+	}
+
+	const auto& stats = _evaluator->stats();
+	cerr << "function calls: " << stats.calls << '\n';
+	cerr << "pooled frames: " << stats.pooledFrames << '\n';
+	cerr << "inlined calls: " << (_inliner ? _inliner->inlined() : 0) << '\n';
+	cerr << "reused loop invariants: " << stats.invariantHits << '\n';
+	cerr << "reused values: " << stats.reusedValues << '\n';
+	cerr << "numeric operations: " << stats.numericOperations << '\n';
+	cerr << "unboxed values: " << stats.unboxedValues << '\n';
+	cerr << "native stores: " << stats.nativeStores << '\n';
+	cerr << "reused numbers: " << stats.reusedNumbers << '\n';
+	cerr << "specialization hits: " << stats.specializationHits << '\n';
+	cerr << "specialization misses: " << stats.specializationMisses << '\n';
+	cerr << "unchecked indexes: " << stats.uncheckedIndexes << '\n';
+	cerr << "reused loop scopes: " << stats.reusedScopes << '\n';
+	cerr << "reused call frames: " << stats.reusedFrames << '\n';
+	cerr << "parallel runs: " << stats.parallelRuns << '\n';
+	cerr << "serial callbacks: " << stats.serialCallbacks << '\n';
+	cerr << "dead stores: " << (_passes ? _passes->changes("dead store elimination") : 0) << '\n';
+
+	jit::Jit::Stats jitStats;
+	if (auto* jit = _evaluator->jit())
+	{
+		jitStats = jit->stats();
+	}
+	cerr << "compiled functions: " << jitStats.compiledFunctions << '\n';
+	cerr << "compiled loops: " << jitStats.compiledLoops << '\n';
+	cerr << "compiled code runs: " << jitStats.entries << '\n';
+	cerr << "jit bailouts: " << jitStats.bailouts << '\n';
+}
+
 void Program::change_write_file(const string& fileName)
 {
 	_outFile.open(fileName, ios::out | ios::trunc);
@@ -99,7 +226,7 @@ void Program::change_write_file(const string& fileName)
 	_out = &_outFile;
 }
 
-void Program::parse_source(const string& input, shared_ptr<Environment> inner, shared_ptr<Environment> outer)
+shared_ptr<li::Program> Program::parse(const string& input)
 {
 	auto lexer = make_shared<li::Lexer>(input);
 	auto parser = make_shared<li::Parser>(lexer);
@@ -112,12 +239,46 @@ void Program::parse_source(const string& input, shared_ptr<Environment> inner, s
 		{
 			cerr << o << '\n';
 		}
+		return nullptr;
+	}
+	return program;
+}
+
+void Program::parse_source(const string& input, shared_ptr<Environment> inner, shared_ptr<Environment> outer)
+{
+	auto program = parse(input);
+	if (!program)
+	{
 		return;
 	}
 
-	auto evaluator = make_shared<li::Evaluator>();
+	if (_inliner)
+	{
+		_inliner->run(program);
+	}
+	if (_passes)
+	{
+		auto module = ir::Builder::build(program);
+		_passes->run(*module);
+		ir::Lowering::run(*module);
+
+		// The preread sources have no outer environment, only the source given is reported
+		if (outer && _program["--type-report"] == true)
+		{
+			ir::NumericSpecialization::report(*module, cerr);
+		}
+	}
+	if (_ranges)
+	{
+		RangeAnalysis::run(program);
+	}
+	if (_licm)
+	{
+		LoopInvariants::run(program);
+	}
+
 	inner->outer = outer;
-	auto obj = evaluator->evaluate(program, inner);
+	auto obj = _evaluator->evaluate(program, inner);
 	
 	if (!obj || obj->type == Object::Type::Null)
 	{
@@ -132,6 +293,40 @@ void Program::parse_source(const string& input, shared_ptr<Environment> inner, s
 	*_out << obj->inspect() << '\n';
 }
 
+int Program::emit_ir(const string& input)
+{
+	auto program = parse(input);
+	if (!program)
+	{
+		return -1;
+	}
+
+	if (_inliner)
+	{
+		_inliner->run(program);
+	}
+	auto module = ir::Builder::build(program);
+	if (_passes)
+	{
+		_passes->run(*module);
+	}
+	module->print(*_out);
+	return 0;
+}
+
+int Program::emit_cpp(const string& input, const string& fileName)
+{
+	auto prelude = parse(read_folder_sources(PREREAD_SOURCES_PATH));
+	auto program = parse(input);
+	if (!prelude || !program)
+	{
+		return -1;
+	}
+
+	aot::CppEmitter::emit(prelude, program, filesystem::path(fileName).filename().string(), *_out);
+	return 0;
+}
+
 string Program::read_file(const string& fileName)
 {
 	string output;
@@ -196,4 +391,4 @@ int Program::repl()
 }
 
 
-}
+}
\ No newline at end of file
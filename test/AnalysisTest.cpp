@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include "initialization.h"
+#include "analysis/FreeVariables.h"
+#include "analysis/ElementUses.h"
+#include "ast/ExpressionStat.hpp"
+#include "ast/LetStat.hpp"
+#include "ast/ReturnStat.hpp"
+#include "ast/InfixExpr.hpp"
+#include "ast/AssignExpr.hpp"
+#include "ast/CallExpr.hpp"
+
+namespace li::test
+{
+
+
+vector<string> symbolNames(const vector<symbol_t>& symbols)
+{
+	vector<string> names;
+	for (auto symbol : symbols)
+	{
+		names.push_back(SymbolTable::name(symbol));
+	}
+	return names;
+}
+
+TEST(AnalysisTest, freeVariables)
+{
+	shared_ptr<Program> program;
+	ASSERT_NO_FATAL_FAILURE(initParser(program, "let f = fun(a) { let b = a + c; fun(d) { a + b + d + e } }", 1));
+	FreeVariables::analyze(program);
+
+	auto outer = dynamic_pointer_cast<FunctionExpr>(dynamic_pointer_cast<LetStat>(program->statements.at(0))->value);
+	ASSERT_NE(outer, nullptr);
+	ASSERT_TRUE(outer->analyzed);
+	EXPECT_EQ(symbolNames(*outer->freeVars), vector<string>({ "c", "b", "e" }));
+
+	auto inner = dynamic_pointer_cast<FunctionExpr>(dynamic_pointer_cast<ExpressionStat>(outer->body->statements.at(1))->expression);
+	ASSERT_NE(inner, nullptr);
+	EXPECT_EQ(symbolNames(*inner->freeVars), vector<string>({ "a", "b", "e" }));
+	EXPECT_EQ(inner->lateBound, vector<bool>({ false, true, false }));
+}
+
+TEST(AnalysisTest, frameEscapes)
+{
+	struct Expected
+	{
+		string input;
+		bool escapes;
+	} tests[] = {
+		{ "let f = fun(a) { a + 1 }", false },
+		{ "let f = fun(a) { fun(b) { a + b } }", false },
+		{ "let f = fun(n) { let g = fun() { h() }; let h = fun() { n }; g }", true },
+		{ "let f = fun() { let fact = fun(n) { if (n < 2) { return 1 }; n * fact(n - 1) }; fact }", true }
+	};
+
+	for (const auto& [input, escapes] : tests)
+	{
+		SCOPED_TRACE(input);
+		shared_ptr<Program> program;
+		ASSERT_NO_FATAL_FAILURE(initParser(program, input, 1));
+		FreeVariables::analyze(program);
+
+		auto fun = dynamic_pointer_cast<FunctionExpr>(dynamic_pointer_cast<LetStat>(program->statements.at(0))->value);
+		ASSERT_NE(fun, nullptr);
+		EXPECT_EQ(fun->frameEscapes, escapes);
+	}
+}
+
+TEST(AnalysisTest, elementUses)
+{
+	shared_ptr<Program> program;
+	ASSERT_NO_FATAL_FAILURE(initParser(program, "let a = [1]; let b = a[0]; a[0] + 1; a[0] = 2; fun() { return a[0] }; f(a[0]); a[0]", 7));
+	ElementUses::analyze(program);
+
+	auto index = [&](size_t i)
+	{
+		return dynamic_pointer_cast<IndexExpr>(dynamic_pointer_cast<ExpressionStat>(program->statements.at(i))->expression);
+	};
+	auto let = dynamic_pointer_cast<IndexExpr>(dynamic_pointer_cast<LetStat>(program->statements.at(1))->value);
+	auto infix = dynamic_pointer_cast<IndexExpr>(dynamic_pointer_cast<InfixExpr>(dynamic_pointer_cast<ExpressionStat>(program->statements.at(2))->expression)->left);
+	auto assigned = dynamic_pointer_cast<IndexExpr>(dynamic_pointer_cast<AssignExpr>(dynamic_pointer_cast<ExpressionStat>(program->statements.at(3))->expression)->id);
+	auto fun = dynamic_pointer_cast<FunctionExpr>(dynamic_pointer_cast<ExpressionStat>(program->statements.at(4))->expression);
+	auto returned = dynamic_pointer_cast<IndexExpr>(dynamic_pointer_cast<ReturnStat>(fun->body->statements.at(0))->value);
+	auto argument = dynamic_pointer_cast<IndexExpr>(dynamic_pointer_cast<CallExpr>(dynamic_pointer_cast<ExpressionStat>(program->statements.at(5))->expression)->exprs->expressions.at(0));
+	ASSERT_TRUE(let && infix && assigned && returned && argument && index(6));
+
+	EXPECT_FALSE(let->consumed);
+	EXPECT_TRUE(infix->consumed);
+	EXPECT_TRUE(assigned->consumed);
+	EXPECT_FALSE(returned->consumed);
+	EXPECT_TRUE(argument->consumed);
+	EXPECT_FALSE(index(6)->consumed);
+}
+
+TEST(AnalysisTest, elementCopies)
+{
+	struct Expected
+	{
+		string input;
+		bool copies;
+	} tests[] = {
+		{ "for (x in a) { s += x }", true },
+		{ "for (x in a) { if (x > 1) { f(x) } }", true },
+		{ "for (x in a) { let y = x }", false },
+		{ "for (x in a) { ++x }", false },
+		{ "for (x in a) { x = 1 }", false },
+		{ "for (x in a) { k = [x] }", false },
+		{ "for (x in a) { fun() { x + 1 } }", false }
+	};
+
+	for (const auto& [input, copies] : tests)
+	{
+		SCOPED_TRACE(input);
+		shared_ptr<Program> program;
+		ASSERT_NO_FATAL_FAILURE(initParser(program, input, 1));
+		ElementUses::analyze(program);
+
+		auto loop = dynamic_pointer_cast<ForStat>(program->statements.at(0));
+		ASSERT_NE(loop, nullptr);
+		EXPECT_EQ(loop->copies, copies);
+	}
+}
+
+
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include "initialization.h"
+#include "evaluator/Evaluator.h"
+
+namespace li::test
+{
+
+
+// Every program gives the same result and the same statistics run as closures as evaluated
+TEST(ClosureTest, sameResults)
+{
+	struct Expected
+	{
+		string input;
+		size_t statements;
+	} tests[] = {
+		{ "1 + 2 * 3 - 4 / 2", 1 },
+		{ "1.5 * 2 + 3 % 2", 1 },
+		{ "!true == !!false", 1 },
+		{ "-(2 - 5.5)", 1 },
+		{ "\"Hello\" + \" \" + \"world!\"", 1 },
+		{ "var s = \"\"; for (i in 0..5) { s += \"ab\"; s = s + \"c\" }; var t = s + \"!\"; s + t", 4 },
+		{ "let s = \"Hello world!\"; s[4] + slice(s, 6, 11) + substr(s, 0, 2) + s[20]", 2 },
+		{ "if (1 < 2) { 10 } else { 20 }", 1 },
+		{ "if (1 > 2) { 10 }", 1 },
+		{ "var s = 0; var i = 0; while (i < 100) { s = s + i * 2; ++i }; s", 4 },
+		{ "var i = 0; var s = 0; while (i < 10) { ++i; if (i % 2 == 0) { return 1 }; s += i }; s", 4 },
+		{ "var s = 0; for (i in 0..10) { for (x in [i, 1]) { s += x } }; s", 3 },
+		{ "var a = [0]; for (i in 1..3) { a = [fun() { i }] }; a[1]() * 10 + a[2]()", 3 },
+		{ "let f = fun(a) { for (i in 0..10) { if (a[i] == 4) { return i } }; 0 }; f([1, 4, 8])", 2 },
+		{ "for (i in 0..true) { i }", 1 },
+		{ "let fib = fun(n) { if (n < 2) { return n }; fib(n - 1) + fib(n - 2) }; fib(15)", 2 },
+		{ "let make = fun() { var c = 0; fun() { ++c } }; let counter = make(); counter(); counter()", 4 },
+		{ "let curry = fun(x) { fun(y) { x + y } }; curry(1)(2)", 2 },
+		{ "let f = fun() { g() }; let g = fun() { 5 }; f() + f()", 3 },
+		{ "var a = [2, 4, 6]; a[2] += 12; a[2] + a[0] + a[1]", 3 },
+		{ "[1, \"Hello world!\", 12 / 3][1]", 1 },
+		{ "var a = [1.5, 2.5]; a[0] *= 2; a[1] = 1; a", 4 },
+		{ "var a = [1, 2]; var y = a[0]; a[0] = 5; y", 4 },
+		{ "var a = [1, 2]; for (x in a) { ++x }; a[0] + a[1]", 3 },
+		{ "var a = [1, 2, 3, 4]; var v = a[1:3]; v[0] = 20; let w = a[:]; a[2] = 30; [w, v[1:]]", 6 },
+		{ "let a = [true]; a[0] = false", 2 },
+		{ "var m = 12; m %= 5; m", 3 },
+		{ "var m = {\"a\": 1, 2: [3]}; m[\"a\"] += 4; m[\"b\"] = m[2]; m", 4 },
+		{ "{[1]: 2}", 1 },
+		{ "var o = ordered([3, 1]); o[2] = 5; o[1] = false; o[3] = 4; o[3] += 1; o", 6 },
+		{ "let f: fun = fun(x: int): int { x + 2 }; f(3)", 2 },
+		{ "if (11 > 2) { return true * false } return 1", 2 },
+		{ "let b = 1; b = 3", 2 },
+		{ "var c = 12; var c = 1", 2 },
+		{ "let f = fun(a): bool { a }; f(1)", 2 },
+		{ "let add = fun(a, b) { a + b }; add(1)", 2 },
+		{ "missing = other", 1 },
+		{ "-true", 1 },
+		{ "283 return 2", 2 }
+	};
+
+	for (const auto& [input, statements] : tests)
+	{
+		SCOPED_TRACE(input);
+		shared_ptr<Program> evaluated, translated;
+		ASSERT_NO_FATAL_FAILURE(initParser(evaluated, input, statements));
+		ASSERT_NO_FATAL_FAILURE(initParser(translated, input, statements));
+
+		auto interpreter = make_shared<Evaluator>();
+		auto expected = interpreter->evaluate(evaluated, make_shared<Environment>());
+		auto evaluator = make_shared<Evaluator>();
+		evaluator->enable_closures();
+		auto result = evaluator->evaluate(translated, make_shared<Environment>());
+
+		testEqual(result, expected);
+		EXPECT_EQ(result->isMutable, expected->isMutable);
+		EXPECT_NE(translated->tree, nullptr);
+
+		const auto& stats = evaluator->stats();
+		const auto& expectedStats = interpreter->stats();
+		EXPECT_EQ(stats.calls, expectedStats.calls);
+		EXPECT_EQ(stats.pooledFrames, expectedStats.pooledFrames);
+		EXPECT_EQ(stats.specializationHits, expectedStats.specializationHits);
+		EXPECT_EQ(stats.specializationMisses, expectedStats.specializationMisses);
+		EXPECT_EQ(stats.reusedScopes, expectedStats.reusedScopes);
+	}
+}
+
+
+}
\ No newline at end of file
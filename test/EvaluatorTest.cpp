@@ -161,7 +161,10 @@ TEST(EvaluatorTest, evaluateError)
 		{ R"(_builtin_(1, 12))", "error - invalid arguments: unknown function for argument type integer" },
 		{ R"(let a = 11; let a = 2)", "error - repeat declaration: a" },
 		{ R"(let b = 1; b = 3)", "error - cannot access immutable variable: b" },
-		{ R"(var c = 12; var c = 1)", "error - repeat declaration: c" }
+		{ R"(var c = 12; var c = 1)", "error - repeat declaration: c" },
+		{ R"(let n: int = 1.5)", "error - annotation mismatch: expected n to be int, but got float" },
+		{ R"(let f = fun(a: int, b: string) { a }; f(1, 2))", "error - annotation mismatch: expected b to be string, but got integer" },
+		{ R"(let f = fun(a): bool { a }; f(1))", "error - annotation mismatch: expected result to be bool, but got integer" }
 	};
 
 	for (const auto& [input, error] : tests)
@@ -185,7 +188,9 @@ TEST(EvaluatorTest, evaluateDeclaration)
 		{ "var a = 1; a", 1 },
 		{ "var a = 5 * 5; a", 25 },
 		{ "var a = 2; var b = a; b", 2 },
-		{ "var a = 11; var b = 22; var c = a + b - 1; c", 32 }
+		{ "var a = 11; var b = 22; var c = a + b - 1; c", 32 },
+		{ "let a: int = 1; var b: int = a + 1; b", 2 },
+		{ "let f = fun(n: int): int { n * 2 }; f(3)", 6 }
 	};
 
 	for (const auto& [input, value] : tests)
@@ -237,7 +242,16 @@ TEST(EvaluatorTest, evaluateString)
 		string value;
 	} tests[] = {
 		{ R"("Hello world!")", "Hello world!" },
-		{ R"("Hello" + " " + "world" + "!")", "Hello world!" }
+		{ R"("Hello" + " " + "world" + "!")", "Hello world!" },
+		{ R"(var s = ""; var i = 0; while (i < 5) { s += "ab"; ++i }; s)", "ababababab" },
+		{ R"(var s = ""; for (c in ["x", "y", "z"]) { s = s + c }; s)", "xyz" },
+		// Strings sharing a buffer keep their own characters whichever of them appends
+		{ R"(var s = "ab"; var t = s + "c"; var u = s + "d"; t + u + s)", "abcabdab" },
+		{ R"(var s = "ab"; var t = s + ""; t += "c"; s += "d"; s + t)", "abdabc" },
+		{ R"(var s = "ab"; s += s; s + s)", "abababab" },
+		{ R"(var s = "a"; var t = s; s += "b"; t)", "ab" },
+		{ R"("abc"[1])", "b" },
+		{ R"(let s = "abc"; s[0] + s[2])", "ac" }
 	};
 
 	for (const auto& [input, value] : tests)
@@ -245,6 +259,13 @@ TEST(EvaluatorTest, evaluateString)
 		SCOPED_TRACE(input);
 		testEqual(initEvaluator(input), make_shared<String>(value));
 	}
+
+	testEqual(initEvaluator(R"("abc"[3])"), Evaluator::null);
+	testEqual(initEvaluator(R"("abc"[-1])"), Evaluator::null);
+	testEqual(initEvaluator(R"("ab" == "a" + "b")"), Evaluator::bool_true);
+	testEqual(initEvaluator(R"("ab" != "a" + "b")"), Evaluator::bool_false);
+	testEqual(initEvaluator(R"(let s = "a"; s += "b")"), make_shared<Error>("error - cannot access immutable variable: s"));
+	testEqual(initEvaluator(R"("a" + 1)"), make_shared<Error>("error - infix operand type mismatch: string + integer"));
 }
 
 TEST(EvaluatorTest, evaluateAssign)
@@ -323,7 +344,11 @@ TEST(EvaluatorTest, evaluateIndex)
 		{ "var a = [1, 2, 3]; a[1] = 11; a[1]", 11 },
 		{ "var a = [2, 4, 6]; a[2] += 12", 18 },
 		{ "var a = [2, 4, 6]; a[2] += 12; a[2]", 18 },
-		{ "var a = [1]; fun(array) { array[0] = 11 }(a); a[0]", 1 }
+		{ "var a = [1]; fun(array) { array[0] = 11 }(a); a[0]", 1 },
+		// Elements a name holds as well are shared with it
+		{ "var x = 1; let b = [x]; ++x; b[0]", 2 },
+		{ "var a = [1, 2]; var y = a[0]; a[0] = 5; y", 5 },
+		{ "var a = [1, 2]; a[0] = true; a[1]", 2 }
 	};
 
 	for (const auto& [input, value] : tests)
@@ -337,12 +362,179 @@ TEST(EvaluatorTest, evaluateIndex)
 	testEqual(initEvaluator("[2, 4, 6][-1]"), Evaluator::null);
 }
 
+TEST(EvaluatorTest, evaluateUnboxedArray)
+{
+	struct Expected
+	{
+		string input;
+		Array::Kind kind;
+		string inspected;
+	} tests[] = {
+		{ "let a = [1, 2, 3]; a", Array::Kind::Integer, "[1, 2, 3]" },
+		{ "let a = [1.5, 2.5]; a", Array::Kind::Float, "[1.5, 2.5]" },
+		{ "let a = [true, 1 > 2]; a", Array::Kind::Bool, "[true, false]" },
+		{ "let a = [1, \"s\"]; a", Array::Kind::Boxed, "[1, s]" },
+		{ "var x = 1; let a = [x]; a", Array::Kind::Boxed, "[1]" },
+		{ "var a = [1, 2]; a[1] += 5; a", Array::Kind::Integer, "[1, 7]" },
+		{ "var a = [1, 2]; a[0] = 1.5; a", Array::Kind::Boxed, "[1.5, 2]" },
+		{ "var a = [true]; a[0] = false; a", Array::Kind::Bool, "[false]" },
+		{ "var a = [1, 2]; let s = a[0] + a[1]; a", Array::Kind::Integer, "[1, 2]" },
+		{ "var a = [1, 2]; let y = a[0]; a", Array::Kind::Boxed, "[1, 2]" },
+		{ "var a = []; a = [1]; a = [2]; a", Array::Kind::Integer, "[1, 2]" },
+		{ "var a = [1]; a = [2.5]; a", Array::Kind::Boxed, "[1, 2.5]" },
+		{ "var a = [1, 2]; var s = 0; for (x in a) { s += x }; a", Array::Kind::Integer, "[1, 2]" },
+		{ "var a = [1, 2]; for (x in a) { ++x }; a", Array::Kind::Boxed, "[2, 3]" },
+		{ "let f = fun(a) { a }; f([1, 2])", Array::Kind::Integer, "[1, 2]" }
+	};
+
+	for (const auto& [input, kind, inspected] : tests)
+	{
+		SCOPED_TRACE(input);
+		auto evaluated = initEvaluator(input);
+		ASSERT_EQ(evaluated->type, Object::Type::Array);
+		EXPECT_EQ(static_cast<Array&>(*evaluated).kind, kind);
+		EXPECT_EQ(evaluated->inspect(), inspected);
+	}
+
+	// Writing an element of a bool array leaves the constants alone
+	testEqual(initEvaluator("var a = [true]; a[0] = false; true"), Evaluator::bool_true);
+}
+
+TEST(EvaluatorTest, evaluateMap)
+{
+	struct Expected
+	{
+		string input;
+		string inspected;
+	} tests[] = {
+		{ R"({"a": 1, 2: "b", true: 1.5, 0.5: [1]})", "{a: 1, 2: b, true: 1.5, 0.5: [1]}" },
+		{ "{}", "{}" },
+		{ R"({"a": 1, "a": 2})", "{a: 2}" },
+		{ R"({"a": 1}["a"])", "1" },
+		{ R"({"a": 1}["b"])", "null" },
+		// Keys of different types are different keys
+		{ R"({1: "int", 1.0: "float", "1": "string"}[1.0])", "float" },
+		{ "{0.0: 1}[-0.0]", "1" },
+		{ R"(var m = {"a": 1}; m["b"] = 2; m)", "{a: 1, b: 2}" },
+		{ R"(var m = {"a": 1}; m["a"] += 5; m)", "{a: 6}" },
+		{ R"(var m = {"a": 1}; m["a"] = "s"; m["a"])", "s" },
+		{ R"(var m = {"a": [1]}; m["a"] = [2]; m)", "{a: [1, 2]}" },
+		{ R"(var m = {"a": {"b": 1}}; m["a"]["c"] = 2; m)", "{a: {b: 1, c: 2}}" },
+		// Values a name holds as well are shared with it as elements are, keys never are
+		{ R"(var x = 1; var m = {"a": x}; ++x; m["a"])", "2" },
+		{ R"(var k = "a"; var m = {k: 1}; k += "b"; m)", "{a: 1}" },
+		{ R"(var m = {"a": 1}; var n = m; n["b"] = 2; m)", "{a: 1, b: 2}" },
+		{ R"(let m = {"a": 1}; m["a"] = 2)", "error - cannot access immutable variable: [" },
+		{ R"(let m = {"a": 1}; m["b"] = 2)", "error - cannot access immutable variable: [" },
+		{ R"({[1]: 2})", "error - index operand type: map[array]" },
+		{ R"({"a": 1}[[1]])", "error - index operand type: map[array]" },
+		// NaN is equal to no key, so it can not be one
+		{ "{0.0 / 0.0: 1}", "error - invalid key: expected a key of the map that is not NaN" },
+		{ "var m = {}; m[0.0 / 0.0] = 1; m", "error - invalid key: expected a key of the map that is not NaN" },
+		{ R"({"a": 1}[0.0 / 0.0])", "error - invalid key: expected a key of the map that is not NaN" }
+	};
+
+	for (const auto& [input, inspected] : tests)
+	{
+		SCOPED_TRACE(input);
+		EXPECT_EQ(initEvaluator(input)->inspect(), inspected);
+	}
+}
+
+TEST(EvaluatorTest, evaluateSlice)
+{
+	struct Expected
+	{
+		string input;
+		string inspected;
+	} tests[] = {
+		{ "[1, 2, 3, 4][1:3]", "[2, 3]" },
+		{ "[1, 2, 3, 4][:2]", "[1, 2]" },
+		{ "[1, 2, 3, 4][2:]", "[3, 4]" },
+		{ "[1, 2, 3, 4][-5:10]", "[1, 2, 3, 4]" },
+		{ "[1, 2, 3, 4][3:1]", "[]" },
+		{ "[1, 2, 3, 4][1:][1:]", "[3, 4]" },
+		{ R"("Hello world!"[6:11])", "world" },
+		// A view of a mutable array changes it and sees it change, also when it is passed on
+		{ "var a = [1, 2, 3]; var v = a[1:]; v[0] = 20; a", "[1, 20, 3]" },
+		{ "var a = [1, 2, 3]; var v = a[1:]; a[2] = 30; v", "[2, 30]" },
+		{ "var a = [1, 2, 3]; fun(v) { v[0] += 10 }(a[2:]); a", "[1, 2, 13]" },
+		{ R"(var a = [1, "s"]; var v = a[:1]; v[0] = [2]; a)", "[[2], s]" },
+		// A view of an immutable array copies the elements it is written, an immutable one at once
+		{ "let a = [1, 2, 3]; var v = a[1:]; v[0] = 20; a", "[1, 2, 3]" },
+		{ "let a = [1, 2, 3]; var v = a[1:]; v[0] = 20; v", "[20, 3]" },
+		{ "var a = [1, 2, 3]; let v = a[1:]; a[1] = 20; v", "[2, 3]" },
+		{ "let a = [1, 2, 3]; let v = a[1:]; v[0] = 20", "error - cannot access immutable variable: [" },
+		// Appending to a view gives it elements of its own
+		{ "var a = [1, 2, 3]; var v = a[:1]; v = [4]; a", "[1, 2, 3]" },
+		{ "var a = [1, 2, 3]; a = a[1:]; a", "[1, 2, 3, 2, 3]" },
+		{ "var a = [1, 2, 3]; var s = 0; for (x in a[1:]) { s += x }; s", "5" },
+		{ "[1, 2][true:]", "error - index operand type: array[bool:]" },
+		{ R"({"a": 1}[0:1])", "error - index operand type: map[integer:integer]" }
+	};
+
+	for (const auto& [input, inspected] : tests)
+	{
+		SCOPED_TRACE(input);
+		EXPECT_EQ(initEvaluator(input)->inspect(), inspected);
+	}
+
+	// The view shares the elements of its parent rather than copying them
+	auto evaluated = initEvaluator("var a = [1, 2, 3, 4]; var v = a[1:3]; v[1:]");
+	ASSERT_EQ(evaluated->type, Object::Type::Array);
+	auto& view = static_cast<Array&>(*evaluated);
+	ASSERT_TRUE(view.isView());
+	size_t from;
+	EXPECT_EQ(view.storage(from).size(), 4);
+	EXPECT_EQ(from, 2);
+	EXPECT_EQ(view.size(), 1);
+}
+
 TEST(EvaluatorTest, evaluateWhile)
 {
 	string input = "var sum = 0; var index = 1; while (index <= 100) { sum = sum + index; index = index + 1 }; sum";
 	testEqual(initEvaluator(input), make_shared<Integer>(5050));
 }
 
+TEST(EvaluatorTest, evaluateFor)
+{
+	struct Expected
+	{
+		string input;
+		size_t statements;
+		shared_ptr<Object> value;
+		uint64_t reusedScopes;
+	} tests[] = {
+		{ "var s = 0; for (i in 0..100) { s += i }; s", 3, make_shared<Integer>(4950), 99 },
+		{ "var s = 0; for (x in [2, 4, 6]) { s += x }; s", 3, make_shared<Integer>(12), 2 },
+		{ "var s = 0; for (i in 5..2) { s += 1 }; s", 3, make_shared<Integer>(0), 0 },
+		{ "var s = 0; for (i in 0..3) { let d = i * 2; s += d }; s", 3, make_shared<Integer>(6), 2 },
+		{ "var s = 0; for (i in 0..3) { for (j in 0..i) { s += j } }; s", 3, make_shared<Integer>(1), 3 },
+		// The number and the scope kept by an array or a closure are not reused
+		{ "var a = [9]; for (i in 0..3) { a = [i] }; a[1] * 10 + a[3]", 3, make_shared<Integer>(2), 2 },
+		{ "var a = [0]; for (i in 1..3) { a = [fun() { i }] }; a[1]() * 10 + a[2]()", 3, make_shared<Integer>(12), 1 },
+		{ "let f = fun(a) { for (i in 0..10) { if (a[i] == 4) { return i } }; 0 }; f([1, 4, 8])", 2, make_shared<Integer>(1), 1 },
+		{ "for (i in 0..3) { i = 1 }", 1, make_shared<Error>("error - cannot access immutable variable: i"), 0 },
+		// Elements are bound themselves, so assigning to them changes the array unless it is immutable
+		{ "var a = [1, 2, 3]; for (x in a) { x = 7 }; a[0] + a[2]", 3, make_shared<Integer>(14), 2 },
+		{ "var a = [1, 2, 3]; for (x in a) { x += 1 }; a[2]", 3, make_shared<Integer>(4), 2 },
+		{ "let a = [1, 2]; for (x in a) { x = 7 }", 2, make_shared<Error>("error - cannot access immutable variable: x"), 0 },
+		{ "for (i in 0..2.5) { i }", 1, make_shared<Error>("error - range operand type: integer..float"), 0 },
+		{ "for (c in \"abc\") { c }", 1, make_shared<Error>("error - expected range or array to iterate: string"), 0 }
+	};
+
+	for (const auto& [input, statements, value, reusedScopes] : tests)
+	{
+		SCOPED_TRACE(input);
+		shared_ptr<Program> program;
+		ASSERT_NO_FATAL_FAILURE(initParser(program, input, statements));
+
+		auto evaluator = make_shared<Evaluator>();
+		testEqual(evaluator->evaluate(program, make_shared<Environment>()), value);
+		EXPECT_EQ(evaluator->stats().reusedScopes, reusedScopes);
+	}
+}
+
 TEST(EvaluatorTest, evaluateInDecrement)
 {
 	struct Expected
@@ -363,5 +555,215 @@ TEST(EvaluatorTest, evaluateInDecrement)
 	}
 }
 
+TEST(EvaluatorTest, evaluateInlineCache)
+{
+	struct Expected
+	{
+		string input;
+		int64_t value;
+	} tests[] = {
+		{ "let f = fun() { g() }; let g = fun() { 5 }; f() + f()", 10 },
+		{ "let x = 1; let f = fun() { x }; let a = f(); let g = fun(x) { f() + x }; g(10) + a", 12 },
+		{ "var total = 0; var i = 0; while (i < 3) { total += i; ++i }; total", 3 },
+		{ "var r = 0; let x = 5; var i = 0; while (i < 2) { r += x; let x = 1; ++i }; r", 10 }
+	};
+
+	for (const auto& [input, value] : tests)
+	{
+		SCOPED_TRACE(input);
+		testEqual(initEvaluator(input), make_shared<Integer>(value));
+	}
+}
+
+TEST(EvaluatorTest, evaluateClosure)
+{
+	struct Expected
+	{
+		string input;
+		int64_t value;
+	} tests[] = {
+		{ "let make = fun() { var c = 0; fun() { ++c } }; let f = make(); f(); f(); f()", 3 },
+		{ "let a = fun(x) { fun(y) { fun(z) { x + y + z } } }; a(1)(2)(3)", 6 },
+		{ "let x = 1; let f = fun() { let g = fun() { x }; let x = 5; g() }; f()", 5 },
+		{ "let f = fun(x) { fun() { let y = x; let x = 2; y + x } }; f(10)()", 12 },
+		{ "let f = fun() { let fact = fun(n) { if (n < 2) { return 1 }; n * fact(n - 1) }; fact(5) }; f()", 120 }
+	};
+
+	for (const auto& [input, value] : tests)
+	{
+		SCOPED_TRACE(input);
+		testEqual(initEvaluator(input), make_shared<Integer>(value));
+	}
+
+	// Only the referenced variable is captured, the closure does not keep the frame of make alive
+	auto evaluated = initEvaluator("let make = fun() { let big = [1, 2, 3]; let n = 5; fun() { n } }; make()");
+	ASSERT_EQ(evaluated->typeName(), "function");
+	auto cast = dynamic_pointer_cast<Function>(evaluated);
+	ASSERT_NE(cast->captures, nullptr);
+	EXPECT_EQ(cast->captures->values.size(), 1);
+	EXPECT_EQ(cast->env->kind, Environment::Kind::Global);
+}
+
+TEST(EvaluatorTest, evaluatePooledFrame)
+{
+	shared_ptr<Program> program;
+	ASSERT_NO_FATAL_FAILURE(initParser(program, "let fib = fun(n) { if (n < 2) { return n }; fib(n - 1) + fib(n - 2) }; fib(10)", 2));
+
+	auto evaluator = make_shared<Evaluator>();
+	testEqual(evaluator->evaluate(program, make_shared<Environment>()), make_shared<Integer>(55));
+	EXPECT_EQ(evaluator->stats().calls, 177);
+	EXPECT_EQ(evaluator->stats().pooledFrames, 177);
+}
+
+TEST(EvaluatorTest, evaluateNumberArguments)
+{
+	struct Expected
+	{
+		string input;
+		size_t statements;
+		string inspected;
+		uint64_t reusedNumbers;
+	} tests[] = {
+		{ "let f = fun(a: int, b: float) { a * b }; f(1, 2.0) + f(2, 3.0) + f(3, 4.0)", 2, "20", 4 },
+		{ "let fib = fun(n: int) { if (n < 2) { return 1 }; fib(n - 1) + fib(n - 2) }; fib(10)", 2, "89", 167 },
+		// A number the result, a closure or a name still holds is not reused
+		{ "let f = fun(a: int) { a }; let x = f(1); let y = f(2); x * 10 + y", 4, "12", 0 },
+		{ "let f = fun(a: int) { fun() { a } }; f(1)() * 10 + f(2)()", 2, "12", 0 },
+		{ "let f = fun(a) { a + 1 }; f(1) + f(2)", 2, "5", 0 }
+	};
+
+	for (const auto& [input, statements, inspected, reusedNumbers] : tests)
+	{
+		SCOPED_TRACE(input);
+		shared_ptr<Program> program;
+		ASSERT_NO_FATAL_FAILURE(initParser(program, input, statements));
+
+		auto evaluator = make_shared<Evaluator>();
+		EXPECT_EQ(evaluator->evaluate(program, make_shared<Environment>())->inspect(), inspected);
+		EXPECT_EQ(evaluator->stats().reusedNumbers, reusedNumbers);
+	}
+}
+
+TEST(EvaluatorTest, evaluateCallbackFrame)
+{
+	struct Expected
+	{
+		string input;
+		size_t statements;
+		string inspected;
+		uint64_t calls;
+		uint64_t reusedFrames;
+	} tests[] = {
+		{ "map([1, 2, 3], fun(x) { x * 2 })", 1, "[2, 4, 6]", 3, 2 },
+		{ "reduce([1, 2, 3], fun(s, x) { s + x }, 0)", 1, "6", 3, 2 },
+		{ "let f = fun(x) { x + 1 }; map([1, 2], fun(x) { f(x) })", 2, "[2, 3]", 4, 1 },
+		// The frame is reused, the number a closure captured is not written over
+		{ "let a = map([1, 2], fun(x) { fun() { x } }); a[0]() + a[1]()", 2, "3", 4, 1 },
+		{ "each([], fun(x) { x })", 1, "null", 0, 0 }
+	};
+
+	for (const auto& [input, statements, inspected, calls, reusedFrames] : tests)
+	{
+		SCOPED_TRACE(input);
+		shared_ptr<Program> program;
+		ASSERT_NO_FATAL_FAILURE(initParser(program, input, statements));
+
+		auto evaluator = make_shared<Evaluator>();
+		EXPECT_EQ(evaluator->evaluate(program, make_shared<Environment>())->inspect(), inspected);
+		EXPECT_EQ(evaluator->stats().calls, calls);
+		EXPECT_EQ(evaluator->stats().reusedFrames, reusedFrames);
+	}
+}
+
+TEST(EvaluatorTest, evaluateParallel)
+{
+	struct Expected
+	{
+		string input;
+		size_t statements;
+		string inspected;
+		bool parallel;
+		uint64_t serialCallbacks;
+	} tests[] = {
+		{ "pmap([1, 2, 3, 4, 5], fun(x) { x * x })", 1, "[1, 4, 9, 16, 25]", true, 0 },
+		{ "preduce([1, 2, 3, 4, 5], fun(s, x) { s + x }, 0)", 1, "15", true, 0 },
+		{ "let k = 3; pmap([1, 2], fun(x) { let y = x * k; y })", 2, "[3, 6]", true, 0 },
+		{ "pmap([1, 2], fun(x) { var a = [x]; a[0] = x + 1; a })", 1, "[[2], [3]]", true, 0 },
+		// The callback changes or reads what all of them share, so it is called one element after another
+		{ "var n = 0; pmap([1, 2, 3], fun(x) { n += x; x }); n", 3, "6", false, 1 },
+		{ "var k = 3; pmap([1, 2], fun(x) { x * k })", 2, "[3, 6]", false, 1 },
+		{ "pmap([1, 2], fun(x) { let op = 1; _builtin_(op, [x]) })", 1, "[1, 1]", false, 1 },
+		{ "pmap([1, 2], fun(x) { _builtin_(1, [x]) })", 1, "[1, 1]", true, 0 },
+		// The array the workers would read becomes mutable, so the elements are done again serially
+		{ "let a = [1]; pmap([1, 2], fun(x) { var b = a; b })", 2, "[[1], [1]]", false, 1 },
+		{ "let a = [1]; pmap([1, 2], fun(x) { if (x > 1) { var b = a; return b }; x })", 2, "[1, [1]]", true, 1 },
+		{ "pmap([], fun(x) { x })", 1, "[]", false, 0 },
+		// Slices of an array all workers read, which are read without the box of the array
+		{ "let a = [1, 2, 3, 4, 5, 6]; pmap([1, 2, 3, 4], fun(x) { var v = a[1:5]; var s = 0; for (i in 0..4) { s += v[i] }; s * x })", 2, "[14, 28, 42, 56]", true, 0 },
+		{ "let a = [1.5, 2.5, 3.5]; pmap([1, 2], fun(x) { let v = a[1:]; var w = v[1:]; v[0] + w[0] * x })", 2, "[6, 9.5]", true, 0 }
+	};
+
+	for (const auto& [input, statements, inspected, parallel, serialCallbacks] : tests)
+	{
+		for (bool closures : { false, true })
+		{
+			SCOPED_TRACE(input + (closures ? " as closures" : ""));
+			shared_ptr<Program> program;
+			ASSERT_NO_FATAL_FAILURE(initParser(program, input, statements));
+
+			auto evaluator = make_shared<Evaluator>();
+			evaluator->enable_threads();
+			if (closures)
+			{
+				evaluator->enable_closures();
+			}
+			EXPECT_EQ(evaluator->evaluate(program, make_shared<Environment>())->inspect(), inspected);
+			EXPECT_EQ(evaluator->stats().parallelRuns > 0, parallel);
+			EXPECT_EQ(evaluator->stats().serialCallbacks, serialCallbacks);
+		}
+	}
+}
+
+TEST(EvaluatorTest, evaluateConstants)
+{
+	// Names that may be assigned hold copies of true, false and null, assigning them leaves the constants alone
+	EXPECT_EQ(initEvaluator("var b = false; b = true; false")->inspect(), "false");
+	EXPECT_EQ(initEvaluator("var a = [true]; a[0] = false; true")->inspect(), "true");
+	EXPECT_EQ(initEvaluator("let f = fun(x) { x = true; x }; f(false); false")->inspect(), "false");
+}
+
+TEST(EvaluatorTest, evaluateSpecialization)
+{
+	struct Expected
+	{
+		string input;
+		size_t statements;
+		shared_ptr<Object> value;
+		uint64_t hits;
+		uint64_t misses;
+	} tests[] = {
+		{ "let f = fun(a, b) { a * b + 1 }; f(2, 3); f(4, 5)", 3, make_shared<Integer>(21), 2, 0 },
+		{ "let f = fun(a, b) { a * b + 1 }; var x = 0; while (x < 3) { x = f(x, 2) }; x", 4, make_shared<Integer>(3), 10, 0 },
+		{ "let f = fun(a, b) { a + b }; var x = 0.5; while (x < 4) { x = f(x, 1.5) }; x", 4, make_shared<Float>(5), 16, 0 },
+		{ "let f = fun(a, b) { a + b }; f(1, 2); f(1.5, 2)", 3, make_shared<Float>(3.5), 0, 1 },
+		{ "let f = fun(a, b) { a + b }; f(1, 2); f(\"a\", \"b\"); f(3, 4)", 4, make_shared<Integer>(7), 0, 1 },
+		{ "let f = fun(a) { -a }; f(1); f(2.5)", 3, make_shared<Float>(-2.5), 0, 1 },
+		{ "let f = fun(a, i) { a[i] }; f([1, 2], 1); f([3], 5)", 3, Evaluator::null, 1, 0 },
+		{ "let f = fun(g) { g(2) }; f(fun(x) { x }); f(3)", 3, make_shared<Error>("error - expected function: integer"), 0, 1 }
+	};
+
+	for (const auto& [input, statements, value, hits, misses] : tests)
+	{
+		SCOPED_TRACE(input);
+		shared_ptr<Program> program;
+		ASSERT_NO_FATAL_FAILURE(initParser(program, input, statements));
+
+		auto evaluator = make_shared<Evaluator>();
+		testEqual(evaluator->evaluate(program, make_shared<Environment>()), value);
+		EXPECT_EQ(evaluator->stats().specializationHits, hits);
+		EXPECT_EQ(evaluator->stats().specializationMisses, misses);
+	}
+}
+
 
 }
\ No newline at end of file
@@ -0,0 +1,317 @@
+#include <gtest/gtest.h>
+#include "initialization.h"
+#include "ir/Builder.h"
+#include "ir/PassManager.h"
+#include "ir/CopyPropagation.h"
+#include "ir/TypePropagation.h"
+#include "ir/NumericSpecialization.h"
+#include "ir/Lowering.h"
+#include "ast/ExpressionStat.hpp"
+#include "evaluator/Evaluator.h"
+#include "object/Integer.hpp"
+#include "object/Float.hpp"
+#include "object/Bool.hpp"
+#include "object/String.hpp"
+#include "object/Error.hpp"
+#include <sstream>
+
+namespace li::test
+{
+
+
+TEST(IRTest, build)
+{
+	shared_ptr<Program> program;
+	ASSERT_NO_FATAL_FAILURE(initParser(program, "let f = fun(n) { var s = 0; if (n > 1) { s = n }; s }", 1));
+
+	auto module = ir::Builder::build(program);
+	ASSERT_EQ(module->functions.size(), 2);
+	EXPECT_EQ(module->functions[1]->name, "f");
+
+	stringstream out;
+	module->functions[1]->print(out);
+	EXPECT_EQ(out.str(),
+		"function @1 f(n)\n"
+		"b0:\n"
+		"  %0 = param n : unknown\n"
+		"  %1 = const 0 : unknown\n"
+		"  declare var s, %1\n"
+		"  %2 = const 1 : unknown\n"
+		"  %3 = infix > %0, %2 : unknown\n"
+		"  branch %3, b2, b1\n"
+		"b1: ; preds b0\n"
+		"  %4 = const null : unknown\n"
+		"  jump b3\n"
+		"b2: ; preds b0\n"
+		"  %5 = assign = %1, %0 : unknown\n"
+		"  jump b3\n"
+		"b3: ; preds b2, b1\n"
+		"  %6 = phi [%1, b2], [%1, b1] : unknown\n"
+		"  %7 = phi [%5, b2], [%4, b1] : unknown\n"
+		"  return %6\n");
+}
+
+TEST(IRTest, notModeled)
+{
+	string tests[] = {
+		"let f = fun(n) { let a = if (n) { return 1 } else { 2 }; a }",
+		"let f = fun(n) { var i = 0; while (i < n) { let a = if (i) { return 1 }; ++i } }"
+	};
+
+	for (const auto& input : tests)
+	{
+		SCOPED_TRACE(input);
+		shared_ptr<Program> program;
+		ASSERT_NO_FATAL_FAILURE(initParser(program, input, 1));
+
+		auto module = ir::Builder::build(program);
+		EXPECT_TRUE(module->functions[0]->supported);
+		EXPECT_FALSE(module->functions[1]->supported);
+	}
+}
+
+TEST(IRTest, copyPropagation)
+{
+	shared_ptr<Program> program;
+	ASSERT_NO_FATAL_FAILURE(initParser(program, "let f = fun(n) { var i = 0; while (i < n) { ++i }; if (n) { 1 }; i }", 1));
+
+	auto module = ir::Builder::build(program);
+	ir::CopyPropagation pass;
+	EXPECT_GT(pass.run(*module->functions[1]), 0);
+
+	for (const auto& block : module->functions[1]->blocks)
+	{
+		for (auto* inst : block->instructions)
+		{
+			EXPECT_NE(inst->opcode, ir::Opcode::Phi);
+		}
+	}
+}
+
+TEST(IRTest, typePropagation)
+{
+	struct Expected
+	{
+		string input;
+		ir::Type type;
+	} tests[] = {
+		{ "1 + 2", ir::Type::Integer },
+		{ "1 + 2.5", ir::Type::Float },
+		{ "1 < 2", ir::Type::Bool },
+		{ "\"a\" + \"b\"", ir::Type::String },
+		{ "[1, 2]", ir::Type::Array },
+		{ "var a = 1; var b = a * 2; b", ir::Type::Integer },
+		{ "let f = fun() { 1 }; f()", ir::Type::Any },
+		{ "var a = 1; if (x) { a = 2 }; a - 1", ir::Type::Integer },
+		{ "if (x) { 1 } else { \"a\" }", ir::Type::Any }
+	};
+
+	for (const auto& [input, type] : tests)
+	{
+		SCOPED_TRACE(input);
+		shared_ptr<Program> program;
+		ASSERT_NO_FATAL_FAILURE(initParser(program, input, count(input.begin(), input.end(), ';') + 1));
+
+		auto module = ir::Builder::build(program);
+		auto& function = *module->functions[0];
+		ir::TypePropagation().run(function);
+
+		auto* value = function.value(static_pointer_cast<ExpressionStat>(program->statements.back())->expression.get());
+		ASSERT_NE(value, nullptr);
+		EXPECT_EQ(ir::type_name(value->type), ir::type_name(type));
+	}
+}
+
+TEST(IRTest, passes)
+{
+	struct Expected
+	{
+		string input;
+		size_t statements;
+		size_t reused;
+		size_t dropped;
+		int64_t value;
+	} tests[] = {
+		{ "let f = fun(a, i) { a[i] * a[i] }; f([3, 4], 1)", 2, 1, 0, 16 },
+		{ "let f = fun(x) { (x + 1) * (x + 1) }; f(2)", 2, 1, 0, 9 },
+		{ "let f = fun(a) { var s = 0; var i = 0; while (i < 3) { if (a[i] > 1) { s = s + a[i] }; ++i }; s }; f([1, 2, 3])", 2, 1, 0, 5 },
+		{ "let f = fun(a) { let b = a[0] + 1; a[0] = 5; b + a[0] + 1 }; f([1])", 2, 0, 0, 8 },
+		{ "let f = fun(a) { var b = a[0]; b = 7; a[0] + a[0] }; f([2])", 2, 1, 0, 14 },
+		{ "let f = fun(n) { var unused = [n, 1]; var s = 2; s = 3; s = 4; s }; f(5)", 2, 0, 2, 4 },
+		{ "let f = fun(n) { var s = n * 2; s = 3; s = 4; s }; f(5)", 2, 0, 0, 4 },
+		{ "let f = fun(n) { var t = m; 1 }; let m = 2; f(5)", 3, 0, 0, 1 },
+		{ "let f = fun(n) { var s = n; let g = fun() { s }; g() }; f(5)", 2, 0, 0, 5 },
+		{ "var unused = 1; unused + 1", 2, 0, 0, 2 }
+	};
+
+	for (const auto& [input, statements, reused, dropped, value] : tests)
+	{
+		SCOPED_TRACE(input);
+		shared_ptr<Program> program;
+		ASSERT_NO_FATAL_FAILURE(initParser(program, input, statements));
+
+		auto module = ir::Builder::build(program);
+		auto passes = ir::PassManager::standard();
+		passes->run(*module);
+		EXPECT_EQ(passes->changes("global value numbering"), reused);
+		EXPECT_EQ(passes->changes("dead store elimination"), dropped);
+		ir::Lowering::run(*module);
+
+		auto evaluator = make_shared<Evaluator>();
+		testEqual(evaluator->evaluate(program, make_shared<Environment>()), make_shared<Integer>(value));
+		EXPECT_EQ(evaluator->stats().reusedValues > 0, reused > 0);
+	}
+}
+
+TEST(IRTest, numericSpecialization)
+{
+	struct Expected
+	{
+		string input;
+		size_t statements;
+		size_t specialized;
+		shared_ptr<Object> value;
+	} tests[] = {
+		{ "var s = 0; var i = 0; while (i < 10) { s = s + i * 2; ++i }; s", 4, 3, make_shared<Integer>(90) },
+		{ "var x = 7; x / 2", 2, 1, make_shared<Integer>(3) },
+		{ "var x = 7.5; x / 2", 2, 1, make_shared<Float>(3.75) },
+		{ "var x = 7; x % 2.5", 2, 1, make_shared<Integer>(1) },
+		{ "let f = fun(n) { n * 2 }; f(3) + 1", 2, 0, make_shared<Integer>(7) },
+		{ "var x = 1; x + [1][0]", 2, 0, make_shared<Integer>(2) },
+		{ "var a = \"a\"; a + \"b\"", 2, 0, make_shared<String>("ab") },
+		{ "var x = 2.5; -x < x", 2, 1, make_shared<Bool>(true) }
+	};
+
+	for (const auto& [input, statements, specialized, value] : tests)
+	{
+		SCOPED_TRACE(input);
+		shared_ptr<Program> program;
+		ASSERT_NO_FATAL_FAILURE(initParser(program, input, statements));
+
+		auto module = ir::Builder::build(program);
+		auto passes = ir::PassManager::standard();
+		passes->run(*module);
+		EXPECT_EQ(passes->changes("numeric specialization"), specialized);
+		ir::Lowering::run(*module);
+
+		auto evaluator = make_shared<Evaluator>();
+		testEqual(evaluator->evaluate(program, make_shared<Environment>()), value);
+		EXPECT_EQ(evaluator->stats().numericOperations > 0, specialized > 0);
+	}
+}
+
+TEST(IRTest, specializationReport)
+{
+	shared_ptr<Program> program;
+	ASSERT_NO_FATAL_FAILURE(initParser(program, "let f = fun() { var a = 1; a * 2 + 1 }; let g = fun(n) { var a = 1; a * n + 1 }; let h = fun(n) { n }", 3));
+
+	auto module = ir::Builder::build(program);
+	ir::PassManager::standard()->run(*module);
+
+	stringstream out;
+	ir::NumericSpecialization::report(*module, out);
+	EXPECT_EQ(out.str(), "fully specialized: f, 1 unboxed\npartially specialized: g (0 of 2 operators)\n");
+}
+
+TEST(IRTest, unboxedChains)
+{
+	struct Expected
+	{
+		string input;
+		size_t statements;
+		uint64_t unboxed;
+		shared_ptr<Object> value;
+	} tests[] = {
+		{ "var x = 7; var y = 2; x / y * y + x % y", 3, 3, make_shared<Integer>(7) },
+		{ "var a = 1.5; var b = 2; a * b + b / 4", 3, 2, make_shared<Float>(3) },
+		{ "var i = 3; i * 2 + 1 < 10", 2, 2, make_shared<Bool>(true) },
+		{ "var s = 0; var i = 0; while (i < 4) { s = s + i * i; ++i }; s", 4, 4, make_shared<Integer>(14) },
+		{ "var x = 3; let y = x * 2; y + 1", 3, 0, make_shared<Integer>(7) },
+		{ "var x = 3; x * 2 + x * 2", 2, 0, make_shared<Integer>(12) }
+	};
+
+	for (const auto& [input, statements, unboxed, value] : tests)
+	{
+		SCOPED_TRACE(input);
+		shared_ptr<Program> program;
+		ASSERT_NO_FATAL_FAILURE(initParser(program, input, statements));
+
+		auto module = ir::Builder::build(program);
+		ir::PassManager::standard()->run(*module);
+		ir::Lowering::run(*module);
+
+		auto evaluator = make_shared<Evaluator>();
+		testEqual(evaluator->evaluate(program, make_shared<Environment>()), value);
+		EXPECT_EQ(evaluator->stats().unboxedValues, unboxed);
+	}
+}
+
+TEST(IRTest, nativeStores)
+{
+	struct Expected
+	{
+		string input;
+		size_t statements;
+		uint64_t stores;
+		shared_ptr<Object> value;
+	} tests[] = {
+		{ "var s = 0; var i = 0; while (i < 4) { s = s + i * i; ++i }; s", 4, 4, make_shared<Integer>(14) },
+		{ "let f = fun(n: int) { var s = 0.5; var i = 0; while (i < n) { s += i / 2; ++i }; s }; f(5)", 2, 5, make_shared<Float>(4.5) },
+		{ "let f = fun(a: int, b: int) { var r = a; r %= b; r *= 3; r -= 1; r }; f(7, 4)", 2, 3, make_shared<Integer>(8) },
+		{ "var x = 2; var y = x; x += 3; y", 4, 1, make_shared<Integer>(5) },
+		// The value of the block is read
+		{ "var x = 1; x = x + 1", 2, 0, make_shared<Integer>(2) }
+	};
+
+	for (const auto& [input, statements, stores, value] : tests)
+	{
+		SCOPED_TRACE(input);
+		shared_ptr<Program> program;
+		ASSERT_NO_FATAL_FAILURE(initParser(program, input, statements));
+
+		auto module = ir::Builder::build(program);
+		ir::PassManager::standard()->run(*module);
+		ir::Lowering::run(*module);
+
+		auto evaluator = make_shared<Evaluator>();
+		testEqual(evaluator->evaluate(program, make_shared<Environment>()), value);
+		EXPECT_EQ(evaluator->stats().nativeStores, stores);
+	}
+}
+
+TEST(IRTest, annotations)
+{
+	struct Expected
+	{
+		string input;
+		size_t statements;
+		size_t specialized;
+		size_t dropped;
+		shared_ptr<Object> value;
+	} tests[] = {
+		{ "let f = fun(a: int, b: float) { a * b + 1 }; f(2, 1.5)", 2, 2, 0, make_shared<Float>(4) },
+		{ "let f = fun(a) { let b: int = a; b + 1 }; f(2)", 2, 1, 0, make_shared<Integer>(3) },
+		{ "let f = fun(a) { let b: int = a; a + 1 }; f(2.5)", 2, 0, 0, make_shared<Error>("error - annotation mismatch: expected b to be int, but got float") },
+		{ "let f = fun(a) { let b: int = 1; a }; f(2)", 2, 0, 1, make_shared<Integer>(2) }
+	};
+
+	for (const auto& [input, statements, specialized, dropped, value] : tests)
+	{
+		SCOPED_TRACE(input);
+		shared_ptr<Program> program;
+		ASSERT_NO_FATAL_FAILURE(initParser(program, input, statements));
+
+		auto module = ir::Builder::build(program);
+		auto passes = ir::PassManager::standard();
+		passes->run(*module);
+		EXPECT_EQ(passes->changes("numeric specialization"), specialized);
+		EXPECT_EQ(passes->changes("dead store elimination"), dropped);
+		ir::Lowering::run(*module);
+
+		auto evaluator = make_shared<Evaluator>();
+		testEqual(evaluator->evaluate(program, make_shared<Environment>()), value);
+	}
+}
+
+
+}
\ No newline at end of file
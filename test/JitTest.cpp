@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include "initialization.h"
+#include "evaluator/Evaluator.h"
+
+namespace li::test
+{
+
+
+// Every program gives the same result compiled as interpreted, compilation is counted to make sure
+// the compiled code ran at all
+TEST(JitTest, sameResults)
+{
+	if (!jit::Jit::supported())
+	{
+		GTEST_SKIP();
+	}
+
+	struct Expected
+	{
+		string input;
+		size_t statements;
+		uint64_t functions;
+		uint64_t loops;
+		uint64_t bailouts;
+	} tests[] = {
+		{ "let fib = fun(n) { if (n < 2) { return n }; fib(n - 1) + fib(n - 2) }; fib(15)", 2, 1, 0, 0 },
+		{ "var s = 0; var i = 0; while (i < 100) { s = s + i * 2; ++i }; s", 4, 0, 1, 0 },
+		{ "var x = 0.5; var i = 0; while (i < 10) { x *= 1.5; ++i }; x", 4, 0, 1, 0 },
+		{ "var t = 0; var i = 0; while (i < 5) { var j = 0; while (j < i) { t += j; ++j }; ++i }; t", 4, 0, 1, 0 },
+		{ "var i = 0; var s = 0; while (i < 10) { ++i; if (i % 2 == 0) { return 1 }; s += i }; s", 4, 0, 1, 0 },
+		{ "let f = fun(a, b) { a % b }; f(7, 3) + f(9, 4) + f(7.5, 2)", 2, 1, 0, 1 },
+		{ "let f = fun(a, b) { if (!(a < b)) { a - b } else { -(b - a) } }; f(1.5, 2) + f(3, 1)", 2, 1, 0, 1 },
+		{ "let f = fun(n) { let m = n * 2; m }; f(3)", 2, 1, 0, 0 },
+		{ "let f = fun(n) { var m = n * 2; m }; f(3)", 2, 1, 0, 0 },
+		{ "let f = fun(x) { x + ++x }; f(1)", 2, 1, 0, 0 },
+		{ "let k = 2.5; let f = fun(x) { x * k }; f(2)", 3, 1, 0, 0 },
+		{ "let c = 0; let f = fun() { c = c + 1; 0 }; f(); f()", 4, 1, 0, 1 },
+		{ "var c = 0; let f = fun() { c += 2; 0 }; f(); f(); c", 5, 1, 0, 0 },
+		{ "let p = fun(x, n) { if (n == 0) { return x }; p(x * 1.5, n - 1) }; p(1.0, 5)", 2, 1, 0, 0 },
+		{ "let f = fun(a) { a >= 2 }; f(1); f(3)", 3, 1, 0, 0 },
+		{ "let f = fun(a) { var i = 0; while (i < a) { ++i }; i }; f(10) + f(20)", 2, 1, 0, 0 },
+		{ "let f = fun(a) { [a] }; f(1)", 2, 0, 0, 0 },
+		{ "let f = fun(a) { a }; f(\"a\")", 2, 0, 0, 0 }
+	};
+
+	for (const auto& [input, statements, functions, loops, bailouts] : tests)
+	{
+		SCOPED_TRACE(input);
+		shared_ptr<Program> interpreted, compiled;
+		ASSERT_NO_FATAL_FAILURE(initParser(interpreted, input, statements));
+		ASSERT_NO_FATAL_FAILURE(initParser(compiled, input, statements));
+
+		auto expected = make_shared<Evaluator>()->evaluate(interpreted, make_shared<Environment>());
+		auto evaluator = make_shared<Evaluator>();
+		ASSERT_TRUE(evaluator->enable_jit(1));
+		auto result = evaluator->evaluate(compiled, make_shared<Environment>());
+
+		testEqual(result, expected);
+		EXPECT_EQ(result->isMutable, expected->isMutable);
+		EXPECT_EQ(evaluator->jit()->stats().compiledFunctions, functions);
+		EXPECT_EQ(evaluator->jit()->stats().compiledLoops, loops);
+		EXPECT_EQ(evaluator->jit()->stats().bailouts, bailouts);
+	}
+}
+
+
+}
\ No newline at end of file
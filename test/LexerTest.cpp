@@ -7,7 +7,7 @@ namespace li::test
 
 TEST(LexerTest, parseToken)
 {
-	Lexer lexer("@identifierString;,(){}12345[]\"Hello world!\"977.21= == != > >= < <=!+-*/% += -= *= /= %=++--let var fun true false if else return while");
+	Lexer lexer("@identifierString;,:(){}12345[]\"Hello world!\"977.21= == != > >= < <=!+-*/% += -= *= /= %=++--let var fun true false if else return while for in 0..12");
 
 	struct
 	{
@@ -18,6 +18,7 @@ TEST(LexerTest, parseToken)
 		{ Token::Identifier,		"identifierString" },
 		{ Token::Semicolon,			";" },
 		{ Token::Comma,				"," },
+		{ Token::Colon,				":" },
 		{ Token::LParen,			"(" },
 		{ Token::RParen,			")" },
 		{ Token::LBrace,			"{" },
@@ -56,6 +57,11 @@ TEST(LexerTest, parseToken)
 		{ Token::Else,				"else" },
 		{ Token::Return,			"return" },
 		{ Token::While,				"while" },
+		{ Token::For,				"for" },
+		{ Token::In,				"in" },
+		{ Token::Integer,			"0" },
+		{ Token::Range,				".." },
+		{ Token::Integer,			"12" },
 		{ Token::Eof,				"" }
 	};
 	int i = 0;
@@ -71,5 +77,21 @@ TEST(LexerTest, parseToken)
 	}
 }
 
+TEST(LexerTest, internIdentifier)
+{
+	Lexer lexer("abc let abc def");
+
+	auto first = lexer.parseToken();
+	auto keyword = lexer.parseToken();
+	auto second = lexer.parseToken();
+	auto other = lexer.parseToken();
+
+	EXPECT_NE(first->symbol, SymbolTable::None);
+	EXPECT_EQ(first->symbol, second->symbol);
+	EXPECT_NE(first->symbol, other->symbol);
+	EXPECT_EQ(keyword->symbol, SymbolTable::None);
+	EXPECT_EQ(SymbolTable::name(first->symbol), "abc");
+}
+
 
 }
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include "initialization.h"
+#include "optimizer/Inliner.h"
+#include "optimizer/LoopInvariants.h"
+#include "optimizer/RangeAnalysis.h"
+#include "evaluator/Evaluator.h"
+#include "object/Integer.hpp"
+
+namespace li::test
+{
+
+
+TEST(OptimizerTest, inlineWrapper)
+{
+	shared_ptr<Program> program;
+	ASSERT_NO_FATAL_FAILURE(initParser(program, "let len = fun(obj) { _builtin_(1, obj) }; let size = fun(a) { return len(a) }; size(x)", 3));
+
+	Inliner inliner;
+	inliner.run(program);
+	EXPECT_EQ(program->statements.at(2)->toString(), "_builtin_(1, x)");
+	EXPECT_EQ(inliner.inlined(), 2);
+}
+
+TEST(OptimizerTest, notInlined)
+{
+	string tests[] = {
+		"let f = fun(n) { f(n) }; f(1)",
+		"let f = fun(n) { n + 1 }; f(1)",
+		"let f = fun(n) { let m = n; _builtin_(1, m) }; f(x)",
+		"let f = fun(a) { _builtin_(1, a) }; let g = fun(f) { f(x) }; f(x)",
+		"let f = fun(a) { _builtin_(1, a) }; let g = f; f(x)",
+		"let f = fun(a) { _builtin_(a, a) }; f(x)",
+		"let f = fun(a, b) { _builtin_(b, a) }; f(x, y)",
+		"let f = fun(a) { _builtin_(g(), a) }; f(x)",
+		"let f = fun(a, b) { _builtin_(1, a) }; f(x, y)",
+		"let f = fun(a) { _builtin_(1, a) }; f(x, y)"
+	};
+
+	for (const auto& input : tests)
+	{
+		SCOPED_TRACE(input);
+		shared_ptr<Program> program;
+		ASSERT_NO_FATAL_FAILURE(initParser(program, input, input.find("let g") == string::npos ? 2 : 3));
+
+		auto call = program->statements.back()->toString();
+		Inliner inliner;
+		inliner.run(program);
+		EXPECT_EQ(program->statements.back()->toString(), call);
+		EXPECT_EQ(inliner.inlined(), 0);
+	}
+}
+
+TEST(OptimizerTest, inlineSemantics)
+{
+	struct Expected
+	{
+		string input;
+		size_t statements;
+		int64_t value;
+	} tests[] = {
+		{ "let len = fun(obj) { _builtin_(1, obj) }; len([1, 2, 3])", 2, 3 },
+		{ "let len = fun(obj) { _builtin_(1, obj) }; let count = fun(a, b) { len(a) + len(b) }; count([1], \"ab\")", 3, 3 },
+		{ "let len = fun(obj) { _builtin_(1, obj) }; let pair = fun(a, b) { [len(a), len(b)] }; pair(\"a\", \"abc\")[1]", 3, 3 },
+		{ "let one = fun() { 1 }; one() + one()", 2, 2 },
+		{ "let len = fun(obj) { _builtin_(1, obj) }; let a = [1, 2]; let f = fun() { len(a) }; f()", 4, 2 }
+	};
+
+	for (const auto& [input, statements, value] : tests)
+	{
+		SCOPED_TRACE(input);
+		shared_ptr<Program> program;
+		ASSERT_NO_FATAL_FAILURE(initParser(program, input, statements));
+
+		Inliner inliner;
+		inliner.run(program);
+		EXPECT_GT(inliner.inlined(), 0);
+
+		auto evaluator = make_shared<Evaluator>();
+		testEqual(evaluator->evaluate(program, make_shared<Environment>()), make_shared<Integer>(value));
+	}
+}
+
+TEST(OptimizerTest, inlineMutatingBuiltins)
+{
+	struct Expected
+	{
+		string input;
+		size_t statements;
+		string inspected;
+	} tests[] = {
+		{ "let rm = fun(m, k) { remove(m, k) }; var m = {\"a\": 1, \"b\": 2}; rm(m, \"a\"); m", 4, "{a: 1, b: 2}" },
+		{ "var om = ordered(); let ins = fun(o, k) { insert(o, k) }; ins(om, 5); om", 4, "{}" },
+		{ "let om = ordered(); let ins = fun(o, k, v) { insert(o, k, v) }; ins(om, 5, 1)", 3, "true" }
+	};
+
+	for (const auto& [input, statements, inspected] : tests)
+	{
+		SCOPED_TRACE(input);
+		shared_ptr<Program> program, uninlined;
+		ASSERT_NO_FATAL_FAILURE(initParser(program, input, statements));
+		ASSERT_NO_FATAL_FAILURE(initParser(uninlined, input, statements));
+
+		Inliner inliner;
+		inliner.run(program);
+		EXPECT_EQ(inliner.inlined(), 0);
+
+		auto evaluated = make_shared<Evaluator>()->evaluate(program, make_shared<Environment>());
+		EXPECT_EQ(evaluated->inspect(), inspected);
+		EXPECT_EQ(evaluated->inspect(), make_shared<Evaluator>()->evaluate(uninlined, make_shared<Environment>())->inspect());
+	}
+}
+
+TEST(OptimizerTest, loopInvariants)
+{
+	struct Expected
+	{
+		string input;
+		size_t statements;
+		size_t hoisted;
+		int64_t value;
+	} tests[] = {
+		{ "let f = fun(a) { var i = 0; var s = 0; while (i < _builtin_(1, a) - 1) { s += a[i]; ++i }; s }; f([1, 2, 3, 4])", 2, 1, 6 },
+		{ "var a = [1]; var c = 0; while (c < _builtin_(1, a)) { if (_builtin_(1, a) < 4) { a = [0] }; ++c }; c", 4, 2, 4 },
+		{ "let n = 3; var s = 0; let f = fun() { while (s < n * 2) { s = s + 1 } }; f(); s", 5, 0, 6 },
+		{ "var c = 0; while (c < 3) { let n = [1, 2]; c = c + _builtin_(1, n) }; c", 3, 0, 4 },
+		{ "let len = fun(x) { 2 }; var c = 0; while (c < len([1])) { ++c }; c", 4, 0, 2 },
+		{ "var c = 0; while (c < 9) { var s = 0; while (s < _builtin_(1, \"ab\") + 1) { ++s }; c = c + s }; c", 3, 1, 9 }
+	};
+
+	for (const auto& [input, statements, hoisted, value] : tests)
+	{
+		SCOPED_TRACE(input);
+		shared_ptr<Program> program;
+		ASSERT_NO_FATAL_FAILURE(initParser(program, input, statements));
+		EXPECT_EQ(LoopInvariants::run(program), hoisted);
+
+		auto evaluator = make_shared<Evaluator>();
+		testEqual(evaluator->evaluate(program, make_shared<Environment>()), make_shared<Integer>(value));
+		EXPECT_EQ(evaluator->stats().invariantHits > 0, hoisted > 0);
+	}
+}
+
+
+TEST(OptimizerTest, rangeAnalysis)
+{
+	struct Expected
+	{
+		string input;
+		size_t statements;
+		size_t proven;
+		int64_t value;
+	} tests[] = {
+		{ "var a = [1, 2, 3]; var i = 0; var s = 0; while (i < _builtin_(1, a)) { s += a[i]; ++i }; s", 5, 1, 6 },
+		{ "var a = [1, 2, 3]; var i = 0 - 1; while (i < _builtin_(1, a)) { let x = a[i]; ++i }; i", 4, 0, 3 },
+		{ "var a = [1, 2]; var i = 0; var k = i; var c = 0; while (i < _builtin_(1, a)) { c += a[i]; ++i }; c", 6, 0, 3 },
+		{ "var a = [1, 2]; var i = 0; let f = fun() { i + 0 }; var c = 0; while (i < _builtin_(1, a)) { c += a[i]; ++i }; c", 6, 0, 3 },
+		{ "var a = [1, 2]; var i = 0; var c = 0; while (i < _builtin_(1, a)) { c += 1; c += a[i]; ++i }; c", 5, 0, 5 },
+		{ "var a = [1]; var i = 0; var c = 0; while (i < _builtin_(1, a)) { c += a[i]; if (i < 2) { a = [5] }; ++i }; c", 5, 1, 11 },
+		{ "var a = [1, 2, 3]; var i = 0; while (_builtin_(1, a) - 1 > i) { a[i] += a[i + 1]; i = i + 1 }; a[0]", 4, 1, 3 },
+		{ "var a = [3, 1, 2]; var i = 0; var c = 0; while (i < _builtin_(1, a)) { var j = i + 0; while (j < _builtin_(1, a)) { c += a[j] * a[i]; ++j }; ++i }; c", 5, 1, 25 },
+		{ "var a = [1, 2, 3]; var c = 0; for (i in 0.._builtin_(1, a)) { c += a[i] }; c", 4, 1, 6 },
+		{ "var a = [1, 2, 3]; var c = 0; for (i in 0 - 1.._builtin_(1, a)) { let x = a[i]; c += 1 }; c", 4, 0, 4 },
+		{ "var a = [1, 2, 3]; var c = 0; for (i in 0.._builtin_(1, a) - 1) { c += a[i]; --i }; c", 4, 0, 3 }
+	};
+
+	for (const auto& [input, statements, proven, value] : tests)
+	{
+		SCOPED_TRACE(input);
+		shared_ptr<Program> program;
+		ASSERT_NO_FATAL_FAILURE(initParser(program, input, statements));
+		EXPECT_EQ(RangeAnalysis::run(program), proven);
+
+		auto evaluator = make_shared<Evaluator>();
+		testEqual(evaluator->evaluate(program, make_shared<Environment>()), make_shared<Integer>(value));
+		EXPECT_EQ(evaluator->stats().uncheckedIndexes > 0, proven > 0);
+	}
+}
+
+}
\ No newline at end of file
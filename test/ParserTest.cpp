@@ -12,8 +12,11 @@
 #include "ast/AssignExpr.hpp"
 #include "ast/FloatExpr.hpp"
 #include "ast/ArrayExpr.hpp"
+#include "ast/MapExpr.hpp"
 #include "ast/IndexExpr.hpp"
+#include "ast/SliceExpr.hpp"
 #include "ast/WhileStat.hpp"
+#include "ast/ForStat.hpp"
 #include "ast/VarStat.hpp"
 #include "ast/InDecrementExpr.hpp"
 #include "initialization.h"
@@ -436,7 +439,9 @@ TEST(ParserTest, FunctionExpr)
 		string body;
 	} tests[] = {
 		{ "fun(a) { a }", "(a)", "{ a;  }" },
-		{ "fun(first, second) { first + second }", "(first, second)", "{ (first + second);  }" }
+		{ "fun(first, second) { first + second }", "(first, second)", "{ (first + second);  }" },
+		{ "fun(a: int, b, c: float): float { a }", "(a: int, b, c: float): float", "{ a;  }" },
+		{ "fun(): fun { f }", "(): fun", "{ f;  }" }
 	};
 
 	for (const auto& [input, args, body] : tests)
@@ -531,7 +536,8 @@ TEST(ParserTest, errorHandling)
 		string error;
 	} tests[] = {
 		{ "let a 2", R"(char 7: error: expected token type to be assign("="), but got integer)" },
-		{ "let = 4", R"(char 7: error: expected token type to be identifier, but got assign("="))" }
+		{ "let = 4", R"(char 7: error: expected token type to be identifier, but got assign("="))" },
+		{ "let a: long = 4", R"(char 13: error: unknown type annotation: long)" }
 	};
 
 	for (const auto& [input, error] : tests)
@@ -563,6 +569,31 @@ TEST(ParserTest, ArrayExpr)
 	ASSERT_NO_FATAL_FAILURE(testStringExpr(exprs.at(2), "Hello world!"));
 }
 
+TEST(ParserTest, MapExpr)
+{
+	shared_ptr<Program> program;
+	ASSERT_NO_FATAL_FAILURE(initParser(program, R"({"a": 1 * 3, 2: "b"})", 1));
+
+    auto statement = dynamic_pointer_cast<ExpressionStat>(program->statements.at(0));
+	ASSERT_TRUE(statement);
+
+	auto map = dynamic_pointer_cast<MapExpr>(statement->expression);
+	ASSERT_TRUE(map);
+	auto exprs = map->entries->expressions;
+	ASSERT_EQ(exprs.size(), 4);
+	ASSERT_NO_FATAL_FAILURE(testStringExpr(exprs.at(0), "a"));
+	ASSERT_NO_FATAL_FAILURE(testInfixExpr(exprs.at(1), "1", "*", "3"));
+	ASSERT_NO_FATAL_FAILURE(testIntegerExpr(exprs.at(2), "2"));
+	ASSERT_NO_FATAL_FAILURE(testStringExpr(exprs.at(3), "b"));
+
+	ASSERT_NO_FATAL_FAILURE(initParser(program, "{}", 1));
+	statement = dynamic_pointer_cast<ExpressionStat>(program->statements.at(0));
+	ASSERT_TRUE(statement);
+	map = dynamic_pointer_cast<MapExpr>(statement->expression);
+	ASSERT_TRUE(map);
+	EXPECT_TRUE(map->entries->expressions.empty());
+}
+
 TEST(ParserTest, IndexExpr)
 {
 	shared_ptr<Program> program;
@@ -577,6 +608,37 @@ TEST(ParserTest, IndexExpr)
 	ASSERT_NO_FATAL_FAILURE(testIntegerExpr(indexExpr->index, "12"));
 }
 
+TEST(ParserTest, SliceExpr)
+{
+	struct Expected
+	{
+		string input;
+		string from;
+		string to;
+	} tests[] = {
+		{ "a[1:n]", "1", "n" },
+		{ "a[:2]", "", "2" },
+		{ "a[i + 1:]", "(i + 1)", "" },
+		{ "a[:]", "", "" }
+	};
+
+	for (const auto& [input, from, to] : tests)
+	{
+		SCOPED_TRACE(input);
+		shared_ptr<Program> program;
+		ASSERT_NO_FATAL_FAILURE(initParser(program, input, 1));
+
+		auto statement = dynamic_pointer_cast<ExpressionStat>(program->statements.at(0));
+		ASSERT_TRUE(statement);
+		auto slice = dynamic_pointer_cast<SliceExpr>(statement->expression);
+		ASSERT_TRUE(slice);
+
+		ASSERT_NO_FATAL_FAILURE(testIdentifierExpr(slice->left, "a"));
+		EXPECT_EQ(slice->from ? slice->from->toString() : "", from);
+		EXPECT_EQ(slice->to ? slice->to->toString() : "", to);
+	}
+}
+
 TEST(ParserTest, WhileStat)
 {
 	shared_ptr<Program> program;
@@ -590,6 +652,37 @@ TEST(ParserTest, WhileStat)
 	ASSERT_NO_FATAL_FAILURE(testInfixExpr(expr->expression, "a", "+", "1"));
 }
 
+TEST(ParserTest, ForStat)
+{
+	struct Expected
+	{
+		string input;
+		string name;
+		string iterable;
+		string end;
+	} tests[] = {
+		{ "for (i in 0..n) { i }", "i", "0", "n" },
+		{ "for (element in array) { element }", "element", "array", "" }
+	};
+
+	for (const auto& [input, name, iterable, end] : tests)
+	{
+		SCOPED_TRACE(input);
+
+		shared_ptr<Program> program;
+		ASSERT_NO_FATAL_FAILURE(initParser(program, input, 1));
+
+		auto statement = dynamic_pointer_cast<ForStat>(program->statements.at(0));
+		ASSERT_TRUE(statement);
+
+		ASSERT_NO_FATAL_FAILURE(testIdentifierExpr(statement->name, name));
+		EXPECT_EQ(statement->iterable->toString(), iterable);
+		EXPECT_EQ(statement->end ? statement->end->toString() : "", end);
+		auto expr = dynamic_pointer_cast<ExpressionStat>(statement->body->statements.at(0));
+		ASSERT_NO_FATAL_FAILURE(testIdentifierExpr(expr->expression, name));
+	}
+}
+
 TEST(ParserTest, InDecrementExpr)
 {
 	struct Expected
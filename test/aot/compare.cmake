@@ -0,0 +1,11 @@
+# Runs a source with the interpreter and the program li --emit-cpp translated it to, which must print the same
+execute_process(COMMAND ${INTERPRETER} ${SOURCE}
+	OUTPUT_VARIABLE expectedOutput
+	ERROR_VARIABLE expectedError)
+execute_process(COMMAND ${COMPILED}
+	OUTPUT_VARIABLE output
+	ERROR_VARIABLE error)
+
+if (NOT output STREQUAL expectedOutput OR NOT error STREQUAL expectedError)
+	message(FATAL_ERROR "${SOURCE}: the translated program printed\n${output}${error}\ninstead of\n${expectedOutput}${expectedError}")
+endif()
\ No newline at end of file
@@ -10,6 +10,8 @@
 #include "object/Error.hpp"
 #include "object/String.hpp"
 #include "object/Array.hpp"
+#include "object/Map.hpp"
+#include "object/OrderedMap.hpp"
 #include "object/Null.hpp"
 #include "program/initialization.h"
 #include "config.h"
@@ -128,14 +130,38 @@ void testEqual(shared_ptr<Object> obj, shared_ptr<Object> value)
 		auto cast = dynamic_pointer_cast<Array>(obj);
 		auto castValue = dynamic_pointer_cast<Array>(value);
 
-		ASSERT_EQ(cast->elements.size(), castValue->elements.size());
-		for (int i = 0; i < cast->elements.size(); i++)
+		ASSERT_EQ(cast->size(), castValue->size());
+		for (size_t i = 0; i < cast->size(); i++)
 		{
-			testEqual(cast->elements.at(i), castValue->elements.at(i));
+			testEqual(cast->get(i), castValue->get(i));
 		}
 		break;
 	}
 
+	case Object::Type::Map:
+	{
+		ASSERT_EQ(obj->typeName(), value->typeName());
+		auto cast = dynamic_pointer_cast<Map>(obj);
+		auto castValue = dynamic_pointer_cast<Map>(value);
+
+		ASSERT_EQ(cast->size(), castValue->size());
+		for (const auto& entry : cast->entries())
+		{
+			if (!entry.key) continue;
+			auto* found = castValue->find(*entry.key);
+			ASSERT_TRUE(found) << "missing key " << entry.key->inspect();
+			testEqual(entry.value, *found);
+		}
+		break;
+	}
+
+	case Object::Type::OrderedMap:
+	{
+		ASSERT_EQ(obj->typeName(), value->typeName());
+		ASSERT_EQ(obj->inspect(), value->inspect());
+		break;
+	}
+
 	case Object::Type::Float:
 	{
 		ASSERT_EQ(obj->typeName(), value->typeName());
@@ -146,7 +172,7 @@ void testEqual(shared_ptr<Object> obj, shared_ptr<Object> value)
 	case Object::Type::String:
 	{
 		ASSERT_EQ(obj->typeName(), value->typeName());
-		EXPECT_EQ(dynamic_pointer_cast<String>(obj)->value, dynamic_pointer_cast<String>(value)->value);
+		EXPECT_EQ(dynamic_pointer_cast<String>(obj)->view(), dynamic_pointer_cast<String>(value)->view());
 		break;
 	}
 
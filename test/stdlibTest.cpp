@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
 #include "evaluator/Evaluator.h"
+#include "object/Error.hpp"
+#include "evaluator/Kernels.h"
+#include "evaluator/ThreadPool.h"
+#include <unordered_map>
+#include <map>
 #include "initialization.h"
 
 namespace li::test
@@ -16,7 +21,25 @@ TEST(stdlibTest, utils)
 		{ R"(print("Hello world!"))", Evaluator::null },
 		{ R"(println("Hello world!"))", Evaluator::null },
 		{ R"(len("12345"))", make_shared<Integer>(5) },
-		{ R"(len([1, 2, 3, 4, 5]))", make_shared<Integer>(5) }
+		{ R"(len([1, 2, 3, 4, 5]))", make_shared<Integer>(5) },
+		{ R"(len({"a": 1, "b": 2}))", make_shared<Integer>(2) },
+		{ R"(var s = "ab"; s += "cd"; len(s))", make_shared<Integer>(4) },
+		{ R"(join(["a", "b", "c"], ", "))", make_shared<String>("a, b, c") },
+		{ R"(join(["a"], "-"))", make_shared<String>("a") },
+		{ R"(join([], "-"))", make_shared<String>("") },
+		{ R"(join(["a", 1], "-"))", make_shared<Error>("error - invalid arguments: expected every element of the array to be a string, but got integer") },
+		{ R"(join([1, 2], "-"))", make_shared<Error>("error - invalid arguments: expected every element of the array to be a string, but got integer") },
+		{ R"(join(["a"], 1))", make_shared<Error>("error - invalid arguments: expected the type of second argument to be string, but got integer") },
+		{ R"(slice("Hello world!", 6, 11))", make_shared<String>("world") },
+		{ R"(slice("Hello", 3, 100))", make_shared<String>("lo") },
+		{ R"(slice("Hello", 4, 2))", make_shared<String>("") },
+		{ R"(substr("Hello world!", 6, 5))", make_shared<String>("world") },
+		{ R"(substr("Hello", -2, 3))", make_shared<String>("Hel") },
+		{ R"(substr("Hello", 2, -1))", make_shared<String>("") },
+		{ R"(var s = slice("Hello world!", 0, 5); s += "!"; s)", make_shared<String>("Hello!") },
+		{ R"(let s = "Hello world!"; var t = slice(s, 0, 5); t += "!"; s)", make_shared<String>("Hello world!") },
+		{ R"(slice(1, 0, 1))", make_shared<Error>("error - invalid arguments: expected the type of first argument to be string, but got integer") },
+		{ R"(substr("a", 0, "b"))", make_shared<Error>("error - invalid arguments: expected the type of third argument to be integer, but got string") }
 	};
 
 	for (const auto& [input, value] : tests)
@@ -26,5 +49,462 @@ TEST(stdlibTest, utils)
 	}
 }
 
+// Long slices share the characters of the string, short ones and ones of a much longer string copy them
+TEST(stdlibTest, stringSlices)
+{
+	String text(string(100, 'a') + string(100, 'b'));
+	auto data = text.view().data();
+
+	auto shared = text.slice(80, 60);
+	EXPECT_EQ(shared->view(), string(20, 'a') + string(40, 'b'));
+	EXPECT_EQ(shared->view().data(), data + 80);
+
+	auto tiny = text.slice(0, 5);
+	EXPECT_EQ(tiny->view(), "aaaaa");
+	EXPECT_NE(tiny->view().data(), data);
+
+	auto pinning = text.slice(100, 40);
+	EXPECT_EQ(pinning->view(), string(40, 'b'));
+	EXPECT_NE(pinning->view().data(), data + 100);
+
+	// Appending to a slice in the middle of the string leaves the string alone
+	shared->append("c");
+	EXPECT_EQ(shared->view(), string(20, 'a') + string(40, 'b') + "c");
+	EXPECT_EQ(text.view(), string(100, 'a') + string(100, 'b'));
+
+	auto tail = text.slice(100, 100);
+	EXPECT_EQ(tail->view().data(), data + 100);
+	tail->append("d");
+	EXPECT_EQ(tail->view(), string(100, 'b') + "d");
+	EXPECT_EQ(text.view(), string(100, 'a') + string(100, 'b'));
+}
+
+TEST(stdlibTest, numeric)
+{
+	struct Expected
+	{
+		string input;
+		string inspected;
+	} tests[] = {
+		{ "sum([1, 2, 3, 4, 5])", "15" },
+		{ "sum([1.5, 2.5])", "4" },
+		{ "sum([1, 2.5])", "3.5" },
+		{ "sum([])", "0" },
+		{ "sum(fill(1001, 3))", "3003" },
+		{ "min([3, -1, 2])", "-1" },
+		{ "max([3, -1, 2])", "3" },
+		{ "min([2.5, 0.5, 1.5])", "0.5" },
+		{ "max([1, 7.5, 3])", "7.5" },
+		{ "dot([1, 2, 3], [4, 5, 6])", "32" },
+		{ "dot([1, 2], [0.5, 0.5])", "1.5" },
+		{ "dot(fill(37, 2), fill(37, 3))", "222" },
+		{ "scale([1, 2, 3], 2)", "[2, 4, 6]" },
+		{ "scale([1, 2], 0.5)", "[0.5, 1]" },
+		{ "add([1, 2, 3], [10, 20, 30])", "[11, 22, 33]" },
+		{ "sub([1, 2], [0.5, 0.5])", "[0.5, 1.5]" },
+		{ "mul([1, 2, 3, 4, 5], [5, 4, 3, 2, 1])", "[5, 8, 9, 8, 5]" },
+		{ "mul([4294967296, -3], [4294967296, 5])", "[0, -15]" },
+		{ "fill(3, 1.5)", "[1.5, 1.5, 1.5]" },
+		{ "fill(2, \"a\")", "[a, a]" },
+		{ "fill(0, 1)", "[]" },
+		{ "var x = 2; let a = [x, x, 1]; sum(a)", "5" },
+		{ "let a = [1, 2]; var b = add(a, a); b[0] = 5; a", "[1, 2]" },
+		{ "min([])", "error - invalid arguments: expected a non-empty array" },
+		{ "sum([1, true])", "error - invalid arguments: expected the elements of first argument to be numbers, but got bool" },
+		{ "sum(1)", "error - invalid arguments: expected the type of first argument to be array, but got integer" },
+		{ "add([1], [1, 2])", "error - invalid arguments: expected the arrays to have the same length, but got 1 and 2" },
+		{ "dot([1], [true])", "error - invalid arguments: expected the elements of second argument to be numbers, but got bool" },
+		{ "scale([1], true)", "error - invalid arguments: expected the type of second argument to be integer or float, but got bool" },
+		{ "fill(-1, 0)", "error - invalid arguments: expected a non-negative length, but got -1" }
+	};
+
+	for (const auto& [input, inspected] : tests)
+	{
+		SCOPED_TRACE(input);
+		EXPECT_EQ(initProgram(input)->inspect(), inspected);
+	}
+}
+
+// The vector loops and the scalar loop finishing them agree with plain loops for every remainder
+TEST(stdlibTest, numericKernels)
+{
+	for (size_t n = 1; n < 20; n++)
+	{
+		SCOPED_TRACE(n);
+		vector<int64_t> a(n), b(n), out(n);
+		vector<double> x(n), y(n), floats(n);
+		int64_t sum = 0, dot = 0;
+		for (size_t i = 0; i < n; i++)
+		{
+			a[i] = (i * 7 % 11) - 5 + (int64_t(i) << 33);
+			b[i] = 3 - int64_t(i);
+			x[i] = a[i] * 0.25;
+			y[i] = b[i] * 0.5;
+			sum += a[i];
+			dot += a[i] * b[i];
+		}
+
+		EXPECT_EQ(Kernels::sum(a.data(), n), sum);
+		EXPECT_EQ(Kernels::dot(a.data(), b.data(), n), dot);
+		EXPECT_EQ(Kernels::min(a.data(), n), *min_element(a.begin(), a.end()));
+		EXPECT_EQ(Kernels::max(a.data(), n), *max_element(a.begin(), a.end()));
+		EXPECT_EQ(Kernels::min(x.data(), n), *min_element(x.begin(), x.end()));
+		EXPECT_EQ(Kernels::max(x.data(), n), *max_element(x.begin(), x.end()));
+		EXPECT_DOUBLE_EQ(Kernels::sum(x.data(), n), sum * 0.25);
+
+		Kernels::combine(Kernels::Op::Mul, a.data(), b.data(), out.data(), n);
+		Kernels::combine(Kernels::Op::Sub, x.data(), y.data(), floats.data(), n);
+		for (size_t i = 0; i < n; i++)
+		{
+			EXPECT_EQ(out[i], a[i] * b[i]);
+			EXPECT_EQ(floats[i], x[i] - y[i]);
+		}
+		Kernels::scale(a.data(), -3, out.data(), n);
+		for (size_t i = 0; i < n; i++)
+		{
+			EXPECT_EQ(out[i], a[i] * -3);
+		}
+	}
+}
+
+TEST(stdlibTest, sort)
+{
+	struct Expected
+	{
+		string input;
+		string inspected;
+	} tests[] = {
+		{ "sort([5, 3, 9, 1, 3])", "[1, 3, 3, 5, 9]" },
+		{ "sort([2.5, -1.5, 0.5])", "[-1.5, 0.5, 2.5]" },
+		{ "sort([3, 1.5, 2])", "[1.5, 2, 3]" },
+		{ "sort([\"pear\", \"apple\", \"fig\"])", "[apple, fig, pear]" },
+		{ "sort([])", "[]" },
+		{ "let a = [2, 1]; let s = sort(a); a", "[2, 1]" },
+		{ "var x = 2; sort([x, 1])", "[1, 2]" },
+		{ "sort([1, 3, 2], fun(a, b) { a > b })", "[3, 2, 1]" },
+		{ "sort([\"bb\", \"a\", \"ccc\"], fun(a, b) { len(a) < len(b) })", "[a, bb, ccc]" },
+		{ "sort([[1, 2], [3], []], fun(a, b) { len(a) < len(b) })", "[[], [3], [1, 2]]" },
+		{ "sort([[1, 0], [0, 1], [1, 1]], fun(a, b) { a[0] < b[0] })", "[[0, 1], [1, 0], [1, 1]]" },
+		{ "sort([true])", "error - invalid arguments: expected the elements of first argument to be numbers or strings, but got bool" },
+		{ "sort([1, \"a\"])", "error - invalid arguments: expected the elements of first argument to be numbers, but got string" },
+		{ "sort(1)", "error - invalid arguments: expected the type of first argument to be array, but got integer" },
+		{ "sort([1], 2)", "error - invalid arguments: expected the type of second argument to be function, but got integer" },
+		{ "sort([2, 1], fun(a, b) { 1 })", "error - invalid arguments: expected the comparator to return bool, but got integer" },
+		{ "sort([2, 1], fun(a, b) { c })", "error - identifier not found: c" }
+	};
+
+	for (const auto& [input, inspected] : tests)
+	{
+		SCOPED_TRACE(input);
+		EXPECT_EQ(initProgram(input)->inspect(), inspected);
+	}
+}
+
+// Large enough to be sorted in runs on several threads where there are several cores
+TEST(stdlibTest, sortKernel)
+{
+	for (size_t n : { size_t(1000), Kernels::parallelSize, Kernels::parallelSize * 3 + 7 })
+	{
+		SCOPED_TRACE(n);
+		vector<int64_t> a(n);
+		for (size_t i = 0; i < n; i++)
+		{
+			a[i] = static_cast<int64_t>(i * 2654435761 % 1000003);
+		}
+		auto expected = a;
+		std::sort(expected.begin(), expected.end());
+		Kernels::sort(a.data(), n, std::less<int64_t>());
+		EXPECT_EQ(a, expected);
+	}
+}
+
+TEST(stdlibTest, higherOrder)
+{
+	struct Expected
+	{
+		string input;
+		string inspected;
+	} tests[] = {
+		{ "map([1, 2, 3], fun(x) { x * x })", "[1, 4, 9]" },
+		{ "map([1.5, 2.5], fun(x) { x + 1 })", "[2.5, 3.5]" },
+		{ "map([\"a\", \"b\"], fun(s) { s + \"!\" })", "[a!, b!]" },
+		{ "map([1, 2], fun(x) { x })", "[1, 2]" },
+		{ "map([], fun(x) { x })", "[]" },
+		{ "let a = [1, 2]; let m = map(a, fun(x) { x += 1; x }); a", "[1, 2]" },
+		{ "let f = fun(x) { let y = x * 2; y }; map([1, 2, 3], f)", "[2, 4, 6]" },
+		{ "var kept = []; each([1, 2], fun(x) { kept = [x] }); kept", "[1, 2]" },
+		{ "filter([1, 2, 3, 4], fun(x) { x % 2 == 0 })", "[2, 4]" },
+		{ "filter([[1], [2, 3]], fun(x) { len(x) > 1 })", "[[2, 3]]" },
+		{ "filter([1.5, 2], fun(x) { x > 1.75 })", "[2]" },
+		{ "reduce([1, 2, 3, 4], fun(s, x) { s + x }, 0)", "10" },
+		{ "reduce([1, 2], fun(s, x) { s = [x]; s }, [])", "[1, 2]" },
+		{ "reduce([], fun(s, x) { s + x }, 5)", "5" },
+		{ "var n = 0; reduce([1, 2], fun(s, x) { s + x }, n); n", "0" },
+		{ "var total = 0; each([1, 2, 3], fun(x) { total += x }); total", "6" },
+		{ "var a = [1]; each(a, fun(x) { a = [x] }); a", "[1, 1]" },
+		{ "map([1], fun(x, y) { x })", "error - invalid arguments: expected a function of 1 arguments, but got one of 2" },
+		{ "map(1, fun(x) { x })", "error - invalid arguments: expected the type of first argument to be array, but got integer" },
+		{ "map([1], 1)", "error - invalid arguments: expected the type of second argument to be function, but got integer" },
+		{ "filter([1], fun(x) { x })", "error - invalid arguments: expected the predicate to return bool, but got integer" },
+		{ "reduce([1], fun(s, x) { s + x })", "error - invalid arguments: expected the number of them to be 3, but got 2" },
+		{ "each([1, 2], fun(x) { y })", "error - identifier not found: y" },
+		{ "map([1], fun(x: float) { x })", "error - annotation mismatch: expected x to be float, but got integer" }
+	};
+
+	for (const auto& [input, inspected] : tests)
+	{
+		SCOPED_TRACE(input);
+		EXPECT_EQ(initProgram(input)->inspect(), inspected);
+	}
+}
+
+
+TEST(stdlibTest, parallel)
+{
+	struct Expected
+	{
+		string input;
+		string inspected;
+	} tests[] = {
+		{ "pmap([1, 2, 3], fun(x) { x * x })", "[1, 4, 9]" },
+		{ "pmap([1.5, 2.5], fun(x) { x + 1 })", "[2.5, 3.5]" },
+		{ "pmap([\"a\", \"b\"], fun(s) { s + \"!\" })", "[a!, b!]" },
+		{ "pmap([], fun(x) { x })", "[]" },
+		{ "let a = [[1], [2, 3]]; pmap(a, fun(x) { len(x) })", "[1, 2]" },
+		{ "let f = fun(x) { if (x < 2) { return x }; f(x - 1) + f(x - 2) }; pmap([10, 15, 20], f)", "[55, 610, 6765]" },
+		{ "preduce([1, 2, 3, 4], fun(s, x) { s + x }, 0)", "10" },
+		{ "preduce([1.5, 2.5], fun(s, x) { s + x }, 1)", "5" },
+		{ "preduce([], fun(s, x) { s + x }, 5)", "5" },
+		{ "preduce([\"b\", \"c\", \"d\", \"e\", \"f\"], fun(s, x) { s + x }, \"a\")", "abcdef" },
+		{ "var n = 0; preduce([1, 2], fun(s, x) { s + x }, n); n", "0" },
+		// Callbacks changing what they share are called serially, in order
+		{ "var total = 0; pmap([1, 2, 3], fun(x) { total = total * 10 + x; x }); total", "123" },
+		{ "var seen = []; preduce([1, 2], fun(s, x) { seen = [x]; s }, 0); seen", "[1, 2]" },
+		{ "pmap([1], fun(x, y) { x })", "error - invalid arguments: expected a function of 1 arguments, but got one of 2" },
+		{ "pmap(1, fun(x) { x })", "error - invalid arguments: expected the type of first argument to be array, but got integer" },
+		{ "preduce([1], fun(s, x) { s + x })", "error - invalid arguments: expected the number of them to be 3, but got 2" },
+		{ "pmap([1, 2, 3], fun(x) { y })", "error - identifier not found: y" },
+		{ "preduce([1, 2], fun(s, x: float) { s }, 0)", "error - annotation mismatch: expected x to be float, but got integer" }
+	};
+
+	for (const auto& [input, inspected] : tests)
+	{
+		SCOPED_TRACE(input);
+		EXPECT_EQ(initProgram(input)->inspect(), inspected);
+	}
+}
+
+TEST(stdlibTest, threadPool)
+{
+	ThreadPool pool(4);
+	for (size_t count : { 0, 1, 7, 1000 })
+	{
+		SCOPED_TRACE(count);
+		vector<atomic<int>> done(count);
+		pool.run(count, [&](size_t index, size_t worker)
+		{
+			EXPECT_LT(worker, pool.size());
+			done[index]++;
+		});
+		for (const auto& times : done)
+		{
+			EXPECT_EQ(times, 1);
+		}
+	}
+
+	// A run started by a task runs on the thread of that task
+	atomic<size_t> nested{ 0 };
+	pool.run(4, [&](size_t, size_t)
+	{
+		pool.run(3, [&](size_t, size_t) { nested++; });
+	});
+	EXPECT_EQ(nested, 12);
+}
+
+
+TEST(stdlibTest, maps)
+{
+	struct Expected
+	{
+		string input;
+		string inspected;
+	} tests[] = {
+		{ R"(keys({"b": 1, 2: 2, "a": 3}))", "[b, 2, a]" },
+		{ R"(values({"b": 1, 2: 2, "a": 3}))", "[1, 2, 3]" },
+		{ "keys({})", "[]" },
+		{ R"(has({"a": 1}, "a"))", "true" },
+		{ R"(has({"a": 1}, 1))", "false" },
+		{ R"(has({"a": 1}, [1]))", "error - invalid arguments: expected the type of second argument to be a key, but got array" },
+		{ "has({1.5: 1}, 0.0 / 0.0)", "error - invalid arguments: expected the second argument to be a key that is not NaN" },
+		{ "var m = {}; remove(m, 0.0 / 0.0)", "error - invalid arguments: expected the second argument to be a key that is not NaN" },
+		{ R"(var m = {"a": 1, "b": 2}; remove(m, "a"))", "1" },
+		{ R"(var m = {"a": 1, "b": 2}; remove(m, "c"))", "null" },
+		{ R"(var m = {"a": 1, "b": 2}; remove(m, "a"); m["a"] = 3; m)", "{b: 2, a: 3}" },
+		{ R"(var m = {"a": [1]}; var v = values(m); v[0] = [2]; m)", "{a: [1]}" },
+		{ "var m = {}; var i = 0; while (i < 100) { m[i] = i * i; ++i }; i = 0; while (i < 90) { remove(m, i); ++i }; len(m) * 10000 + m[95]", "109025" },
+		{ R"(let m = {"a": 1}; remove(m, "a"))", "error - invalid arguments: expected the map to be mutable" },
+		{ R"(keys([1]))", "error - invalid arguments: expected the type of first argument to be map, but got array" },
+		{ R"(has({"a": 1}))", "error - invalid arguments: expected the number of them to be 2, but got 1" }
+	};
+
+	for (const auto& [input, inspected] : tests)
+	{
+		SCOPED_TRACE(input);
+		EXPECT_EQ(initProgram(input)->inspect(), inspected);
+	}
+}
+
+// Inserting and removing many keys, which grows and compacts the table, finds what unordered_map finds
+TEST(stdlibTest, mapTable)
+{
+	Map map;
+	unordered_map<int64_t, int64_t> expected;
+	uint64_t state = 1;
+	for (int64_t i = 0; i < 20000; i++)
+	{
+		state = state * 6364136223846793005ull + 1442695040888963407ull;
+		auto key = static_cast<int64_t>(state >> 53);
+		if (state >> 62 == 0)
+		{
+			auto removed = map.remove(Integer(key));
+			EXPECT_EQ(removed != nullptr, expected.erase(key) == 1);
+		}
+		else
+		{
+			map.set(make_shared<Integer>(key), make_shared<Integer>(i));
+			expected[key] = i;
+		}
+	}
+
+	ASSERT_EQ(map.size(), expected.size());
+	for (int64_t key = 0; key < 2048; key++)
+	{
+		auto* found = map.find(Integer(key));
+		auto it = expected.find(key);
+		ASSERT_EQ(found != nullptr, it != expected.end());
+		if (found)
+		{
+			EXPECT_EQ(static_cast<Integer&>(**found).value, it->second);
+		}
+	}
+}
+
+
+TEST(stdlibTest, orderedMaps)
+{
+	struct Expected
+	{
+		string input;
+		string inspected;
+	} tests[] = {
+		{ "ordered()", "{}" },
+		{ "ordered([3, 1.5, 2])", "{1.5: true, 2: true, 3: true}" },
+		{ R"(ordered({"b": 1, "a": [2]}))", "{a: [2], b: 1}" },
+		{ "var o = ordered(); insert(o, 2, \"b\"); insert(o, 1, \"a\"); o", "{1: a, 2: b}" },
+		{ "var o = ordered([1]); insert(o, 1.0, 5)", "false" },
+		{ "var o = ordered([1]); insert(o, 1.0, 5); o", "{1: 5}" },
+		{ "var o = ordered(); insert(o, \"k\")", "true" },
+		{ "var o = ordered([5, 1, 3]); o[3]", "true" },
+		{ "var o = ordered(); o[\"b\"] = 2; o[\"a\"] = 1; o[\"a\"] += 5; o", "{a: 6, b: 2}" },
+		{ "keys(ordered([\"pear\", \"fig\", \"apple\"]))", "[apple, fig, pear]" },
+		{ "var o = ordered(); insert(o, 2, 20); insert(o, 1, 10); values(o)", "[10, 20]" },
+		{ "first(ordered([4, 2, 8]))", "2" },
+		{ "last(ordered([4, 2, 8]))", "8" },
+		{ "first(ordered())", "null" },
+		{ "lower_bound(ordered([1, 4, 9]), 5)", "9" },
+		{ "lower_bound(ordered([1, 4, 9]), 4)", "4" },
+		{ "lower_bound(ordered([1, 4, 9]), 9.5)", "null" },
+		{ "range(ordered([1, 4, 6, 9]), 2, 9)", "[4, 6]" },
+		{ "range(ordered([\"a\", \"ab\", \"b\"]), \"a\", \"b\")", "[a, ab]" },
+		{ "var o = ordered([1, 2]); remove(o, 1); remove(o, 2); insert(o, \"s\"); o", "{s: true}" },
+		{ "len(ordered([1, 1, 2]))", "2" },
+		{ "has(ordered([1, 2]), 2.0)", "true" },
+		{ "let o = ordered([1]); insert(o, 2)", "error - invalid arguments: expected the map to be mutable" },
+		{ "let o = ordered([1]); o[1] = false", "error - cannot access immutable variable: [" },
+		{ "ordered([1, \"a\"])", "error - invalid arguments: expected every element of the array to be a number like the keys of the map, but got string" },
+		{ "ordered({true: 1})", "error - invalid arguments: expected every key of the map to be a number or a string, but got bool" },
+		{ "ordered(1)", "error - invalid arguments: expected the type of first argument to be map or array, but got integer" },
+		{ "var o = ordered([1]); insert(o, \"a\")", "error - invalid arguments: expected the second argument to be a number like the keys of the map, but got string" },
+		{ "range(ordered([1]), 0, [1])", "error - invalid arguments: expected the third argument to be a number or a string, but got array" },
+		{ "first({})", "error - invalid arguments: expected the type of first argument to be ordered_map, but got map" },
+		{ "ordered([1])[\"a\"]", "error - index operand type: ordered_map[string]" },
+		// NaN is a float, but it does not go before or after any number
+		{ "ordered([1.5, 0.0 / 0.0])", "error - invalid arguments: expected every element of the array to be a key that is not NaN" },
+		{ "var o = ordered(); insert(o, 0.0 / 0.0, 1)", "error - invalid arguments: expected the second argument to be a key that is not NaN" },
+		{ "ordered([1])[0.0 / 0.0]", "error - invalid key: expected a key of the ordered_map that is not NaN" }
+	};
+
+	for (const auto& [input, inspected] : tests)
+	{
+		SCOPED_TRACE(input);
+		EXPECT_EQ(initProgram(input)->inspect(), inspected);
+	}
+}
+
+// Inserting and removing many keys, which splits, borrows and merges nodes, keeps what map keeps
+TEST(stdlibTest, orderedMapTree)
+{
+	OrderedMap tree;
+	std::map<int64_t, int64_t> expected;
+	uint64_t state = 7;
+	auto visited = [&](const Object* from)
+	{
+		vector<int64_t> keys;
+		tree.visit(from, [&](const shared_ptr<Object>& key, const shared_ptr<Object>& value)
+		{
+			keys.push_back(static_cast<Integer&>(*key).value);
+			EXPECT_EQ(static_cast<Integer&>(*value).value, expected[keys.back()]);
+			return true;
+		});
+		return keys;
+	};
+
+	for (int64_t i = 0; i < 30000; i++)
+	{
+		state = state * 6364136223846793005ull + 1442695040888963407ull;
+		auto key = static_cast<int64_t>(state >> 52) - 2048;
+		// Removes more than it inserts in the second half, so that the tree shrinks again
+		if ((state >> 61) < (i < 15000 ? 2u : 5u))
+		{
+			auto removed = tree.remove(Integer(key));
+			EXPECT_EQ(removed != nullptr, expected.erase(key) == 1);
+		}
+		else
+		{
+			EXPECT_EQ(tree.insert(make_shared<Integer>(key), make_shared<Integer>(i)), !expected.count(key));
+			expected[key] = i;
+		}
+
+		if (i % 5000 == 0 || i == 29999)
+		{
+			ASSERT_EQ(tree.size(), expected.size());
+			vector<int64_t> keys;
+			for (const auto& [key, value] : expected) keys.push_back(key);
+			EXPECT_EQ(visited(nullptr), keys);
+
+			Integer from(key);
+			auto bound = expected.lower_bound(key);
+			auto found = tree.lower_bound(from);
+			ASSERT_EQ(found != nullptr, bound != expected.end());
+			if (found)
+			{
+				EXPECT_EQ(static_cast<Integer&>(*found).value, bound->first);
+			}
+			EXPECT_EQ(visited(&from), vector<int64_t>(keys.begin() + (bound == expected.end() ? keys.size() : distance(expected.begin(), bound)), keys.end()));
+		}
+	}
+
+	for (int64_t key = -2048; key < 2048; key++)
+	{
+		auto* found = tree.find(Integer(key));
+		ASSERT_EQ(found != nullptr, expected.count(key) == 1);
+	}
+	if (!expected.empty())
+	{
+		EXPECT_EQ(static_cast<Integer&>(*tree.first()).value, expected.begin()->first);
+		EXPECT_EQ(static_cast<Integer&>(*tree.last()).value, expected.rbegin()->first);
+	}
+}
+
 
 }
\ No newline at end of file